@@ -446,6 +446,7 @@ def __set_output_directories(cache_dir):
         os.path.join(cache_dir, "bakefiles"),
         os.path.join(cache_dir, "logs"),
         os.path.join(cache_dir, "savestates"),
+        os.path.join(cache_dir, "staticsdf"),
         os.path.join(cache_dir, "temp")
     ]
 
@@ -491,6 +492,14 @@ def __get_limit_behaviour_enum(b):
     return int(b)
 
 
+def __get_whitewater_cache_precision_bits(precision):
+    if precision == 'WHITEWATER_CACHE_PRECISION_8':
+        return 8
+    if precision == 'WHITEWATER_CACHE_PRECISION_FULL':
+        return 32
+    return 16
+
+
 def __get_emission_boundary(settings, fluidsim):
     dims = fluidsim.get_simulation_dimensions()
     bounds = AABB(0.0, 0.0, 0.0, dims.x, dims.y, dims.z)
@@ -968,6 +977,12 @@ def __initialize_fluid_simulation_settings(fluidsim, data):
         fluidsim.enable_whitewater_lifetime_attribute = \
             __get_parameter_data(whitewater.enable_lifetime_attribute, frameno)
 
+        fluidsim.enable_whitewater_chunked_output = \
+            __get_parameter_data(whitewater.enable_chunked_whitewater_cache, frameno)
+
+        cache_precision = __get_parameter_data(whitewater.whitewater_cache_precision, frameno)
+        fluidsim.whitewater_chunked_output_bits = __get_whitewater_cache_precision_bits(cache_precision)
+
         is_generating_whitewater = __get_parameter_data(whitewater.enable_whitewater_emission, frameno)
         fluidsim.enable_diffuse_particle_emission = is_generating_whitewater
 
@@ -1232,6 +1247,9 @@ def __initialize_fluid_simulation_settings(fluidsim, data):
         num_chunks = __get_parameter_data(surface.compute_chunks_fixed, frameno)
     fluidsim.num_polygonizer_slices = num_chunks
 
+    fluidsim.enable_surface_mesh_streaming = \
+        __get_parameter_data(surface.enable_surface_mesh_streaming, frameno)
+
     particle_scale = __get_parameter_data(surface.particle_scale, frameno)
     particle_scale *= surface.native_particle_scale
     fluidsim.marker_particle_scale = particle_scale
@@ -1349,6 +1367,12 @@ def __initialize_fluid_simulation_settings(fluidsim, data):
 
     fluidsim.enable_static_solid_levelset_precomputation = \
         __get_parameter_data(advanced.precompute_static_obstacles, frameno)
+    fluidsim.enable_static_solid_levelset_multi_resolution = \
+        __get_parameter_data(advanced.multi_resolution_static_obstacles, frameno)
+    if __get_parameter_data(advanced.cache_static_obstacles, frameno):
+        staticsdf_directory = os.path.join(__get_cache_directory(), "staticsdf")
+        __limit_static_obstacle_cache(staticsdf_directory)
+        fluidsim.set_static_solid_levelset_cache_directory(staticsdf_directory)
 
     fluidsim.enable_temporary_mesh_levelset = \
         __get_parameter_data(advanced.reserve_temporary_grids, frameno)
@@ -2297,6 +2321,9 @@ def __update_animatable_domain_properties(fluidsim, data, frameno):
     precomp_static_sdf = __get_parameter_data(advanced.precompute_static_obstacles, frameno)
     __set_property(fluidsim, 'enable_static_solid_levelset_precomputation', precomp_static_sdf)
 
+    multires_static_sdf = __get_parameter_data(advanced.multi_resolution_static_obstacles, frameno)
+    __set_property(fluidsim, 'enable_static_solid_levelset_multi_resolution', multires_static_sdf)
+
     reserve_temp_grids = __get_parameter_data(advanced.reserve_temporary_grids, frameno)
     __set_property(fluidsim, 'enable_temporary_mesh_levelset', reserve_temp_grids)
 
@@ -2356,7 +2383,60 @@ def __write_bounds_data(cache_directory, fluidsim, frameno):
         f.write(bounds_json)
 
 
+def __limit_static_obstacle_cache(staticsdf_directory, max_files=4):
+    # Each change to the static obstacles writes a new cache file. Only the 
+    # most recently written files are kept.
+    if not os.path.isdir(staticsdf_directory):
+        return
+
+    filepaths = []
+    for filename in os.listdir(staticsdf_directory):
+        if filename.startswith("staticsdf_") and filename.endswith(".data"):
+            filepaths.append(os.path.join(staticsdf_directory, filename))
+    filepaths.sort(key=lambda f: os.path.getmtime(f), reverse=True)
+
+    try:
+        for filepath in filepaths[max_files:]:
+            fpl.delete_file(filepath, display_popup_on_error=False)
+    except Exception as e:
+        print("FLIP Fluids: OS/Filesystem Error: Unable to delete older static obstacle cache files from storage")
+        print("Error Message: ", e)
+
+
+def __get_surface_mesh_streaming_filepath(frameno):
+    fstring = __frame_number_to_string(frameno)
+    return os.path.join(__get_cache_directory(), "temp", "surfacestream" + fstring + ".bobj")
+
+
+def __write_streamed_surface_data(cache_directory, fluidsim, frameno):
+    # The engine has already written the surface to disk as a sequence of
+    # BOBJ chunk records. Surface attributes are not generated when streaming.
+    # If the stream file could not be written, the engine falls back to
+    # outputting the surface to memory.
+    fstring = __frame_number_to_string(frameno)
+
+    surface_filename = fstring + ".bobj"
+    surface_filepath = os.path.join(cache_directory, "bakefiles", surface_filename)
+    stream_filepath = __get_surface_mesh_streaming_filepath(frameno)
+    if os.path.isfile(stream_filepath):
+        os.replace(stream_filepath, surface_filepath)
+    else:
+        filedata = fluidsim.get_surface_data()
+        with open(surface_filepath, 'wb') as f:
+            f.write(filedata)
+
+    preview_filename = "preview" + fstring + ".bobj"
+    preview_filepath = os.path.join(cache_directory, "bakefiles", preview_filename)
+    filedata = fluidsim.get_surface_preview_data()
+    with open(preview_filepath, 'wb') as f:
+        f.write(filedata)
+
+
 def __write_surface_data(cache_directory, fluidsim, frameno):
+    if fluidsim.enable_surface_mesh_streaming:
+        __write_streamed_surface_data(cache_directory, fluidsim, frameno)
+        return
+
     fstring = __frame_number_to_string(frameno)
 
     surface_filename = fstring + ".bobj"
@@ -3268,6 +3348,9 @@ def __run_simulation(fluidsim, data, cache_directory, bakedata):
             geometry_database.close()
             raise Exception
 
+        stream_filepath = __get_surface_mesh_streaming_filepath(blender_frameno)
+        fluidsim.set_surface_mesh_streaming_filepath(stream_filepath)
+
         dt = __get_current_frame_delta_time(domain, simulator_frameno)
         fluidsim.update(dt)
 
@@ -238,6 +238,10 @@ def clear_cache_directory(cache_directory, clear_export=False, clear_logs=False,
     extensions = [".bat", ".sh", ".txt"]
     delete_files_in_directory(scripts_dir, extensions, remove_directory=True)
 
+    staticsdf_dir = os.path.join(cache_directory, "staticsdf")
+    extensions = [".data"]
+    delete_files_in_directory(staticsdf_dir, extensions, remove_directory=True)
+
     savestates_dir = os.path.join(cache_directory, "savestates")
     if os.path.isdir(savestates_dir):
         extensions = [".data", ".state", ".backup"]
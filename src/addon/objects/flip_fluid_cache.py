@@ -32,6 +32,7 @@ from ..operators import draw_particles_operators
 from ..operators import draw_force_field_operators
 from ..operators import helper_operators
 from ..utils import version_compatibility_utils as vcu
+from ..utils import whitewater_cache_utils
 
 DISABLE_MESH_CACHE_LOAD = False
 GL_POINT_CACHE_DATA = {}
@@ -1125,26 +1126,43 @@ class FlipFluidMeshCache(bpy.types.PropertyGroup):
         if len(bobj_data) == 0:
             return [], []
 
+        # A streamed surface mesh is stored as a sequence of BOBJ chunk records
+        # that are concatenated into a single mesh
+        vertex_chunks = []
+        triangle_chunks = []
+        vertex_count = 0
         data_offset = 0
-        num_vertices = struct.unpack_from('i', bobj_data, data_offset)[0]
-        data_offset += 4
+        while data_offset < len(bobj_data):
+            num_vertices = struct.unpack_from('i', bobj_data, data_offset)[0]
+            data_offset += 4
 
-        num_floats = 3 * num_vertices
-        num_bytes = 4 * num_floats
+            num_floats = 3 * num_vertices
+            num_bytes = 4 * num_floats
 
-        vertices = np.fromfile(filename, dtype=np.float32, count=num_floats, offset=data_offset)
+            vertices = np.fromfile(filename, dtype=np.float32, count=num_floats, offset=data_offset)
 
-        data_offset += num_bytes
+            data_offset += num_bytes
 
-        num_triangles = struct.unpack_from('i', bobj_data, data_offset)[0]
-        data_offset += 4
+            num_triangles = struct.unpack_from('i', bobj_data, data_offset)[0]
+            data_offset += 4
 
-        num_ints = 3 * num_triangles
-        num_bytes = 4 * num_ints
+            num_ints = 3 * num_triangles
+            num_bytes = 4 * num_ints
 
-        triangles = np.fromfile(filename, dtype=np.int32, count=num_ints, offset=data_offset)
+            triangles = np.fromfile(filename, dtype=np.int32, count=num_ints, offset=data_offset)
 
-        return vertices, triangles
+            data_offset += num_bytes
+
+            if vertex_count > 0:
+                triangles += vertex_count
+            vertex_chunks.append(vertices)
+            triangle_chunks.append(triangles)
+            vertex_count += num_vertices
+
+        if len(vertex_chunks) == 1:
+            return vertex_chunks[0], triangle_chunks[0]
+
+        return np.concatenate(vertex_chunks), np.concatenate(triangle_chunks)
 
 
     def import_ffp3(self, filename, pct_surface=1.0, pct_boundary=1.0, pct_interior=1.0, attribute_type='ATTRIBUTE_TYPE_UNKNOWN'):
@@ -1248,6 +1266,12 @@ class FlipFluidMeshCache(bpy.types.PropertyGroup):
         if len(wwp_data) == 0:
             return [], []
 
+        if whitewater_cache_utils.is_chunked_whitewater_data(wwp_data):
+            vertices = whitewater_cache_utils.read_chunked_whitewater_data(wwp_data, pct)
+            if len(vertices) == 0:
+                return [], []
+            return vertices, []
+
         dataidx = int(math.ceil((pct / 100) * 255))
         num_vertices = struct.unpack_from('i', wwp_data, dataidx * 4)[0] + 1
         if num_vertices <= 0:
@@ -1271,6 +1295,12 @@ class FlipFluidMeshCache(bpy.types.PropertyGroup):
         if len(wwi_data) == 0:
             return [], []
 
+        if whitewater_cache_utils.is_chunked_whitewater_data(wwi_data):
+            values = whitewater_cache_utils.read_chunked_whitewater_data(wwi_data, pct)
+            if len(values) == 0:
+                return [], []
+            return values, []
+
         dataidx = int(math.ceil((pct / 100) * 255))
         num_vertices = struct.unpack_from('i', wwi_data, dataidx * 4)[0] + 1
         if num_vertices <= 0:
@@ -1294,6 +1324,12 @@ class FlipFluidMeshCache(bpy.types.PropertyGroup):
         if len(wwi_data) == 0:
             return [], []
 
+        if whitewater_cache_utils.is_chunked_whitewater_data(wwi_data):
+            values = whitewater_cache_utils.read_chunked_whitewater_data(wwi_data, pct)
+            if len(values) == 0:
+                return [], []
+            return values, []
+
         dataidx = int(math.ceil((pct / 100) * 255))
         num_vertices = struct.unpack_from('i', wwi_data, dataidx * 4)[0] + 1
         if num_vertices <= 0:
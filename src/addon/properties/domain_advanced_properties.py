@@ -196,6 +196,22 @@ class DomainAdvancedProperties(bpy.types.PropertyGroup):
                 " more RAM if enabled",
             default = True,
             )
+    cache_static_obstacles: BoolProperty(
+            name="Cache Static Obstacles",
+            description="Store precomputed static obstacle data in the cache"
+                " directory and reuse it when the simulation is resumed or"
+                " re-baked with unchanged static obstacles. Requires Precompute"
+                " Static Obstacles. Uses additional disk space",
+            default = False,
+            )
+    multi_resolution_static_obstacles: BoolProperty(
+            name="Multi-Resolution Static Obstacles",
+            description="Compute precomputed static obstacle data at full"
+                " resolution only near the fluid and at a coarser resolution"
+                " elsewhere. Decreases the time and memory needed to precompute"
+                " large static obstacles. Requires Precompute Static Obstacles",
+            default = False,
+            )
     reserve_temporary_grids: BoolProperty(
             name="Reserve Temporary Grid Memory",
             description="Reserve space in memory for temporary grids. Increases"
@@ -244,6 +260,8 @@ class DomainAdvancedProperties(bpy.types.PropertyGroup):
         add(path + ".enable_asynchronous_meshing",               "Async Meshing",                      group_id=1)
         add(path + ".enable_fracture_optimization",              "Enable Fracture Optimization",        group_id=1)
         add(path + ".precompute_static_obstacles",               "Precompute Static Obstacles",        group_id=1)
+        add(path + ".cache_static_obstacles",                    "Cache Static Obstacles",             group_id=1)
+        add(path + ".multi_resolution_static_obstacles",         "Multi-Resolution Static Obstacles",  group_id=1)
         add(path + ".reserve_temporary_grids",                   "Reserve Temporary Grid Memory",      group_id=1)
         add(path + ".disable_changing_topology_warning",         "Disable Changing Topology Warning",  group_id=1)
 
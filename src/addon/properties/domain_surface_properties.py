@@ -73,6 +73,16 @@ class DomainSurfaceProperties(bpy.types.PropertyGroup):
             default='COMPUTE_CHUNK_MODE_AUTO',
             options={'HIDDEN'},
             )
+    enable_surface_mesh_streaming: BoolProperty(
+            name="Stream Surface Mesh",
+            description="Write each compute chunk of the surface mesh to the"
+                " cache as soon as it is generated instead of holding the whole"
+                " mesh in memory. Reduces memory usage when used with multiple"
+                " compute chunks. Motion blur data and surface attributes are"
+                " not generated while this option is enabled",
+            default=False,
+            options={'HIDDEN'},
+            )
     meshing_volume_mode: EnumProperty(
             name="Meshing Volume Mode",
             description="Determing which parts of the fluid will be meshed",
@@ -389,6 +399,7 @@ class DomainSurfaceProperties(bpy.types.PropertyGroup):
         add(path + ".particle_scale",                                     "Particle Scale",                                 group_id=0)
         add(path + ".compute_chunk_mode",                                 "Compute Chunk Mode",                             group_id=0)
         add(path + ".compute_chunks_fixed",                               "Num Compute Chunks (fixed)",                     group_id=0)
+        add(path + ".enable_surface_mesh_streaming",                      "Stream Surface Mesh",                            group_id=0)
         add(path + ".meshing_volume_mode",                                "Meshing Volume Mode",                            group_id=0)
         add(path + ".export_animated_meshing_volume_object",              "Export Animated Mesh",                           group_id=0)
         add(path + ".enable_meshing_offset",                              "Enable Obstacle Meshing",                        group_id=0)
@@ -121,6 +121,21 @@ class DomainWhitewaterProperties(bpy.types.PropertyGroup):
             default=False,
             options={'HIDDEN'},
             )
+    enable_chunked_whitewater_cache: BoolProperty(
+            name="Compact Whitewater Cache",
+            description="Write whitewater particles and attributes in a compact format. Particles"
+                " are grouped into spatial chunks and their values are quantized to the range of"
+                " their chunk. Reduces whitewater cache size and load times on large particle"
+                " counts",
+            default=False,
+            )
+    whitewater_cache_precision: EnumProperty(
+            name="Whitewater Cache Precision",
+            description="Number of bits used to store each component of a whitewater position"
+                " or attribute value in the compact whitewater cache",
+            items=types.whitewater_cache_precisions,
+            default='WHITEWATER_CACHE_PRECISION_16',
+            )
     enable_whitewater_emission: bpy.props.BoolProperty(
             name="Enable Whitewater Emission",
             description="Allow whitewater emitters to generate new particles",
@@ -517,6 +532,8 @@ class DomainWhitewaterProperties(bpy.types.PropertyGroup):
         add(path + ".enable_velocity_vector_attribute",         "Generate Velocity Attributes",   group_id=0)
         add(path + ".enable_id_attribute",                      "Generate ID Attributes",         group_id=0)
         add(path + ".enable_lifetime_attribute",                "Generate Lifetime Attributes",   group_id=0)
+        add(path + ".enable_chunked_whitewater_cache",          "Compact Whitewater Cache",       group_id=0)
+        add(path + ".whitewater_cache_precision",               "Whitewater Cache Precision",     group_id=0)
         add(path + ".enable_whitewater_emission",               "Enable Emission",                group_id=0)
         add(path + ".whitewater_emitter_generation_rate",       "Emission Rate",                  group_id=0)
         add(path + ".wavecrest_emission_rate",                  "Wavecrest Emission Rate",        group_id=0)
@@ -138,6 +138,12 @@ whitewater_ui_modes = (
     ('WHITEWATER_UI_MODE_ADVANCED', "Advanced", "Display all whitewater simulation parameters. Advanced settings will be highlighted in red by default. For most simulations, you will not need to change these settings from their defaults.")
     )
 
+whitewater_cache_precisions = (
+    ('WHITEWATER_CACHE_PRECISION_8',    "8-bit",  "Store whitewater positions and attributes with 8 bits per component. Smallest cache size with visible quantization on large particle chunks"),
+    ('WHITEWATER_CACHE_PRECISION_16',   "16-bit", "Store whitewater positions and attributes with 16 bits per component"),
+    ('WHITEWATER_CACHE_PRECISION_FULL', "Full",   "Store whitewater positions and attributes as unquantized 32-bit floats")
+    )
+
 cache_info_modes = (
     ('CACHE_INFO', "Cache Info", "Display info about the entire simulation cache"),
     ('FRAME_INFO', "Frame Info", "Display info about a single simulation frame")
@@ -47,6 +47,12 @@ def _draw_geometry_attributes_menu(self, context):
         column.prop(wprops, "enable_id_attribute")
         column.prop(wprops, "enable_lifetime_attribute")
         column.separator()
+        row = column.row(align=True)
+        row.prop(wprops, "enable_chunked_whitewater_cache")
+        row = row.row(align=True)
+        row.enabled = wprops.enable_chunked_whitewater_cache
+        row.prop(wprops, "whitewater_cache_precision", text="")
+        column.separator()
         column.operator("flip_fluid_operators.helper_initialize_motion_blur")
     else:
         row = row.row(align=True)
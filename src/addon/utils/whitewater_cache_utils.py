@@ -0,0 +1,231 @@
+# Blender FLIP Fluids Add-on
+# Copyright (C) 2026 Ryan L. Guy & Dennis Fassbaender
+# 
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+# 
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+# 
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+# Reader and writer for the chunked whitewater file format (WWC). The format
+# is described in src/engine/whitewaterchunkedfile.h. Chunked files are 
+# written with the .wwp, .wwi and .wwf extensions and are identified by the
+# magic bytes at the start of the file.
+
+import struct
+import numpy as np
+
+
+MAGIC = b'WWC\xff'
+FILE_VERSION = 1
+HEADER_SIZE = 32
+CHUNK_INFO_SIZE = 64
+DATA_ALIGNMENT = 8
+
+VALUE_TYPE_VECTOR = 0
+VALUE_TYPE_FLOAT = 1
+VALUE_TYPE_INT = 2
+
+CHUNK_INFO_DTYPE = np.dtype([
+        ('position_min', '<f4', 3),
+        ('position_max', '<f4', 3),
+        ('value_min', '<f4', 3),
+        ('value_max', '<f4', 3),
+        ('data_offset', '<u8'),
+        ('num_particles', '<u4'),
+        ('reserved', '<u4')
+        ])
+
+
+def is_chunked_whitewater_data(data):
+    return len(data) >= HEADER_SIZE and data[0:4] == MAGIC
+
+
+def read_header(data):
+    if not is_chunked_whitewater_data(data):
+        return None
+
+    version, value_type, component_bits, num_particles, num_chunks, id_limit, _ = struct.unpack_from('<7I', data, 4)
+    if version != FILE_VERSION or component_bits not in (8, 16, 32) or id_limit == 0:
+        return None
+
+    header = {}
+    header["value_type"] = value_type
+    header["component_bits"] = component_bits
+    header["num_particles"] = num_particles
+    header["num_chunks"] = num_chunks
+    header["id_limit"] = id_limit
+    return header
+
+
+def read_chunk_table(data, header):
+    offset = HEADER_SIZE + 4 * header["id_limit"]
+    return np.frombuffer(data, dtype=CHUNK_INFO_DTYPE, count=header["num_chunks"], offset=offset)
+
+
+def read_chunked_whitewater_data(data, pct, region=None):
+    # pct is in range [0, 100] and selects the same particle subset as the 
+    # WWP import percentage. region is an optional (min, max) pair of points,
+    # chunks with position bounds outside of the region are skipped. Vector 
+    # values are returned as a flat float32 array.
+    header = read_header(data)
+    if header is None:
+        raise ValueError("Invalid or unsupported chunked whitewater file data")
+
+    value_type = header["value_type"]
+    is_int_data = value_type == VALUE_TYPE_INT
+    empty_values = np.empty(0, dtype=np.int32 if is_int_data else np.float32)
+    if pct <= 0 or header["num_chunks"] == 0:
+        return empty_values
+
+    id_limit = header["id_limit"]
+    id_bin = int(np.ceil((min(pct, 100) / 100) * (id_limit - 1)))
+    num_components = 3 if value_type == VALUE_TYPE_VECTOR else 1
+    component_bits = header["component_bits"]
+    max_quantized = float((1 << component_bits) - 1) if component_bits < 32 else 0.0
+    quantized_dtype = {8: np.dtype('<u1'), 16: np.dtype('<u2'), 32: np.dtype('<f4')}[component_bits]
+    if is_int_data:
+        quantized_dtype = np.dtype('<i4')
+
+    chunk_values = []
+    for chunk in read_chunk_table(data, header):
+        if region is not None:
+            rmin, rmax = region
+            if (np.any(chunk['position_max'] < np.asarray(rmin, dtype=np.float32)) or 
+                    np.any(chunk['position_min'] > np.asarray(rmax, dtype=np.float32))):
+                continue
+
+        data_offset = int(chunk['data_offset'])
+        num_particles = struct.unpack_from('<I', data, data_offset + 4 * id_bin)[0]
+        num_particles = min(num_particles, int(chunk['num_particles']))
+        if num_particles == 0:
+            continue
+
+        values = np.frombuffer(data, dtype=quantized_dtype, count=num_particles * num_components, 
+                               offset=data_offset + 4 * id_limit)
+        if is_int_data or component_bits == 32:
+            chunk_values.append(values)
+            continue
+
+        value_min = chunk['value_min'][:num_components]
+        value_max = chunk['value_max'][:num_components]
+        scale = (value_max - value_min) / np.float32(max_quantized)
+        values = values.reshape(-1, num_components).astype(np.float32) * scale + value_min
+        chunk_values.append(values.astype(np.float32).ravel())
+
+    if not chunk_values:
+        return empty_values
+    return np.concatenate(chunk_values)
+
+
+def read_chunked_whitewater_file(filename, pct, region=None):
+    with open(filename, "rb") as f:
+        data = f.read()
+    return read_chunked_whitewater_data(data, pct, region)
+
+
+def _expand_bits(v):
+    v = v.astype(np.uint64)
+    v = (v * 0x00010001) & 0xFF0000FF
+    v = (v * 0x00000101) & 0x0F00F00F
+    v = (v * 0x00000011) & 0xC30C30C3
+    v = (v * 0x00000005) & 0x49249249
+    return v
+
+
+def _get_morton_codes(positions):
+    pmin = positions.min(axis=0)
+    size = positions.max(axis=0) - pmin
+    invsize = np.divide(1.0, size, out=np.zeros_like(size), where=size > 0)
+    cells = np.clip((positions - pmin) * invsize * np.float32(1023), 0, 1023).astype(np.uint32)
+    return (_expand_bits(cells[:, 2]) << 2) | (_expand_bits(cells[:, 1]) << 1) | _expand_bits(cells[:, 0])
+
+
+def encode_chunked_whitewater_data(values, positions, ids, value_type, 
+                                   component_bits=16, chunk_size=65536, id_limit=256):
+    # values, positions and ids describe the same particles. Files encoded 
+    # from the same positions and ids share a particle order.
+    positions = np.asarray(positions, dtype=np.float32).reshape(-1, 3)
+    ids = np.asarray(ids, dtype=np.int64).ravel()
+    num_particles = len(positions)
+    num_components = 3 if value_type == VALUE_TYPE_VECTOR else 1
+    if value_type == VALUE_TYPE_INT:
+        component_bits = 32
+        values = np.asarray(values, dtype=np.int32).reshape(-1, 1)
+    else:
+        values = np.asarray(values, dtype=np.float32).reshape(-1, num_components)
+    if component_bits not in (8, 16, 32):
+        raise ValueError("component_bits must be 8, 16, or 32")
+    if len(values) != num_particles or len(ids) != num_particles:
+        raise ValueError("values, positions, and ids must have the same length")
+
+    num_chunks = (num_particles + chunk_size - 1) // chunk_size
+    if num_particles > 0:
+        morton_order = np.argsort(_get_morton_codes(positions), kind='stable')
+        chunk_index = np.arange(num_particles) // chunk_size
+        order = morton_order[np.lexsort((np.arange(num_particles), ids[morton_order], chunk_index))]
+    else:
+        order = np.empty(0, dtype=np.int64)
+
+    value_bytes = component_bits // 8
+    table_end = HEADER_SIZE + 4 * id_limit + CHUNK_INFO_SIZE * num_chunks
+    data_offset = (table_end + DATA_ALIGNMENT - 1) // DATA_ALIGNMENT * DATA_ALIGNMENT
+
+    chunk_table = np.zeros(num_chunks, dtype=CHUNK_INFO_DTYPE)
+    chunk_data = []
+    total_id_counts = np.zeros(id_limit, dtype=np.uint32)
+    for cidx in range(num_chunks):
+        chunk_order = order[cidx * chunk_size:min((cidx + 1) * chunk_size, num_particles)]
+        chunk_positions = positions[chunk_order]
+        chunk_values = values[chunk_order]
+        id_counts = np.cumsum(np.bincount(ids[chunk_order], minlength=id_limit)[:id_limit]).astype(np.uint32)
+        total_id_counts += np.diff(id_counts, prepend=np.uint32(0)).astype(np.uint32)
+
+        info = chunk_table[cidx]
+        info['position_min'] = chunk_positions.min(axis=0)
+        info['position_max'] = chunk_positions.max(axis=0)
+        info['data_offset'] = data_offset
+        info['num_particles'] = len(chunk_order)
+
+        if value_type == VALUE_TYPE_INT:
+            encoded = chunk_values.astype('<i4')
+        elif component_bits == 32:
+            encoded = chunk_values.astype('<f4')
+        else:
+            vmin = chunk_values.min(axis=0)
+            vmax = chunk_values.max(axis=0)
+            info['value_min'][:num_components] = vmin
+            info['value_max'][:num_components] = vmax
+            max_quantized = np.float32((1 << component_bits) - 1)
+            scale = np.divide(max_quantized, vmax - vmin, out=np.zeros_like(vmin), where=vmax > vmin)
+            quantized = np.clip(np.floor((chunk_values - vmin) * scale + np.float32(0.5)), 0, max_quantized)
+            encoded = quantized.astype('<u2' if component_bits == 16 else '<u1')
+
+        block = id_counts.astype('<u4').tobytes() + encoded.tobytes()
+        padding = (DATA_ALIGNMENT - len(block) % DATA_ALIGNMENT) % DATA_ALIGNMENT
+        block += b'\x00' * padding
+        chunk_data.append(block)
+        data_offset += len(block)
+
+    cumulative_id_counts = np.cumsum(total_id_counts).astype('<u4')
+    header = MAGIC + struct.pack('<7I', FILE_VERSION, value_type, component_bits, 
+                                 num_particles, num_chunks, id_limit, 0)
+    table = header + cumulative_id_counts.tobytes() + chunk_table.tobytes()
+    table += b'\x00' * ((DATA_ALIGNMENT - len(table) % DATA_ALIGNMENT) % DATA_ALIGNMENT)
+    return table + b''.join(chunk_data)
+
+
+def write_chunked_whitewater_file(filename, values, positions, ids, value_type, 
+                                  component_bits=16, chunk_size=65536, id_limit=256):
+    data = encode_chunked_whitewater_data(values, positions, ids, value_type, 
+                                          component_bits, chunk_size, id_limit)
+    with open(filename, 'wb') as f:
+        f.write(data)
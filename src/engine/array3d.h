@@ -29,6 +29,8 @@ SOFTWARE.
 #include <vector>
 #include <cmath>
 
+#include "float16.h"
+
 struct GridIndex {
     int i, j, k;
 
@@ -573,7 +575,7 @@ public:
             for (int j = 0; j < coarseGrid.height; j++) {
                 for (int i = 0; i < coarseGrid.width; i++) {
                     
-                    T sum = 0;
+                    double sum = 0.0;
                     int neighbours = 0;
                     for (int nk = 2*k - 1; nk <= 2*k + 1; nk++) {
                         for (int nj = 2*j - 1; nj <= 2*j + 1; nj++) {
@@ -585,7 +587,7 @@ public:
                             }
                         }
                     }
-                    coarseGrid.set(i, j, k, sum / (T)neighbours);
+                    coarseGrid.set(i, j, k, (T)(sum / (double)neighbours));
 
                 }
             }
@@ -258,7 +258,7 @@ private:
 
 
     int _blocksize = 1;
-    T _backgroundValue;
+    T _backgroundValue = T();
 
     Array3d<BlockData> _blockDataGrid;
     std::vector<T> _arraydata;
@@ -528,6 +528,42 @@ extern "C" {
         );
     }
 
+    EXPORTDLL void FluidSimulation_enable_surface_decimation(FluidSimulation* obj,
+                                                             int *err) {
+        CBindings::safe_execute_method_void_0param(
+            obj, &FluidSimulation::enableSurfaceDecimation, err
+        );
+    }
+
+    EXPORTDLL void FluidSimulation_disable_surface_decimation(FluidSimulation* obj,
+                                                              int *err) {
+        CBindings::safe_execute_method_void_0param(
+            obj, &FluidSimulation::disableSurfaceDecimation, err
+        );
+    }
+
+    EXPORTDLL int FluidSimulation_is_surface_decimation_enabled(FluidSimulation* obj,
+                                                                int *err) {
+        return CBindings::safe_execute_method_ret_0param(
+            obj, &FluidSimulation::isSurfaceDecimationEnabled, err
+        );
+    }
+
+    EXPORTDLL double FluidSimulation_get_surface_decimation_error_bound(FluidSimulation* obj, 
+                                                                        int *err) {
+        return CBindings::safe_execute_method_ret_0param(
+            obj, &FluidSimulation::getSurfaceDecimationErrorBound, err
+        );
+    }
+
+    EXPORTDLL void FluidSimulation_set_surface_decimation_error_bound(FluidSimulation* obj, 
+                                                                      double e,
+                                                                      int *err) {
+        CBindings::safe_execute_method_void_1param(
+            obj, &FluidSimulation::setSurfaceDecimationErrorBound, e, err
+        );
+    }
+
     EXPORTDLL void FluidSimulation_set_meshing_volume(FluidSimulation* obj, 
                                                       MeshObject *volume,
                                                      int *err) {
@@ -658,6 +694,83 @@ extern "C" {
         );
     }
 
+    EXPORTDLL void FluidSimulation_enable_surface_mesh_streaming(FluidSimulation* obj,
+                                                                 int *err) {
+        CBindings::safe_execute_method_void_0param(
+            obj, &FluidSimulation::enableSurfaceMeshStreaming, err
+        );
+    }
+
+    EXPORTDLL void FluidSimulation_disable_surface_mesh_streaming(FluidSimulation* obj,
+                                                                  int *err) {
+        CBindings::safe_execute_method_void_0param(
+            obj, &FluidSimulation::disableSurfaceMeshStreaming, err
+        );
+    }
+
+    EXPORTDLL int FluidSimulation_is_surface_mesh_streaming_enabled(FluidSimulation* obj,
+                                                                    int *err) {
+        return CBindings::safe_execute_method_ret_0param(
+            obj, &FluidSimulation::isSurfaceMeshStreamingEnabled, err
+        );
+    }
+
+    EXPORTDLL void FluidSimulation_set_surface_mesh_streaming_filepath(FluidSimulation* obj, 
+                                                                      const char* c_filepath, 
+                                                                      int *err) {
+        std::string cpp_filepath(c_filepath);
+
+        *err = CBindings::SUCCESS;
+        try {
+            obj->setSurfaceMeshStreamingFilepath(cpp_filepath);
+        } catch (std::exception &ex) {
+            CBindings::set_error_message(ex);
+            *err = CBindings::FAIL;
+        }
+    }
+
+    EXPORTDLL void FluidSimulation_enable_surface_mesh_temporal_cache(FluidSimulation* obj,
+                                                                      int *err) {
+        CBindings::safe_execute_method_void_0param(
+            obj, &FluidSimulation::enableSurfaceMeshTemporalCache, err
+        );
+    }
+
+    EXPORTDLL void FluidSimulation_disable_surface_mesh_temporal_cache(FluidSimulation* obj,
+                                                                       int *err) {
+        CBindings::safe_execute_method_void_0param(
+            obj, &FluidSimulation::disableSurfaceMeshTemporalCache, err
+        );
+    }
+
+    EXPORTDLL int FluidSimulation_is_surface_mesh_temporal_cache_enabled(FluidSimulation* obj,
+                                                                         int *err) {
+        return CBindings::safe_execute_method_ret_0param(
+            obj, &FluidSimulation::isSurfaceMeshTemporalCacheEnabled, err
+        );
+    }
+
+    EXPORTDLL void FluidSimulation_enable_surface_anisotropic_kernels(FluidSimulation* obj,
+                                                                      int *err) {
+        CBindings::safe_execute_method_void_0param(
+            obj, &FluidSimulation::enableSurfaceAnisotropicKernels, err
+        );
+    }
+
+    EXPORTDLL void FluidSimulation_disable_surface_anisotropic_kernels(FluidSimulation* obj,
+                                                                       int *err) {
+        CBindings::safe_execute_method_void_0param(
+            obj, &FluidSimulation::disableSurfaceAnisotropicKernels, err
+        );
+    }
+
+    EXPORTDLL int FluidSimulation_is_surface_anisotropic_kernels_enabled(FluidSimulation* obj,
+                                                                         int *err) {
+        return CBindings::safe_execute_method_ret_0param(
+            obj, &FluidSimulation::isSurfaceAnisotropicKernelsEnabled, err
+        );
+    }
+
     EXPORTDLL void FluidSimulation_enable_preview_mesh_output(FluidSimulation* obj,
                                                               double dx,
                                                               int *err) {
@@ -779,6 +892,42 @@ extern "C" {
         );
     }
 
+    EXPORTDLL void FluidSimulation_enable_whitewater_chunked_output(FluidSimulation* obj,
+                                                                    int *err) {
+        CBindings::safe_execute_method_void_0param(
+            obj, &FluidSimulation::enableWhitewaterChunkedOutput, err
+        );
+    }
+
+    EXPORTDLL void FluidSimulation_disable_whitewater_chunked_output(FluidSimulation* obj,
+                                                                     int *err) {
+        CBindings::safe_execute_method_void_0param(
+            obj, &FluidSimulation::disableWhitewaterChunkedOutput, err
+        );
+    }
+
+    EXPORTDLL int FluidSimulation_is_whitewater_chunked_output_enabled(FluidSimulation* obj,
+                                                                       int *err) {
+        return CBindings::safe_execute_method_ret_0param(
+            obj, &FluidSimulation::isWhitewaterChunkedOutputEnabled, err
+        );
+    }
+
+    EXPORTDLL int FluidSimulation_get_whitewater_chunked_output_bits(FluidSimulation* obj,
+                                                                     int *err) {
+        return CBindings::safe_execute_method_ret_0param(
+            obj, &FluidSimulation::getWhitewaterChunkedOutputBits, err
+        );
+    }
+
+    EXPORTDLL void FluidSimulation_set_whitewater_chunked_output_bits(FluidSimulation* obj,
+                                                                      int bits,
+                                                                      int *err) {
+        CBindings::safe_execute_method_void_1param(
+            obj, &FluidSimulation::setWhitewaterChunkedOutputBits, bits, err
+        );
+    }
+
     EXPORTDLL void FluidSimulation_enable_whitewater_velocity_attribute(FluidSimulation* obj,
                                                                         int *err) {
         CBindings::safe_execute_method_void_0param(
@@ -1854,6 +2003,19 @@ extern "C" {
         );
     }
 
+    EXPORTDLL int FluidSimulation_get_diffuse_particle_random_seed(FluidSimulation* obj, int *err) {
+        return CBindings::safe_execute_method_ret_0param(
+            obj, &FluidSimulation::getDiffuseParticleRandomSeed, err
+        );
+    }
+
+    EXPORTDLL void FluidSimulation_set_diffuse_particle_random_seed(FluidSimulation* obj, 
+                                                                    int seed, int *err) {
+        CBindings::safe_execute_method_void_1param(
+            obj, &FluidSimulation::setDiffuseParticleRandomSeed, seed, err
+        );
+    }
+
     EXPORTDLL double FluidSimulation_get_min_diffuse_emitter_energy(FluidSimulation* obj, int *err) {
         return CBindings::safe_execute_method_ret_0param(
             obj, &FluidSimulation::getMinDiffuseEmitterEnergy, err
@@ -1965,6 +2127,71 @@ extern "C" {
         );
     }
 
+    EXPORTDLL void FluidSimulation_enable_diffuse_particle_budget_scheduler(FluidSimulation* obj,
+                                                                            int *err) {
+        CBindings::safe_execute_method_void_0param(
+            obj, &FluidSimulation::enableDiffuseParticleBudgetScheduler, err
+        );
+    }
+
+    EXPORTDLL void FluidSimulation_disable_diffuse_particle_budget_scheduler(FluidSimulation* obj,
+                                                                             int *err) {
+        CBindings::safe_execute_method_void_0param(
+            obj, &FluidSimulation::disableDiffuseParticleBudgetScheduler, err
+        );
+    }
+
+    EXPORTDLL int FluidSimulation_is_diffuse_particle_budget_scheduler_enabled(FluidSimulation* obj,
+                                                                               int *err) {
+        return CBindings::safe_execute_method_ret_0param(
+            obj, &FluidSimulation::isDiffuseParticleBudgetSchedulerEnabled, err
+        );
+    }
+
+    EXPORTDLL void FluidSimulation_add_diffuse_particle_importance_region(FluidSimulation* obj,
+                                                                          AABB_t bounds,
+                                                                          double importance,
+                                                                          int *err) {
+        AABB bounds_cpp = CBindings::to_class(bounds);
+
+        *err = CBindings::SUCCESS;
+        try {
+            obj->addDiffuseParticleImportanceRegion(bounds_cpp, importance);
+        } catch (std::exception &ex) {
+            CBindings::set_error_message(ex);
+            *err = CBindings::FAIL;
+        }
+    }
+
+    EXPORTDLL void FluidSimulation_clear_diffuse_particle_importance_regions(FluidSimulation* obj,
+                                                                             int *err) {
+        CBindings::safe_execute_method_void_0param(
+            obj, &FluidSimulation::clearDiffuseParticleImportanceRegions, err
+        );
+    }
+
+    EXPORTDLL int FluidSimulation_get_num_diffuse_particle_importance_regions(FluidSimulation* obj,
+                                                                              int *err) {
+        return CBindings::safe_execute_method_ret_0param(
+            obj, &FluidSimulation::getNumDiffuseParticleImportanceRegions, err
+        );
+    }
+
+    EXPORTDLL double FluidSimulation_get_diffuse_particle_background_importance(FluidSimulation* obj,
+                                                                                int *err) {
+        return CBindings::safe_execute_method_ret_0param(
+            obj, &FluidSimulation::getDiffuseParticleBackgroundImportance, err
+        );
+    }
+
+    EXPORTDLL void FluidSimulation_set_diffuse_particle_background_importance(FluidSimulation* obj,
+                                                                              double importance, 
+                                                                              int *err) {
+        CBindings::safe_execute_method_void_1param(
+            obj, &FluidSimulation::setDiffuseParticleBackgroundImportance, importance, err
+        );
+    }
+
     EXPORTDLL double FluidSimulation_get_min_diffuse_particle_lifetime(FluidSimulation* obj,
                                                                        int *err) {
         return CBindings::safe_execute_method_ret_0param(
@@ -3151,6 +3378,41 @@ extern "C" {
         );
     }
 
+    EXPORTDLL void FluidSimulation_set_static_solid_levelset_cache_directory(FluidSimulation* obj, 
+                                                                             const char* c_directory, 
+                                                                             int *err) {
+        std::string cpp_directory(c_directory);
+
+        *err = CBindings::SUCCESS;
+        try {
+            obj->setStaticSolidLevelSetCacheDirectory(cpp_directory);
+        } catch (std::exception &ex) {
+            CBindings::set_error_message(ex);
+            *err = CBindings::FAIL;
+        }
+    }
+
+    EXPORTDLL void FluidSimulation_enable_static_solid_levelset_multi_resolution(FluidSimulation* obj,
+                                                                                 int *err) {
+        CBindings::safe_execute_method_void_0param(
+            obj, &FluidSimulation::enableStaticSolidLevelSetMultiResolution, err
+        );
+    }
+
+    EXPORTDLL void FluidSimulation_disable_static_solid_levelset_multi_resolution(FluidSimulation* obj,
+                                                                                  int *err) {
+        CBindings::safe_execute_method_void_0param(
+            obj, &FluidSimulation::disableStaticSolidLevelSetMultiResolution, err
+        );
+    }
+
+    EXPORTDLL int FluidSimulation_is_static_solid_levelset_multi_resolution_enabled(FluidSimulation* obj,
+                                                                                    int *err) {
+        return CBindings::safe_execute_method_ret_0param(
+            obj, &FluidSimulation::isStaticSolidLevelSetMultiResolutionEnabled, err
+        );
+    }
+
     EXPORTDLL void FluidSimulation_enable_temporary_mesh_levelset(FluidSimulation* obj,
                                                                                int *err) {
         CBindings::safe_execute_method_void_0param(
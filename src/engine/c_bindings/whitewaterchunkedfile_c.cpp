@@ -0,0 +1,178 @@
+/*
+MIT License
+
+Copyright (C) 2026 Ryan L. Guy & Dennis Fassbaender
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#include <stdexcept>
+#include <cstring>
+
+#include "../whitewaterchunkedfile.h"
+#include "aabb_c.h"
+#include "cbindings.h"
+
+#ifdef _WIN32
+    #define EXPORTDLL __declspec(dllexport)
+#else
+    #define EXPORTDLL
+#endif
+
+
+static void _read_values(char *data, unsigned long long size, double pct, AABB_t *region,
+                         WhitewaterChunkedFile::ValueType type,
+                         std::vector<float> &values, std::vector<int> &intValues) {
+    std::vector<vmath::vec3> vectorValues;
+    bool success = false;
+    if (type == WhitewaterChunkedFile::ValueType::vector) {
+        if (region == nullptr) {
+            success = WhitewaterChunkedFile::readVectorData(data, size, pct, vectorValues);
+        } else {
+            AABB bbox = CBindings::to_class(*region);
+            success = WhitewaterChunkedFile::readVectorData(data, size, pct, bbox, vectorValues);
+        }
+        values.resize(3 * vectorValues.size());
+        for (size_t i = 0; i < vectorValues.size(); i++) {
+            values[3*i] = vectorValues[i].x;
+            values[3*i + 1] = vectorValues[i].y;
+            values[3*i + 2] = vectorValues[i].z;
+        }
+    } else if (type == WhitewaterChunkedFile::ValueType::scalar) {
+        if (region == nullptr) {
+            success = WhitewaterChunkedFile::readFloatData(data, size, pct, values);
+        } else {
+            AABB bbox = CBindings::to_class(*region);
+            success = WhitewaterChunkedFile::readFloatData(data, size, pct, bbox, values);
+        }
+    } else {
+        if (region == nullptr) {
+            success = WhitewaterChunkedFile::readIntData(data, size, pct, intValues);
+        } else {
+            AABB bbox = CBindings::to_class(*region);
+            success = WhitewaterChunkedFile::readIntData(data, size, pct, bbox, intValues);
+        }
+    }
+
+    if (!success) {
+        throw std::runtime_error("Error: invalid or unsupported chunked whitewater file data.\n");
+    }
+}
+
+
+extern "C" {
+
+    EXPORTDLL int WhitewaterChunkedFile_is_chunked_file_data(char *data, 
+                                                             unsigned long long size, 
+                                                             int *err) {
+        *err = CBindings::SUCCESS;
+        return (int)WhitewaterChunkedFile::isChunkedFileData(data, size);
+    }
+
+    EXPORTDLL int WhitewaterChunkedFile_get_value_type(char *data, 
+                                                       unsigned long long size, 
+                                                       int *err) {
+        *err = CBindings::SUCCESS;
+        WhitewaterChunkedFile::FileHeader header;
+        if (!WhitewaterChunkedFile::readFileHeader(data, size, header)) {
+            std::runtime_error ex("Error: invalid or unsupported chunked whitewater file data.\n");
+            CBindings::set_error_message(ex);
+            *err = CBindings::FAIL;
+            return -1;
+        }
+        return (int)header.valueType;
+    }
+
+    // Returns the number of particles that a read with the same parameters 
+    // decodes, region may be NULL. Vector reads write three floats per 
+    // particle.
+    EXPORTDLL int WhitewaterChunkedFile_get_num_particles(char *data, 
+                                                          unsigned long long size, 
+                                                          double pct,
+                                                          AABB_t *region,
+                                                          int *err) {
+        *err = CBindings::SUCCESS;
+        int result = 0;
+        try {
+            unsigned int numParticles = 0;
+            bool success;
+            if (region == nullptr) {
+                success = WhitewaterChunkedFile::readNumParticles(data, size, pct, numParticles);
+            } else {
+                AABB bbox = CBindings::to_class(*region);
+                success = WhitewaterChunkedFile::readNumParticles(data, size, pct, bbox, numParticles);
+            }
+
+            if (!success) {
+                throw std::runtime_error("Error: invalid or unsupported chunked whitewater file data.\n");
+            }
+            result = (int)numParticles;
+        } catch (std::exception &ex) {
+            CBindings::set_error_message(ex);
+            *err = CBindings::FAIL;
+        }
+
+        return result;
+    }
+
+    EXPORTDLL void WhitewaterChunkedFile_read_float_values(char *data, 
+                                                           unsigned long long size, 
+                                                           double pct,
+                                                           AABB_t *region,
+                                                           float *values,
+                                                           int *err) {
+        *err = CBindings::SUCCESS;
+        try {
+            WhitewaterChunkedFile::FileHeader header;
+            if (!WhitewaterChunkedFile::readFileHeader(data, size, header) ||
+                    header.valueType == WhitewaterChunkedFile::ValueType::integer) {
+                throw std::runtime_error("Error: invalid or unsupported chunked whitewater file data.\n");
+            }
+
+            std::vector<float> floatValues;
+            std::vector<int> intValues;
+            _read_values(data, size, pct, region, header.valueType, floatValues, intValues);
+            std::memcpy(values, floatValues.data(), floatValues.size() * sizeof(float));
+        } catch (std::exception &ex) {
+            CBindings::set_error_message(ex);
+            *err = CBindings::FAIL;
+        }
+    }
+
+    EXPORTDLL void WhitewaterChunkedFile_read_int_values(char *data, 
+                                                         unsigned long long size, 
+                                                         double pct,
+                                                         AABB_t *region,
+                                                         int *values,
+                                                         int *err) {
+        *err = CBindings::SUCCESS;
+        try {
+            std::vector<float> floatValues;
+            std::vector<int> intValues;
+            _read_values(data, size, pct, region, 
+                         WhitewaterChunkedFile::ValueType::integer, floatValues, intValues);
+            std::memcpy(values, intValues.data(), intValues.size() * sizeof(int));
+        } catch (std::exception &ex) {
+            CBindings::set_error_message(ex);
+            *err = CBindings::FAIL;
+        }
+    }
+
+}
@@ -25,6 +25,7 @@ SOFTWARE.
 #include "diffuseparticlesimulation.h"
 
 #include <cstring>
+#include <algorithm>
 
 #include "threadutils.h"
 #include "interpolation.h"
@@ -33,6 +34,7 @@ SOFTWARE.
 #include "particlelevelset.h"
 #include "meshobject.h"
 #include "forcefieldgrid.h"
+#include "influencegrid.h"
 
 DiffuseParticleSimulation::DiffuseParticleSimulation() {
     double inf = std::numeric_limits<float>::infinity();
@@ -56,6 +58,8 @@ void DiffuseParticleSimulation::update(DiffuseParticleSimulationParameters param
     _markerParticleRadius = params.markerParticleRadius;
     _CFLConditionNumber = params.CFLConditionNumber;
     _bodyForce = params.bodyForce;
+    _randomKey[0] = (unsigned int)params.frame;
+    _randomKey[1] = (unsigned int)params.frameTimeStep;
 
     _markerParticles = params.markerParticles;
     _vfield = params.vfield;
@@ -70,11 +74,12 @@ void DiffuseParticleSimulation::update(DiffuseParticleSimulationParameters param
     _nearSolidGridCellSize = params.nearSolidGridCellSize;
     _forceFieldGrid = params.forceFieldGrid;
     _isForceFieldGridSet = params.isForceFieldGridSet;
-
+    _isDiffuseParticleTypeCountsValid = false;
 
     bool isParticlesEnabled = _isFoamEnabled || _isBubblesEnabled || _isSprayEnabled || _isDustEnabled;
     bool emitParticles = _isDiffuseParticleEmissionEnabled && 
-                         _diffuseParticles.size() < _maxNumDiffuseParticles &&
+                         (_diffuseParticles.size() < _maxNumDiffuseParticles || 
+                                _isParticleBudgetSchedulerEnabled) &&
                          !_markerParticles->empty() &&
                          isParticlesEnabled;
 
@@ -86,6 +91,7 @@ void DiffuseParticleSimulation::update(DiffuseParticleSimulationParameters param
         _getDiffuseParticleEmitters(normalEmitters, dustEmitters);
         _emitNormalDiffuseParticles(normalEmitters, params.deltaTime);
         _emitDustDiffuseParticles(dustEmitters, params.deltaTime);
+        _limitNumDiffuseParticles();
     }
 
     if (_diffuseParticles.size() == 0.0) {
@@ -192,6 +198,8 @@ bool DiffuseParticleSimulation::isBoundaryDustEmissionEnabled() {
 }
 
 ParticleSystem* DiffuseParticleSimulation::getDiffuseParticles() {
+    // Particles may be modified through the returned pointer
+    _isDiffuseParticleTypeCountsValid = false;
     return &_diffuseParticles;
 }
 
@@ -254,6 +262,42 @@ void DiffuseParticleSimulation::setEmitterGenerationBounds(AABB bbox) {
     _emitterGenerationBounds = bbox;
 }
 
+void DiffuseParticleSimulation::enableParticleBudgetScheduler() {
+    _isParticleBudgetSchedulerEnabled = true;
+}
+
+void DiffuseParticleSimulation::disableParticleBudgetScheduler() {
+    _isParticleBudgetSchedulerEnabled = false;
+}
+
+bool DiffuseParticleSimulation::isParticleBudgetSchedulerEnabled() {
+    return _isParticleBudgetSchedulerEnabled;
+}
+
+void DiffuseParticleSimulation::addImportanceRegion(AABB bbox, float importance) {
+    FLUIDSIM_ASSERT(importance >= 0.0f);
+    _importanceRegions.push_back(bbox);
+    _importanceRegionWeights.push_back(importance);
+}
+
+void DiffuseParticleSimulation::clearImportanceRegions() {
+    _importanceRegions.clear();
+    _importanceRegionWeights.clear();
+}
+
+int DiffuseParticleSimulation::getNumImportanceRegions() {
+    return (int)_importanceRegions.size();
+}
+
+float DiffuseParticleSimulation::getBackgroundImportance() {
+    return _backgroundImportance;
+}
+
+void DiffuseParticleSimulation::setBackgroundImportance(float importance) {
+    FLUIDSIM_ASSERT(importance >= 0.0f);
+    _backgroundImportance = importance;
+}
+
 double DiffuseParticleSimulation::getEmitterGenerationRate() {
     return _emitterGenerationRate;
 }
@@ -264,6 +308,14 @@ void DiffuseParticleSimulation::setEmitterGenerationRate(double rate) {
     _emitterGenerationRate = rate;
 }
 
+int DiffuseParticleSimulation::getRandomSeed() {
+    return (int)_randomSeed;
+}
+
+void DiffuseParticleSimulation::setRandomSeed(int seed) {
+    _randomSeed = (unsigned int)seed;
+}
+
 double DiffuseParticleSimulation::getMinEmitterEnergy() {
     return _minParticleEnergy;
 }
@@ -645,6 +697,39 @@ double DiffuseParticleSimulation::getDomainScale() {
     return _domainScale;
 }
 
+void DiffuseParticleSimulation::enableChunkedFileFormat() {
+    _isChunkedFileFormatEnabled = true;
+}
+
+void DiffuseParticleSimulation::disableChunkedFileFormat() {
+    _isChunkedFileFormatEnabled = false;
+}
+
+bool DiffuseParticleSimulation::isChunkedFileFormatEnabled() {
+    return _isChunkedFileFormatEnabled;
+}
+
+void DiffuseParticleSimulation::setChunkedFileComponentBits(int bits) {
+    FLUIDSIM_ASSERT(bits == 8 || bits == 16 || bits == 32);
+    _chunkedFileComponentBits = bits;
+}
+
+int DiffuseParticleSimulation::getChunkedFileComponentBits() {
+    return _chunkedFileComponentBits;
+}
+
+void DiffuseParticleSimulation::beginChunkedFileOutput() {
+    _isChunkedFileLayoutCacheEnabled = true;
+    _isChunkedFileLayoutValid.assign(_isChunkedFileLayoutValid.size(), false);
+}
+
+void DiffuseParticleSimulation::endChunkedFileOutput() {
+    _isChunkedFileLayoutCacheEnabled = false;
+    _isChunkedFileLayoutValid.assign(_isChunkedFileLayoutValid.size(), false);
+    _chunkedFileLayouts.clear();
+    _chunkedFileLayouts.shrink_to_fit();
+}
+
 void DiffuseParticleSimulation::getDiffuseParticleFileDataWWP(std::vector<char> &data) {
     std::vector<vmath::vec3> positions;
     std::vector<unsigned char> ids;
@@ -673,7 +758,10 @@ void DiffuseParticleSimulation::getDiffuseParticleFileDataWWP(std::vector<char>
         }
     }
 
-    _getDiffuseParticleFileDataWWP(positions, ids, data);
+    WhitewaterChunkedFile::ChunkLayout localLayout;
+
+    WhitewaterChunkedFile::ChunkLayout &layout = _getChunkedFileLayout(DiffuseParticleType::notset, positions, ids, localLayout);
+    _getDiffuseParticleFileDataWWP(positions, layout, ids, data);
 }
 
 void DiffuseParticleSimulation::getFoamParticleFileDataWWP(std::vector<char> &data) {
@@ -710,7 +798,10 @@ void DiffuseParticleSimulation::getFoamParticleFileDataWWP(std::vector<char> &da
         }
     }
 
-    _getDiffuseParticleFileDataWWP(positions, ids, data);
+    WhitewaterChunkedFile::ChunkLayout localLayout;
+
+    WhitewaterChunkedFile::ChunkLayout &layout = _getChunkedFileLayout(DiffuseParticleType::foam, positions, ids, localLayout);
+    _getDiffuseParticleFileDataWWP(positions, layout, ids, data);
 }
 
 void DiffuseParticleSimulation::getBubbleParticleFileDataWWP(std::vector<char> &data) {
@@ -747,7 +838,10 @@ void DiffuseParticleSimulation::getBubbleParticleFileDataWWP(std::vector<char> &
         }
     }
 
-    _getDiffuseParticleFileDataWWP(positions, ids, data);
+    WhitewaterChunkedFile::ChunkLayout localLayout;
+
+    WhitewaterChunkedFile::ChunkLayout &layout = _getChunkedFileLayout(DiffuseParticleType::bubble, positions, ids, localLayout);
+    _getDiffuseParticleFileDataWWP(positions, layout, ids, data);
 }
 
 void DiffuseParticleSimulation::getSprayParticleFileDataWWP(std::vector<char> &data) {
@@ -785,7 +879,10 @@ void DiffuseParticleSimulation::getSprayParticleFileDataWWP(std::vector<char> &d
         }
     }
 
-    _getDiffuseParticleFileDataWWP(positions, ids, data);
+    WhitewaterChunkedFile::ChunkLayout localLayout;
+
+    WhitewaterChunkedFile::ChunkLayout &layout = _getChunkedFileLayout(DiffuseParticleType::spray, positions, ids, localLayout);
+    _getDiffuseParticleFileDataWWP(positions, layout, ids, data);
 }
 
 void DiffuseParticleSimulation::getDustParticleFileDataWWP(std::vector<char> &data) {
@@ -822,12 +919,16 @@ void DiffuseParticleSimulation::getDustParticleFileDataWWP(std::vector<char> &da
         }
     }
 
-    _getDiffuseParticleFileDataWWP(positions, ids, data);
+    WhitewaterChunkedFile::ChunkLayout localLayout;
+
+    WhitewaterChunkedFile::ChunkLayout &layout = _getChunkedFileLayout(DiffuseParticleType::dust, positions, ids, localLayout);
+    _getDiffuseParticleFileDataWWP(positions, layout, ids, data);
 }
 
 void DiffuseParticleSimulation::getFoamParticleBlurFileDataWWP(std::vector<char> &data, double dt) {
     std::vector<vmath::vec3> translations;
     std::vector<unsigned char> ids;
+    std::vector<vmath::vec3> positions;
     translations.reserve(_diffuseParticles.size());
     ids.reserve(_diffuseParticles.size());
 
@@ -850,6 +951,9 @@ void DiffuseParticleSimulation::getFoamParticleBlurFileDataWWP(std::vector<char>
                 vmath::vec3 t = _vfield->evaluateVelocityAtPositionLinear(p) * _domainScale * dt;
                 translations.push_back(t);
                 ids.push_back(particleIds->at(i));
+                if (_isChunkedFileFormatEnabled) {
+                    positions.push_back(particlePositions->at(i) * _domainScale + _domainOffset);
+                }
             }
         }
     } else {
@@ -859,16 +963,23 @@ void DiffuseParticleSimulation::getFoamParticleBlurFileDataWWP(std::vector<char>
                 vmath::vec3 t = _vfield->evaluateVelocityAtPositionLinear(p) * _domainScale * dt;
                 translations.push_back(t);
                 ids.push_back(particleIds->at(i));
+                if (_isChunkedFileFormatEnabled) {
+                    positions.push_back(particlePositions->at(i) * _domainScale + _domainOffset);
+                }
             }
         }
     }
 
-    _getDiffuseParticleFileDataWWP(translations, ids, data);
+    WhitewaterChunkedFile::ChunkLayout localLayout;
+
+    WhitewaterChunkedFile::ChunkLayout &layout = _getChunkedFileLayout(DiffuseParticleType::foam, positions, ids, localLayout);
+    _getDiffuseParticleFileDataWWP(translations, layout, ids, data);
 }
 
 void DiffuseParticleSimulation::getBubbleParticleBlurFileDataWWP(std::vector<char> &data, double dt) {
     std::vector<vmath::vec3> translations;
     std::vector<unsigned char> ids;
+    std::vector<vmath::vec3> positions;
     translations.reserve(_diffuseParticles.size());
     ids.reserve(_diffuseParticles.size());
 
@@ -891,6 +1002,9 @@ void DiffuseParticleSimulation::getBubbleParticleBlurFileDataWWP(std::vector<cha
                 vmath::vec3 t = _vfield->evaluateVelocityAtPositionLinear(p) * _domainScale * dt;
                 translations.push_back(t);
                 ids.push_back(particleIds->at(i));
+                if (_isChunkedFileFormatEnabled) {
+                    positions.push_back(particlePositions->at(i) * _domainScale + _domainOffset);
+                }
             }
         }
     } else {
@@ -900,16 +1014,23 @@ void DiffuseParticleSimulation::getBubbleParticleBlurFileDataWWP(std::vector<cha
                 vmath::vec3 t = _vfield->evaluateVelocityAtPositionLinear(p) * _domainScale * dt;
                 translations.push_back(t);
                 ids.push_back(particleIds->at(i));
+                if (_isChunkedFileFormatEnabled) {
+                    positions.push_back(particlePositions->at(i) * _domainScale + _domainOffset);
+                }
             }
         }
     }
 
-    _getDiffuseParticleFileDataWWP(translations, ids, data);
+    WhitewaterChunkedFile::ChunkLayout localLayout;
+
+    WhitewaterChunkedFile::ChunkLayout &layout = _getChunkedFileLayout(DiffuseParticleType::bubble, positions, ids, localLayout);
+    _getDiffuseParticleFileDataWWP(translations, layout, ids, data);
 }
 
 void DiffuseParticleSimulation::getSprayParticleBlurFileDataWWP(std::vector<char> &data, double dt) {
     std::vector<vmath::vec3> translations;
     std::vector<unsigned char> ids;
+    std::vector<vmath::vec3> positions;
     translations.reserve(_diffuseParticles.size());
     ids.reserve(_diffuseParticles.size());
 
@@ -932,6 +1053,9 @@ void DiffuseParticleSimulation::getSprayParticleBlurFileDataWWP(std::vector<char
                 vmath::vec3 t = _vfield->evaluateVelocityAtPositionLinear(p) * _domainScale * dt;
                 translations.push_back(t);
                 ids.push_back(particleIds->at(i));
+                if (_isChunkedFileFormatEnabled) {
+                    positions.push_back(particlePositions->at(i) * _domainScale + _domainOffset);
+                }
             }
         }
     } else {
@@ -941,16 +1065,23 @@ void DiffuseParticleSimulation::getSprayParticleBlurFileDataWWP(std::vector<char
                 vmath::vec3 t = _vfield->evaluateVelocityAtPositionLinear(p) * _domainScale * dt;
                 translations.push_back(t);
                 ids.push_back(particleIds->at(i));
+                if (_isChunkedFileFormatEnabled) {
+                    positions.push_back(particlePositions->at(i) * _domainScale + _domainOffset);
+                }
             }
         }
     }
 
-    _getDiffuseParticleFileDataWWP(translations, ids, data);
+    WhitewaterChunkedFile::ChunkLayout localLayout;
+
+    WhitewaterChunkedFile::ChunkLayout &layout = _getChunkedFileLayout(DiffuseParticleType::spray, positions, ids, localLayout);
+    _getDiffuseParticleFileDataWWP(translations, layout, ids, data);
 }
 
 void DiffuseParticleSimulation::getDustParticleBlurFileDataWWP(std::vector<char> &data, double dt) {
     std::vector<vmath::vec3> translations;
     std::vector<unsigned char> ids;
+    std::vector<vmath::vec3> positions;
     translations.reserve(_diffuseParticles.size());
     ids.reserve(_diffuseParticles.size());
 
@@ -973,6 +1104,9 @@ void DiffuseParticleSimulation::getDustParticleBlurFileDataWWP(std::vector<char>
                 vmath::vec3 t = _vfield->evaluateVelocityAtPositionLinear(p) * _domainScale * dt;
                 translations.push_back(t);
                 ids.push_back(particleIds->at(i));
+                if (_isChunkedFileFormatEnabled) {
+                    positions.push_back(particlePositions->at(i) * _domainScale + _domainOffset);
+                }
             }
         }
     } else {
@@ -982,16 +1116,23 @@ void DiffuseParticleSimulation::getDustParticleBlurFileDataWWP(std::vector<char>
                 vmath::vec3 t = _vfield->evaluateVelocityAtPositionLinear(p) * _domainScale * dt;
                 translations.push_back(t);
                 ids.push_back(particleIds->at(i));
+                if (_isChunkedFileFormatEnabled) {
+                    positions.push_back(particlePositions->at(i) * _domainScale + _domainOffset);
+                }
             }
         }
     }
 
-    _getDiffuseParticleFileDataWWP(translations, ids, data);
+    WhitewaterChunkedFile::ChunkLayout localLayout;
+
+    WhitewaterChunkedFile::ChunkLayout &layout = _getChunkedFileLayout(DiffuseParticleType::dust, positions, ids, localLayout);
+    _getDiffuseParticleFileDataWWP(translations, layout, ids, data);
 }
 
 void DiffuseParticleSimulation::getFoamParticleVelocityAttributeFileDataWWP(std::vector<char> &data) {
     std::vector<vmath::vec3> velocities;
     std::vector<unsigned char> ids;
+    std::vector<vmath::vec3> positions;
     velocities.reserve(_diffuseParticles.size());
     ids.reserve(_diffuseParticles.size());
 
@@ -1015,6 +1156,9 @@ void DiffuseParticleSimulation::getFoamParticleVelocityAttributeFileDataWWP(std:
                 vmath::vec3 v = particleVelocities->at(i);
                 velocities.push_back(v);
                 ids.push_back(particleIds->at(i));
+                if (_isChunkedFileFormatEnabled) {
+                    positions.push_back(particlePositions->at(i) * _domainScale + _domainOffset);
+                }
             }
         }
     } else {
@@ -1023,16 +1167,23 @@ void DiffuseParticleSimulation::getFoamParticleVelocityAttributeFileDataWWP(std:
                 vmath::vec3 v = particleVelocities->at(i);
                 velocities.push_back(v);
                 ids.push_back(particleIds->at(i));
+                if (_isChunkedFileFormatEnabled) {
+                    positions.push_back(particlePositions->at(i) * _domainScale + _domainOffset);
+                }
             }
         }
     }
 
-    _getDiffuseParticleFileDataWWP(velocities, ids, data);
+    WhitewaterChunkedFile::ChunkLayout localLayout;
+
+    WhitewaterChunkedFile::ChunkLayout &layout = _getChunkedFileLayout(DiffuseParticleType::foam, positions, ids, localLayout);
+    _getDiffuseParticleFileDataWWP(velocities, layout, ids, data);
 }
 
 void DiffuseParticleSimulation::getBubbleParticleVelocityAttributeFileDataWWP(std::vector<char> &data) {
     std::vector<vmath::vec3> velocities;
     std::vector<unsigned char> ids;
+    std::vector<vmath::vec3> positions;
     velocities.reserve(_diffuseParticles.size());
     ids.reserve(_diffuseParticles.size());
 
@@ -1056,6 +1207,9 @@ void DiffuseParticleSimulation::getBubbleParticleVelocityAttributeFileDataWWP(st
                 vmath::vec3 v = particleVelocities->at(i);
                 velocities.push_back(v);
                 ids.push_back(particleIds->at(i));
+                if (_isChunkedFileFormatEnabled) {
+                    positions.push_back(particlePositions->at(i) * _domainScale + _domainOffset);
+                }
             }
         }
     } else {
@@ -1064,16 +1218,23 @@ void DiffuseParticleSimulation::getBubbleParticleVelocityAttributeFileDataWWP(st
                 vmath::vec3 v = particleVelocities->at(i);
                 velocities.push_back(v);
                 ids.push_back(particleIds->at(i));
+                if (_isChunkedFileFormatEnabled) {
+                    positions.push_back(particlePositions->at(i) * _domainScale + _domainOffset);
+                }
             }
         }
     }
 
-    _getDiffuseParticleFileDataWWP(velocities, ids, data);
+    WhitewaterChunkedFile::ChunkLayout localLayout;
+
+    WhitewaterChunkedFile::ChunkLayout &layout = _getChunkedFileLayout(DiffuseParticleType::bubble, positions, ids, localLayout);
+    _getDiffuseParticleFileDataWWP(velocities, layout, ids, data);
 }
 
 void DiffuseParticleSimulation::getSprayParticleVelocityAttributeFileDataWWP(std::vector<char> &data) {
     std::vector<vmath::vec3> velocities;
     std::vector<unsigned char> ids;
+    std::vector<vmath::vec3> positions;
     velocities.reserve(_diffuseParticles.size());
     ids.reserve(_diffuseParticles.size());
 
@@ -1097,6 +1258,9 @@ void DiffuseParticleSimulation::getSprayParticleVelocityAttributeFileDataWWP(std
                 vmath::vec3 v = particleVelocities->at(i);
                 velocities.push_back(v);
                 ids.push_back(particleIds->at(i));
+                if (_isChunkedFileFormatEnabled) {
+                    positions.push_back(particlePositions->at(i) * _domainScale + _domainOffset);
+                }
             }
         }
     } else {
@@ -1105,16 +1269,23 @@ void DiffuseParticleSimulation::getSprayParticleVelocityAttributeFileDataWWP(std
                 vmath::vec3 v = particleVelocities->at(i);
                 velocities.push_back(v);
                 ids.push_back(particleIds->at(i));
+                if (_isChunkedFileFormatEnabled) {
+                    positions.push_back(particlePositions->at(i) * _domainScale + _domainOffset);
+                }
             }
         }
     }
 
-    _getDiffuseParticleFileDataWWP(velocities, ids, data);
+    WhitewaterChunkedFile::ChunkLayout localLayout;
+
+    WhitewaterChunkedFile::ChunkLayout &layout = _getChunkedFileLayout(DiffuseParticleType::spray, positions, ids, localLayout);
+    _getDiffuseParticleFileDataWWP(velocities, layout, ids, data);
 }
 
 void DiffuseParticleSimulation::getDustParticleVelocityAttributeFileDataWWP(std::vector<char> &data) {
     std::vector<vmath::vec3> velocities;
     std::vector<unsigned char> ids;
+    std::vector<vmath::vec3> positions;
     velocities.reserve(_diffuseParticles.size());
     ids.reserve(_diffuseParticles.size());
 
@@ -1138,6 +1309,9 @@ void DiffuseParticleSimulation::getDustParticleVelocityAttributeFileDataWWP(std:
                 vmath::vec3 v = particleVelocities->at(i);
                 velocities.push_back(v);
                 ids.push_back(particleIds->at(i));
+                if (_isChunkedFileFormatEnabled) {
+                    positions.push_back(particlePositions->at(i) * _domainScale + _domainOffset);
+                }
             }
         }
     } else {
@@ -1146,16 +1320,23 @@ void DiffuseParticleSimulation::getDustParticleVelocityAttributeFileDataWWP(std:
                 vmath::vec3 v = particleVelocities->at(i);
                 velocities.push_back(v);
                 ids.push_back(particleIds->at(i));
+                if (_isChunkedFileFormatEnabled) {
+                    positions.push_back(particlePositions->at(i) * _domainScale + _domainOffset);
+                }
             }
         }
     }
 
-    _getDiffuseParticleFileDataWWP(velocities, ids, data);
+    WhitewaterChunkedFile::ChunkLayout localLayout;
+
+    WhitewaterChunkedFile::ChunkLayout &layout = _getChunkedFileLayout(DiffuseParticleType::dust, positions, ids, localLayout);
+    _getDiffuseParticleFileDataWWP(velocities, layout, ids, data);
 }
 
 void DiffuseParticleSimulation::getFoamParticleIDAttributeFileDataWWI(std::vector<char> &data) {
     std::vector<int> outputids;
     std::vector<unsigned char> ids;
+    std::vector<vmath::vec3> positions;
     outputids.reserve(_diffuseParticles.size());
     ids.reserve(_diffuseParticles.size());
 
@@ -1177,6 +1358,9 @@ void DiffuseParticleSimulation::getFoamParticleIDAttributeFileDataWWI(std::vecto
                 int idx = (int)(particleIds->at(i));
                 outputids.push_back(idx);
                 ids.push_back(particleIds->at(i));
+                if (_isChunkedFileFormatEnabled) {
+                    positions.push_back(particlePositions->at(i) * _domainScale + _domainOffset);
+                }
             }
         }
     } else {
@@ -1185,16 +1369,23 @@ void DiffuseParticleSimulation::getFoamParticleIDAttributeFileDataWWI(std::vecto
                 int idx = (int)(particleIds->at(i));
                 outputids.push_back(idx);
                 ids.push_back(particleIds->at(i));
+                if (_isChunkedFileFormatEnabled) {
+                    positions.push_back(particlePositions->at(i) * _domainScale + _domainOffset);
+                }
             }
         }
     }
 
-    _getDiffuseParticleFileDataWWI(outputids, ids, data);
+    WhitewaterChunkedFile::ChunkLayout localLayout;
+
+    WhitewaterChunkedFile::ChunkLayout &layout = _getChunkedFileLayout(DiffuseParticleType::foam, positions, ids, localLayout);
+    _getDiffuseParticleFileDataWWI(outputids, layout, ids, data);
 }
 
 void DiffuseParticleSimulation::getBubbleParticleIDAttributeFileDataWWI(std::vector<char> &data) {
     std::vector<int> outputids;
     std::vector<unsigned char> ids;
+    std::vector<vmath::vec3> positions;
     outputids.reserve(_diffuseParticles.size());
     ids.reserve(_diffuseParticles.size());
 
@@ -1216,6 +1407,9 @@ void DiffuseParticleSimulation::getBubbleParticleIDAttributeFileDataWWI(std::vec
                 int idx = (int)(particleIds->at(i));
                 outputids.push_back(idx);
                 ids.push_back(particleIds->at(i));
+                if (_isChunkedFileFormatEnabled) {
+                    positions.push_back(particlePositions->at(i) * _domainScale + _domainOffset);
+                }
             }
         }
     } else {
@@ -1224,16 +1418,23 @@ void DiffuseParticleSimulation::getBubbleParticleIDAttributeFileDataWWI(std::vec
                 int idx = (int)(particleIds->at(i));
                 outputids.push_back(idx);
                 ids.push_back(particleIds->at(i));
+                if (_isChunkedFileFormatEnabled) {
+                    positions.push_back(particlePositions->at(i) * _domainScale + _domainOffset);
+                }
             }
         }
     }
 
-    _getDiffuseParticleFileDataWWI(outputids, ids, data);
+    WhitewaterChunkedFile::ChunkLayout localLayout;
+
+    WhitewaterChunkedFile::ChunkLayout &layout = _getChunkedFileLayout(DiffuseParticleType::bubble, positions, ids, localLayout);
+    _getDiffuseParticleFileDataWWI(outputids, layout, ids, data);
 }
 
 void DiffuseParticleSimulation::getSprayParticleIDAttributeFileDataWWI(std::vector<char> &data) {
     std::vector<int> outputids;
     std::vector<unsigned char> ids;
+    std::vector<vmath::vec3> positions;
     outputids.reserve(_diffuseParticles.size());
     ids.reserve(_diffuseParticles.size());
 
@@ -1255,6 +1456,9 @@ void DiffuseParticleSimulation::getSprayParticleIDAttributeFileDataWWI(std::vect
                 int idx = (int)(particleIds->at(i));
                 outputids.push_back(idx);
                 ids.push_back(particleIds->at(i));
+                if (_isChunkedFileFormatEnabled) {
+                    positions.push_back(particlePositions->at(i) * _domainScale + _domainOffset);
+                }
             }
         }
     } else {
@@ -1263,16 +1467,23 @@ void DiffuseParticleSimulation::getSprayParticleIDAttributeFileDataWWI(std::vect
                 int idx = (int)(particleIds->at(i));
                 outputids.push_back(idx);
                 ids.push_back(particleIds->at(i));
+                if (_isChunkedFileFormatEnabled) {
+                    positions.push_back(particlePositions->at(i) * _domainScale + _domainOffset);
+                }
             }
         }
     }
 
-    _getDiffuseParticleFileDataWWI(outputids, ids, data);
+    WhitewaterChunkedFile::ChunkLayout localLayout;
+
+    WhitewaterChunkedFile::ChunkLayout &layout = _getChunkedFileLayout(DiffuseParticleType::spray, positions, ids, localLayout);
+    _getDiffuseParticleFileDataWWI(outputids, layout, ids, data);
 }
 
 void DiffuseParticleSimulation::getDustParticleIDAttributeFileDataWWI(std::vector<char> &data) {
     std::vector<int> outputids;
     std::vector<unsigned char> ids;
+    std::vector<vmath::vec3> positions;
     outputids.reserve(_diffuseParticles.size());
     ids.reserve(_diffuseParticles.size());
 
@@ -1294,6 +1505,9 @@ void DiffuseParticleSimulation::getDustParticleIDAttributeFileDataWWI(std::vecto
                 int idx = (int)(particleIds->at(i));
                 outputids.push_back(idx);
                 ids.push_back(particleIds->at(i));
+                if (_isChunkedFileFormatEnabled) {
+                    positions.push_back(particlePositions->at(i) * _domainScale + _domainOffset);
+                }
             }
         }
     } else {
@@ -1302,16 +1516,23 @@ void DiffuseParticleSimulation::getDustParticleIDAttributeFileDataWWI(std::vecto
                 int idx = (int)(particleIds->at(i));
                 outputids.push_back(idx);
                 ids.push_back(particleIds->at(i));
+                if (_isChunkedFileFormatEnabled) {
+                    positions.push_back(particlePositions->at(i) * _domainScale + _domainOffset);
+                }
             }
         }
     }
 
-    _getDiffuseParticleFileDataWWI(outputids, ids, data);
+    WhitewaterChunkedFile::ChunkLayout localLayout;
+
+    WhitewaterChunkedFile::ChunkLayout &layout = _getChunkedFileLayout(DiffuseParticleType::dust, positions, ids, localLayout);
+    _getDiffuseParticleFileDataWWI(outputids, layout, ids, data);
 }
 
 void DiffuseParticleSimulation::getFoamParticleLifetimeAttributeFileDataWWF(std::vector<char> &data) {
     std::vector<float> outputLifetimes;
     std::vector<unsigned char> ids;
+    std::vector<vmath::vec3> positions;
     outputLifetimes.reserve(_diffuseParticles.size());
     ids.reserve(_diffuseParticles.size());
 
@@ -1335,6 +1556,9 @@ void DiffuseParticleSimulation::getFoamParticleLifetimeAttributeFileDataWWF(std:
                 float lifetime = particleLifetimes->at(i);
                 outputLifetimes.push_back(lifetime);
                 ids.push_back(particleIds->at(i));
+                if (_isChunkedFileFormatEnabled) {
+                    positions.push_back(particlePositions->at(i) * _domainScale + _domainOffset);
+                }
             }
         }
     } else {
@@ -1343,16 +1567,23 @@ void DiffuseParticleSimulation::getFoamParticleLifetimeAttributeFileDataWWF(std:
                 float lifetime = particleLifetimes->at(i);
                 outputLifetimes.push_back(lifetime);
                 ids.push_back(particleIds->at(i));
+                if (_isChunkedFileFormatEnabled) {
+                    positions.push_back(particlePositions->at(i) * _domainScale + _domainOffset);
+                }
             }
         }
     }
 
-    _getDiffuseParticleFileDataWWF(outputLifetimes, ids, data);
+    WhitewaterChunkedFile::ChunkLayout localLayout;
+
+    WhitewaterChunkedFile::ChunkLayout &layout = _getChunkedFileLayout(DiffuseParticleType::foam, positions, ids, localLayout);
+    _getDiffuseParticleFileDataWWF(outputLifetimes, layout, ids, data);
 }
 
 void DiffuseParticleSimulation::getBubbleParticleLifetimeAttributeFileDataWWF(std::vector<char> &data) {
     std::vector<float> outputLifetimes;
     std::vector<unsigned char> ids;
+    std::vector<vmath::vec3> positions;
     outputLifetimes.reserve(_diffuseParticles.size());
     ids.reserve(_diffuseParticles.size());
 
@@ -1376,6 +1607,9 @@ void DiffuseParticleSimulation::getBubbleParticleLifetimeAttributeFileDataWWF(st
                 float lifetime = particleLifetimes->at(i);
                 outputLifetimes.push_back(lifetime);
                 ids.push_back(particleIds->at(i));
+                if (_isChunkedFileFormatEnabled) {
+                    positions.push_back(particlePositions->at(i) * _domainScale + _domainOffset);
+                }
             }
         }
     } else {
@@ -1384,16 +1618,23 @@ void DiffuseParticleSimulation::getBubbleParticleLifetimeAttributeFileDataWWF(st
                 float lifetime = particleLifetimes->at(i);
                 outputLifetimes.push_back(lifetime);
                 ids.push_back(particleIds->at(i));
+                if (_isChunkedFileFormatEnabled) {
+                    positions.push_back(particlePositions->at(i) * _domainScale + _domainOffset);
+                }
             }
         }
     }
 
-    _getDiffuseParticleFileDataWWF(outputLifetimes, ids, data);
+    WhitewaterChunkedFile::ChunkLayout localLayout;
+
+    WhitewaterChunkedFile::ChunkLayout &layout = _getChunkedFileLayout(DiffuseParticleType::bubble, positions, ids, localLayout);
+    _getDiffuseParticleFileDataWWF(outputLifetimes, layout, ids, data);
 }
 
 void DiffuseParticleSimulation::getSprayParticleLifetimeAttributeFileDataWWF(std::vector<char> &data) {
     std::vector<float> outputLifetimes;
     std::vector<unsigned char> ids;
+    std::vector<vmath::vec3> positions;
     outputLifetimes.reserve(_diffuseParticles.size());
     ids.reserve(_diffuseParticles.size());
 
@@ -1417,6 +1658,9 @@ void DiffuseParticleSimulation::getSprayParticleLifetimeAttributeFileDataWWF(std
                 float lifetime = particleLifetimes->at(i);
                 outputLifetimes.push_back(lifetime);
                 ids.push_back(particleIds->at(i));
+                if (_isChunkedFileFormatEnabled) {
+                    positions.push_back(particlePositions->at(i) * _domainScale + _domainOffset);
+                }
             }
         }
     } else {
@@ -1425,16 +1669,23 @@ void DiffuseParticleSimulation::getSprayParticleLifetimeAttributeFileDataWWF(std
                 float lifetime = particleLifetimes->at(i);
                 outputLifetimes.push_back(lifetime);
                 ids.push_back(particleIds->at(i));
+                if (_isChunkedFileFormatEnabled) {
+                    positions.push_back(particlePositions->at(i) * _domainScale + _domainOffset);
+                }
             }
         }
     }
 
-    _getDiffuseParticleFileDataWWF(outputLifetimes, ids, data);
+    WhitewaterChunkedFile::ChunkLayout localLayout;
+
+    WhitewaterChunkedFile::ChunkLayout &layout = _getChunkedFileLayout(DiffuseParticleType::spray, positions, ids, localLayout);
+    _getDiffuseParticleFileDataWWF(outputLifetimes, layout, ids, data);
 }
 
 void DiffuseParticleSimulation::getDustParticleLifetimeAttributeFileDataWWF(std::vector<char> &data) {
     std::vector<float> outputLifetimes;
     std::vector<unsigned char> ids;
+    std::vector<vmath::vec3> positions;
     outputLifetimes.reserve(_diffuseParticles.size());
     ids.reserve(_diffuseParticles.size());
 
@@ -1458,6 +1709,9 @@ void DiffuseParticleSimulation::getDustParticleLifetimeAttributeFileDataWWF(std:
                 float lifetime = particleLifetimes->at(i);
                 outputLifetimes.push_back(lifetime);
                 ids.push_back(particleIds->at(i));
+                if (_isChunkedFileFormatEnabled) {
+                    positions.push_back(particlePositions->at(i) * _domainScale + _domainOffset);
+                }
             }
         }
     } else {
@@ -1466,14 +1720,21 @@ void DiffuseParticleSimulation::getDustParticleLifetimeAttributeFileDataWWF(std:
                 float lifetime = particleLifetimes->at(i);
                 outputLifetimes.push_back(lifetime);
                 ids.push_back(particleIds->at(i));
+                if (_isChunkedFileFormatEnabled) {
+                    positions.push_back(particlePositions->at(i) * _domainScale + _domainOffset);
+                }
             }
         }
     }
 
-    _getDiffuseParticleFileDataWWF(outputLifetimes, ids, data);
+    WhitewaterChunkedFile::ChunkLayout localLayout;
+
+    WhitewaterChunkedFile::ChunkLayout &layout = _getChunkedFileLayout(DiffuseParticleType::dust, positions, ids, localLayout);
+    _getDiffuseParticleFileDataWWF(outputLifetimes, layout, ids, data);
 }
 
 void DiffuseParticleSimulation::loadDiffuseParticles(FragmentedVector<DiffuseParticle> &particles) {
+    _isDiffuseParticleTypeCountsValid = false;
     _diffuseParticles.reserve(_diffuseParticles.size() + particles.size());
 
     DiffuseParticleAttributes atts = _getDiffuseParticleAttributes();
@@ -1494,7 +1755,8 @@ void DiffuseParticleSimulation::
         _getDiffuseParticleEmitters(std::vector<DiffuseParticleEmitter> &normalEmitters,
                                     std::vector<DiffuseParticleEmitter> &dustEmitters) {
 
-    _turbulenceField.calculateTurbulenceField(_vfield, *_liquidSDF);
+    _turbulenceField.initializeTurbulenceField(_vfield, *_liquidSDF);
+    _initializeEmitterBlockGrid();
 
     std::vector<vmath::vec3> surfaceParticles;
     std::vector<vmath::vec3> insideParticles;
@@ -1505,11 +1767,19 @@ void DiffuseParticleSimulation::
     allParticles.insert(allParticles.end(), surfaceParticles.begin(), surfaceParticles.end());
     allParticles.insert(allParticles.end(), insideParticles.begin(), insideParticles.end());
 
+    // Turbulence tiles are computed up front so that the turbulence field 
+    // is only read during emitter generation
+    _turbulenceField.calculateTurbulenceTilesAtPositions(_isDustEnabled ? allParticles : insideParticles);
+
     _getSurfaceDiffuseParticleEmitters(surfaceParticles, normalEmitters);
     _getInsideDiffuseParticleEmitters(insideParticles, normalEmitters);
     _getDiffuseDustParticleEmitters(allParticles, dustEmitters);
-    _shuffleDiffuseParticleEmitters(normalEmitters);
-    _shuffleDiffuseParticleEmitters(dustEmitters);
+
+    // Tile data is computed from the current velocity field and must not be 
+    // read after the velocity field changes in the next time step
+    _turbulenceField.invalidateTurbulenceField();
+    _shuffleDiffuseParticleEmitters(normalEmitters, RandomStream::normalEmitterShuffle);
+    _shuffleDiffuseParticleEmitters(dustEmitters, RandomStream::dustEmitterShuffle);
 }
 
 DiffuseParticleSimulation::DiffuseParticleAttributes DiffuseParticleSimulation::_getDiffuseParticleAttributes() {
@@ -1522,18 +1792,34 @@ DiffuseParticleSimulation::DiffuseParticleAttributes DiffuseParticleSimulation::
     return atts;
 }
 
-void DiffuseParticleSimulation::_trilinearInterpolate(std::vector<vmath::vec3> &input, 
-                                                      MACVelocityField *vfield, 
-                                                      std::vector<vmath::vec3> &output) {
-    FLUIDSIM_ASSERT(output.size() == input.size());
+void DiffuseParticleSimulation::_sampleGrids(std::vector<vmath::vec3> &positions, 
+                                             DiffuseGridSamples &samples) {
+    size_t n = positions.size();
+    if (samples.isVelocityEnabled) {
+        samples.velocities = std::vector<vmath::vec3>(n);
+    }
+    if (samples.isSurfaceDistanceEnabled) {
+        samples.surfaceDistances = std::vector<double>(n, 0.0);
+    }
+    if (samples.isWavecrestEnabled) {
+        samples.curvatures = std::vector<float>(n, 0.0f);
+        samples.surfaceGradients = std::vector<vmath::vec3>(n);
+    }
+    if (samples.isSolidDistanceEnabled) {
+        samples.solidDistances = std::vector<float>(n, 0.0f);
+    }
+
+    if (positions.empty()) {
+        return;
+    }
 
     int numCPU = ThreadUtils::getMaxThreadCount();
-    int numthreads = (int)fmin(numCPU, input.size());
+    int numthreads = (int)fmin(numCPU, n);
     std::vector<std::thread> threads(numthreads);
-    std::vector<int> intervals = ThreadUtils::splitRangeIntoIntervals(0, input.size(), numthreads);
+    std::vector<int> intervals = ThreadUtils::splitRangeIntoIntervals(0, n, numthreads);
     for (int i = 0; i < numthreads; i++) {
-        threads[i] = std::thread(&DiffuseParticleSimulation::_trilinearInterpolateThread, this,
-                                 intervals[i], intervals[i + 1], &input, vfield, &output);
+        threads[i] = std::thread(&DiffuseParticleSimulation::_sampleGridsThread, this,
+                                 intervals[i], intervals[i + 1], &positions, &samples);
     }
 
     for (int i = 0; i < numthreads; i++) {
@@ -1541,12 +1827,40 @@ void DiffuseParticleSimulation::_trilinearInterpolate(std::vector<vmath::vec3> &
     }
 }
 
-void DiffuseParticleSimulation::_trilinearInterpolateThread(int startidx, int endidx, 
-                                                            std::vector<vmath::vec3> *input, 
-                                                            MACVelocityField *vfield, 
-                                                            std::vector<vmath::vec3> *output) {
+void DiffuseParticleSimulation::_sampleGridsThread(int startidx, int endidx, 
+                                                   std::vector<vmath::vec3> *positions, 
+                                                   DiffuseGridSamples *samples) {
+    // The surface distance and curvature grids are sampled at cell centers
+    vmath::vec3 hdx(0.5*_dx, 0.5*_dx, 0.5*_dx);
+    bool isCellCenterStencilRequired = samples->isSurfaceDistanceEnabled || samples->isWavecrestEnabled;
     for (int i = startidx; i < endidx; i++) {
-        (*output)[i] = vfield->evaluateVelocityAtPositionLinear(input->at(i));
+        vmath::vec3 p = positions->at(i);
+
+        if (samples->isVelocityEnabled) {
+            MACVelocityField::LinearStencil vs = _vfield->getLinearStencil(p);
+            samples->velocities[i] = _vfield->evaluateVelocityAtPositionLinear(vs);
+        }
+
+        if (isCellCenterStencilRequired) {
+            Interpolation::TrilinearStencil cs = Interpolation::getTrilinearStencil(p - hdx, _dx);
+            if (samples->isSurfaceDistanceEnabled) {
+                samples->surfaceDistances[i] = Interpolation::trilinearInterpolate(cs, *_surfaceSDF);
+            }
+
+            if (samples->isWavecrestEnabled) {
+                float k = Interpolation::trilinearInterpolate(cs, *_kgrid) * _dx;
+                samples->curvatures[i] = k;
+                if (k >= _minWavecrestCurvature) {
+                    vmath::vec3 grad;
+                    Interpolation::trilinearInterpolateGradient(cs, *_surfaceSDF, &grad);
+                    samples->surfaceGradients[i] = grad;
+                }
+            }
+        }
+
+        if (samples->isSolidDistanceEnabled) {
+            samples->solidDistances[i] = _solidSDF->trilinearInterpolate(p);
+        }
     }
 }
 
@@ -1556,14 +1870,185 @@ double DiffuseParticleSimulation::_getParticleJitter() {
 }
 
 vmath::vec3 DiffuseParticleSimulation::_jitterParticlePosition(vmath::vec3 p, 
-                                                               double jitter) {
-    p.x += _randomDouble(-jitter, jitter);
-    p.y += _randomDouble(-jitter, jitter);
-    p.z += _randomDouble(-jitter, jitter);
+                                                               double jitter,
+                                                               unsigned int counter) {
+    float values[4];
+    _generateRandomNumbers(RandomStream::markerParticleJitter, counter, 0, values);
+    p.x += (2.0 * values[0] - 1.0) * jitter;
+    p.y += (2.0 * values[1] - 1.0) * jitter;
+    p.z += (2.0 * values[2] - 1.0) * jitter;
 
     return p;
 }
 
+void DiffuseParticleSimulation::_initializeEmitterBlockGrid() {
+    // Emitter blocks coincide with turbulence field tiles
+    int bi, bj, bk;
+    _turbulenceField.getTileGridDimensions(&bi, &bj, &bk);
+    Array3d<EmitterBlockBounds> blockBounds(bi, bj, bk);
+
+    size_t gridsize = bi * bj * bk;
+    size_t numCPU = ThreadUtils::getMaxThreadCount();
+    int numthreads = (int)fmin(numCPU, gridsize);
+    std::vector<std::thread> threads(numthreads);
+    std::vector<int> intervals = ThreadUtils::splitRangeIntoIntervals(0, gridsize, numthreads);
+    for (int i = 0; i < numthreads; i++) {
+        threads[i] = std::thread(&DiffuseParticleSimulation::_computeEmitterBlockBoundsThread, this,
+                                 intervals[i], intervals[i + 1], &blockBounds);
+    }
+
+    for (int i = 0; i < numthreads; i++) {
+        threads[i].join();
+    }
+
+    // Turbulence is only computed for tiles that neighbour a block where the
+    // emitter energy threshold can be reached
+    Array3d<bool> isTurbulenceTileRequired(bi, bj, bk, false);
+    for (size_t idx = 0; idx < gridsize; idx++) {
+        GridIndex b = Grid3d::getUnflattenedIndex(idx, bi, bj);
+        EmitterBlockBounds bounds = _getEmitterBlockNeighbourhoodBounds(blockBounds, b);
+        if (!_isEmitterEnergyPossible(bounds)) {
+            continue;
+        }
+
+        for (int k = b.k - 1; k <= b.k + 1; k++) {
+            for (int j = b.j - 1; j <= b.j + 1; j++) {
+                for (int i = b.i - 1; i <= b.i + 1; i++) {
+                    if (isTurbulenceTileRequired.isIndexInRange(i, j, k)) {
+                        isTurbulenceTileRequired.set(i, j, k, true);
+                    }
+                }
+            }
+        }
+    }
+
+    std::vector<GridIndex> turbulenceTiles;
+    for (size_t idx = 0; idx < gridsize; idx++) {
+        GridIndex b = Grid3d::getUnflattenedIndex(idx, bi, bj);
+        if (isTurbulenceTileRequired(b)) {
+            turbulenceTiles.push_back(b);
+        }
+    }
+    _turbulenceField.calculateTurbulenceTiles(turbulenceTiles);
+
+    for (size_t i = 0; i < turbulenceTiles.size(); i++) {
+        GridIndex b = turbulenceTiles[i];
+        EmitterBlockBounds bounds = blockBounds(b);
+        bounds.maxTurbulence = _turbulenceField.getMaxTileTurbulence(b);
+        blockBounds.set(b, bounds);
+    }
+
+    if (_isEmitterBlockActiveGrid.width == bi && 
+            _isEmitterBlockActiveGrid.height == bj && 
+            _isEmitterBlockActiveGrid.depth == bk) {
+        _isEmitterBlockActiveGrid.fill(false);
+    } else {
+        _isEmitterBlockActiveGrid = Array3d<bool>(bi, bj, bk, false);
+    }
+
+    for (size_t idx = 0; idx < gridsize; idx++) {
+        GridIndex b = Grid3d::getUnflattenedIndex(idx, bi, bj);
+        EmitterBlockBounds bounds = _getEmitterBlockNeighbourhoodBounds(blockBounds, b);
+        _isEmitterBlockActiveGrid.set(b, _isEmitterBlockActive(bounds));
+    }
+}
+
+void DiffuseParticleSimulation::_computeEmitterBlockBoundsThread(int startidx, int endidx, 
+                                                                 Array3d<EmitterBlockBounds> *blockBounds) {
+    int blockWidth = _turbulenceField.getTileWidth();
+    int bi = blockBounds->width;
+    int bj = blockBounds->height;
+    for (int idx = startidx; idx < endidx; idx++) {
+        GridIndex b = Grid3d::getUnflattenedIndex(idx, bi, bj);
+        int imin = b.i * blockWidth;
+        int jmin = b.j * blockWidth;
+        int kmin = b.k * blockWidth;
+        int imax = std::min(imin + blockWidth, _isize);
+        int jmax = std::min(jmin + blockWidth, _jsize);
+        int kmax = std::min(kmin + blockWidth, _ksize);
+
+        EmitterBlockBounds bounds;
+        for (int k = kmin; k < kmax; k++) {
+            for (int j = jmin; j < jmax; j++) {
+                for (int i = imin; i < imax; i++) {
+                    bounds.maxu = std::max(bounds.maxu, (float)fabs(_vfield->U(i, j, k)));
+                    bounds.maxv = std::max(bounds.maxv, (float)fabs(_vfield->V(i, j, k)));
+                    bounds.maxw = std::max(bounds.maxw, (float)fabs(_vfield->W(i, j, k)));
+                    bounds.maxCurvature = std::max(bounds.maxCurvature, _kgrid->get(i, j, k));
+                }
+            }
+        }
+
+        // Faces on the positive sides of the block
+        for (int k = kmin; k < kmax; k++) {
+            for (int j = jmin; j < jmax; j++) {
+                bounds.maxu = std::max(bounds.maxu, (float)fabs(_vfield->U(imax, j, k)));
+            }
+        }
+        for (int k = kmin; k < kmax; k++) {
+            for (int i = imin; i < imax; i++) {
+                bounds.maxv = std::max(bounds.maxv, (float)fabs(_vfield->V(i, jmax, k)));
+            }
+        }
+        for (int j = jmin; j < jmax; j++) {
+            for (int i = imin; i < imax; i++) {
+                bounds.maxw = std::max(bounds.maxw, (float)fabs(_vfield->W(i, j, kmax)));
+            }
+        }
+
+        blockBounds->set(b, bounds);
+    }
+}
+
+DiffuseParticleSimulation::EmitterBlockBounds DiffuseParticleSimulation::
+        _getEmitterBlockNeighbourhoodBounds(Array3d<EmitterBlockBounds> &blockBounds, GridIndex b) {
+    // Particle positions are jittered and potentials are interpolated from 
+    // neighbouring cells, so bounds are taken over the neighbouring blocks
+    EmitterBlockBounds bounds;
+    for (int k = b.k - 1; k <= b.k + 1; k++) {
+        for (int j = b.j - 1; j <= b.j + 1; j++) {
+            for (int i = b.i - 1; i <= b.i + 1; i++) {
+                if (!blockBounds.isIndexInRange(i, j, k)) {
+                    continue;
+                }
+
+                EmitterBlockBounds n = blockBounds(i, j, k);
+                bounds.maxu = std::max(bounds.maxu, n.maxu);
+                bounds.maxv = std::max(bounds.maxv, n.maxv);
+                bounds.maxw = std::max(bounds.maxw, n.maxw);
+                bounds.maxCurvature = std::max(bounds.maxCurvature, n.maxCurvature);
+                bounds.maxTurbulence = std::max(bounds.maxTurbulence, n.maxTurbulence);
+            }
+        }
+    }
+
+    return bounds;
+}
+
+bool DiffuseParticleSimulation::_isEmitterEnergyPossible(EmitterBlockBounds &bounds) {
+    // Surface particle velocities may be scaled by the spray emission 
+    // speed factor before the energy potential is evaluated
+    double speedFactor = std::max(_sprayEmissionSpeedFactor, 1.0);
+    double maxSpeedSquared = speedFactor * speedFactor * 
+                             ((double)bounds.maxu * bounds.maxu + 
+                              (double)bounds.maxv * bounds.maxv + 
+                              (double)bounds.maxw * bounds.maxw);
+    return 0.5 * maxSpeedSquared > _minParticleEnergy;
+}
+
+bool DiffuseParticleSimulation::_isEmitterBlockActive(EmitterBlockBounds &bounds) {
+    if (!_isEmitterEnergyPossible(bounds)) {
+        return false;
+    }
+
+    bool isWavecrestPossible = bounds.maxCurvature * _dx >= _minWavecrestCurvature;
+    bool isTurbulencePossible = bounds.maxTurbulence >= _minTurbulence;
+    bool isDustPossible = _isDustEnabled && 
+                          bounds.maxTurbulence >= _minDustTurbulenceFactor * _minTurbulence;
+
+    return isWavecrestPossible || isTurbulencePossible || isDustPossible;
+}
+
 void DiffuseParticleSimulation::
         _sortMarkerParticlePositions(std::vector<vmath::vec3> &surface, 
                                      std::vector<vmath::vec3> &inside) {
@@ -1574,9 +2059,15 @@ void DiffuseParticleSimulation::
     double jitter = _getParticleJitter();
     float width = (float)(_diffuseSurfaceNarrowBandSize * _dx);
     vmath::vec3 hdx(0.5*_dx, 0.5*_dx, 0.5*_dx);
+    double blockdx = _turbulenceField.getTileWidth() * _dx;
     for (size_t i = 0; i < positions->size(); i++) {
         vmath::vec3 p = positions->at(i);
-        p = _jitterParticlePosition(p, jitter);
+        GridIndex b = Grid3d::positionToGridIndex(p, blockdx);
+        if (_isEmitterBlockActiveGrid.isIndexInRange(b) && !_isEmitterBlockActiveGrid(b)) {
+            continue;
+        }
+
+        p = _jitterParticlePosition(p, jitter, (unsigned int)i);
         if (!_emitterGenerationBounds.isPointInside(p)) {
             continue;
         }
@@ -1685,18 +2176,24 @@ void DiffuseParticleSimulation::
         _getSurfaceDiffuseParticleEmitters(std::vector<vmath::vec3> &surface, 
                                            std::vector<DiffuseParticleEmitter> &emitters) {
     
-    std::vector<vmath::vec3> velocities(surface.size());
-    _trilinearInterpolate(surface, _vfield, velocities);
-
-    vmath::vec3 hdx(0.5*_dx, 0.5*_dx, 0.5*_dx);
+    DiffuseGridSamples samples;
+    samples.isVelocityEnabled = true;
+    samples.isSurfaceDistanceEnabled = true;
+    samples.isWavecrestEnabled = true;
+    _sampleGrids(surface, samples);
+
+    // Random values are drawn per candidate index so that they do not 
+    // depend on which candidates were rejected before
     double eps = 1e-6;
+    float randomValues[4];
     for (size_t i = 0; i < surface.size(); i++) {
         vmath::vec3 p = surface[i];
-        vmath::vec3 v = velocities[i];
+        vmath::vec3 v = samples.velocities[i];
+        _generateRandomNumbers(RandomStream::surfaceEmitterGeneration, (unsigned int)i, 0, randomValues);
 
-        double dist = Interpolation::trilinearInterpolate(p - hdx, _dx, *_surfaceSDF);
+        double dist = samples.surfaceDistances[i];
         if (dist > -0.75 * _dx) {
-            v *= _randomDouble(1.0f, _sprayEmissionSpeedFactor);
+            v *= 1.0 + randomValues[0] * (_sprayEmissionSpeedFactor - 1.0);
         }
 
         double Ie = _getEnergyPotential(v);
@@ -1704,30 +2201,28 @@ void DiffuseParticleSimulation::
             continue;
         }
 
-        double Iwc = _getWavecrestPotential(p, v);
-        if (Iwc > 0.0 && _randomDouble(0.0, 1.0) < _emitterGenerationRate) {
+        double Iwc = _getWavecrestPotential(v, samples.curvatures[i], samples.surfaceGradients[i]);
+        if (Iwc > 0.0 && randomValues[1] < _emitterGenerationRate) {
             emitters.push_back(DiffuseParticleEmitter(p, v, Ie, Iwc, 0.0, 0.0));
         }
     }
 }
 
 double DiffuseParticleSimulation::
-        _getWavecrestPotential(vmath::vec3 p, vmath::vec3 v) {
+        _getWavecrestPotential(vmath::vec3 v, float curvature, vmath::vec3 surfaceGradient) {
 
     float eps = 1e-6f;
     if (fabs(v.x) < eps && fabs(v.y) < eps && fabs(v.z) < eps) {
         return 0.0;
     }
 
-    vmath::vec3 hdx(0.5*_dx, 0.5*_dx, 0.5*_dx);
-    float k = Interpolation::trilinearInterpolate(p - hdx, _dx, *_kgrid) * _dx;
+    float k = curvature;
     if (k < _minWavecrestCurvature) {
         return 0.0;
     }
     k = fmin(k, _maxWavecrestCurvature);
 
-    vmath::vec3 grad;
-    Interpolation::trilinearInterpolateGradient(p - hdx, _dx, *_surfaceSDF, &grad);
+    vmath::vec3 grad = surfaceGradient;
     if (fabs(grad.x) < eps && fabs(grad.y) < eps && fabs(grad.z) < eps) {
         return 0.0;
     }
@@ -1774,11 +2269,14 @@ double DiffuseParticleSimulation::
 void DiffuseParticleSimulation::_getInsideDiffuseParticleEmitters(std::vector<vmath::vec3> &inside, 
                                                                   std::vector<DiffuseParticleEmitter> &emitters) {
 
-    std::vector<vmath::vec3> velocities(inside.size());
-    _trilinearInterpolate(inside, _vfield, velocities);
+    DiffuseGridSamples samples;
+    samples.isVelocityEnabled = true;
+    _sampleGrids(inside, samples);
+    std::vector<vmath::vec3> &velocities = samples.velocities;
 
     vmath::vec3 p, v;
     double eps = 1e-6;
+    float randomValues[4];
     for (unsigned int i = 0; i < inside.size(); i++) {
         p = inside[i];
         v = velocities[i];
@@ -1789,7 +2287,12 @@ void DiffuseParticleSimulation::_getInsideDiffuseParticleEmitters(std::vector<vm
         }
 
         double It = _getTurbulencePotential(p, _turbulenceField);
-        if (It > 0.0 && _randomDouble(0.0, 1.0) < _emitterGenerationRate) {
+        if (It <= 0.0) {
+            continue;
+        }
+
+        _generateRandomNumbers(RandomStream::insideEmitterGeneration, i, 0, randomValues);
+        if (randomValues[0] < _emitterGenerationRate) {
             emitters.push_back(DiffuseParticleEmitter(p, v, Ie, 0.0, It, 0.0));
         }
     }
@@ -1801,11 +2304,12 @@ void DiffuseParticleSimulation::_getDiffuseDustParticleEmitters(std::vector<vmat
         return;
     }
 
-    std::vector<vmath::vec3> velocities(particles.size());
-    _trilinearInterpolate(particles, _vfield, velocities);
-
-    std::vector<float> sdfDistances;
-    _solidSDF->trilinearInterpolatePoints(particles, sdfDistances);
+    DiffuseGridSamples samples;
+    samples.isVelocityEnabled = true;
+    samples.isSolidDistanceEnabled = true;
+    _sampleGrids(particles, samples);
+    std::vector<vmath::vec3> &velocities = samples.velocities;
+    std::vector<float> &sdfDistances = samples.solidDistances;
 
     AABB boundary = _getBoundaryAABB();
 
@@ -1841,21 +2345,68 @@ void DiffuseParticleSimulation::_getDiffuseDustParticleEmitters(std::vector<vmat
 
         double dustEmissionStrength = obj->getDustEmissionStrength();
         double Id = _getDustTurbulencePotential(p, dustEmissionStrength, _turbulenceField);
-        if (Id > 0.0 && _randomDouble(0.0, 1.0) < _emitterGenerationRate) {
+        if (Id <= 0.0) {
+            continue;
+        }
+
+        float randomValues[4];
+        _generateRandomNumbers(RandomStream::dustEmitterGeneration, i, 0, randomValues);
+        if (randomValues[0] < _emitterGenerationRate) {
             dustEmitters.push_back(DiffuseParticleEmitter(p, v, Ie, 0.0, 0.0, Id));
         }
     }
 }
 
 void DiffuseParticleSimulation::
-        _shuffleDiffuseParticleEmitters(std::vector<DiffuseParticleEmitter> &emitters) {
+        _shuffleDiffuseParticleEmitters(std::vector<DiffuseParticleEmitter> &emitters,
+                                        RandomStream stream) {
 
-    DiffuseParticleEmitter em;
-    for (int i = (int)emitters.size() - 2; i >= 0; i--) {
-        int j = (rand() % (int)(i - 0 + 1));
-        em = emitters[i];
-        emitters[i] = emitters[j];
-        emitters[j] = em;
+    // Emitters are ordered by a random key drawn for each emitter index. The
+    // index in the low bits makes every sort key unique.
+    std::vector<unsigned long long> sortKeys(emitters.size());
+    float values[4];
+    for (size_t i = 0; i < emitters.size(); i++) {
+        _generateRandomNumbers(stream, (unsigned int)i, 0, values);
+        unsigned long long key = (unsigned long long)(values[0] * 16777216.0f);
+        sortKeys[i] = (key << 32) | (unsigned long long)i;
+    }
+    std::sort(sortKeys.begin(), sortKeys.end());
+
+    std::vector<DiffuseParticleEmitter> shuffled;
+    shuffled.reserve(emitters.size());
+    for (size_t i = 0; i < sortKeys.size(); i++) {
+        shuffled.push_back(emitters[sortKeys[i] & 0xFFFFFFFFULL]);
+    }
+    emitters.swap(shuffled);
+}
+
+void DiffuseParticleSimulation::_generateRandomNumbers(RandomStream stream, 
+                                                       unsigned int counter1, 
+                                                       unsigned int counter2, 
+                                                       float values[4]) {
+    // Philox4x32-10 counter based generator keyed by frame and time step.
+    // The random seed fills the last counter word. The generator is a 
+    // bijection of the counter for a fixed key, so different seeds never 
+    // produce the same values.
+    unsigned int ctr[4] = {counter1, counter2, (unsigned int)stream, _randomSeed};
+    unsigned int key[2] = {_randomKey[0], _randomKey[1]};
+    for (int round = 0; round < 10; round++) {
+        unsigned long long p0 = 0xD2511F53ULL * (unsigned long long)ctr[0];
+        unsigned long long p1 = 0xCD9E8D57ULL * (unsigned long long)ctr[2];
+        unsigned int c0 = (unsigned int)(p1 >> 32) ^ ctr[1] ^ key[0];
+        unsigned int c2 = (unsigned int)(p0 >> 32) ^ ctr[3] ^ key[1];
+        ctr[0] = c0;
+        ctr[1] = (unsigned int)p1;
+        ctr[2] = c2;
+        ctr[3] = (unsigned int)p0;
+        key[0] += 0x9E3779B9;
+        key[1] += 0xBB67AE85;
+    }
+
+    // 24 bit values in [0, 1)
+    float scale = 1.0f / 16777216.0f;
+    for (int i = 0; i < 4; i++) {
+        values[i] = (float)(ctr[i] >> 8) * scale;
     }
 }
 
@@ -1875,69 +2426,170 @@ void DiffuseParticleSimulation::_addNewDiffuseParticles(std::vector<DiffuseParti
 
 void DiffuseParticleSimulation::_emitNormalDiffuseParticles(std::vector<DiffuseParticleEmitter> &emitters, double dt) {
     std::vector<DiffuseParticle> newdps;
-    for (size_t i = 0; i < emitters.size(); i++) {
-        if (_diffuseParticles.size() >= _maxNumDiffuseParticles) {
-            return;
-        }
-
-        _emitDiffuseParticles(emitters[i], dt, newdps);
-    }
+    _emitDiffuseParticles(emitters, dt, RandomStream::normalEmission, newdps);
 
-    _computeNewDiffuseParticleVelocities(newdps);
+    _computeNewDiffuseParticleVelocities(newdps, RandomStream::normalVelocity);
     _addNewDiffuseParticles(newdps);
 }
 
 void DiffuseParticleSimulation::_emitDustDiffuseParticles(std::vector<DiffuseParticleEmitter> &emitters, double dt) {
     std::vector<DiffuseParticle> newdps;
-    for (size_t i = 0; i < emitters.size(); i++) {
-        if (_diffuseParticles.size() >= _maxNumDiffuseParticles) {
-            return;
-        }
-
-        _emitDiffuseParticles(emitters[i], dt, newdps);
-    }
+    _emitDiffuseParticles(emitters, dt, RandomStream::dustEmission, newdps);
 
     for (size_t i = 0; i < newdps.size(); i++) {
         newdps[i].type = DiffuseParticleType::dust;
     }
 
-    _computeNewDiffuseParticleVelocities(newdps);
+    _computeNewDiffuseParticleVelocities(newdps, RandomStream::dustVelocity);
     _addNewDiffuseParticles(newdps);
 }
 
-void DiffuseParticleSimulation::_emitDiffuseParticles(DiffuseParticleEmitter &emitter, 
+void DiffuseParticleSimulation::_emitDiffuseParticles(std::vector<DiffuseParticleEmitter> &emitters, 
                                                       double dt,
+                                                      RandomStream stream,
                                                       std::vector<DiffuseParticle> &particles) {
 
-    int n = _getNumberOfEmissionParticles(emitter, dt);
-    if (_diffuseParticles.size() + n >= _maxNumDiffuseParticles) {
-        n = _maxNumDiffuseParticles - _diffuseParticles.size();
+    if (emitters.empty()) {
+        return;
     }
 
-    if (n <= 0) {
+    if (_diffuseParticles.size() >= _maxNumDiffuseParticles && !_isParticleBudgetSchedulerEnabled) {
         return;
     }
 
+    std::vector<int> emissionCounts;
+    _getEmissionCounts(emitters, dt, emissionCounts);
+
+    // Emission quotas are tracked per importance tier. Without the budget
+    // scheduler all emitters share one tier that is limited by the remaining
+    // particle budget.
+    std::vector<int> emitterTiers(emitters.size(), 0);
+    std::vector<size_t> quotas;
+    if (_isParticleBudgetSchedulerEnabled) {
+        _getScheduledEmissionQuotas(emitters, emissionCounts, emitterTiers, quotas);
+    } else {
+        quotas.push_back(_maxNumDiffuseParticles - _diffuseParticles.size());
+    }
+
+    // Candidates are generated in rounds and only valid candidates count 
+    // against the quotas. Each round assigns emitters a range of candidate 
+    // slots by a prefix sum, continuing where the previous round stopped. 
+    // Valid candidates are accepted in emitter order, so the emitted 
+    // particles do not depend on the size of the rounds.
+    std::vector<int> emitterStarts(emitters.size(), 0);
+    std::vector<int> emitterOffsets(emitters.size() + 1, 0);
+    std::vector<DiffuseParticle> candidates;
+    std::vector<char> isCandidateValid;
+    for (;;) {
+        std::vector<size_t> slots(quotas.size(), 0);
+        for (size_t i = 0; i < quotas.size(); i++) {
+            if (quotas[i] > 0) {
+                slots[i] = std::max(quotas[i], _minEmissionRoundSize);
+            }
+        }
+
+        size_t numCandidates = 0;
+        for (size_t i = 0; i < emitters.size(); i++) {
+            emitterOffsets[i] = (int)numCandidates;
+            size_t &tierSlots = slots[emitterTiers[i]];
+            size_t n = std::min((size_t)(emissionCounts[i] - emitterStarts[i]), tierSlots);
+            tierSlots -= n;
+            numCandidates += n;
+        }
+        emitterOffsets[emitters.size()] = (int)numCandidates;
+
+        if (numCandidates == 0) {
+            break;
+        }
+
+        candidates.assign(numCandidates, DiffuseParticle());
+        isCandidateValid.assign(numCandidates, false);
+        _emitDiffuseParticleCandidates(emitters, emitterStarts, emitterOffsets, 
+                                       dt, stream, candidates, isCandidateValid);
+
+        for (size_t eidx = 0; eidx < emitters.size(); eidx++) {
+            size_t &quota = quotas[emitterTiers[eidx]];
+            for (int i = emitterOffsets[eidx]; i < emitterOffsets[eidx + 1]; i++) {
+                if (quota > 0 && isCandidateValid[i]) {
+                    DiffuseParticle dp = candidates[i];
+                    dp.id = _getDiffuseParticleID();
+                    particles.push_back(dp);
+                    quota--;
+                }
+            }
+            emitterStarts[eidx] += emitterOffsets[eidx + 1] - emitterOffsets[eidx];
+        }
+    }
+}
+
+void DiffuseParticleSimulation::_getEmissionCounts(std::vector<DiffuseParticleEmitter> &emitters, 
+                                                   double dt, 
+                                                   std::vector<int> &emissionCounts) {
     float eps = 10e-4f;
-    if (vmath::length(emitter.velocity) < eps) {
-        return;
+    emissionCounts = std::vector<int>(emitters.size(), 0);
+    for (size_t i = 0; i < emitters.size(); i++) {
+        if (vmath::length(emitters[i].velocity) < eps) {
+            continue;
+        }
+
+        int n = _getNumberOfEmissionParticles(emitters[i], dt);
+        if (n > 0) {
+            emissionCounts[i] = n;
+        }
     }
+}
 
-    float emitterRadius = _emitterRadiusFactor * (float)_markerParticleRadius;
-    vmath::vec3 axis = vmath::normalize(emitter.velocity);
+void DiffuseParticleSimulation::_emitDiffuseParticleCandidates(std::vector<DiffuseParticleEmitter> &emitters, 
+                                                               std::vector<int> &emitterStarts,
+                                                               std::vector<int> &emitterOffsets,
+                                                               double dt,
+                                                               RandomStream stream,
+                                                               std::vector<DiffuseParticle> &candidates,
+                                                               std::vector<char> &isCandidateValid) {
 
-    vmath::vec3 e1;
-    if (fabs(axis.x) - 1.0 < eps && fabs(axis.y) < eps && fabs(axis.z) < eps) {
-        e1 = vmath::normalize(vmath::cross(axis, vmath::vec3(0.0, 1.0, 0.0)));
-    } else {
-        e1 = vmath::normalize(vmath::cross(axis, vmath::vec3(1.0, 0.0, 0.0)));
+    // Threads are assigned an equal share of candidate slots and emit for 
+    // the emitters whose slots start within that share
+    size_t numCandidates = candidates.size();
+    size_t numCPU = ThreadUtils::getMaxThreadCount();
+    int numthreads = (int)fmin(numCPU, numCandidates);
+    std::vector<std::thread> threads(numthreads);
+    std::vector<int> intervals = ThreadUtils::splitRangeIntoIntervals(0, numCandidates, numthreads);
+    std::vector<int> emitterIntervals(numthreads + 1, (int)emitters.size());
+    emitterIntervals[0] = 0;
+    for (int i = 1; i < numthreads; i++) {
+        auto it = std::lower_bound(emitterOffsets.begin(), emitterOffsets.end() - 1, intervals[i]);
+        emitterIntervals[i] = (int)(it - emitterOffsets.begin());
+    }
+
+    for (int i = 0; i < numthreads; i++) {
+        threads[i] = std::thread(&DiffuseParticleSimulation::_emitDiffuseParticlesThread, this,
+                                 emitterIntervals[i], emitterIntervals[i + 1], 
+                                 &emitters, &emitterStarts, &emitterOffsets, dt, stream,
+                                 &candidates, &isCandidateValid);
     }
-    vmath::vec3 e2 = vmath::normalize(vmath::cross(axis, e1));
+
+    for (int i = 0; i < numthreads; i++) {
+        threads[i].join();
+    }
+}
+
+void DiffuseParticleSimulation::_emitDiffuseParticlesThread(int startidx, int endidx,
+                                                            std::vector<DiffuseParticleEmitter> *emitters, 
+                                                            std::vector<int> *emitterStarts,
+                                                            std::vector<int> *emitterOffsets,
+                                                            double dt,
+                                                            RandomStream stream,
+                                                            std::vector<DiffuseParticle> *candidates,
+                                                            std::vector<char> *isCandidateValid) {
+
+    float eps = 10e-4f;
+    float emitterRadius = _emitterRadiusFactor * (float)_markerParticleRadius;
 
     AABB boundary = _getBoundaryAABB();
     boundary.expand(-_solidBufferWidth * _dx);
 
     float solidBuffer = (float)(_solidBufferWidth * _dx);
+    vmath::vec3 hdx(0.5*_dx, 0.5*_dx, 0.5*_dx);
     float minLife = (float)_minDiffuseParticleLifetime;
     float maxLife = (float)_maxDiffuseParticleLifetime;
     float variance = (float)_lifetimeVariance;
@@ -1945,39 +2597,60 @@ void DiffuseParticleSimulation::_emitDiffuseParticles(DiffuseParticleEmitter &em
     vmath::vec3 p;
     vmath::vec3 v(0.0, 0.0, 0.0); // velocities will computed in bulk later
     GridIndex g;
-    for (int i = 0; i < n; i++) {
-        float Xr = (float)(rand()) / (float)RAND_MAX;
-        float Xt = (float)(rand()) / (float)RAND_MAX;
-        float Xh = (float)(rand()) / (float)RAND_MAX;
-
-        float r = emitterRadius * sqrt(Xr);
-        float theta = Xt * twopi;
-        float h = Xh * vmath::length((float)dt * emitter.velocity);
-        float sinval = sin(theta);
-        float cosval = cos(theta);
-
-        p = emitter.position + r * cosval * e1 + r * sinval * e2 + h * axis;
-        g = Grid3d::positionToGridIndex(p, _dx);
-        if (!Grid3d::isGridIndexInRange(g, _isize, _jsize, _ksize)) {
+    float randomValues[4];
+    for (int eidx = startidx; eidx < endidx; eidx++) {
+        int n = emitterOffsets->at(eidx + 1) - emitterOffsets->at(eidx);
+        if (n <= 0) {
             continue;
         }
 
-        if (_solidSDF->trilinearInterpolate(p) < solidBuffer) {
-            continue;
-        }
+        DiffuseParticleEmitter emitter = emitters->at(eidx);
+        vmath::vec3 axis = vmath::normalize(emitter.velocity);
 
-        float lifetime = minLife + emitter.energyPotential * (maxLife - minLife);
-        lifetime += _randomDouble(-variance, variance);
-        if (lifetime <= 0.0f) {
-            continue;
-        }
+        vmath::vec3 e1;
+        if (fabs(axis.x) - 1.0 < eps && fabs(axis.y) < eps && fabs(axis.z) < eps) {
+            e1 = vmath::normalize(vmath::cross(axis, vmath::vec3(0.0, 1.0, 0.0)));
+        } else {
+            e1 = vmath::normalize(vmath::cross(axis, vmath::vec3(1.0, 0.0, 0.0)));
+        }
+        vmath::vec3 e2 = vmath::normalize(vmath::cross(axis, e1));
+
+        float emissionLength = vmath::length((float)dt * emitter.velocity);
+        float lifetimeBase = minLife + emitter.energyPotential * (maxLife - minLife);
+        int offset = emitterOffsets->at(eidx);
+        int start = emitterStarts->at(eidx);
+        for (int i = 0; i < n; i++) {
+            _generateRandomNumbers(stream, (unsigned int)eidx, (unsigned int)(start + i), randomValues);
+            float Xr = randomValues[0];
+            float Xt = randomValues[1];
+            float Xh = randomValues[2];
+
+            float r = emitterRadius * sqrt(Xr);
+            float theta = Xt * twopi;
+            float h = Xh * emissionLength;
+            float sinval = sin(theta);
+            float cosval = cos(theta);
+
+            p = emitter.position + r * cosval * e1 + r * sinval * e2 + h * axis;
+            g = Grid3d::positionToGridIndex(p, _dx);
+            if (!Grid3d::isGridIndexInRange(g, _isize, _jsize, _ksize)) {
+                continue;
+            }
+
+            if (_solidSDF->trilinearInterpolate(p) < solidBuffer) {
+                continue;
+            }
 
-        DiffuseParticle dp(p, v, lifetime, _getDiffuseParticleID());
-        dp.type = _getDiffuseParticleType(dp, boundary);
-        particles.push_back(dp);
+            float lifetime = lifetimeBase + (2.0f * randomValues[3] - 1.0f) * variance;
+            if (lifetime <= 0.0f) {
+                continue;
+            }
 
-        if (particles.size() >= _maxNumDiffuseParticles) {
-            return;
+            DiffuseParticle dp(p, v, lifetime, 0);
+            double dist = Interpolation::trilinearInterpolate(p - hdx, _dx, *_surfaceSDF);
+            dp.type = _getDiffuseParticleType(dp, boundary, dist);
+            (*candidates)[offset + i] = dp;
+            (*isCandidateValid)[offset + i] = true;
         }
     }
 }
@@ -1987,7 +2660,7 @@ int DiffuseParticleSimulation::
                                       double dt) {
 
     GridIndex g = Grid3d::positionToGridIndex(emitter.position, _dx);
-    double iscale = _influenceGrid->get(g);
+    double iscale = _influenceGrid->getInfluence(g);
     double wc = _wavecrestEmissionRate * emitter.wavecrestPotential;
     double t = _turbulenceEmissionRate * emitter.turbulencePotential;
     double d = _dustEmissionRate * emitter.dustPotential;
@@ -2006,23 +2679,39 @@ unsigned char DiffuseParticleSimulation::_getDiffuseParticleID() {
     return (unsigned char)id;
 }
 
-void DiffuseParticleSimulation::_computeNewDiffuseParticleVelocities(std::vector<DiffuseParticle> &particles) {
+void DiffuseParticleSimulation::_computeNewDiffuseParticleVelocities(std::vector<DiffuseParticle> &particles,
+                                                                     RandomStream stream) {
+    if (particles.empty()) {
+        return;
+    }
 
-    std::vector<vmath::vec3> data;
-    data.reserve(particles.size());
-    for (size_t i = 0; i < particles.size(); i++) {
-        data.push_back(particles[i].position);
+    size_t numCPU = ThreadUtils::getMaxThreadCount();
+    int numthreads = (int)fmin(numCPU, particles.size());
+    std::vector<std::thread> threads(numthreads);
+    std::vector<int> intervals = ThreadUtils::splitRangeIntoIntervals(0, particles.size(), numthreads);
+    for (int i = 0; i < numthreads; i++) {
+        threads[i] = std::thread(&DiffuseParticleSimulation::_computeNewDiffuseParticleVelocitiesThread, this,
+                                 intervals[i], intervals[i + 1], &particles, stream);
     }
 
-    _trilinearInterpolate(data, _vfield, data);
+    for (int i = 0; i < numthreads; i++) {
+        threads[i].join();
+    }
+}
 
-    for (size_t i = 0; i < particles.size(); i++) {
-        vmath::vec3 v = data[i];
-        if (particles[i].type == DiffuseParticleType::spray) {
-            v *= _randomDouble(1.0, _sprayEmissionSpeedFactor);
+void DiffuseParticleSimulation::_computeNewDiffuseParticleVelocitiesThread(int startidx, int endidx,
+                                                                           std::vector<DiffuseParticle> *particles,
+                                                                           RandomStream stream) {
+    float randomValues[4];
+    for (int i = startidx; i < endidx; i++) {
+        DiffuseParticle *dp = &(particles->at(i));
+        vmath::vec3 v = _vfield->evaluateVelocityAtPositionLinear(dp->position);
+        if (dp->type == DiffuseParticleType::spray) {
+            _generateRandomNumbers(stream, (unsigned int)i, 0, randomValues);
+            v *= 1.0 + randomValues[0] * (_sprayEmissionSpeedFactor - 1.0);
         }
 
-        particles[i].velocity = v;
+        dp->velocity = v;
     }
 }
 
@@ -2031,6 +2720,12 @@ void DiffuseParticleSimulation::_updateDiffuseParticleTypes() {
     boundary.expand(-_solidBufferWidth * _dx);
 
     DiffuseParticleAttributes atts = _getDiffuseParticleAttributes();
+
+    // Surface distances are sampled in bulk before the types are classified.
+    DiffuseGridSamples samples;
+    samples.isSurfaceDistanceEnabled = true;
+    _sampleGrids(*(atts.positions), samples);
+
     for (size_t i = 0; i < _diffuseParticles.size(); i++) {
         if ((DiffuseParticleType)atts.types->at(i) == DiffuseParticleType::dust) {
             continue;
@@ -2038,7 +2733,7 @@ void DiffuseParticleSimulation::_updateDiffuseParticleTypes() {
 
         DiffuseParticle dp = atts.getDiffuseParticle(i);
         DiffuseParticleType oldtype = dp.type;
-        DiffuseParticleType newtype = _getDiffuseParticleType(dp, boundary);
+        DiffuseParticleType newtype = _getDiffuseParticleType(dp, boundary, samples.surfaceDistances[i]);
         atts.types->at(i) = (char)newtype;
 
         if (oldtype == DiffuseParticleType::bubble && 
@@ -2049,7 +2744,9 @@ void DiffuseParticleSimulation::_updateDiffuseParticleTypes() {
     }
 }
 
-DiffuseParticleType DiffuseParticleSimulation::_getDiffuseParticleType(DiffuseParticle &dp, AABB &boundary) {
+DiffuseParticleType DiffuseParticleSimulation::_getDiffuseParticleType(DiffuseParticle &dp, 
+                                                                       AABB &boundary,
+                                                                       double dist) {
 
     if (!boundary.isPointInside(dp.position)) {
         return DiffuseParticleType::spray;
@@ -2057,8 +2754,6 @@ DiffuseParticleType DiffuseParticleSimulation::_getDiffuseParticleType(DiffusePa
 
     double foamDist = _maxFoamToSurfaceDistance * _dx;
     double foamOffset = _foamLayerOffset * _dx;
-    vmath::vec3 hdx(0.5*_dx, 0.5*_dx, 0.5*_dx);
-    double dist = Interpolation::trilinearInterpolate(dp.position - hdx, _dx, *_surfaceSDF);
 
     DiffuseParticleType oldtype = dp.type;
     DiffuseParticleType type;
@@ -2080,13 +2775,13 @@ DiffuseParticleType DiffuseParticleSimulation::_getDiffuseParticleType(DiffusePa
     }
 
     if (type == DiffuseParticleType::foam || type == DiffuseParticleType::spray) {
+        // The bordering air grid is only read here. This method is called
+        // from the emission threads, so cells that have not been cached are
+        // looked up in the material grid directly.
         GridIndex g = Grid3d::positionToGridIndex(dp.position, _dx);
-        if (!_isBorderingAirGridSet(g)) {
-            _borderingAirGrid.set(g, _mgrid.isCellNeighbouringAir(g));
-            _isBorderingAirGridSet.set(g, true);
-        }
-        
-        if (!_borderingAirGrid(g)) {
+        bool isBorderingAir = _isBorderingAirGridSet(g) ? _borderingAirGrid(g) : 
+                                                          _mgrid.isCellNeighbouringAir(g);
+        if (!isBorderingAir) {
             type = DiffuseParticleType::bubble;
         }
     }
@@ -2146,104 +2841,29 @@ void DiffuseParticleSimulation::_updateFoamPreservation(double dt) {
 }
 
 void DiffuseParticleSimulation::_advanceDiffuseParticles(double dt) {
-    _advanceSprayParticles(dt);
-    _advanceBubbleParticles(dt);
-    _advanceFoamParticles(dt);
-    _advanceDustParticles(dt);
-}
-
-AABB DiffuseParticleSimulation::_getBoundaryAABB() {
-    double eps = 1e-6;
-    AABB domainAABB(0.0, 0.0, 0.0, _isize * _dx, _jsize * _dx, _ksize * _dx);
-    domainAABB.expand(-3 * _dx - eps);
-    return domainAABB;
-}
-
-void DiffuseParticleSimulation::_advanceSprayParticles(double dt) {
-
-    int spraycount = _getNumSprayParticles();
-    if (spraycount == 0) {
-        return;
-    }
-
-    int numCPU = ThreadUtils::getMaxThreadCount();
-    int numthreads = (int)fmin(numCPU, _diffuseParticles.size());
-    std::vector<std::thread> threads(numthreads);
-    std::vector<int> intervals = ThreadUtils::splitRangeIntoIntervals(0, _diffuseParticles.size(), numthreads);
-    for (int i = 0; i < numthreads; i++) {
-        threads[i] = std::thread(&DiffuseParticleSimulation::_advanceSprayParticlesThread, this,
-                                 intervals[i], intervals[i + 1], dt);
-    }
-
-    for (int i = 0; i < numthreads; i++) {
-        threads[i].join();
-    }
-}
-
-void DiffuseParticleSimulation::_advanceBubbleParticles(double dt) {
-
-    int bubblecount = _getNumBubbleParticles();
-    if (bubblecount == 0) {
-        return;
-    }
-
-    int numCPU = ThreadUtils::getMaxThreadCount();
-    int numthreads = (int)fmin(numCPU, _diffuseParticles.size());
-    std::vector<std::thread> threads(numthreads);
-    std::vector<int> intervals = ThreadUtils::splitRangeIntoIntervals(0, _diffuseParticles.size(), numthreads);
-    for (int i = 0; i < numthreads; i++) {
-        threads[i] = std::thread(&DiffuseParticleSimulation::_advanceBubbleParticlesThread, this,
-                                 intervals[i], intervals[i + 1], dt);
-    }
+    // All particle types are advanced in a single pass over the particles
+    int numCPU = ThreadUtils::getMaxThreadCount();
+    int numthreads = (int)fmin(numCPU, _diffuseParticles.size());
+    std::vector<std::thread> threads(numthreads);
+    std::vector<int> intervals = ThreadUtils::splitRangeIntoIntervals(0, _diffuseParticles.size(), numthreads);
+    for (int i = 0; i < numthreads; i++) {
+        threads[i] = std::thread(&DiffuseParticleSimulation::_advanceDiffuseParticlesThread, this,
+                                 intervals[i], intervals[i + 1], dt);
+    }
 
     for (int i = 0; i < numthreads; i++) {
         threads[i].join();
     }
 }
 
-void DiffuseParticleSimulation::_advanceFoamParticles(double dt) {
-
-    int foamcount = _getNumFoamParticles();
-    if (foamcount == 0) {
-        return;
-    }
-
-    int numCPU = ThreadUtils::getMaxThreadCount();
-    int numthreads = (int)fmin(numCPU, _diffuseParticles.size());
-    std::vector<std::thread> threads(numthreads);
-    std::vector<int> intervals = ThreadUtils::splitRangeIntoIntervals(0, _diffuseParticles.size(), numthreads);
-    for (int i = 0; i < numthreads; i++) {
-        threads[i] = std::thread(&DiffuseParticleSimulation::_advanceFoamParticlesThread, this,
-                                 intervals[i], intervals[i + 1], dt);
-    }
-
-    for (int i = 0; i < numthreads; i++) {
-        threads[i].join();
-    }
-}
-
-void DiffuseParticleSimulation::_advanceDustParticles(double dt) {
-
-    int dustcount = _getNumDustParticles();
-    if (dustcount == 0) {
-        return;
-    }
-
-    int numCPU = ThreadUtils::getMaxThreadCount();
-    int numthreads = (int)fmin(numCPU, _diffuseParticles.size());
-    std::vector<std::thread> threads(numthreads);
-    std::vector<int> intervals = ThreadUtils::splitRangeIntoIntervals(0, _diffuseParticles.size(), numthreads);
-    for (int i = 0; i < numthreads; i++) {
-        threads[i] = std::thread(&DiffuseParticleSimulation::_advanceDustParticlesThread, this,
-                                 intervals[i], intervals[i + 1], dt);
-    }
-
-    for (int i = 0; i < numthreads; i++) {
-        threads[i].join();
-    }
+AABB DiffuseParticleSimulation::_getBoundaryAABB() {
+    double eps = 1e-6;
+    AABB domainAABB(0.0, 0.0, 0.0, _isize * _dx, _jsize * _dx, _ksize * _dx);
+    domainAABB.expand(-3 * _dx - eps);
+    return domainAABB;
 }
 
-void DiffuseParticleSimulation::_advanceSprayParticlesThread(int startidx, int endidx, double dt) {
+void DiffuseParticleSimulation::_advanceDiffuseParticlesThread(int startidx, int endidx, double dt) {
     AABB boundary = _getBoundaryAABB();
     boundary.expand(-_solidBufferWidth * _dx);
 
@@ -2251,29 +2871,24 @@ void DiffuseParticleSimulation::_advanceSprayParticlesThread(int startidx, int e
 
     float deadParticleLifetime = -1e6;
     float invdt = 1.0f / (float)dt;
+    vmath::vec3 nextp, nextv;
     for (int i = startidx; i < endidx; i++) {
         DiffuseParticle dp = atts.getDiffuseParticle(i);
-        if (dp.type != DiffuseParticleType::spray) {
-            continue;
-        }
-
-        double factor = (double)dp.id / (double)(_diffuseParticleIDLimit - 1);
-        double mind = std::max(_sprayDragCoefficient - _sprayDragCoefficient * _sprayDragVarianceFactor, 0.0);
-        double maxd = _sprayDragCoefficient + _sprayDragCoefficient * _sprayDragVarianceFactor;
-        double dragCoefficient = mind + (1.0 - factor) * (maxd - mind);
-
-        vmath::vec3 bodyForce = _getGravityVector(dp.position, dp.type);
-        vmath::vec3 dragvec = -dragCoefficient * dp.velocity * (float)dt;
-        vmath::vec3 nextv = dp.velocity + bodyForce * (float)dt + dragvec;
-        vmath::vec3 nextp = dp.position + nextv * (float)dt;
-
-        vmath::vec3 resolvedPosition;
-        vmath::vec3 resolvedVelocity;
-        bool collisionFound = _resolveSprayCollision(dp.position, nextp, dp, boundary,
-                                                     resolvedPosition, resolvedVelocity);
-        nextp = resolvedPosition;
-        if (collisionFound) {
-            nextv = resolvedVelocity + bodyForce * (float)dt;
+        switch (dp.type) {
+            case DiffuseParticleType::spray:
+                _advanceSprayParticle(dp, dt, boundary, nextp, nextv);
+                break;
+            case DiffuseParticleType::bubble:
+                _advanceBubbleParticle(dp, dt, boundary, nextp, nextv);
+                break;
+            case DiffuseParticleType::foam:
+                _advanceFoamParticle(dp, dt, boundary, nextp, nextv);
+                break;
+            case DiffuseParticleType::dust:
+                _advanceDustParticle(dp, dt, boundary, nextp, nextv);
+                break;
+            default:
+                continue;
         }
 
         float maxv  = (float)_maxVelocityFactor * vmath::length(nextv);
@@ -2286,110 +2901,69 @@ void DiffuseParticleSimulation::_advanceSprayParticlesThread(int startidx, int e
     }
 }
 
-void DiffuseParticleSimulation::_advanceBubbleParticlesThread(int startidx, int endidx, double dt) {
-    AABB boundary = _getBoundaryAABB();
-    boundary.expand(-_solidBufferWidth * _dx);
-
-    DiffuseParticleAttributes atts = _getDiffuseParticleAttributes();
+void DiffuseParticleSimulation::_advanceSprayParticle(DiffuseParticle &dp, double dt, AABB &boundary, 
+                                                      vmath::vec3 &nextp, vmath::vec3 &nextv) {
+    double factor = (double)dp.id / (double)(_diffuseParticleIDLimit - 1);
+    double mind = std::max(_sprayDragCoefficient - _sprayDragCoefficient * _sprayDragVarianceFactor, 0.0);
+    double maxd = _sprayDragCoefficient + _sprayDragCoefficient * _sprayDragVarianceFactor;
+    double dragCoefficient = mind + (1.0 - factor) * (maxd - mind);
 
-    float deadParticleLifetime = -1e6;
-    float invdt = 1.0f / (float)dt;
-    for (int i = startidx; i < endidx; i++) {
-        DiffuseParticle dp = atts.getDiffuseParticle(i);
-        if (dp.type != DiffuseParticleType::bubble) {
-            continue;
-        }
-
-        vmath::vec3 bodyForce = _getGravityVector(dp.position, dp.type);
-        vmath::vec3 vmac = _vfield->evaluateVelocityAtPositionLinear(dp.position);
-        vmath::vec3 vbub = dp.velocity;
-        vmath::vec3 bouyancyVelocity = (float)-_bubbleBouyancyCoefficient * bodyForce;
-        vmath::vec3 dragVelocity = (float)_bubbleDragCoefficient*(vmac - vbub) / (float)dt;
-
-        vmath::vec3 nextv = dp.velocity + (float)dt*(bouyancyVelocity + dragVelocity);
-        vmath::vec3 nextp = dp.position + nextv * (float)dt;
-        nextp = _resolveCollision(dp.position, nextp, dp, boundary);
-
-        float maxv  = (float)_maxVelocityFactor * vmath::length(nextv);
-        if (vmath::length(nextp - dp.position) * invdt > maxv) {
-            atts.lifetimes->at(i) = deadParticleLifetime;
-        } 
+    vmath::vec3 bodyForce = _getGravityVector(dp.position, dp.type);
+    vmath::vec3 dragvec = -dragCoefficient * dp.velocity * (float)dt;
+    nextv = dp.velocity + bodyForce * (float)dt + dragvec;
+    nextp = dp.position + nextv * (float)dt;
 
-        atts.positions->at(i) = nextp;
-        atts.velocities->at(i) = nextv;
+    vmath::vec3 resolvedPosition;
+    vmath::vec3 resolvedVelocity;
+    bool collisionFound = _resolveSprayCollision(dp.position, nextp, dp, boundary,
+                                                 resolvedPosition, resolvedVelocity);
+    nextp = resolvedPosition;
+    if (collisionFound) {
+        nextv = resolvedVelocity + bodyForce * (float)dt;
     }
 }
 
-void DiffuseParticleSimulation::_advanceFoamParticlesThread(int startidx, int endidx, double dt) {
-    AABB boundary = _getBoundaryAABB();
-    boundary.expand(-_solidBufferWidth * _dx);
-
-    DiffuseParticleAttributes atts = _getDiffuseParticleAttributes();
-
-    float deadParticleLifetime = -1e6;
-    float invdt = 1.0f / (float)dt;
-    for (int i = startidx; i < endidx; i++) {
-        DiffuseParticle dp = atts.getDiffuseParticle(i);
-        if (dp.type != DiffuseParticleType::foam) {
-            continue;
-        }
-
-        vmath::vec3 vmac = _vfield->evaluateVelocityAtPositionLinear(dp.position);
-        vmath::vec3 nextv = _foamAdvectionStrength * vmac;
-        vmath::vec3 nextp = dp.position + nextv * (float)dt;
-        nextp = _resolveCollision(dp.position, nextp, dp, boundary);
-
-        float maxv  = (float)_maxVelocityFactor * vmath::length(nextv);
-        if (vmath::length(nextp - dp.position) * invdt > maxv) {
-            atts.lifetimes->at(i) = deadParticleLifetime;
-        } 
+void DiffuseParticleSimulation::_advanceBubbleParticle(DiffuseParticle &dp, double dt, AABB &boundary, 
+                                                       vmath::vec3 &nextp, vmath::vec3 &nextv) {
+    vmath::vec3 bodyForce = _getGravityVector(dp.position, dp.type);
+    vmath::vec3 vmac = _vfield->evaluateVelocityAtPositionLinear(dp.position);
+    vmath::vec3 vbub = dp.velocity;
+    vmath::vec3 bouyancyVelocity = (float)-_bubbleBouyancyCoefficient * bodyForce;
+    vmath::vec3 dragVelocity = (float)_bubbleDragCoefficient*(vmac - vbub) / (float)dt;
 
-        atts.positions->at(i) = nextp;
-        atts.velocities->at(i) = nextv;
-    }
+    nextv = dp.velocity + (float)dt*(bouyancyVelocity + dragVelocity);
+    nextp = dp.position + nextv * (float)dt;
+    nextp = _resolveCollision(dp.position, nextp, dp, boundary);
 }
 
-void DiffuseParticleSimulation::_advanceDustParticlesThread(int startidx, int endidx, double dt) {
-    AABB boundary = _getBoundaryAABB();
-    boundary.expand(-_solidBufferWidth * _dx);
-
-    DiffuseParticleAttributes atts = _getDiffuseParticleAttributes();
-
-    float deadParticleLifetime = -1e6;
-    float invdt = 1.0f / (float)dt;
-    for (int i = startidx; i < endidx; i++) {
-        DiffuseParticle dp = atts.getDiffuseParticle(i);
-        if (dp.type != DiffuseParticleType::dust) {
-            continue;
-        }
-
-        double factor = (double)dp.id / (double)(_diffuseParticleIDLimit - 1);
-        double minb = _dustBouyancyCoefficient - _dustBouyancyCoefficient * _dustBouyancyVarianceFactor;
-        double maxb = _dustBouyancyCoefficient + _dustBouyancyCoefficient * _dustBouyancyVarianceFactor;
-        double buoyancyCoefficient = minb + factor * (maxb - minb);
-
-        double mind = std::max(_dustDragCoefficient - _dustDragCoefficient * _dustDragVarianceFactor, 0.0);
-        double maxd = std::min(_dustDragCoefficient + _dustDragCoefficient * _dustDragVarianceFactor, 1.0);
-        double dragCoefficient = mind + (1.0 - factor) * (maxd - mind);
+void DiffuseParticleSimulation::_advanceFoamParticle(DiffuseParticle &dp, double dt, AABB &boundary, 
+                                                     vmath::vec3 &nextp, vmath::vec3 &nextv) {
+    vmath::vec3 vmac = _vfield->evaluateVelocityAtPositionLinear(dp.position);
+    nextv = _foamAdvectionStrength * vmac;
+    nextp = dp.position + nextv * (float)dt;
+    nextp = _resolveCollision(dp.position, nextp, dp, boundary);
+}
 
-        vmath::vec3 bodyForce = _getGravityVector(dp.position, dp.type);
-        vmath::vec3 vmac = _vfield->evaluateVelocityAtPositionLinear(dp.position);
-        vmath::vec3 vbub = dp.velocity;
-        vmath::vec3 bouyancyVelocity = (float)-buoyancyCoefficient * bodyForce;
-        vmath::vec3 dragVelocity = (float)dragCoefficient * (vmac - vbub) / (float)dt;
+void DiffuseParticleSimulation::_advanceDustParticle(DiffuseParticle &dp, double dt, AABB &boundary, 
+                                                     vmath::vec3 &nextp, vmath::vec3 &nextv) {
+    double factor = (double)dp.id / (double)(_diffuseParticleIDLimit - 1);
+    double minb = _dustBouyancyCoefficient - _dustBouyancyCoefficient * _dustBouyancyVarianceFactor;
+    double maxb = _dustBouyancyCoefficient + _dustBouyancyCoefficient * _dustBouyancyVarianceFactor;
+    double buoyancyCoefficient = minb + factor * (maxb - minb);
 
-        vmath::vec3 nextv = dp.velocity + (float)dt * (bouyancyVelocity + dragVelocity);
-        vmath::vec3 nextp = dp.position + nextv * (float)dt;
-        nextp = _resolveCollision(dp.position, nextp, dp, boundary);
+    double mind = std::max(_dustDragCoefficient - _dustDragCoefficient * _dustDragVarianceFactor, 0.0);
+    double maxd = std::min(_dustDragCoefficient + _dustDragCoefficient * _dustDragVarianceFactor, 1.0);
+    double dragCoefficient = mind + (1.0 - factor) * (maxd - mind);
 
-        float maxv  = (float)_maxVelocityFactor * vmath::length(nextv);
-        if (vmath::length(nextp - dp.position) * invdt > maxv) {
-            atts.lifetimes->at(i) = deadParticleLifetime;
-        } 
+    vmath::vec3 bodyForce = _getGravityVector(dp.position, dp.type);
+    vmath::vec3 vmac = _vfield->evaluateVelocityAtPositionLinear(dp.position);
+    vmath::vec3 vbub = dp.velocity;
+    vmath::vec3 bouyancyVelocity = (float)-buoyancyCoefficient * bodyForce;
+    vmath::vec3 dragVelocity = (float)dragCoefficient * (vmac - vbub) / (float)dt;
 
-        atts.positions->at(i) = nextp;
-        atts.velocities->at(i) = nextv;
-    }
+    nextv = dp.velocity + (float)dt * (bouyancyVelocity + dragVelocity);
+    nextp = dp.position + nextv * (float)dt;
+    nextp = _resolveCollision(dp.position, nextp, dp, boundary);
 }
 
 vmath::vec3 DiffuseParticleSimulation::_resolveCollision(vmath::vec3 oldp, 
@@ -2672,89 +3246,139 @@ vmath::vec3 DiffuseParticleSimulation::_getGravityVector(vmath::vec3 pos, Diffus
 void DiffuseParticleSimulation::
         _getDiffuseParticleTypeCounts(size_t *numfoam, size_t *numbubble, size_t *numspray, size_t *numdust) {
 
-    std::vector<char> *particleTypes;
-    _diffuseParticles.getAttributeValues("TYPE", particleTypes);
-
-    size_t foam = 0;
-    size_t bubble = 0;
-    size_t spray = 0;
-    size_t dust = 0;
-    for (size_t i = 0; i < particleTypes->size(); i++) {
-        DiffuseParticleType type = (DiffuseParticleType)(particleTypes->at(i));
-        if (type == DiffuseParticleType::foam) {
-            foam++;
-        } else if (type == DiffuseParticleType::bubble) {
-            bubble++;
-        } else if (type == DiffuseParticleType::spray) {
-            spray++;
-        }else if (type == DiffuseParticleType::dust) {
-            dust++;
-        }
+    if (!_isDiffuseParticleTypeCountsValid) {
+        _countDiffuseParticleTypes(_diffuseParticleTypeCounts);
+        _isDiffuseParticleTypeCountsValid = true;
     }
 
-    *numfoam = foam;
-    *numbubble = bubble;
-    *numspray = spray;
-    *numdust = dust;
+    std::vector<size_t> &counts = _diffuseParticleTypeCounts;
+    *numfoam = counts[(size_t)DiffuseParticleType::foam];
+    *numbubble = counts[(size_t)DiffuseParticleType::bubble];
+    *numspray = counts[(size_t)DiffuseParticleType::spray];
+    *numdust = counts[(size_t)DiffuseParticleType::dust];
 }
 
-size_t DiffuseParticleSimulation::_getNumSprayParticles() {
+void DiffuseParticleSimulation::_countDiffuseParticleTypes(std::vector<size_t> &counts) {
     std::vector<char> *particleTypes;
     _diffuseParticles.getAttributeValues("TYPE", particleTypes);
 
-    size_t spraycount = 0;
-    for (size_t i = 0; i < particleTypes->size(); i++) {
-        if ((DiffuseParticleType)particleTypes->at(i) == DiffuseParticleType::spray) {
-            spraycount++;
-        }
+    // Each thread counts the particle types of its interval into its own 
+    // set of counts, which are summed after the threads are joined
+    size_t numTypes = (size_t)DiffuseParticleType::notset + 1;
+    int numCPU = ThreadUtils::getMaxThreadCount();
+    int numthreads = (int)fmin(numCPU, particleTypes->size());
+    std::vector<size_t> threadCounts(numthreads * numTypes, 0);
+    std::vector<std::thread> threads(numthreads);
+    std::vector<int> intervals = ThreadUtils::splitRangeIntoIntervals(0, particleTypes->size(), numthreads);
+    for (int i = 0; i < numthreads; i++) {
+        threads[i] = std::thread(&DiffuseParticleSimulation::_countDiffuseParticleTypesThread, this,
+                                 intervals[i], intervals[i + 1], particleTypes, 
+                                 threadCounts.data() + i * numTypes);
     }
 
-    return spraycount;
-}
+    for (int i = 0; i < numthreads; i++) {
+        threads[i].join();
+    }
 
-size_t DiffuseParticleSimulation::_getNumBubbleParticles() {
-    std::vector<char> *particleTypes;
-    _diffuseParticles.getAttributeValues("TYPE", particleTypes);
+    counts.assign(numTypes, 0);
+    for (int i = 0; i < numthreads; i++) {
+        for (size_t tidx = 0; tidx < numTypes; tidx++) {
+            counts[tidx] += threadCounts[i * numTypes + tidx];
+        }
+    }
+}
 
-    size_t bubblecount = 0;
-    for (size_t i = 0; i < particleTypes->size(); i++) {
-        if ((DiffuseParticleType)particleTypes->at(i) == DiffuseParticleType::bubble) {
-            bubblecount++;
+void DiffuseParticleSimulation::_countDiffuseParticleTypesThread(int startidx, int endidx, 
+                                                                 std::vector<char> *particleTypes,
+                                                                 size_t *counts) {
+    size_t numTypes = (size_t)DiffuseParticleType::notset + 1;
+    std::vector<size_t> localCounts(numTypes, 0);
+    for (int i = startidx; i < endidx; i++) {
+        size_t tidx = (size_t)(unsigned char)particleTypes->at(i);
+        if (tidx < numTypes) {
+            localCounts[tidx]++;
         }
     }
 
-    return bubblecount;
+    for (size_t tidx = 0; tidx < numTypes; tidx++) {
+        counts[tidx] = localCounts[tidx];
+    }
 }
 
-size_t DiffuseParticleSimulation::_getNumFoamParticles() {
-    std::vector<char> *particleTypes;
-    _diffuseParticles.getAttributeValues("TYPE", particleTypes);
+size_t DiffuseParticleSimulation::_getNumSprayParticles() {
+    size_t numfoam, numbubble, numspray, numdust;
+    _getDiffuseParticleTypeCounts(&numfoam, &numbubble, &numspray, &numdust);
+    return numspray;
+}
 
-    size_t foamcount = 0;
-    for (size_t i = 0; i < particleTypes->size(); i++) {
-        if ((DiffuseParticleType)particleTypes->at(i) == DiffuseParticleType::foam) {
-            foamcount++;
-        }
-    }
+size_t DiffuseParticleSimulation::_getNumBubbleParticles() {
+    size_t numfoam, numbubble, numspray, numdust;
+    _getDiffuseParticleTypeCounts(&numfoam, &numbubble, &numspray, &numdust);
+    return numbubble;
+}
 
-    return foamcount;
+size_t DiffuseParticleSimulation::_getNumFoamParticles() {
+    size_t numfoam, numbubble, numspray, numdust;
+    _getDiffuseParticleTypeCounts(&numfoam, &numbubble, &numspray, &numdust);
+    return numfoam;
 }
 
 size_t DiffuseParticleSimulation::_getNumDustParticles() {
-    std::vector<char> *particleTypes;
-    _diffuseParticles.getAttributeValues("TYPE", particleTypes);
+    size_t numfoam, numbubble, numspray, numdust;
+    _getDiffuseParticleTypeCounts(&numfoam, &numbubble, &numspray, &numdust);
+    return numdust;
+}
 
-    size_t dustcount = 0;
-    for (size_t i = 0; i < particleTypes->size(); i++) {
-        if ((DiffuseParticleType)particleTypes->at(i) == DiffuseParticleType::dust) {
-            dustcount++;
+void DiffuseParticleSimulation::_removeDiffuseParticles() {
+    DiffuseParticleAttributes atts = _getDiffuseParticleAttributes();
+
+    std::vector<bool> isInsideSolid;
+    _solidSDF->trilinearInterpolateSolidPoints(*(atts.positions), isInsideSolid);
+
+    // Particles are tested for removal in parallel. The per cell particle 
+    // limit depends on particle order and is applied serially to the
+    // particles that pass the tests.
+    size_t numParticles = _diffuseParticles.size();
+    std::vector<char> isRemovedByTests(numParticles, false);
+    int numCPU = ThreadUtils::getMaxThreadCount();
+    int numthreads = (int)fmin(numCPU, numParticles);
+    std::vector<std::thread> threads(numthreads);
+    std::vector<int> intervals = ThreadUtils::splitRangeIntoIntervals(0, numParticles, numthreads);
+    for (int i = 0; i < numthreads; i++) {
+        threads[i] = std::thread(&DiffuseParticleSimulation::_findRemovedDiffuseParticlesThread, this,
+                                 intervals[i], intervals[i + 1], &isInsideSolid, &isRemovedByTests);
+    }
+
+    for (int i = 0; i < numthreads; i++) {
+        threads[i].join();
+    }
+
+    Array3d<int> countGrid = Array3d<int>(_isize, _jsize, _ksize, 0);
+    std::vector<bool> isRemoved(numParticles, false);
+    for (size_t i = 0; i < numParticles; i++) {
+        if (isRemovedByTests[i]) {
+            isRemoved[i] = true;
+            continue;
+        }
+
+        GridIndex g = Grid3d::positionToGridIndex(atts.positions->at(i), _dx);
+        if (countGrid.isIndexInRange(g) && countGrid(g) >= _maxDiffuseParticlesPerCell) {
+            isRemoved[i] = true;
+            continue;
+        }
+
+        if (countGrid.isIndexInRange(g)) {
+            countGrid.add(g, 1);
         }
     }
 
-    return dustcount;
+    _diffuseParticles.removeParticles(isRemoved);
+    _limitNumDiffuseParticles();
 }
 
-void DiffuseParticleSimulation::_removeDiffuseParticles() {
+void DiffuseParticleSimulation::_findRemovedDiffuseParticlesThread(int startidx, int endidx,
+                                                                   std::vector<bool> *isInsideSolid,
+                                                                   std::vector<char> *isRemoved) {
 
     AABB boundary = _getBoundaryAABB();
     AABB collisionBounds = boundary;
@@ -2807,40 +3431,34 @@ void DiffuseParticleSimulation::_removeDiffuseParticles() {
                                    _dustBoundaryCollisions[4] && _dustBoundaryCollisions[5];
 
     DiffuseParticleAttributes atts = _getDiffuseParticleAttributes();
-
-    std::vector<bool> isInsideSolid;
-    _solidSDF->trilinearInterpolateSolidPoints(*(atts.positions), isInsideSolid);
-
-    Array3d<int> countGrid = Array3d<int>(_isize, _jsize, _ksize, 0);
-    std::vector<bool> isRemoved(_diffuseParticles.size(), false);
-    for (size_t i = 0; i < _diffuseParticles.size(); i++) {
+    for (int i = startidx; i < endidx; i++) {
         DiffuseParticle dp = atts.getDiffuseParticle(i);
         if ((!_isFoamEnabled && dp.type == DiffuseParticleType::foam) ||
                 (!_isBubblesEnabled && dp.type == DiffuseParticleType::bubble) ||
                 (!_isSprayEnabled && dp.type == DiffuseParticleType::spray) ||
                 (!_isDustEnabled && dp.type == DiffuseParticleType::dust) ) {
-            isRemoved[i] = true;
+            isRemoved->at(i) = true;
             continue;
         }
 
         if (dp.lifetime <= 0.0) {
-            isRemoved[i] = true;
+            isRemoved->at(i) = true;
             continue;
         }
 
         bool isInBoundary = boundary.isPointInside(dp.position);
         if (_getLimitBehaviour(dp) == LimitBehaviour::kill && !isInBoundary) {
-            isRemoved[i] = true;
+            isRemoved->at(i) = true;
             continue;
         }
 
         if (_getLimitBehaviour(dp) != LimitBehaviour::ballistic && !isInBoundary) {
-            isRemoved[i] = true;
+            isRemoved->at(i) = true;
             continue;
         }
 
-        if (isInBoundary && isInsideSolid[i]) {
-            isRemoved[i] = true;
+        if (isInBoundary && isInsideSolid->at(i)) {
+            isRemoved->at(i) = true;
             continue;
         }
 
@@ -2848,55 +3466,204 @@ void DiffuseParticleSimulation::_removeDiffuseParticles() {
             if (dp.position.x < boundaryXNegFoam || dp.position.x > boundaryXPosFoam ||
                     dp.position.y < boundaryYNegFoam || dp.position.y > boundaryYPosFoam ||
                     dp.position.z < boundaryZNegFoam || dp.position.z > boundaryZPosFoam) {
-                isRemoved[i] = true;
+                isRemoved->at(i) = true;
                 continue;
             }
         } else if (dp.type == DiffuseParticleType::bubble && !isBoundaryAllClosedBubble) {
             if (dp.position.x < boundaryXNegBubble || dp.position.x > boundaryXPosBubble ||
                     dp.position.y < boundaryYNegBubble || dp.position.y > boundaryYPosBubble ||
                     dp.position.z < boundaryZNegBubble || dp.position.z > boundaryZPosBubble) {
-                isRemoved[i] = true;
+                isRemoved->at(i) = true;
                 continue;
             }
         } else if (dp.type == DiffuseParticleType::spray && !isBoundaryAllClosedSpray) {
             if (dp.position.x < boundaryXNegSpray || dp.position.x > boundaryXPosSpray ||
                     dp.position.y < boundaryYNegSpray || dp.position.y > boundaryYPosSpray ||
                     dp.position.z < boundaryZNegSpray || dp.position.z > boundaryZPosSpray) {
-                isRemoved[i] = true;
+                isRemoved->at(i) = true;
                 continue;
             }
         } else if (dp.type == DiffuseParticleType::dust && !isBoundaryAllClosedDust) {
             if (dp.position.x < boundaryXNegDust || dp.position.x > boundaryXPosDust ||
                     dp.position.y < boundaryYNegDust || dp.position.y > boundaryYPosDust ||
                     dp.position.z < boundaryZNegDust || dp.position.z > boundaryZPosDust) {
-                isRemoved[i] = true;
+                isRemoved->at(i) = true;
                 continue;
             }
         }
+    }
+}
 
-        GridIndex g = Grid3d::positionToGridIndex(dp.position, _dx);
-        if (countGrid.isIndexInRange(g) && countGrid(g) >= _maxDiffuseParticlesPerCell) {
-            isRemoved[i] = true;
-            continue;
+int DiffuseParticleSimulation::_getImportanceTier(vmath::vec3 p) {
+    int tier = (int)_importanceRegions.size();
+    float maxWeight = -1.0f;
+    for (size_t i = 0; i < _importanceRegions.size(); i++) {
+        if (_importanceRegionWeights[i] > maxWeight && _importanceRegions[i].isPointInside(p)) {
+            tier = (int)i;
+            maxWeight = _importanceRegionWeights[i];
         }
+    }
 
-        if (countGrid.isIndexInRange(g)) {
-            countGrid.add(g, 1);
+    return tier;
+}
+
+float DiffuseParticleSimulation::_getImportanceTierWeight(int tier) {
+    if (tier >= (int)_importanceRegions.size()) {
+        return _backgroundImportance;
+    }
+    return _importanceRegionWeights[tier];
+}
+
+void DiffuseParticleSimulation::_getImportanceTierCounts(std::vector<size_t> &counts) {
+    counts = std::vector<size_t>(_importanceRegions.size() + 1, 0);
+    if (_importanceRegions.empty()) {
+        counts[0] = _diffuseParticles.size();
+        return;
+    }
+
+    std::vector<vmath::vec3> *positions;
+    _diffuseParticles.getAttributeValues("POSITION", positions);
+    for (size_t i = 0; i < positions->size(); i++) {
+        counts[_getImportanceTier(positions->at(i))]++;
+    }
+}
+
+void DiffuseParticleSimulation::_getEmissionQuotas(std::vector<size_t> &existingCounts, 
+                                                   std::vector<size_t> &emissionDemands, 
+                                                   std::vector<size_t> &quotas) {
+    // Each tier is given a capacity target by filling the particle budget in
+    // proportion to tier weight. A tier that needs less than its share to 
+    // hold its existing and newly emitted particles is capped at its demand 
+    // and the remainder is redistributed over the other tiers.
+    size_t numTiers = existingCounts.size();
+    std::vector<double> demands(numTiers);
+    std::vector<double> capacities(numTiers, 0.0);
+    std::vector<bool> isActive(numTiers, false);
+    for (size_t i = 0; i < numTiers; i++) {
+        demands[i] = (double)existingCounts[i] + (double)emissionDemands[i];
+        isActive[i] = _getImportanceTierWeight((int)i) > 0.0f && demands[i] > 0.0;
+    }
+
+    double remaining = (double)_maxNumDiffuseParticles;
+    bool isFilled = false;
+    while (!isFilled) {
+        double totalWeight = 0.0;
+        for (size_t i = 0; i < numTiers; i++) {
+            if (isActive[i]) {
+                totalWeight += _getImportanceTierWeight((int)i);
+            }
+        }
+
+        if (totalWeight <= 0.0) {
+            break;
         }
+
+        isFilled = true;
+        double satisfied = 0.0;
+        for (size_t i = 0; i < numTiers; i++) {
+            if (!isActive[i]) {
+                continue;
+            }
+
+            double share = remaining * _getImportanceTierWeight((int)i) / totalWeight;
+            capacities[i] = share;
+            if (demands[i] <= share) {
+                capacities[i] = demands[i];
+                satisfied += demands[i];
+                isActive[i] = false;
+                isFilled = false;
+            }
+        }
+        remaining = std::max(remaining - satisfied, 0.0);
     }
 
-    _diffuseParticles.removeParticles(isRemoved);
+    quotas = std::vector<size_t>(numTiers, 0);
+    for (size_t i = 0; i < numTiers; i++) {
+        size_t capacity = (size_t)capacities[i];
+        if (capacity > existingCounts[i]) {
+            quotas[i] = std::min(capacity - existingCounts[i], emissionDemands[i]);
+        }
+    }
+}
+
+void DiffuseParticleSimulation::_getScheduledEmissionQuotas(std::vector<DiffuseParticleEmitter> &emitters, 
+                                                            std::vector<int> &emissionCounts,
+                                                            std::vector<int> &emitterTiers,
+                                                            std::vector<size_t> &quotas) {
+    std::vector<size_t> emissionDemands(_importanceRegions.size() + 1, 0);
+    for (size_t i = 0; i < emitters.size(); i++) {
+        if (emissionCounts[i] > 0) {
+            emitterTiers[i] = _getImportanceTier(emitters[i].position);
+            emissionDemands[emitterTiers[i]] += (size_t)emissionCounts[i];
+        }
+    }
+
+    std::vector<size_t> existingCounts;
+    _getImportanceTierCounts(existingCounts);
+
+    _getEmissionQuotas(existingCounts, emissionDemands, quotas);
+}
+
+void DiffuseParticleSimulation::_limitNumDiffuseParticles() {
+    if (_diffuseParticles.size() <= _maxNumDiffuseParticles) {
+        return;
+    }
 
-    if (_diffuseParticles.size() >= _maxNumDiffuseParticles) {
+    if (_isParticleBudgetSchedulerEnabled) {
+        _retireLowImportanceDiffuseParticles();
+    } else {
         _diffuseParticles.resize(_maxNumDiffuseParticles);
     }
 }
 
+void DiffuseParticleSimulation::_retireLowImportanceDiffuseParticles() {
+    // Particles are retired in order of increasing importance weight and 
+    // then increasing remaining lifetime
+    DiffuseParticleAttributes atts = _getDiffuseParticleAttributes();
+    size_t numParticles = _diffuseParticles.size();
+    size_t numRetired = numParticles - _maxNumDiffuseParticles;
+
+    std::vector<float> weights(numParticles);
+    for (size_t i = 0; i < numParticles; i++) {
+        weights[i] = _getImportanceTierWeight(_getImportanceTier(atts.positions->at(i)));
+    }
+
+    std::vector<size_t> order(numParticles);
+    for (size_t i = 0; i < numParticles; i++) {
+        order[i] = i;
+    }
+
+    std::vector<float> *lifetimes = atts.lifetimes;
+    std::nth_element(order.begin(), order.begin() + numRetired, order.end(), 
+        [&weights, lifetimes](size_t a, size_t b) {
+            if (weights[a] != weights[b]) {
+                return weights[a] < weights[b];
+            }
+            if (lifetimes->at(a) != lifetimes->at(b)) {
+                return lifetimes->at(a) < lifetimes->at(b);
+            }
+            return a < b;
+        }
+    );
+
+    std::vector<bool> isRemoved(numParticles, false);
+    for (size_t i = 0; i < numRetired; i++) {
+        isRemoved[order[i]] = true;
+    }
+    _diffuseParticles.removeParticles(isRemoved);
+}
+
 void DiffuseParticleSimulation::_getDiffuseParticleFileDataWWP(std::vector<vmath::vec3> &positions, 
+                                                               WhitewaterChunkedFile::ChunkLayout &layout,
                                                                std::vector<unsigned char> &ids,
                                                                std::vector<char> &data) {
     FLUIDSIM_ASSERT(positions.size() == ids.size())
 
+    if (_isChunkedFileFormatEnabled) {
+        WhitewaterChunkedFile::writeVectorData(layout, positions, _chunkedFileComponentBits, data);
+        return;
+    }
+
     std::vector<unsigned int> idcounts(_diffuseParticleIDLimit, 0);
     for (size_t i = 0; i < ids.size(); i++) {
         idcounts[(int)ids[i]]++;
@@ -2936,10 +3703,16 @@ void DiffuseParticleSimulation::_getDiffuseParticleFileDataWWP(std::vector<vmath
 }
 
 void DiffuseParticleSimulation::_getDiffuseParticleFileDataWWI(std::vector<int> &intvalues, 
+                                                               WhitewaterChunkedFile::ChunkLayout &layout,
                                                                std::vector<unsigned char> &ids,
                                                                std::vector<char> &data) {
     FLUIDSIM_ASSERT(intvalues.size() == ids.size())
 
+    if (_isChunkedFileFormatEnabled) {
+        WhitewaterChunkedFile::writeIntData(layout, intvalues, data);
+        return;
+    }
+
     std::vector<unsigned int> idcounts(_diffuseParticleIDLimit, 0);
     for (size_t i = 0; i < ids.size(); i++) {
         idcounts[(unsigned int)ids[i]]++;
@@ -2978,10 +3751,16 @@ void DiffuseParticleSimulation::_getDiffuseParticleFileDataWWI(std::vector<int>
 }
 
 void DiffuseParticleSimulation::_getDiffuseParticleFileDataWWF(std::vector<float> &floatvalues, 
+                                                               WhitewaterChunkedFile::ChunkLayout &layout,
                                                                std::vector<unsigned char> &ids,
                                                                std::vector<char> &data) {
     FLUIDSIM_ASSERT(floatvalues.size() == ids.size())
 
+    if (_isChunkedFileFormatEnabled) {
+        WhitewaterChunkedFile::writeFloatData(layout, floatvalues, _chunkedFileComponentBits, data);
+        return;
+    }
+
     std::vector<unsigned int> idcounts(_diffuseParticleIDLimit, 0);
     for (size_t i = 0; i < ids.size(); i++) {
         idcounts[(unsigned int)ids[i]]++;
@@ -3017,4 +3796,36 @@ void DiffuseParticleSimulation::_getDiffuseParticleFileDataWWF(std::vector<float
 
     std::memcpy(data.data() + byteOffset, (char *)floatData.data(), intDataSize);
     byteOffset += intDataSize;
+}
+
+WhitewaterChunkedFile::ChunkLayout& DiffuseParticleSimulation::_getChunkedFileLayout(
+                                            DiffuseParticleType type,
+                                            std::vector<vmath::vec3> &positions, 
+                                            std::vector<unsigned char> &ids,
+                                            WhitewaterChunkedFile::ChunkLayout &localLayout) {
+    if (!_isChunkedFileFormatEnabled) {
+        return localLayout;
+    }
+
+    FLUIDSIM_ASSERT(positions.size() == ids.size())
+    if (!_isChunkedFileLayoutCacheEnabled) {
+        WhitewaterChunkedFile::generateChunkLayout(positions, ids, _diffuseParticleIDLimit, 
+                                                   _chunkedFileChunkSize, localLayout);
+        return localLayout;
+    }
+
+    int idx = (int)type;
+    if (_chunkedFileLayouts.empty()) {
+        _chunkedFileLayouts.resize((int)DiffuseParticleType::notset + 1);
+        _isChunkedFileLayoutValid.assign(_chunkedFileLayouts.size(), false);
+    }
+
+    WhitewaterChunkedFile::ChunkLayout &layout = _chunkedFileLayouts[idx];
+    if (!_isChunkedFileLayoutValid[idx]) {
+        WhitewaterChunkedFile::generateChunkLayout(positions, ids, _diffuseParticleIDLimit, 
+                                                   _chunkedFileChunkSize, layout);
+        _isChunkedFileLayoutValid[idx] = true;
+    }
+
+    return layout;
 }
\ No newline at end of file
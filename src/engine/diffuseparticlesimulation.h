@@ -33,11 +33,13 @@ SOFTWARE.
 #include "vmath.h"
 #include "fragmentedvector.h"
 #include "array3d.h"
+#include "blockarray3d.h"
 #include "aabb.h"
 #include "fluidmaterialgrid.h"
 #include "turbulencefield.h"
 #include "particlesystem.h"
 #include "diffuseparticle.h"
+#include "whitewaterchunkedfile.h"
 
 struct MarkerParticle;
 enum class DiffuseParticleType : char;
@@ -45,6 +47,7 @@ class MeshLevelSet;
 class MACVelocityField;
 class ParticleLevelSet;
 class ForceFieldGrid;
+class InfluenceGrid;
 
 struct DiffuseParticleSimulationParameters {
     int isize;
@@ -63,12 +66,16 @@ struct DiffuseParticleSimulationParameters {
     Array3d<float> *surfaceSDF;
     MeshLevelSet *meshingVolumeSDF;
     bool isMeshingVolumeSet = false;
-    Array3d<float> *curvatureGrid;
-    Array3d<float> *influenceGrid;
+    BlockArray3d<float> *curvatureGrid;
+    InfluenceGrid *influenceGrid;
     Array3d<bool> *nearSolidGrid;
     double nearSolidGridCellSize;
     ForceFieldGrid *forceFieldGrid;
     bool isForceFieldGridSet = false;
+
+    // Keys for the emission random number generator
+    int frame = 0;
+    int frameTimeStep = 0;
 };
 
 enum class LimitBehaviour : char { 
@@ -134,6 +141,9 @@ public:
     double getEmitterGenerationRate();
     void setEmitterGenerationRate(double rate);
 
+    int getRandomSeed();
+    void setRandomSeed(int seed);
+
     double getMinEmitterEnergy();
     void setMinEmitterEnergy(double e);
     double getMaxEmitterEnergy();
@@ -154,6 +164,21 @@ public:
     AABB getEmitterGenerationBounds();
     void setEmitterGenerationBounds(AABB bbox);
 
+    // The particle budget scheduler distributes the max particle count over
+    // importance regions. Each region receives a share of the budget that 
+    // is proportional to its importance and when the budget is exceeded, 
+    // particles in the least important regions are removed first. A position 
+    // belongs to the most important region that contains it, or to the 
+    // background if no region contains it.
+    void enableParticleBudgetScheduler();
+    void disableParticleBudgetScheduler();
+    bool isParticleBudgetSchedulerEnabled();
+    void addImportanceRegion(AABB bbox, float importance);
+    void clearImportanceRegions();
+    int getNumImportanceRegions();
+    float getBackgroundImportance();
+    void setBackgroundImportance(float importance);
+
     double getMinDiffuseParticleLifetime();
     void setMinDiffuseParticleLifetime(double lifetime);
     double getMaxDiffuseParticleLifetime();
@@ -252,6 +277,22 @@ public:
     vmath::vec3 getDomainOffset();
     void setDomainScale(double scale);
     double getDomainScale();
+
+    // File data is written in the chunked whitewater format (WWC) instead 
+    // of the WWP, WWI and WWF formats when enabled
+    void enableChunkedFileFormat();
+    void disableChunkedFileFormat();
+    bool isChunkedFileFormatEnabled();
+    void setChunkedFileComponentBits(int bits);
+    int getChunkedFileComponentBits();
+
+    // Between beginChunkedFileOutput and endChunkedFileOutput, the chunk 
+    // layout of each particle type is generated once and shared by all 
+    // files of that type. Particles must not change in between. Outside of
+    // this bracket, a layout is generated for each file and not kept.
+    void beginChunkedFileOutput();
+    void endChunkedFileOutput();
+
     void getDiffuseParticleFileDataWWP(std::vector<char> &data);
     void getFoamParticleFileDataWWP(std::vector<char> &data);
     void getBubbleParticleFileDataWWP(std::vector<char> &data);
@@ -278,6 +319,23 @@ public:
 
 private:
 
+    // Independent streams of the counter based emission random number
+    // generator. Values drawn from a stream depend only on the random seed,
+    // frame, time step and counters so that emission does not depend on 
+    // thread count.
+    enum class RandomStream : unsigned int { 
+        normalEmitterShuffle = 0, 
+        dustEmitterShuffle = 1,
+        normalEmission = 2,
+        dustEmission = 3,
+        normalVelocity = 4,
+        dustVelocity = 5,
+        markerParticleJitter = 6,
+        surfaceEmitterGeneration = 7,
+        insideEmitterGeneration = 8,
+        dustEmitterGeneration = 9
+    };
+
     struct DiffuseParticleEmitter {
         vmath::vec3 position;
         vmath::vec3 velocity;
@@ -301,6 +359,16 @@ private:
                                    dustPotential(d) {}
     };    
 
+    // Upper bounds of the values that emitter potentials are computed from
+    // within a block of cells
+    struct EmitterBlockBounds {
+        float maxu = 0.0f;
+        float maxv = 0.0f;
+        float maxw = 0.0f;
+        float maxCurvature = 0.0f;
+        float maxTurbulence = 0.0f;
+    };
+
     struct DiffuseParticleAttributes {
         std::vector<vmath::vec3> *positions = nullptr;
         std::vector<vmath::vec3> *velocities = nullptr;
@@ -321,24 +389,45 @@ private:
 
     DiffuseParticleAttributes _getDiffuseParticleAttributes();
 
-    void _trilinearInterpolate(std::vector<vmath::vec3> &input, MACVelocityField *vfield, 
-                               std::vector<vmath::vec3> &output);
-    void _trilinearInterpolateThread(int startidx, int endidx, 
-                                     std::vector<vmath::vec3> *input, MACVelocityField *vfield, 
-                                     std::vector<vmath::vec3> *output);
+    // Values of the simulation grids at a set of positions. Each enabled
+    // group is sampled in a single pass over the positions and grids that
+    // share a layout also share the interpolation stencil of a position.
+    struct DiffuseGridSamples {
+        bool isVelocityEnabled = false;
+        bool isSurfaceDistanceEnabled = false;
+        bool isWavecrestEnabled = false;        // curvature and surface gradient
+        bool isSolidDistanceEnabled = false;
+
+        std::vector<vmath::vec3> velocities;
+        std::vector<double> surfaceDistances;
+        std::vector<float> curvatures;
+        std::vector<vmath::vec3> surfaceGradients;
+        std::vector<float> solidDistances;
+    };
+
+    void _sampleGrids(std::vector<vmath::vec3> &positions, DiffuseGridSamples &samples);
+    void _sampleGridsThread(int startidx, int endidx, 
+                            std::vector<vmath::vec3> *positions, DiffuseGridSamples *samples);
     void _getDiffuseParticleEmitters(std::vector<DiffuseParticleEmitter> &normalEmitters,
                                      std::vector<DiffuseParticleEmitter> &dustEmitters);
+    void _initializeEmitterBlockGrid();
+    void _computeEmitterBlockBoundsThread(int startidx, int endidx, 
+                                          Array3d<EmitterBlockBounds> *blockBounds);
+    EmitterBlockBounds _getEmitterBlockNeighbourhoodBounds(Array3d<EmitterBlockBounds> &blockBounds, 
+                                                           GridIndex b);
+    bool _isEmitterEnergyPossible(EmitterBlockBounds &bounds);
+    bool _isEmitterBlockActive(EmitterBlockBounds &bounds);
     void _sortMarkerParticlePositions(std::vector<vmath::vec3> &surface, 
                                       std::vector<vmath::vec3> &inside);
     double _getParticleJitter();
-    vmath::vec3 _jitterParticlePosition(vmath::vec3 p, double jitter);
+    vmath::vec3 _jitterParticlePosition(vmath::vec3 p, double jitter, unsigned int counter);
     void _initializeMaterialGrid();
     void _initializeMaterialGridThread(int startidx, int endidx);
     void _shrinkMaterialGridFluidThread(int startidx, int endidx, 
                                         FluidMaterialGrid *mgridtemp);
     void _getSurfaceDiffuseParticleEmitters(std::vector<vmath::vec3> &surface, 
                                             std::vector<DiffuseParticleEmitter> &emitters);
-    double _getWavecrestPotential(vmath::vec3 p, vmath::vec3 v);
+    double _getWavecrestPotential(vmath::vec3 v, float curvature, vmath::vec3 surfaceGradient);
     double _getTurbulencePotential(vmath::vec3 p, TurbulenceField &tfield);
     double _getDustTurbulencePotential(vmath::vec3 p, double emissionStrength, TurbulenceField &tfield);
     double _getEnergyPotential(vmath::vec3 velocity);
@@ -346,35 +435,63 @@ private:
                                            std::vector<DiffuseParticleEmitter> &emitters);
     void _getDiffuseDustParticleEmitters(std::vector<vmath::vec3> &particles, 
                                          std::vector<DiffuseParticleEmitter> &dustEmitters);
-    void _shuffleDiffuseParticleEmitters(std::vector<DiffuseParticleEmitter> &emitters);
+    void _shuffleDiffuseParticleEmitters(std::vector<DiffuseParticleEmitter> &emitters,
+                                         RandomStream stream);
 
     void _addNewDiffuseParticles(std::vector<DiffuseParticle> &newDiffuseParticles);
     void _emitNormalDiffuseParticles(std::vector<DiffuseParticleEmitter> &emitters, double dt);
     void _emitDustDiffuseParticles(std::vector<DiffuseParticleEmitter> &emitters, double dt);
-    void _emitDiffuseParticles(DiffuseParticleEmitter &emitter, 
+    void _emitDiffuseParticles(std::vector<DiffuseParticleEmitter> &emitters, 
                                double dt,
+                               RandomStream stream,
                                std::vector<DiffuseParticle> &particles);
+    void _getEmissionCounts(std::vector<DiffuseParticleEmitter> &emitters, 
+                            double dt, 
+                            std::vector<int> &emissionCounts);
+    void _emitDiffuseParticleCandidates(std::vector<DiffuseParticleEmitter> &emitters, 
+                                        std::vector<int> &emitterStarts,
+                                        std::vector<int> &emitterOffsets,
+                                        double dt,
+                                        RandomStream stream,
+                                        std::vector<DiffuseParticle> &candidates,
+                                        std::vector<char> &isCandidateValid);
+    void _emitDiffuseParticlesThread(int startidx, int endidx,
+                                     std::vector<DiffuseParticleEmitter> *emitters, 
+                                     std::vector<int> *emitterStarts,
+                                     std::vector<int> *emitterOffsets,
+                                     double dt,
+                                     RandomStream stream,
+                                     std::vector<DiffuseParticle> *candidates,
+                                     std::vector<char> *isCandidateValid);
     int _getNumberOfEmissionParticles(DiffuseParticleEmitter &emitter,
                                       double dt);
     unsigned char _getDiffuseParticleID();
-    void _computeNewDiffuseParticleVelocities(std::vector<DiffuseParticle> &particles);
+    void _computeNewDiffuseParticleVelocities(std::vector<DiffuseParticle> &particles,
+                                              RandomStream stream);
+    void _computeNewDiffuseParticleVelocitiesThread(int startidx, int endidx,
+                                                    std::vector<DiffuseParticle> *particles,
+                                                    RandomStream stream);
+    void _generateRandomNumbers(RandomStream stream, 
+                                unsigned int counter1, unsigned int counter2, 
+                                float values[4]);
 
     void _updateDiffuseParticleTypes();
-    DiffuseParticleType _getDiffuseParticleType(DiffuseParticle &p, AABB &boundary);
+    DiffuseParticleType _getDiffuseParticleType(DiffuseParticle &p, AABB &boundary, double dist);
 
     void _updateDiffuseParticleLifetimes(double dt);
     void _updateFoamPreservation(double dt);
 
     void _advanceDiffuseParticles(double dt);
     AABB _getBoundaryAABB();
-    void _advanceSprayParticles(double dt);
-    void _advanceBubbleParticles(double dt);
-    void _advanceFoamParticles(double dt);
-    void _advanceDustParticles(double dt);
-    void _advanceSprayParticlesThread(int startidx, int endidx, double dt);
-    void _advanceBubbleParticlesThread(int startidx, int endidx, double dt);
-    void _advanceFoamParticlesThread(int startidx, int endidx, double dt);
-    void _advanceDustParticlesThread(int startidx, int endidx, double dt);
+    void _advanceDiffuseParticlesThread(int startidx, int endidx, double dt);
+    void _advanceSprayParticle(DiffuseParticle &dp, double dt, AABB &boundary, 
+                               vmath::vec3 &nextp, vmath::vec3 &nextv);
+    void _advanceBubbleParticle(DiffuseParticle &dp, double dt, AABB &boundary, 
+                                vmath::vec3 &nextp, vmath::vec3 &nextv);
+    void _advanceFoamParticle(DiffuseParticle &dp, double dt, AABB &boundary, 
+                              vmath::vec3 &nextp, vmath::vec3 &nextv);
+    void _advanceDustParticle(DiffuseParticle &dp, double dt, AABB &boundary, 
+                              vmath::vec3 &nextp, vmath::vec3 &nextv);
     vmath::vec3 _resolveCollision(vmath::vec3 oldp, vmath::vec3 newp, 
                                   DiffuseParticle &dp, AABB &boundary);
     bool _resolveSprayCollision(vmath::vec3 oldp, vmath::vec3 newp,
@@ -390,22 +507,49 @@ private:
                                        size_t *numbubble, 
                                        size_t *numspray,
                                        size_t *numdust);
+    void _countDiffuseParticleTypes(std::vector<size_t> &counts);
+    void _countDiffuseParticleTypesThread(int startidx, int endidx, 
+                                          std::vector<char> *particleTypes,
+                                          size_t *counts);
     size_t _getNumSprayParticles();
     size_t _getNumBubbleParticles();
     size_t _getNumFoamParticles();
     size_t _getNumDustParticles();
 
     void _removeDiffuseParticles();
+    void _findRemovedDiffuseParticlesThread(int startidx, int endidx,
+                                            std::vector<bool> *isInsideSolid,
+                                            std::vector<char> *isRemoved);
+
+    int _getImportanceTier(vmath::vec3 p);
+    float _getImportanceTierWeight(int tier);
+    void _getImportanceTierCounts(std::vector<size_t> &counts);
+    void _getEmissionQuotas(std::vector<size_t> &existingCounts, 
+                            std::vector<size_t> &emissionDemands, 
+                            std::vector<size_t> &quotas);
+    void _getScheduledEmissionQuotas(std::vector<DiffuseParticleEmitter> &emitters, 
+                                     std::vector<int> &emissionCounts,
+                                     std::vector<int> &emitterTiers,
+                                     std::vector<size_t> &quotas);
+    void _limitNumDiffuseParticles();
+    void _retireLowImportanceDiffuseParticles();
 
     void _getDiffuseParticleFileDataWWP(std::vector<vmath::vec3> &positions, 
+                                        WhitewaterChunkedFile::ChunkLayout &layout,
                                         std::vector<unsigned char> &ids,
                                         std::vector<char> &data);
     void _getDiffuseParticleFileDataWWI(std::vector<int> &intvalues, 
+                                        WhitewaterChunkedFile::ChunkLayout &layout,
                                         std::vector<unsigned char> &ids,
                                         std::vector<char> &data);
     void _getDiffuseParticleFileDataWWF(std::vector<float> &floatvalues, 
+                                        WhitewaterChunkedFile::ChunkLayout &layout,
                                         std::vector<unsigned char> &ids,
                                         std::vector<char> &data);
+    WhitewaterChunkedFile::ChunkLayout& _getChunkedFileLayout(DiffuseParticleType type,
+                                                              std::vector<vmath::vec3> &positions, 
+                                                              std::vector<unsigned char> &ids,
+                                                              WhitewaterChunkedFile::ChunkLayout &localLayout);
 
     template<class T>
     void _removeItemsFromVector(FragmentedVector<T> &items, std::vector<bool> &isRemoved) {
@@ -426,10 +570,6 @@ private:
         items.shrink_to_fit();
     }
 
-    inline double _randomDouble(double min, double max) {
-        return min + ((double)rand() / (double)RAND_MAX) * (max - min);
-    }
-
     int _isize = 0;
     int _jsize = 0;
     int _ksize = 0;
@@ -437,6 +577,8 @@ private:
     double _CFLConditionNumber = 5;
     double _markerParticleRadius = 0;
     vmath::vec3 _bodyForce;
+    unsigned int _randomKey[2] = {0, 0};
+    unsigned int _randomSeed = 0;
     float _forceFieldWeightWhitewaterFoam = 1.0f;
     float _forceFieldWeightWhitewaterBubble = 1.0f;
     float _forceFieldWeightWhitewaterSpray = 1.0f;
@@ -465,6 +607,12 @@ private:
     double _emitterGenerationRate = 1.0;
     size_t _maxNumDiffuseParticles = 10e6;
     size_t _maxNumDiffuseParticlesLimit = std::numeric_limits<size_t>::max();
+
+    // Emission candidates are generated in rounds until the particle budget
+    // is filled with valid particles. Every tier with a remaining budget 
+    // receives at least this many candidate slots per round.
+    size_t _minEmissionRoundSize = 1024;
+
     double _minDiffuseParticleLifetime = 0.0;
     double _maxDiffuseParticleLifetime = 7.0;
     double _lifetimeVariance = 3.0;
@@ -511,6 +659,11 @@ private:
     std::vector<bool> _dustActiveSides{true, true, true, true, true, true};
     AABB _emitterGenerationBounds;
 
+    bool _isParticleBudgetSchedulerEnabled = false;
+    std::vector<AABB> _importanceRegions;
+    std::vector<float> _importanceRegionWeights;
+    float _backgroundImportance = 1.0f;
+
     std::vector<bool> _foamBoundaryCollisions{true, true, true, true, true, true};
     std::vector<bool> _bubbleBoundaryCollisions{true, true, true, true, true, true};
     std::vector<bool> _sprayBoundaryCollisions{true, true, true, true, true, true};
@@ -524,8 +677,8 @@ private:
     Array3d<float> *_surfaceSDF;
     MeshLevelSet *_meshingVolumeSDF = NULL;
     bool _isMeshingVolumeSet = false;
-    Array3d<float> *_kgrid;
-    Array3d<float> *_influenceGrid;
+    BlockArray3d<float> *_kgrid;
+    InfluenceGrid *_influenceGrid;
     Array3d<bool> *_nearSolidGrid;
     double _nearSolidGridCellSize = 0.0;
     ForceFieldGrid *_forceFieldGrid;
@@ -534,9 +687,29 @@ private:
     FluidMaterialGrid _mgrid;
     Array3d<bool> _borderingAirGrid;
     Array3d<bool> _isBorderingAirGridSet;
+
+    // Marker particles are only considered as emitters if they lie within an
+    // active block. Blocks are the tiles of the turbulence field. A block is 
+    // inactive when no particle within it can reach the emission thresholds.
+    Array3d<bool> _isEmitterBlockActiveGrid;
     TurbulenceField _turbulenceField;
     ParticleSystem _diffuseParticles;
 
+    // Type counts are computed on the first request after the particles 
+    // have changed and reused until the next change
+    bool _isDiffuseParticleTypeCountsValid = false;
+    std::vector<size_t> _diffuseParticleTypeCounts;
+
     int _currentDiffuseParticleID = 0;
     int _diffuseParticleIDLimit = 256;
+
+    bool _isChunkedFileFormatEnabled = false;
+    int _chunkedFileComponentBits = WhitewaterChunkedFile::defaultComponentBits;
+    int _chunkedFileChunkSize = WhitewaterChunkedFile::defaultChunkSize;
+
+    // Indexed by DiffuseParticleType. The notset entry holds the layout of 
+    // all particle types combined.
+    bool _isChunkedFileLayoutCacheEnabled = false;
+    std::vector<WhitewaterChunkedFile::ChunkLayout> _chunkedFileLayouts;
+    std::vector<bool> _isChunkedFileLayoutValid;
 };
@@ -488,6 +488,34 @@ class FluidSimulation(object):
         pb.init_lib_func(libfunc, [c_void_p, c_int, c_void_p], None)
         pb.execute_lib_func(libfunc, [self(), int(n)])
 
+    @property
+    def enable_surface_decimation(self):
+        libfunc = lib.FluidSimulation_is_surface_decimation_enabled
+        pb.init_lib_func(libfunc, [c_void_p, c_void_p], c_int)
+        return bool(pb.execute_lib_func(libfunc, [self()]))
+
+    @enable_surface_decimation.setter
+    def enable_surface_decimation(self, boolval):
+        if boolval:
+            libfunc = lib.FluidSimulation_enable_surface_decimation
+        else:
+            libfunc = lib.FluidSimulation_disable_surface_decimation
+        pb.init_lib_func(libfunc, [c_void_p, c_void_p], None)
+        pb.execute_lib_func(libfunc, [self()])
+
+    @property
+    def surface_decimation_error_bound(self):
+        libfunc = lib.FluidSimulation_get_surface_decimation_error_bound
+        pb.init_lib_func(libfunc, [c_void_p, c_void_p], c_double)
+        return pb.execute_lib_func(libfunc, [self()])
+
+    @surface_decimation_error_bound.setter
+    @decorators.check_ge_zero
+    def surface_decimation_error_bound(self, e):
+        libfunc = lib.FluidSimulation_set_surface_decimation_error_bound
+        pb.init_lib_func(libfunc, [c_void_p, c_double, c_void_p], None)
+        pb.execute_lib_func(libfunc, [self(), e])
+
     def set_meshing_volume(self, mesh_object):
         libfunc = lib.FluidSimulation_set_meshing_volume
         pb.init_lib_func(libfunc, [c_void_p, c_void_p, c_void_p], None)
@@ -586,6 +614,58 @@ class FluidSimulation(object):
         pb.init_lib_func(libfunc, [c_void_p, c_void_p], None)
         pb.execute_lib_func(libfunc, [self()])
 
+    @property
+    def enable_surface_mesh_streaming(self):
+        libfunc = lib.FluidSimulation_is_surface_mesh_streaming_enabled
+        pb.init_lib_func(libfunc, [c_void_p, c_void_p], c_int)
+        return bool(pb.execute_lib_func(libfunc, [self()]))
+
+    @enable_surface_mesh_streaming.setter
+    def enable_surface_mesh_streaming(self, boolval):
+        if boolval:
+            libfunc = lib.FluidSimulation_enable_surface_mesh_streaming
+        else:
+            libfunc = lib.FluidSimulation_disable_surface_mesh_streaming
+        pb.init_lib_func(libfunc, [c_void_p, c_void_p], None)
+        pb.execute_lib_func(libfunc, [self()])
+
+    def set_surface_mesh_streaming_filepath(self, filepath):
+        c_string = filepath.encode('utf-8') 
+
+        libfunc = lib.FluidSimulation_set_surface_mesh_streaming_filepath
+        pb.init_lib_func(libfunc, [c_void_p, c_char_p, c_void_p], None)
+        pb.execute_lib_func(libfunc, [self(), c_string])
+
+    @property
+    def enable_surface_mesh_temporal_cache(self):
+        libfunc = lib.FluidSimulation_is_surface_mesh_temporal_cache_enabled
+        pb.init_lib_func(libfunc, [c_void_p, c_void_p], c_int)
+        return bool(pb.execute_lib_func(libfunc, [self()]))
+
+    @enable_surface_mesh_temporal_cache.setter
+    def enable_surface_mesh_temporal_cache(self, boolval):
+        if boolval:
+            libfunc = lib.FluidSimulation_enable_surface_mesh_temporal_cache
+        else:
+            libfunc = lib.FluidSimulation_disable_surface_mesh_temporal_cache
+        pb.init_lib_func(libfunc, [c_void_p, c_void_p], None)
+        pb.execute_lib_func(libfunc, [self()])
+
+    @property
+    def enable_surface_anisotropic_kernels(self):
+        libfunc = lib.FluidSimulation_is_surface_anisotropic_kernels_enabled
+        pb.init_lib_func(libfunc, [c_void_p, c_void_p], c_int)
+        return bool(pb.execute_lib_func(libfunc, [self()]))
+
+    @enable_surface_anisotropic_kernels.setter
+    def enable_surface_anisotropic_kernels(self, boolval):
+        if boolval:
+            libfunc = lib.FluidSimulation_enable_surface_anisotropic_kernels
+        else:
+            libfunc = lib.FluidSimulation_disable_surface_anisotropic_kernels
+        pb.init_lib_func(libfunc, [c_void_p, c_void_p], None)
+        pb.execute_lib_func(libfunc, [self()])
+
     @property
     def enable_preview_mesh_output(self):
         libfunc = lib.FluidSimulation_is_preview_mesh_output_enabled
@@ -676,6 +756,33 @@ class FluidSimulation(object):
         pb.init_lib_func(libfunc, [c_void_p, c_void_p], None)
         pb.execute_lib_func(libfunc, [self()])
 
+    @property
+    def enable_whitewater_chunked_output(self):
+        libfunc = lib.FluidSimulation_is_whitewater_chunked_output_enabled
+        pb.init_lib_func(libfunc, [c_void_p, c_void_p], c_int)
+        return bool(pb.execute_lib_func(libfunc, [self()]))
+
+    @enable_whitewater_chunked_output.setter
+    def enable_whitewater_chunked_output(self, boolval):
+        if boolval:
+            libfunc = lib.FluidSimulation_enable_whitewater_chunked_output
+        else:
+            libfunc = lib.FluidSimulation_disable_whitewater_chunked_output
+        pb.init_lib_func(libfunc, [c_void_p, c_void_p], None)
+        pb.execute_lib_func(libfunc, [self()])
+
+    @property
+    def whitewater_chunked_output_bits(self):
+        libfunc = lib.FluidSimulation_get_whitewater_chunked_output_bits
+        pb.init_lib_func(libfunc, [c_void_p, c_void_p], c_int)
+        return pb.execute_lib_func(libfunc, [self()])
+
+    @whitewater_chunked_output_bits.setter
+    def whitewater_chunked_output_bits(self, bits):
+        libfunc = lib.FluidSimulation_set_whitewater_chunked_output_bits
+        pb.init_lib_func(libfunc, [c_void_p, c_int, c_void_p], None)
+        pb.execute_lib_func(libfunc, [self(), int(bits)])
+
     @property
     def enable_whitewater_velocity_attribute(self):
         libfunc = lib.FluidSimulation_is_whitewater_velocity_attribute_enabled
@@ -1502,6 +1609,18 @@ class FluidSimulation(object):
         pb.init_lib_func(libfunc, [c_void_p, c_double, c_void_p], None)
         pb.execute_lib_func(libfunc, [self(), rate])
 
+    @property
+    def diffuse_particle_random_seed(self):
+        libfunc = lib.FluidSimulation_get_diffuse_particle_random_seed
+        pb.init_lib_func(libfunc, [c_void_p, c_void_p], c_int)
+        return pb.execute_lib_func(libfunc, [self()])
+
+    @diffuse_particle_random_seed.setter
+    def diffuse_particle_random_seed(self, seed):
+        libfunc = lib.FluidSimulation_set_diffuse_particle_random_seed
+        pb.init_lib_func(libfunc, [c_void_p, c_int, c_void_p], None)
+        pb.execute_lib_func(libfunc, [self(), seed])
+
     @property
     def min_diffuse_emitter_energy(self):
         libfunc = lib.FluidSimulation_get_min_diffuse_emitter_energy
@@ -1602,6 +1721,49 @@ class FluidSimulation(object):
         pb.init_lib_func(libfunc, [c_void_p, AABB_t, c_void_p], None)
         pb.execute_lib_func(libfunc, [self(), bounds.to_struct()])
 
+    @property
+    def enable_diffuse_particle_budget_scheduler(self):
+        libfunc = lib.FluidSimulation_is_diffuse_particle_budget_scheduler_enabled
+        pb.init_lib_func(libfunc, [c_void_p, c_void_p], c_int)
+        return bool(pb.execute_lib_func(libfunc, [self()]))
+
+    @enable_diffuse_particle_budget_scheduler.setter
+    def enable_diffuse_particle_budget_scheduler(self, boolval):
+        if boolval:
+            libfunc = lib.FluidSimulation_enable_diffuse_particle_budget_scheduler
+        else:
+            libfunc = lib.FluidSimulation_disable_diffuse_particle_budget_scheduler
+        pb.init_lib_func(libfunc, [c_void_p, c_void_p], None)
+        pb.execute_lib_func(libfunc, [self()])
+
+    def add_diffuse_particle_importance_region(self, bounds, importance):
+        libfunc = lib.FluidSimulation_add_diffuse_particle_importance_region
+        pb.init_lib_func(libfunc, [c_void_p, AABB_t, c_double, c_void_p], None)
+        pb.execute_lib_func(libfunc, [self(), bounds.to_struct(), importance])
+
+    def clear_diffuse_particle_importance_regions(self):
+        libfunc = lib.FluidSimulation_clear_diffuse_particle_importance_regions
+        pb.init_lib_func(libfunc, [c_void_p, c_void_p], None)
+        pb.execute_lib_func(libfunc, [self()])
+
+    def get_num_diffuse_particle_importance_regions(self):
+        libfunc = lib.FluidSimulation_get_num_diffuse_particle_importance_regions
+        pb.init_lib_func(libfunc, [c_void_p, c_void_p], c_int)
+        return pb.execute_lib_func(libfunc, [self()])
+
+    @property
+    def diffuse_particle_background_importance(self):
+        libfunc = lib.FluidSimulation_get_diffuse_particle_background_importance
+        pb.init_lib_func(libfunc, [c_void_p, c_void_p], c_double)
+        return pb.execute_lib_func(libfunc, [self()])
+
+    @diffuse_particle_background_importance.setter
+    @decorators.check_ge_zero
+    def diffuse_particle_background_importance(self, importance):
+        libfunc = lib.FluidSimulation_set_diffuse_particle_background_importance
+        pb.init_lib_func(libfunc, [c_void_p, c_double, c_void_p], None)
+        pb.execute_lib_func(libfunc, [self(), importance])
+
     @property
     def min_diffuse_particle_lifetime(self):
         libfunc = lib.FluidSimulation_get_min_diffuse_particle_lifetime
@@ -2618,6 +2780,28 @@ class FluidSimulation(object):
         pb.init_lib_func(libfunc, [c_void_p, c_void_p], None)
         pb.execute_lib_func(libfunc, [self()])
 
+    def set_static_solid_levelset_cache_directory(self, directory):
+        c_string = directory.encode('utf-8') 
+
+        libfunc = lib.FluidSimulation_set_static_solid_levelset_cache_directory
+        pb.init_lib_func(libfunc, [c_void_p, c_char_p, c_void_p], None)
+        pb.execute_lib_func(libfunc, [self(), c_string])
+
+    @property
+    def enable_static_solid_levelset_multi_resolution(self):
+        libfunc = lib.FluidSimulation_is_static_solid_levelset_multi_resolution_enabled
+        pb.init_lib_func(libfunc, [c_void_p, c_void_p], c_int)
+        return bool(pb.execute_lib_func(libfunc, [self()]))
+
+    @enable_static_solid_levelset_multi_resolution.setter
+    def enable_static_solid_levelset_multi_resolution(self, boolval):
+        if boolval:
+            libfunc = lib.FluidSimulation_enable_static_solid_levelset_multi_resolution
+        else:
+            libfunc = lib.FluidSimulation_disable_static_solid_levelset_multi_resolution
+        pb.init_lib_func(libfunc, [c_void_p, c_void_p], None)
+        pb.execute_lib_func(libfunc, [self()])
+
     @property
     def enable_temporary_mesh_levelset(self):
         libfunc = lib.FluidSimulation_is_temporary_mesh_levelset_enabled
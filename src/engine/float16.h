@@ -0,0 +1,142 @@
+/*
+MIT License
+
+Copyright (C) 2026 Ryan L. Guy & Dennis Fassbaender
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+/*
+    IEEE 754 binary16 storage type. Values are converted to and from 32-bit 
+    floats on every access, so arithmetic is always carried out in single 
+    precision. Intended for compact storage of large grids whose values are 
+    either bounded (weights in [0, 1]) or only need to be precise close to 
+    zero (signed distance fields).
+
+    Relative rounding error is at most 2^-11. Magnitudes above 65504 are 
+    stored as infinity.
+*/
+struct float16 {
+    uint16_t bits = 0;
+
+    float16() {}
+    float16(float f) : bits(floatToBits(f)) {}
+
+    operator float() const { 
+        return bitsToFloat(bits); 
+    }
+
+    float16 operator-() const {
+        float16 h;
+        h.bits = bits ^ 0x8000;
+        return h;
+    }
+
+    float16& operator+=(float f) { *this = float16((float)*this + f); return *this; }
+    float16& operator-=(float f) { *this = float16((float)*this - f); return *this; }
+    float16& operator*=(float f) { *this = float16((float)*this * f); return *this; }
+    float16& operator/=(float f) { *this = float16((float)*this / f); return *this; }
+
+    static inline uint16_t floatToBits(float f) {
+        uint32_t x;
+        std::memcpy(&x, &f, sizeof(float));
+
+        uint32_t sign = (x >> 16) & 0x8000;
+        uint32_t absx = x & 0x7FFFFFFF;
+
+        if (absx >= 0x7F800000) {
+            // Inf or NaN
+            uint32_t nan = absx > 0x7F800000 ? 0x0200 : 0;
+            return (uint16_t)(sign | 0x7C00 | nan);
+        }
+
+        if (absx >= 0x477FF000) {
+            // Rounds to a value above the largest finite half
+            return (uint16_t)(sign | 0x7C00);
+        }
+
+        if (absx < 0x38800000) {
+            // Subnormal half or zero
+            if (absx < 0x33000000) {
+                return (uint16_t)sign;
+            }
+            uint32_t exponent = absx >> 23;
+            uint32_t mantissa = (absx & 0x007FFFFF) | 0x00800000;
+            uint32_t shift = 126 - exponent;
+            uint32_t halfMantissa = mantissa >> shift;
+            uint32_t remainder = mantissa & ((1u << shift) - 1);
+            uint32_t halfway = 1u << (shift - 1);
+            if (remainder > halfway || (remainder == halfway && (halfMantissa & 1))) {
+                halfMantissa++;
+            }
+            return (uint16_t)(sign | halfMantissa);
+        }
+
+        // Normal half, round to nearest even
+        uint32_t h = (absx - 0x38000000) >> 13;
+        uint32_t remainder = absx & 0x1FFF;
+        if (remainder > 0x1000 || (remainder == 0x1000 && (h & 1))) {
+            h++;
+        }
+        return (uint16_t)(sign | h);
+    }
+
+    static inline float bitsToFloat(uint16_t h) {
+        uint32_t sign = (uint32_t)(h & 0x8000) << 16;
+        uint32_t exponent = (h >> 10) & 0x1F;
+        uint32_t mantissa = h & 0x03FF;
+
+        uint32_t x;
+        if (exponent == 0x1F) {
+            x = sign | 0x7F800000 | (mantissa << 13);
+        } else if (exponent != 0) {
+            x = sign | ((exponent + 112) << 23) | (mantissa << 13);
+        } else if (mantissa != 0) {
+            // Subnormal half, renormalize
+            exponent = 113;
+            while ((mantissa & 0x0400) == 0) {
+                mantissa <<= 1;
+                exponent--;
+            }
+            x = sign | (exponent << 23) | ((mantissa & 0x03FF) << 13);
+        } else {
+            x = sign;
+        }
+
+        float f;
+        std::memcpy(&f, &x, sizeof(float));
+        return f;
+    }
+};
+
+/*
+    Element type of the grids that support reduced precision storage: the 
+    solid and liquid signed distance fields and the pressure solver weight 
+    grid. Selected at build time with the WITH_HALF_PRECISION_GRIDS option.
+*/
+#if WITH_HALF_PRECISION_GRIDS
+    typedef float16 StorageFloat;
+#else
+    typedef float StorageFloat;
+#endif
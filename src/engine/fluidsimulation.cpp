@@ -25,13 +25,16 @@ SOFTWARE.
 #include "fluidsimulation.h"
 
 #include <cstring>
+#include <cstdio>
 #include <iomanip>
 #include <algorithm>
+#include <fstream>
 
 #include "threadutils.h"
 #include "stopwatch.h"
 #include "viscositysolver.h"
 #include "particlemesher.h"
+#include "meshdecimator.h"
 #include "polygonizer3d.h"
 #include "diffuseparticle.h"
 #include "particlemaskgrid.h"
@@ -484,6 +487,41 @@ void FluidSimulation::setSurfaceSmoothingIterations(int n) {
     _surfaceReconstructionSmoothingIterations = n;
 }
 
+void FluidSimulation::enableSurfaceDecimation() {
+    _logfile.log(std::ostringstream().flush() << 
+                 _logfile.getTime() << " enableSurfaceDecimation" << std::endl);
+
+    _isSurfaceDecimationEnabled = true;
+}
+
+void FluidSimulation::disableSurfaceDecimation() {
+    _logfile.log(std::ostringstream().flush() << 
+                 _logfile.getTime() << " disableSurfaceDecimation" << std::endl);
+
+    _isSurfaceDecimationEnabled = false;
+}
+
+bool FluidSimulation::isSurfaceDecimationEnabled() {
+    return _isSurfaceDecimationEnabled;
+}
+
+double FluidSimulation::getSurfaceDecimationErrorBound() {
+    return _surfaceDecimationErrorBound;
+}
+
+void FluidSimulation::setSurfaceDecimationErrorBound(double e) {
+    if (e < 0.0) {
+        std::string msg = "Error: surface decimation error bound must be greater than or equal to 0.0.\n";
+        msg += "error bound: " + _toString(e) + "\n";
+        throw std::domain_error(msg);
+    }
+
+    _logfile.log(std::ostringstream().flush() << 
+                 _logfile.getTime() << " setSurfaceDecimationErrorBound: " << e << std::endl);
+
+    _surfaceDecimationErrorBound = e;
+}
+
 void FluidSimulation::setMeshingVolume(MeshObject *volumeObject) {
     _logfile.log(std::ostringstream().flush() << 
                  _logfile.getTime() << " setMeshingVolume: " << volumeObject << std::endl);
@@ -606,6 +644,71 @@ bool FluidSimulation::isAsynchronousMeshingEnabled() {
     return _isAsynchronousMeshingEnabled;
 }
 
+void FluidSimulation::enableSurfaceMeshStreaming() {
+    _logfile.log(std::ostringstream().flush() << 
+                 _logfile.getTime() << " enableSurfaceMeshStreaming" << std::endl);
+
+    _isSurfaceMeshStreamingEnabled = true;
+}
+
+void FluidSimulation::disableSurfaceMeshStreaming() {
+    _logfile.log(std::ostringstream().flush() << 
+                 _logfile.getTime() << " disableSurfaceMeshStreaming" << std::endl);
+
+    _isSurfaceMeshStreamingEnabled = false;
+}
+
+bool FluidSimulation::isSurfaceMeshStreamingEnabled() {
+    return _isSurfaceMeshStreamingEnabled;
+}
+
+void FluidSimulation::setSurfaceMeshStreamingFilepath(std::string filepath) {
+    _logfile.log(std::ostringstream().flush() << 
+                 _logfile.getTime() << " setSurfaceMeshStreamingFilepath: " << filepath << std::endl);
+
+    _surfaceMeshStreamingFilepath = filepath;
+}
+
+std::string FluidSimulation::getSurfaceMeshStreamingFilepath() {
+    return _surfaceMeshStreamingFilepath;
+}
+
+void FluidSimulation::enableSurfaceMeshTemporalCache() {
+    _logfile.log(std::ostringstream().flush() << 
+                 _logfile.getTime() << " enableSurfaceMeshTemporalCache" << std::endl);
+
+    _isSurfaceMeshTemporalCacheEnabled = true;
+}
+
+void FluidSimulation::disableSurfaceMeshTemporalCache() {
+    _logfile.log(std::ostringstream().flush() << 
+                 _logfile.getTime() << " disableSurfaceMeshTemporalCache" << std::endl);
+
+    _isSurfaceMeshTemporalCacheEnabled = false;
+}
+
+bool FluidSimulation::isSurfaceMeshTemporalCacheEnabled() {
+    return _isSurfaceMeshTemporalCacheEnabled;
+}
+
+void FluidSimulation::enableSurfaceAnisotropicKernels() {
+    _logfile.log(std::ostringstream().flush() << 
+                 _logfile.getTime() << " enableSurfaceAnisotropicKernels" << std::endl);
+
+    _isSurfaceAnisotropicKernelsEnabled = true;
+}
+
+void FluidSimulation::disableSurfaceAnisotropicKernels() {
+    _logfile.log(std::ostringstream().flush() << 
+                 _logfile.getTime() << " disableSurfaceAnisotropicKernels" << std::endl);
+
+    _isSurfaceAnisotropicKernelsEnabled = false;
+}
+
+bool FluidSimulation::isSurfaceAnisotropicKernelsEnabled() {
+    return _isSurfaceAnisotropicKernelsEnabled;
+}
+
 void FluidSimulation::enablePreviewMeshOutput(double cellsize) {
     if (cellsize <= 0.0) {
         std::string msg = "Error: cell size must be greater than 0.0.\n";
@@ -714,6 +817,41 @@ bool FluidSimulation::isWhitewaterMotionBlurEnabled() {
     return _isWhitewaterMotionBlurEnabled;
 }
 
+void FluidSimulation::enableWhitewaterChunkedOutput() {
+    _logfile.log(std::ostringstream().flush() << 
+                 _logfile.getTime() << " enableWhitewaterChunkedOutput" << std::endl);
+
+    _diffuseMaterial.enableChunkedFileFormat();
+}
+
+void FluidSimulation::disableWhitewaterChunkedOutput() {
+    _logfile.log(std::ostringstream().flush() << 
+                 _logfile.getTime() << " disableWhitewaterChunkedOutput" << std::endl);
+
+    _diffuseMaterial.disableChunkedFileFormat();
+}
+
+bool FluidSimulation::isWhitewaterChunkedOutputEnabled() {
+    return _diffuseMaterial.isChunkedFileFormatEnabled();
+}
+
+int FluidSimulation::getWhitewaterChunkedOutputBits() {
+    return _diffuseMaterial.getChunkedFileComponentBits();
+}
+
+void FluidSimulation::setWhitewaterChunkedOutputBits(int bits) {
+    if (bits != 8 && bits != 16 && bits != 32) {
+        std::string msg = "Error: whitewater chunked output bits must be 8, 16, or 32.\n";
+        msg += "bits: " + _toString(bits) + "\n";
+        throw std::domain_error(msg);
+    }
+
+    _logfile.log(std::ostringstream().flush() << 
+                 _logfile.getTime() << " setWhitewaterChunkedOutputBits: " << bits << std::endl);
+
+    _diffuseMaterial.setChunkedFileComponentBits(bits);
+}
+
 void FluidSimulation::enableSurfaceVelocityAttribute() {
     _logfile.log(std::ostringstream().flush() << 
                  _logfile.getTime() << " enableSurfaceVelocityAttribute" << std::endl);
@@ -1724,6 +1862,17 @@ void FluidSimulation::setDiffuseEmitterGenerationRate(double rate) {
     _diffuseMaterial.setEmitterGenerationRate(rate);
 }
 
+int FluidSimulation::getDiffuseParticleRandomSeed() {
+    return _diffuseMaterial.getRandomSeed();
+}
+
+void FluidSimulation::setDiffuseParticleRandomSeed(int seed) {
+    _logfile.log(std::ostringstream().flush() << 
+                 _logfile.getTime() << " setDiffuseParticleRandomSeed: " << seed << std::endl);
+
+    _diffuseMaterial.setRandomSeed(seed);
+}
+
 double FluidSimulation::getMinDiffuseEmitterEnergy() {
     return _diffuseMaterial.getMinEmitterEnergy();
 }
@@ -1844,6 +1993,69 @@ void FluidSimulation::setDiffuseEmitterGenerationBounds(AABB bbox) {
     _diffuseMaterial.setEmitterGenerationBounds(bbox);
 }
 
+void FluidSimulation::enableDiffuseParticleBudgetScheduler() {
+    _logfile.log(std::ostringstream().flush() << 
+                 _logfile.getTime() << " enableDiffuseParticleBudgetScheduler" << std::endl);
+
+    _diffuseMaterial.enableParticleBudgetScheduler();
+}
+
+void FluidSimulation::disableDiffuseParticleBudgetScheduler() {
+    _logfile.log(std::ostringstream().flush() << 
+                 _logfile.getTime() << " disableDiffuseParticleBudgetScheduler" << std::endl);
+
+    _diffuseMaterial.disableParticleBudgetScheduler();
+}
+
+bool FluidSimulation::isDiffuseParticleBudgetSchedulerEnabled() {
+    return _diffuseMaterial.isParticleBudgetSchedulerEnabled();
+}
+
+void FluidSimulation::addDiffuseParticleImportanceRegion(AABB bbox, double importance) {
+    if (importance < 0) {
+        std::string msg = "Error: importance must be greater than or equal to 0.\n";
+        msg += "importance: " + _toString(importance) + "\n";
+        throw std::domain_error(msg);
+    }
+
+    _logfile.log(std::ostringstream().flush() << 
+                 _logfile.getTime() << " addDiffuseParticleImportanceRegion: " << 
+                 bbox.position.x << " " << bbox.position.y << " " << bbox.position.z << " " <<
+                 bbox.width << " " << bbox.height << " " << bbox.depth << " " << 
+                 importance << std::endl);
+
+    _diffuseMaterial.addImportanceRegion(bbox, (float)importance);
+}
+
+void FluidSimulation::clearDiffuseParticleImportanceRegions() {
+    _logfile.log(std::ostringstream().flush() << 
+                 _logfile.getTime() << " clearDiffuseParticleImportanceRegions" << std::endl);
+
+    _diffuseMaterial.clearImportanceRegions();
+}
+
+int FluidSimulation::getNumDiffuseParticleImportanceRegions() {
+    return _diffuseMaterial.getNumImportanceRegions();
+}
+
+double FluidSimulation::getDiffuseParticleBackgroundImportance() {
+    return _diffuseMaterial.getBackgroundImportance();
+}
+
+void FluidSimulation::setDiffuseParticleBackgroundImportance(double importance) {
+    if (importance < 0) {
+        std::string msg = "Error: background importance must be greater than or equal to 0.\n";
+        msg += "importance: " + _toString(importance) + "\n";
+        throw std::domain_error(msg);
+    }
+
+    _logfile.log(std::ostringstream().flush() << 
+                 _logfile.getTime() << " setDiffuseParticleBackgroundImportance: " << 
+                 importance << std::endl);
+
+    _diffuseMaterial.setBackgroundImportance((float)importance);
+}
+
 double FluidSimulation::getMinDiffuseParticleLifetime() {
     return _diffuseMaterial.getMinDiffuseParticleLifetime();
 }   
@@ -3000,6 +3212,43 @@ bool FluidSimulation::isStaticSolidLevelSetPrecomputationEnabled() {
     return _isStaticSolidLevelSetPrecomputed;
 }
 
+void FluidSimulation::setStaticSolidLevelSetCacheDirectory(std::string directory) {
+    _logfile.log(std::ostringstream().flush() << 
+                 _logfile.getTime() << " setStaticSolidLevelSetCacheDirectory: " << directory << std::endl);
+
+    _staticSolidLevelSetCacheDirectory = directory;
+}
+
+std::string FluidSimulation::getStaticSolidLevelSetCacheDirectory() {
+    return _staticSolidLevelSetCacheDirectory;
+}
+
+void FluidSimulation::enableStaticSolidLevelSetMultiResolution() {
+    _logfile.log(std::ostringstream().flush() << 
+                 _logfile.getTime() << " enableStaticSolidLevelSetMultiResolution" << std::endl);
+
+    if (!_isStaticSolidLevelSetMultiResolutionEnabled) {
+        _isPrecomputedSolidLevelSetUpToDate = false;
+        _isSolidLevelSetUpToDate = false;
+    }
+    _isStaticSolidLevelSetMultiResolutionEnabled = true;
+}
+
+void FluidSimulation::disableStaticSolidLevelSetMultiResolution() {
+    _logfile.log(std::ostringstream().flush() << 
+                 _logfile.getTime() << " disableStaticSolidLevelSetMultiResolution" << std::endl);
+
+    if (_isStaticSolidLevelSetMultiResolutionEnabled) {
+        _isPrecomputedSolidLevelSetUpToDate = false;
+        _isSolidLevelSetUpToDate = false;
+    }
+    _isStaticSolidLevelSetMultiResolutionEnabled = false;
+}
+
+bool FluidSimulation::isStaticSolidLevelSetMultiResolutionEnabled() {
+    return _isStaticSolidLevelSetMultiResolutionEnabled;
+}
+
 void FluidSimulation::enableTemporaryMeshLevelSet() {
     _logfile.log(std::ostringstream().flush() << 
                  _logfile.getTime() << " enableTemporaryMeshLevelSet" << std::endl);
@@ -4482,6 +4731,7 @@ void FluidSimulation::_addMarkerParticles(std::vector<MarkerParticle> &particles
     }
 
     _markerParticles.update();
+    _isStaticSolidLevelSetTileBinningValid = false;
 }
 
 void FluidSimulation::_initializeParticleRadii() {
@@ -5368,6 +5618,7 @@ void FluidSimulation::_loadMarkerParticles(MarkerParticleLoadData &particleData,
     }
 
     _markerParticles.update();
+    _isStaticSolidLevelSetTileBinningValid = false;
 }
 
 void FluidSimulation::_loadDiffuseParticles(DiffuseParticleLoadData &data) {
@@ -5505,6 +5756,11 @@ void FluidSimulation::_updatePrecomputedSolidLevelSet(double dt,
         _isPrecomputedSolidLevelSetUpToDate = false;
     }
 
+    if (_isStaticSolidLevelSetMultiResolutionEnabled) {
+        _updateMultiResolutionStaticSolidLevelSet(dt);
+        return;
+    }
+
     if (_isPrecomputedSolidLevelSetUpToDate) {
         return;
     }
@@ -5515,131 +5771,507 @@ void FluidSimulation::_updatePrecomputedSolidLevelSet(double dt,
         _staticSolidSDF = MeshLevelSet(_isize, _jsize, _ksize, _dx);
     }
 
-    _addStaticObjectsToSDF(dt, _staticSolidSDF);
+    if (_staticSolidLevelSetCacheDirectory.empty()) {
+        _addStaticObjectsToSDF(dt, _staticSolidSDF);
+        _isPrecomputedSolidLevelSetUpToDate = true;
+        return;
+    }
+
+    unsigned long long key = _getStaticSolidLevelSetCacheKey(dt);
+    if (!_loadStaticSolidLevelSetCache(key)) {
+        _addStaticObjectsToSDF(dt, _staticSolidSDF);
+        _writeStaticSolidLevelSetCache(key);
+    }
 
     _isPrecomputedSolidLevelSetUpToDate = true;
 }
 
-void FluidSimulation::_addAnimatedObjectsToSolidSDF(double dt) {
-    std::vector<MeshObject*> inversedObstacles;
-    std::vector<MeshObject*> normalObstacles;
-    for (size_t i = 0; i < _obstacles.size(); i++) {
-        if (_obstacles[i]->isEnabled() && _obstacles[i]->isAnimated()) {
-            if (_obstacles[i]->isInversed()) {
-                inversedObstacles.push_back(_obstacles[i]);
-            } else {
-                normalObstacles.push_back(_obstacles[i]);
-            }
-        }
+void FluidSimulation::_updateMultiResolutionStaticSolidLevelSet(double dt) {
+    if (!_isPrecomputedSolidLevelSetUpToDate) {
+        _computeMultiResolutionStaticSolidLevelSet(dt);
+    } else if (_isStaticSolidLevelSetRefinementPending) {
+        _refineMultiResolutionStaticSolidLevelSet(dt);
     }
+}
 
-    float frameTime = (float)(_currentFrameDeltaTimeRemaining + _currentFrameTimeStep);
-    float frameProgress = 1.0f - frameTime / (float)_currentFrameDeltaTime;
+void FluidSimulation::_computeMultiResolutionStaticSolidLevelSet(double dt) {
+    StopWatch t;
+    t.start();
 
-    if (!_isTempSolidLevelSetEnabled && (!normalObstacles.empty() || !inversedObstacles.empty())) {
-        _tempSolidSDF = MeshLevelSet(_isize, _jsize, _ksize, _dx);
+    int pi, pj, pk;
+    _staticSolidSDF.getGridDimensions(&pi, &pj, &pk);
+    if (pi != _isize || pj != _jsize || pk != _ksize) {
+        _staticSolidSDF = MeshLevelSet(_isize, _jsize, _ksize, _dx);
     }
 
-    if (_isFractureOptimizationEnabled) {
-        if (!normalObstacles.empty()) {
-            _tempSolidSDF.reset();
-            MeshObject tempMeshObject;
-            tempMeshObject.getMeshLevelSetFractureOptimization(normalObstacles, dt, frameProgress, _solidLevelSetExactBand, _tempSolidSDF);
-            _solidSDF.calculateUnion(_tempSolidSDF);
-        }
-    } else {
-        for (size_t i = 0; i < normalObstacles.size(); i++) {
-            _tempSolidSDF.reset();
-            normalObstacles[i]->getMeshLevelSet(dt, frameProgress, _solidLevelSetExactBand, _tempSolidSDF);
-            _solidSDF.calculateUnion(_tempSolidSDF);
+    int factor = _staticSolidLevelSetCoarseFactor;
+    int ci = (int)std::ceil((double)_isize / (double)factor);
+    int cj = (int)std::ceil((double)_jsize / (double)factor);
+    int ck = (int)std::ceil((double)_ksize / (double)factor);
+    _staticSolidCoarseSDF = MeshLevelSet(ci, cj, ck, factor * _dx);
+    _addStaticObjectsToSDF(dt, _staticSolidCoarseSDF);
+
+    _getRequiredStaticSolidLevelSetTiles(_staticSolidLevelSetTiles);
+    GridUtils::featherGrid26(&_staticSolidLevelSetTiles, ThreadUtils::getMaxThreadCount());
+    _isStaticSolidLevelSetTileBinningValid = true;
+    _staticSolidLevelSetTileBinningTravel = 0.0;
+
+    _staticSolidSDF.setExactBandMask(&_staticSolidLevelSetTiles, _staticSolidLevelSetTileWidth);
+    _addStaticObjectsToSDF(dt, _staticSolidSDF);
+    _staticSolidSDF.fillOutsideExactBandMask(_staticSolidCoarseSDF);
+    _staticSolidSDF.clearExactBandMask();
+
+    _isStaticSolidLevelSetRefinementPending = false;
+    _isPrecomputedSolidLevelSetUpToDate = true;
+
+    size_t numActiveTiles = 0;
+    bool *tilesArray = _staticSolidLevelSetTiles.getRawArray();
+    for (size_t i = 0; i < _staticSolidLevelSetTiles.getNumElements(); i++) {
+        if (tilesArray[i]) {
+            numActiveTiles++;
         }
     }
 
-    if (!inversedObstacles.empty()) {
-        MeshLevelSet tempSolidInversedSDF(_isize, _jsize, _ksize, _dx);
-        tempSolidInversedSDF.disableVelocityData();
+    t.stop();
+    _logfile.log(std::ostringstream().flush() << 
+                 "Computed multi-resolution static obstacle level set: " << 
+                 numActiveTiles << " / " << _staticSolidLevelSetTiles.getNumElements() << 
+                 " tiles refined (" << t.getTime() << "s)" << std::endl);
+}
 
-        for (size_t i = 0; i < inversedObstacles.size(); i++) {
-            _tempSolidSDF.reset();
-            _tempSolidSDF.disableVelocityData();
-            inversedObstacles[i]->getMeshLevelSet(dt, frameProgress, _solidLevelSetExactBand, _tempSolidSDF);
-            tempSolidInversedSDF.calculateUnion(_tempSolidSDF);
-        }
+void FluidSimulation::_refineMultiResolutionStaticSolidLevelSet(double dt) {
+    StopWatch t;
+    t.start();
 
-        tempSolidInversedSDF.enableVelocityData();
-        tempSolidInversedSDF.negate();
-        _solidSDF.calculateUnion(tempSolidInversedSDF);
+    MeshLevelSet refinedSDF(_isize, _jsize, _ksize, _dx);
+    refinedSDF.setExactBandMask(&_staticSolidLevelSetRefinementTiles, _staticSolidLevelSetTileWidth);
+    _addStaticObjectsToSDF(dt, refinedSDF);
 
-        _tempSolidSDF.enableVelocityData();
+    bool *tilesArray = _staticSolidLevelSetTiles.getRawArray();
+    bool *refinementTilesArray = _staticSolidLevelSetRefinementTiles.getRawArray();
+    size_t numRefinedTiles = 0;
+    for (size_t i = 0; i < _staticSolidLevelSetTiles.getNumElements(); i++) {
+        if (refinementTilesArray[i]) {
+            tilesArray[i] = true;
+            numRefinedTiles++;
+        }
     }
 
-    if (!_isTempSolidLevelSetEnabled) {
-        _tempSolidSDF = MeshLevelSet();
+    // Closest triangle indices can only be copied between level sets when the
+    // mesh objects were unioned in the same order. This may not be the case
+    // when obstacles are computed concurrently with fracture optimization.
+    if (refinedSDF.getMeshObjects() == _staticSolidSDF.getMeshObjects()) {
+        _staticSolidSDF.mergeExactBandMaskTiles(refinedSDF);
+    } else {
+        _staticSolidSDF.setExactBandMask(&_staticSolidLevelSetTiles, _staticSolidLevelSetTileWidth);
+        _addStaticObjectsToSDF(dt, _staticSolidSDF);
+        _staticSolidSDF.fillOutsideExactBandMask(_staticSolidCoarseSDF);
+        _staticSolidSDF.clearExactBandMask();
     }
-}
 
-void FluidSimulation::_addStaticObjectsToSDF(double dt, MeshLevelSet &sdf){
-    TriangleMesh boundaryMesh = _domainMeshObject.getMesh();
-    sdf.reset();
-    sdf.pushMeshObject(&_domainMeshObject);
-    sdf.disableVelocityData();    // Stops velocity data from being calculated 
-                                  // twice (once during sdf calculations, and
-                                  // once when sdf is negated
-    sdf.fastCalculateSignedDistanceField(boundaryMesh, _solidLevelSetExactBand);
-    sdf.enableVelocityData();
-    sdf.negate();
+    _isStaticSolidLevelSetRefinementPending = false;
 
-    std::vector<MeshObject*> inversedObstacles;
-    std::vector<MeshObject*> normalObstacles;
-    for (size_t i = 0; i < _obstacles.size(); i++) {
-        if (_obstacles[i]->isEnabled() && !_obstacles[i]->isAnimated()) {
-            if (_obstacles[i]->isInversed()) {
-                inversedObstacles.push_back(_obstacles[i]);
-            } else {
-                normalObstacles.push_back(_obstacles[i]);
-            }
-        }
+    t.stop();
+    _logfile.log(std::ostringstream().flush() << 
+                 "Refined multi-resolution static obstacle level set: " << 
+                 numRefinedTiles << " tiles (" << t.getTime() << "s)" << std::endl);
+}
+
+bool FluidSimulation::_isStaticSolidLevelSetRefinementRequired() {
+    if (!_isStaticSolidLevelSetPrecomputed || 
+            !_isStaticSolidLevelSetMultiResolutionEnabled || 
+            !_isPrecomputedSolidLevelSetUpToDate) {
+        return false;
     }
 
-    float frameTime = (float)(_currentFrameDeltaTimeRemaining + _currentFrameTimeStep);
-    float frameProgress = 1.0f - frameTime / (float)_currentFrameDeltaTime;
+    // Refined tiles are padded by one tile beyond the required tiles. Until
+    // the marker particles have travelled a tile width since the last check,
+    // no particle can have left the padding and the binning is reused.
+    double tileSize = _staticSolidLevelSetTileWidth * _dx;
+    if (_isStaticSolidLevelSetTileBinningValid && 
+            _staticSolidLevelSetTileBinningTravel < tileSize && 
+            !_isFluidGeneratingThisFrame()) {
+        return false;
+    }
 
-    if (!_isTempSolidLevelSetEnabled && (!normalObstacles.empty() || !inversedObstacles.empty())) {
-        _tempSolidSDF = MeshLevelSet(_isize, _jsize, _ksize, _dx);
+    Array3d<bool> requiredTiles;
+    _getRequiredStaticSolidLevelSetTiles(requiredTiles);
+    if (requiredTiles.width != _staticSolidLevelSetTiles.width || 
+            requiredTiles.height != _staticSolidLevelSetTiles.height || 
+            requiredTiles.depth != _staticSolidLevelSetTiles.depth) {
+        _isStaticSolidLevelSetTileBinningValid = false;
+        return false;
     }
 
-    if (_isFractureOptimizationEnabled) {
-        if (!normalObstacles.empty()) {
-            _tempSolidSDF.reset();
-            MeshObject tempMeshObject;
-            tempMeshObject.getMeshLevelSetFractureOptimization(normalObstacles, dt, frameProgress, _solidLevelSetExactBand, _tempSolidSDF);
-            sdf.calculateUnion(_tempSolidSDF);
+    Array3d<bool> paddedTiles = requiredTiles;
+    GridUtils::featherGrid26(&paddedTiles, ThreadUtils::getMaxThreadCount());
+
+    _staticSolidLevelSetRefinementTiles = Array3d<bool>(requiredTiles.width, 
+                                                        requiredTiles.height, 
+                                                        requiredTiles.depth, 
+                                                        false);
+
+    bool isRefinementRequired = false;
+    bool isPaddingRefined = true;
+    bool *requiredTilesArray = requiredTiles.getRawArray();
+    bool *paddedTilesArray = paddedTiles.getRawArray();
+    bool *tilesArray = _staticSolidLevelSetTiles.getRawArray();
+    bool *refinementTilesArray = _staticSolidLevelSetRefinementTiles.getRawArray();
+    for (size_t i = 0; i < requiredTiles.getNumElements(); i++) {
+        if (requiredTilesArray[i] && !tilesArray[i]) {
+            isRefinementRequired = true;
         }
-    } else {
-        for (size_t i = 0; i < normalObstacles.size(); i++) {
-            _tempSolidSDF.reset();
-            normalObstacles[i]->getMeshLevelSet(dt, frameProgress, _solidLevelSetExactBand, _tempSolidSDF);
-            sdf.calculateUnion(_tempSolidSDF);
+        if (paddedTilesArray[i] && !tilesArray[i]) {
+            refinementTilesArray[i] = true;
+            isPaddingRefined = false;
         }
     }
 
-    if (!inversedObstacles.empty()) {
-        MeshLevelSet tempSolidInversedSDF(_isize, _jsize, _ksize, _dx);
-        tempSolidInversedSDF.disableVelocityData();
+    _isStaticSolidLevelSetRefinementPending = isRefinementRequired;
+    _isStaticSolidLevelSetTileBinningValid = isRefinementRequired || isPaddingRefined;
+    _staticSolidLevelSetTileBinningTravel = 0.0;
 
-        for (size_t i = 0; i < inversedObstacles.size(); i++) {
-            _tempSolidSDF.reset();
-            _tempSolidSDF.disableVelocityData();
-            inversedObstacles[i]->getMeshLevelSet(dt, frameProgress, _solidLevelSetExactBand, _tempSolidSDF);
-            tempSolidInversedSDF.calculateUnion(_tempSolidSDF);
-        }
+    return isRefinementRequired;
+}
+
+void FluidSimulation::_getRequiredStaticSolidLevelSetTiles(Array3d<bool> &tiles) {
+    // Level set nodes span (isize + 1) x (jsize + 1) x (ksize + 1)
+    int tw = _staticSolidLevelSetTileWidth;
+    int ti = (int)std::ceil((double)(_isize + 1) / (double)tw);
+    int tj = (int)std::ceil((double)(_jsize + 1) / (double)tw);
+    int tk = (int)std::ceil((double)(_ksize + 1) / (double)tw);
+    tiles = Array3d<bool>(ti, tj, tk, false);
+
+    std::vector<vmath::vec3> *positions;
+    _markerParticles.getAttributeValues("POSITION", positions);
+
+    if (!positions->empty()) {
+        int numCPU = ThreadUtils::getMaxThreadCount();
+        int numthreads = (int)fmin(numCPU, positions->size());
+        std::vector<std::thread> threads(numthreads);
+        std::vector<int> intervals = ThreadUtils::splitRangeIntoIntervals(0, positions->size(), numthreads);
+        for (int i = 0; i < numthreads; i++) {
+            threads[i] = std::thread(&FluidSimulation::_getRequiredStaticSolidLevelSetTilesThread, this,
+                                     intervals[i], intervals[i + 1], positions, &tiles);
+        }
+
+        for (int i = 0; i < numthreads; i++) {
+            threads[i].join();
+        }
+    }
+
+    // Fluid added by inflows and fluid objects at the end of this time step
+    // is culled against the solid level set before the next refinement
+    for (size_t i = 0; i < _meshFluidSources.size(); i++) {
+        MeshFluidSource *source = _meshFluidSources[i];
+        if (!source->isEnabled() || !source->isInflow()) {
+            continue;
+        }
+
+        int si, sj, sk;
+        source->getMeshLevelSet()->getGridDimensions(&si, &sj, &sk);
+        AABB bbox(source->getMeshLevelSetOffset(), si * _dx, sj * _dx, sk * _dx);
+        _activateStaticSolidLevelSetTiles(bbox, tiles);
+    }
+
+    for (size_t i = 0; i < _addedFluidMeshObjectQueue.size(); i++) {
+        TriangleMesh m = _addedFluidMeshObjectQueue[i].object.getMesh();
+        if (m.vertices.empty()) {
+            continue;
+        }
+        _activateStaticSolidLevelSetTiles(AABB(m.vertices), tiles);
+    }
+
+    // Expand tiles to cover the distance that the fluid can travel in a
+    // time step plus the exact band of the obstacle surface
+    int margin = (int)std::ceil(_CFLConditionNumber) + _solidLevelSetExactBand + 1;
+    int numLayers = (margin + tw - 1) / tw;
+    for (int i = 0; i < numLayers; i++) {
+        GridUtils::featherGrid26(&tiles, ThreadUtils::getMaxThreadCount());
+    }
+}
+
+void FluidSimulation::_getRequiredStaticSolidLevelSetTilesThread(int startidx, int endidx, 
+                                                                 std::vector<vmath::vec3> *positions, 
+                                                                 Array3d<bool> *tiles) {
+    double tileSize = _staticSolidLevelSetTileWidth * _dx;
+    for (int i = startidx; i < endidx; i++) {
+        GridIndex g = Grid3d::positionToGridIndex(positions->at(i), tileSize);
+        if (tiles->isIndexInRange(g)) {
+            tiles->set(g, true);
+        }
+    }
+}
+
+void FluidSimulation::_activateStaticSolidLevelSetTiles(AABB bbox, Array3d<bool> &tiles) {
+    double tileSize = _staticSolidLevelSetTileWidth * _dx;
+    GridIndex gmin = Grid3d::positionToGridIndex(bbox.getMinPoint(), tileSize);
+    GridIndex gmax = Grid3d::positionToGridIndex(bbox.getMaxPoint(), tileSize);
+    gmin.i = std::max(gmin.i, 0);
+    gmin.j = std::max(gmin.j, 0);
+    gmin.k = std::max(gmin.k, 0);
+    gmax.i = std::min(gmax.i, tiles.width - 1);
+    gmax.j = std::min(gmax.j, tiles.height - 1);
+    gmax.k = std::min(gmax.k, tiles.depth - 1);
+
+    for (int k = gmin.k; k <= gmax.k; k++) {
+        for (int j = gmin.j; j <= gmax.j; j++) {
+            for (int i = gmin.i; i <= gmax.i; i++) {
+                tiles.set(i, j, k, true);
+            }
+        }
+    }
+}
+
+unsigned long long FluidSimulation::_getStaticSolidLevelSetCacheKey(double dt) {
+    // 64-bit FNV-1a offset basis
+    unsigned long long hash = 14695981039346656037ULL;
+
+    int version = 2;
+    int storageFloatSize = (int)sizeof(StorageFloat);
+    int exactBand = _solidLevelSetExactBand;
+    int isFractureOptimizationEnabled = _isFractureOptimizationEnabled ? 1 : 0;
+    hash = _hashData(&version, sizeof(int), hash);
+    hash = _hashData(&storageFloatSize, sizeof(int), hash);
+    hash = _hashData(&_isize, sizeof(int), hash);
+    hash = _hashData(&_jsize, sizeof(int), hash);
+    hash = _hashData(&_ksize, sizeof(int), hash);
+    hash = _hashData(&_dx, sizeof(double), hash);
+    hash = _hashData(&_domainOffset, sizeof(vmath::vec3), hash);
+    hash = _hashData(&exactBand, sizeof(int), hash);
+    hash = _hashData(&isFractureOptimizationEnabled, sizeof(int), hash);
+
+    TriangleMesh domainMesh = _domainMeshObject.getMesh();
+    hash = _hashData(domainMesh.vertices.data(), domainMesh.vertices.size() * sizeof(vmath::vec3), hash);
+    hash = _hashData(domainMesh.triangles.data(), domainMesh.triangles.size() * sizeof(Triangle), hash);
+
+    float frameTime = (float)(_currentFrameDeltaTimeRemaining + _currentFrameTimeStep);
+    float frameProgress = 1.0f - frameTime / (float)_currentFrameDeltaTime;
+    for (size_t i = 0; i < _obstacles.size(); i++) {
+        MeshObject *obj = _obstacles[i];
+        if (!obj->isEnabled() || obj->isAnimated()) {
+            continue;
+        }
+
+        int objectIndex = (int)i;
+        int isInversed = obj->isInversed() ? 1 : 0;
+        float expansion = obj->getMeshExpansion();
+        float velocityScale = obj->getVelocityScale();
+        hash = _hashData(&objectIndex, sizeof(int), hash);
+        hash = _hashData(&isInversed, sizeof(int), hash);
+        hash = _hashData(&expansion, sizeof(float), hash);
+        hash = _hashData(&velocityScale, sizeof(float), hash);
+
+        // dt only enters the level set through the vertex velocities. Hashing
+        // the velocities rather than dt keeps the cache valid across resumes
+        // for obstacles that do not move.
+        TriangleMesh m = obj->getMesh(frameProgress);
+        std::vector<vmath::vec3> velocities = obj->getVertexVelocities(dt, frameProgress);
+        hash = _hashData(m.vertices.data(), m.vertices.size() * sizeof(vmath::vec3), hash);
+        hash = _hashData(m.triangles.data(), m.triangles.size() * sizeof(Triangle), hash);
+        hash = _hashData(velocities.data(), velocities.size() * sizeof(vmath::vec3), hash);
+    }
+
+    return hash;
+}
+
+std::string FluidSimulation::_getStaticSolidLevelSetCacheFilepath(unsigned long long key) {
+    std::ostringstream ss;
+    ss << "staticsdf_" << std::hex << std::setw(16) << std::setfill('0') << key << ".data";
+
+    std::string dir = _staticSolidLevelSetCacheDirectory;
+    char last = dir.back();
+    if (last != '/' && last != '\\') {
+        dir += "/";
+    }
+
+    return dir + ss.str();
+}
+
+std::vector<MeshObject*> FluidSimulation::_getStaticSolidLevelSetObjectTable() {
+    std::vector<MeshObject*> table;
+    table.push_back(&_domainMeshObject);
+    for (size_t i = 0; i < _obstacles.size(); i++) {
+        table.push_back(_obstacles[i]);
+    }
+    return table;
+}
+
+bool FluidSimulation::_loadStaticSolidLevelSetCache(unsigned long long key) {
+    StopWatch t;
+    t.start();
+
+    std::string filepath = _getStaticSolidLevelSetCacheFilepath(key);
+    std::vector<MeshObject*> objectTable = _getStaticSolidLevelSetObjectTable();
+    bool success = _staticSolidSDF.loadFromFile(filepath, key, objectTable);
+
+    t.stop();
+    if (success) {
+        _logfile.log(std::ostringstream().flush() << 
+                     "Loaded static obstacle level set from cache: " << filepath <<
+                     " (" << t.getTime() << "s)" << std::endl);
+    }
+
+    return success;
+}
+
+void FluidSimulation::_writeStaticSolidLevelSetCache(unsigned long long key) {
+    std::string filepath = _getStaticSolidLevelSetCacheFilepath(key);
+    std::vector<MeshObject*> objectTable = _getStaticSolidLevelSetObjectTable();
+    bool success = _staticSolidSDF.writeToFile(filepath, key, objectTable);
+    if (!success) {
+        _logfile.log(std::ostringstream().flush() << 
+                     "WARNING: Unable to write static obstacle level set cache: " << 
+                     filepath << std::endl);
+    }
+}
+
+unsigned long long FluidSimulation::_hashData(const void *data, size_t numBytes, 
+                                              unsigned long long hash) {
+    // 64-bit FNV-1a
+    const unsigned char *bytes = (const unsigned char *)data;
+    for (size_t i = 0; i < numBytes; i++) {
+        hash ^= (unsigned long long)bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+void FluidSimulation::_addAnimatedObjectsToSolidSDF(double dt) {
+    std::vector<MeshObject*> inversedObstacles;
+    std::vector<MeshObject*> normalObstacles;
+    for (size_t i = 0; i < _obstacles.size(); i++) {
+        if (_obstacles[i]->isEnabled() && _obstacles[i]->isAnimated()) {
+            if (_obstacles[i]->isInversed()) {
+                inversedObstacles.push_back(_obstacles[i]);
+            } else {
+                normalObstacles.push_back(_obstacles[i]);
+            }
+        }
+    }
+
+    float frameTime = (float)(_currentFrameDeltaTimeRemaining + _currentFrameTimeStep);
+    float frameProgress = 1.0f - frameTime / (float)_currentFrameDeltaTime;
+
+    if (!_isTempSolidLevelSetEnabled && (!normalObstacles.empty() || !inversedObstacles.empty())) {
+        _tempSolidSDF = MeshLevelSet(_isize, _jsize, _ksize, _dx);
+    }
+
+    if (_isFractureOptimizationEnabled) {
+        if (!normalObstacles.empty()) {
+            _tempSolidSDF.reset();
+            MeshObject tempMeshObject;
+            tempMeshObject.getMeshLevelSetFractureOptimization(normalObstacles, dt, frameProgress, _solidLevelSetExactBand, _tempSolidSDF);
+            _solidSDF.calculateUnion(_tempSolidSDF);
+        }
+    } else {
+        for (size_t i = 0; i < normalObstacles.size(); i++) {
+            _tempSolidSDF.reset();
+            normalObstacles[i]->getMeshLevelSet(dt, frameProgress, _solidLevelSetExactBand, _tempSolidSDF);
+            _solidSDF.calculateUnion(_tempSolidSDF);
+        }
+    }
+
+    if (!inversedObstacles.empty()) {
+        MeshLevelSet tempSolidInversedSDF(_isize, _jsize, _ksize, _dx);
+        tempSolidInversedSDF.disableVelocityData();
+
+        for (size_t i = 0; i < inversedObstacles.size(); i++) {
+            _tempSolidSDF.reset();
+            _tempSolidSDF.disableVelocityData();
+            inversedObstacles[i]->getMeshLevelSet(dt, frameProgress, _solidLevelSetExactBand, _tempSolidSDF);
+            tempSolidInversedSDF.calculateUnion(_tempSolidSDF);
+        }
 
         tempSolidInversedSDF.enableVelocityData();
         tempSolidInversedSDF.negate();
-        sdf.calculateUnion(tempSolidInversedSDF);
+        _solidSDF.calculateUnion(tempSolidInversedSDF);
 
         _tempSolidSDF.enableVelocityData();
     }
+
+    if (!_isTempSolidLevelSetEnabled) {
+        _tempSolidSDF = MeshLevelSet();
+    }
+}
+
+void FluidSimulation::_addStaticObjectsToSDF(double dt, MeshLevelSet &sdf){
+    TriangleMesh boundaryMesh = _domainMeshObject.getMesh();
+    sdf.reset();
+    sdf.pushMeshObject(&_domainMeshObject);
+    sdf.disableVelocityData();    // Stops velocity data from being calculated 
+                                  // twice (once during sdf calculations, and
+                                  // once when sdf is negated
+    sdf.fastCalculateSignedDistanceField(boundaryMesh, _solidLevelSetExactBand);
+    sdf.enableVelocityData();
+    sdf.negate();
+
+    std::vector<MeshObject*> inversedObstacles;
+    std::vector<MeshObject*> normalObstacles;
+    for (size_t i = 0; i < _obstacles.size(); i++) {
+        if (_obstacles[i]->isEnabled() && !_obstacles[i]->isAnimated()) {
+            if (_obstacles[i]->isInversed()) {
+                inversedObstacles.push_back(_obstacles[i]);
+            } else {
+                normalObstacles.push_back(_obstacles[i]);
+            }
+        }
+    }
+
+    float frameTime = (float)(_currentFrameDeltaTimeRemaining + _currentFrameTimeStep);
+    float frameProgress = 1.0f - frameTime / (float)_currentFrameDeltaTime;
+
+    // The coarse far field level set of the multi-resolution static solid
+    // level set does not match the dimensions of the shared temporary level set
+    int si, sj, sk;
+    sdf.getGridDimensions(&si, &sj, &sk);
+    double sdx = sdf.getCellSize();
+    bool isSimulationGridSize = si == _isize && sj == _jsize && sk == _ksize && sdx == _dx;
+
+    MeshLevelSet coarseTempSolidSDF;
+    MeshLevelSet *tempSolidSDF = &_tempSolidSDF;
+    if (!isSimulationGridSize) {
+        coarseTempSolidSDF = MeshLevelSet(si, sj, sk, sdx);
+        tempSolidSDF = &coarseTempSolidSDF;
+    } else if (!_isTempSolidLevelSetEnabled && (!normalObstacles.empty() || !inversedObstacles.empty())) {
+        _tempSolidSDF = MeshLevelSet(_isize, _jsize, _ksize, _dx);
+    }
+    tempSolidSDF->setExactBandMask(sdf.getExactBandMask(), sdf.getExactBandMaskTileWidth());
+
+    if (_isFractureOptimizationEnabled) {
+        if (!normalObstacles.empty()) {
+            tempSolidSDF->reset();
+            MeshObject tempMeshObject;
+            tempMeshObject.getMeshLevelSetFractureOptimization(normalObstacles, dt, frameProgress, _solidLevelSetExactBand, *tempSolidSDF);
+            sdf.calculateUnion(*tempSolidSDF);
+        }
+    } else {
+        for (size_t i = 0; i < normalObstacles.size(); i++) {
+            tempSolidSDF->reset();
+            normalObstacles[i]->getMeshLevelSet(dt, frameProgress, _solidLevelSetExactBand, *tempSolidSDF);
+            sdf.calculateUnion(*tempSolidSDF);
+        }
+    }
+
+    if (!inversedObstacles.empty()) {
+        MeshLevelSet tempSolidInversedSDF(si, sj, sk, sdx);
+        tempSolidInversedSDF.disableVelocityData();
+
+        for (size_t i = 0; i < inversedObstacles.size(); i++) {
+            tempSolidSDF->reset();
+            tempSolidSDF->disableVelocityData();
+            inversedObstacles[i]->getMeshLevelSet(dt, frameProgress, _solidLevelSetExactBand, *tempSolidSDF);
+            tempSolidInversedSDF.calculateUnion(*tempSolidSDF);
+        }
+
+        tempSolidInversedSDF.enableVelocityData();
+        tempSolidInversedSDF.negate();
+        sdf.calculateUnion(tempSolidInversedSDF);
+
+        tempSolidSDF->enableVelocityData();
+    }
+
+    tempSolidSDF->clearExactBandMask();
 }
 
 void FluidSimulation::_addStaticObjectsToSolidSDF(double dt, std::vector<MeshObjectStatus> &objectStatus) {
@@ -5694,6 +6326,10 @@ void FluidSimulation::_updateSolidLevelSet(double dt) {
         _isSolidLevelSetUpToDate = false;
     }
 
+    if (_isStaticSolidLevelSetRefinementRequired()) {
+        _isSolidLevelSetUpToDate = false;
+    }
+
     if (_isSolidLevelSetUpToDate) {
         return;
     }
@@ -5726,6 +6362,7 @@ void FluidSimulation::_updateSolidLevelSet(double dt) {
 
     _isSolidLevelSetUpToDate = true;
     _isWeightGridUpToDate = false;
+    _obstacleInfluenceGrid.invalidateInfluenceSources();
 
 }
 
@@ -6013,14 +6650,12 @@ void FluidSimulation::_calculateFluidCurvatureGridThread() {
 
     if (_isFluidInSimulation()) {
 
-        if (_fluidCurvatureGrid.width == _isize && 
-                _fluidCurvatureGrid.height == _jsize && 
-                _fluidCurvatureGrid.depth == _ksize) {
+        if (_fluidSurfaceLevelSet.width == _isize && 
+                _fluidSurfaceLevelSet.height == _jsize && 
+                _fluidSurfaceLevelSet.depth == _ksize) {
             _fluidSurfaceLevelSet.fill(0.0f);
-            _fluidCurvatureGrid.fill(0.0f);
         } else {
             _fluidSurfaceLevelSet = Array3d<float>(_isize, _jsize, _ksize, 0.0f);
-            _fluidCurvatureGrid = Array3d<float>(_isize, _jsize, _ksize, 0.0f);
         }
 
         _liquidSDF.calculateCurvatureGrid(_fluidSurfaceLevelSet, _fluidCurvatureGrid);
@@ -6374,15 +7009,16 @@ void FluidSimulation::_updateWeightGrid() {
 
     int U = 0; int V = 1; int W = 2; int CENTER = 3;
     
-    _updateWeightGridMT(U);
-    _updateWeightGridMT(V);
-    _updateWeightGridMT(W);
-    _updateWeightGridMT(CENTER);
+    float errorU = _updateWeightGridMT(U);
+    float errorV = _updateWeightGridMT(V);
+    float errorW = _updateWeightGridMT(W);
+    float errorCenter = _updateWeightGridMT(CENTER);
+    _weightGridStorageError = fmax(fmax(errorU, errorV), fmax(errorW, errorCenter));
 
     _isWeightGridUpToDate = true;
 }
 
-void FluidSimulation::_updateWeightGridMT(int dir) {
+float FluidSimulation::_updateWeightGridMT(int dir) {
 
     int U = 0; int V = 1; int W = 2; int CENTER = 3;
 
@@ -6400,19 +7036,25 @@ void FluidSimulation::_updateWeightGridMT(int dir) {
     size_t numCPU = ThreadUtils::getMaxThreadCount();
     int numthreads = (int)fmin(numCPU, gridsize);
     std::vector<std::thread> threads(numthreads);
+    std::vector<float> threadMaxErrors(numthreads, 0.0f);
     std::vector<int> intervals = ThreadUtils::splitRangeIntoIntervals(0, gridsize, numthreads);
     for (int i = 0; i < numthreads; i++) {
         threads[i] = std::thread(&FluidSimulation::_updateWeightGridThread, this,
-                                 intervals[i], intervals[i + 1], dir);
+                                 intervals[i], intervals[i + 1], dir, &(threadMaxErrors[i]));
     }
 
+    float maxError = 0.0f;
     for (int i = 0; i < numthreads; i++) {
         threads[i].join();
+        maxError = fmax(maxError, threadMaxErrors[i]);
     }
+
+    return maxError;
 }
 
-void FluidSimulation::_updateWeightGridThread(int startidx, int endidx, int dir) {
+void FluidSimulation::_updateWeightGridThread(int startidx, int endidx, int dir, float *maxError) {
     int U = 0; int V = 1; int W = 2; int CENTER = 3;
+    float localMaxError = 0.0f;
 
     if (dir == U) {
 
@@ -6421,6 +7063,9 @@ void FluidSimulation::_updateWeightGridThread(int startidx, int endidx, int dir)
             float weight = 1.0f - _solidSDF.getFaceWeightU(g);
             weight = _clamp(weight, 0.0f, 1.0f);
             _weightGrid.U.set(g, weight);
+            #if WITH_HALF_PRECISION_GRIDS
+            localMaxError = fmax(localMaxError, fabs((float)_weightGrid.U(g) - weight));
+            #endif
         }
 
     } else if (dir == V) {
@@ -6430,6 +7075,9 @@ void FluidSimulation::_updateWeightGridThread(int startidx, int endidx, int dir)
             float weight = 1.0f - _solidSDF.getFaceWeightV(g);
             weight = _clamp(weight, 0.0f, 1.0f);
             _weightGrid.V.set(g, weight);
+            #if WITH_HALF_PRECISION_GRIDS
+            localMaxError = fmax(localMaxError, fabs((float)_weightGrid.V(g) - weight));
+            #endif
         }
 
     } else if (dir == W) {
@@ -6439,6 +7087,9 @@ void FluidSimulation::_updateWeightGridThread(int startidx, int endidx, int dir)
             float weight = 1.0f - _solidSDF.getFaceWeightW(g);
             weight = _clamp(weight, 0.0f, 1.0f);
             _weightGrid.W.set(g, weight);
+            #if WITH_HALF_PRECISION_GRIDS
+            localMaxError = fmax(localMaxError, fabs((float)_weightGrid.W(g) - weight));
+            #endif
         }
 
     } else if (dir == CENTER) {
@@ -6448,9 +7099,14 @@ void FluidSimulation::_updateWeightGridThread(int startidx, int endidx, int dir)
             float weight = 1.0f - _solidSDF.getCellWeight(g);
             weight = _clamp(weight, 0.0f, 1.0f);
             _weightGrid.center.set(g, weight);
+            #if WITH_HALF_PRECISION_GRIDS
+            localMaxError = fmax(localMaxError, fabs((float)_weightGrid.center(g) - weight));
+            #endif
         }
 
     }
+
+    *maxError = localMaxError;
 }
 
 void FluidSimulation::_pressureSolve(double dt) {
@@ -6487,7 +7143,7 @@ void FluidSimulation::_pressureSolve(double dt) {
             MACVelocityField vfieldLevel1 = _MACVelocity.generateCoarseGrid();
             MACVelocityField vfieldSolidLevel1 = _solidSDF.getVelocityDataGrid()->field.generateCoarseGrid();
             ValidVelocityComponentGrid validVelocitiesLevel1(icoarse, jcoarse, kcoarse);
-            Array3d<float> LiquidSDFLevel1 = _liquidSDF.getPhiGrid()->generateCoarseGrid();
+            Array3d<StorageFloat> LiquidSDFLevel1 = _liquidSDF.getPhiGrid()->generateCoarseGrid();
             WeightGrid weightGridLevel1 = _weightGrid.generateCoarseGrid();
             Array3d<float> fluidCurvatureGridLevel1;
             if (_isSurfaceTensionEnabled) {
@@ -6571,6 +7227,12 @@ void FluidSimulation::_pressureSolve(double dt) {
 
         _extrapolateFluidVelocities(_MACVelocity, _validVelocities);
 
+        #if WITH_HALF_PRECISION_GRIDS
+        _logfile.log(std::ostringstream().flush() << 
+                     "Half precision storage error (liquid SDF / weights): " << 
+                     _liquidSDF.getMaxStorageError() << " / " << _weightGridStorageError << std::endl);
+        #endif
+
     }
     
     t.stop();
@@ -6892,7 +7554,7 @@ void FluidSimulation::_updateDiffuseMaterial(double dt) {
 
     params.surfaceSDF = &_fluidSurfaceLevelSet;
     params.curvatureGrid = &_fluidCurvatureGrid;
-    params.influenceGrid = _obstacleInfluenceGrid.getInfluenceGrid();
+    params.influenceGrid = &_obstacleInfluenceGrid;
     params.nearSolidGrid = &_nearSolidGrid;
     params.nearSolidGridCellSize = _nearSolidGridCellSize;
 
@@ -6902,6 +7564,9 @@ void FluidSimulation::_updateDiffuseMaterial(double dt) {
         params.isForceFieldGridSet = true;
     }
 
+    params.frame = _currentFrame;
+    params.frameTimeStep = _currentFrameTimeStepNumber;
+
     _diffuseMaterial.update(params);
 
     t.stop();
@@ -7139,6 +7804,12 @@ void FluidSimulation::_updateSheetSeeding() {
 
         _markerParticles.update();
 
+        // Sheet particles are seeded within two cells of the cells that
+        // contain existing marker particles
+        if (!sheetParticles.empty()) {
+            _staticSolidLevelSetTileBinningTravel += 3.0 * _dx;
+        }
+
     }
 
     t.stop();
@@ -8448,8 +9119,10 @@ void FluidSimulation::_advanceMarkerParticles(double dt) {
             threads[i].join();
         }
 
+        float maxDistanceTravelled = 0.0f;
         for (size_t i = 0; i < _markerParticles.size(); i++) {
             float distanceTravelled = vmath::length(positions->at(i) - output[i]);
+            maxDistanceTravelled = std::max(distanceTravelled, maxDistanceTravelled);
             if (distanceTravelled < 1e-6) {
                 // In the rare case that a particle did not move, it could be
                 // that this particle is stuck. Velocity should be set to 0.0
@@ -8458,6 +9131,7 @@ void FluidSimulation::_advanceMarkerParticles(double dt) {
             }
             positions->at(i) = output[i];
         }
+        _staticSolidLevelSetTileBinningTravel += maxDistanceTravelled;
 
         _removeMarkerParticles(_currentFrameDeltaTime);
 
@@ -9273,6 +9947,53 @@ void FluidSimulation::_smoothSurfaceMesh(TriangleMesh &mesh) {
                 _surfaceReconstructionSmoothingIterations);
 }
 
+void FluidSimulation::_smoothSurfaceMesh(TriangleMesh &mesh, std::vector<bool> &isPinnedVertex) {
+    mesh.smooth(_surfaceReconstructionSmoothingValue, 
+                _surfaceReconstructionSmoothingIterations,
+                isPinnedVertex);
+}
+
+void FluidSimulation::_decimateSurfaceMesh(TriangleMesh &mesh, size_t *numTriangles, 
+                                           size_t *numDecimatedTriangles, double *decimationTime) {
+    if (!_isSurfaceDecimationEnabled) {
+        return;
+    }
+
+    StopWatch t;
+    t.start();
+
+    *numTriangles += mesh.triangles.size();
+
+    MeshDecimatorParameters params;
+    params.maxError = _surfaceDecimationErrorBound * _dx;
+
+    MeshDecimator decimator;
+    decimator.decimate(params, mesh);
+
+    *numDecimatedTriangles += mesh.triangles.size();
+
+    t.stop();
+    *decimationTime += t.getTime();
+}
+
+void FluidSimulation::_logSurfaceDecimation(size_t numTriangles, size_t numDecimatedTriangles, 
+                                            double decimationTime) {
+    if (!_isSurfaceDecimationEnabled) {
+        return;
+    }
+
+    double reduction = 0.0;
+    if (numTriangles > 0) {
+        reduction = 100.0 * (1.0 - (double)numDecimatedTriangles / (double)numTriangles);
+    }
+
+    _logfile.log(std::ostringstream().flush() << 
+                 _logfile.getTime() << " Surface decimation: " << 
+                 numTriangles << " -> " << numDecimatedTriangles << " triangles (" << 
+                 std::fixed << std::setprecision(1) << reduction << "% reduction) in " << 
+                 std::setprecision(3) << decimationTime << "s" << std::endl);
+}
+
 void FluidSimulation::_invertContactNormals(TriangleMesh &mesh) {
     if (!_isInvertedContactNormalsEnabled) {
         return;
@@ -9343,130 +10064,90 @@ void FluidSimulation::_removeMeshNearDomain(TriangleMesh &mesh) {
     mesh.removeExtraneousVertices();
 }
 
-void FluidSimulation::_computeDomainBoundarySDF(MeshLevelSet *sdf) {
-    AABB bbox = _getBoundaryAABB();
-    vmath::vec3 minp = bbox.getMinPoint();
-    vmath::vec3 maxp = bbox.getMaxPoint();
-    GridIndex gmin = Grid3d::positionToGridIndex(minp, _dx);
-    GridIndex gmax = Grid3d::positionToGridIndex(maxp, _dx);
-
-    /*
-    for (int k = gmin.k + 1; k <= gmax.k; k++) {
-        for (int j = gmin.j + 1; j <= gmax.j; j++) {
-            for (int i = gmin.i + 1; i <= gmax.i; i++) {
-                sdf->set(i, j, k, -sdf->get(i, j, k));
-            }
-        }
-    }
-    */
-
-    // -X side
-    for (int k = 0; k < _ksize + 1; k++) {
-        for (int j = 0; j < _jsize + 1; j++) {
-            for (int i = gmin.i; i <= gmin.i + 1; i++) {
-                vmath::vec3 p = Grid3d::GridIndexToPosition(i, j, k, _dx);
-                float d = std::max(bbox.getSignedDistance(p), 0.0f);
-                sdf->set(i, j, k, d);
-            }   
-        }
-    }
+void FluidSimulation::_initializeOutputSurfaceSolidSDF(MeshLevelSet *sdf) {
+    sdf->constructMinimalLevelSet(_isize, _jsize, _ksize, _dx);
 
-    // +X side
-    for (int k = 0; k < _ksize + 1; k++) {
-        for (int j = 0; j < _jsize + 1; j++) {
-            for (int i = gmax.i; i <= gmax.i + 1; i++) {
-                vmath::vec3 p = Grid3d::GridIndexToPosition(i, j, k, _dx);
-                float d = std::max(bbox.getSignedDistance(p), 0.0f);
-                sdf->set(i, j, k, d);
-            }   
-        }
-    }
-
-    // -Y side
-    for (int k = 0; k < _ksize + 1; k++) {
-        for (int j = gmin.j; j <= gmin.j + 1; j++) {
-            for (int i = 0; i < _isize + 1; i++) {
-                vmath::vec3 p = Grid3d::GridIndexToPosition(i, j, k, _dx);
-                float d = std::max(bbox.getSignedDistance(p), 0.0f);
-                sdf->set(i, j, k, d);
-            }   
-        }
+    size_t numCPU = ThreadUtils::getMaxThreadCount();
+    int numthreads = (int)fmin(numCPU, _ksize + 1);
+    std::vector<std::thread> threads(numthreads);
+    std::vector<int> intervals = ThreadUtils::splitRangeIntoIntervals(0, _ksize + 1, numthreads);
+    for (int i = 0; i < numthreads; i++) {
+        threads[i] = std::thread(&FluidSimulation::_initializeOutputSurfaceSolidSDFThread, this,
+                                 intervals[i], intervals[i + 1], sdf);
     }
 
-    // +Y side
-    for (int k = 0; k < _ksize + 1; k++) {
-        for (int j = gmax.j; j <= gmax.j + 1; j++) {
-            for (int i = 0; i < _isize + 1; i++) {
-                vmath::vec3 p = Grid3d::GridIndexToPosition(i, j, k, _dx);
-                float d = std::max(bbox.getSignedDistance(p), 0.0f);
-                sdf->set(i, j, k, d);
-            }   
-        }
+    for (int i = 0; i < numthreads; i++) {
+        threads[i].join();
     }
+}
 
-    // -Z side
-    for (int k = gmin.k; k <= gmin.k + 1; k++) {
-        for (int j = 0; j < _jsize + 1; j++) {
-            for (int i = 0; i < _isize + 1; i++) {
-                vmath::vec3 p = Grid3d::GridIndexToPosition(i, j, k, _dx);
-                float d = std::max(bbox.getSignedDistance(p), 0.0f);
-                sdf->set(i, j, k, d);
-            }   
+void FluidSimulation::_initializeOutputSurfaceSolidSDFThread(int startk, int endk, MeshLevelSet *sdf) {
+    if (_isObstacleMeshingOffsetEnabled) {
+        // Obstacle distances are combined with the meshing volume and offset.
+        // Values near boundary are unchanged so that the mesh is generated
+        // directly against domain boundary
+        float eps = 1e-9;
+        float offset = (float)(_obstacleMeshingOffset * _dx);
+        bool isOffsetApplied = std::abs(offset) > eps;
+        for (int k = startk; k < endk; k++) {
+            for (int j = 0; j < _jsize + 1; j++) {
+                bool isOffsetRow = isOffsetApplied && 
+                                   k >= 3 && k < _ksize - 2 && 
+                                   j >= 3 && j < _jsize - 2;
+                for (int i = 0; i < _isize + 1; i++) {
+                    float d = _solidSDF(i, j, k);
+                    if (_isMeshingVolumeSet) {
+                        d = std::min(d, _meshingVolumeSDF(i, j, k));
+                    }
+                    if (isOffsetRow && i >= 3 && i < _isize - 2) {
+                        d += offset;
+                    }
+                    sdf->set(i, j, k, d);
+                }
+            }
         }
+        return;
     }
 
-    // +Z side
-    for (int k = gmax.k; k <= gmax.k + 1; k++) {
+    // Obstacles are not meshed against. Only the domain boundary is written
+    // and all nodes on its two layer thick sides are given distances to the 
+    // boundary AABB.
+    AABB bbox = _getBoundaryAABB();
+    GridIndex gmin = Grid3d::positionToGridIndex(bbox.getMinPoint(), _dx);
+    GridIndex gmax = Grid3d::positionToGridIndex(bbox.getMaxPoint(), _dx);
+    float fillval = 3.0 * _dx;
+    for (int k = startk; k < endk; k++) {
+        bool isBoundaryK = (k >= gmin.k && k <= gmin.k + 1) || (k >= gmax.k && k <= gmax.k + 1);
         for (int j = 0; j < _jsize + 1; j++) {
+            bool isBoundaryRow = isBoundaryK || 
+                                 (j >= gmin.j && j <= gmin.j + 1) || 
+                                 (j >= gmax.j && j <= gmax.j + 1);
             for (int i = 0; i < _isize + 1; i++) {
-                vmath::vec3 p = Grid3d::GridIndexToPosition(i, j, k, _dx);
-                float d = std::max(bbox.getSignedDistance(p), 0.0f);
+                bool isBoundary = isBoundaryRow || 
+                                  (i >= gmin.i && i <= gmin.i + 1) || 
+                                  (i >= gmax.i && i <= gmax.i + 1);
+                float d = fillval;
+                if (isBoundary) {
+                    vmath::vec3 p = Grid3d::GridIndexToPosition(i, j, k, _dx);
+                    d = std::max(bbox.getSignedDistance(p), 0.0f);
+                }
                 sdf->set(i, j, k, d);
-            }   
+            }
         }
     }
 }
 
-void FluidSimulation::_generateOutputSurface(TriangleMesh &surface, TriangleMesh &preview,
-                                               std::vector<vmath::vec3> *particles,
-                                               MeshLevelSet *solidSDF) {
-    
-    _applyMeshingVolumeToSDF(solidSDF);
-    _filterParticlesOutsideMeshingVolume(particles);
+bool FluidSimulation::_initializeOutputSurfaceMesherParameters(std::vector<vmath::vec3> *particles,
+                                                               std::vector<bool> *isOutsideMeshingVolume,
+                                                               MeshLevelSet *solidSDF,
+                                                               ParticleMesherParameters &params) {
 
-    if (_markerParticles.empty()) {
-        surface = TriangleMesh();
-        preview = TriangleMesh();
-        return;
-    }
+    _filterParticlesOutsideMeshingVolume(particles, isOutsideMeshingVolume);
 
-    if (_isObstacleMeshingOffsetEnabled) {
-        float eps = 1e-9;
-        float offset = (float)(_obstacleMeshingOffset * _dx);
-        if (std::abs(offset) > eps) {
-            // Values near boundary are unchanged so that the mesh is generated
-            // directly against domain boundary
-            for (int k = 3; k < _ksize - 2; k++) {
-                for (int j = 3; j < _jsize - 2; j++) {
-                    for (int i = 3; i < _isize - 2; i++) {
-                        solidSDF->set(i, j, k, solidSDF->get(i, j, k) + offset);
-                    }
-                }
-            }
-        }
-    } else {
-        float fillval = 3.0 * _dx;
-        for (int k = 0; k < _ksize + 1; k++) {
-            for (int j = 0; j < _jsize + 1; j++) {
-                for (int i = 0; i < _isize + 1; i++) {
-                    solidSDF->set(i, j, k, fillval);
-                }
-            }
-        }
-        _computeDomainBoundarySDF(solidSDF);
+    if (_markerParticles.empty()) {
+        return false;
     }
 
-    ParticleMesherParameters params;
     params.isize = _isize;
     params.jsize = _jsize;
     params.ksize = _ksize;
@@ -9480,18 +10161,175 @@ void FluidSimulation::_generateOutputSurface(TriangleMesh &surface, TriangleMesh
     if (_isPreviewSurfaceMeshEnabled) {
         params.previewdx = _previewdx;
     }
+    params.isAnisotropicKernelEnabled = _isSurfaceAnisotropicKernelsEnabled;
+
+    if (_isSurfaceMeshTemporalCacheEnabled) {
+        params.cache = &_surfaceMesherCache;
+    } else {
+        _surfaceMesherCache.clear();
+    }
+
+    return true;
+}
+
+void FluidSimulation::_generateOutputSurface(TriangleMesh &surface, TriangleMesh &preview,
+                                               std::vector<vmath::vec3> *particles,
+                                               std::vector<bool> *isOutsideMeshingVolume,
+                                               MeshLevelSet *solidSDF) {
+
+    ParticleMesherParameters params;
+    if (!_initializeOutputSurfaceMesherParameters(particles, isOutsideMeshingVolume, solidSDF, params)) {
+        surface = TriangleMesh();
+        preview = TriangleMesh();
+        return;
+    }
 
     ParticleMesher mesher;
     surface = mesher.meshParticles(params);
     if (_isPreviewSurfaceMeshEnabled) {
         preview = mesher.getPreviewMesh();
     }
+    _logSurfaceMesherCacheReuse();
 
     surface.removeMinimumTriangleCountPolyhedra(_minimumSurfacePolyhedronTriangleCount);
     _removeMeshNearDomain(surface);
     _removeMeshNearDomain(preview);
 }
 
+bool FluidSimulation::_outputStreamingSurfaceMesh(std::vector<vmath::vec3> *particles,
+                                                  std::vector<bool> *isOutsideMeshingVolume,
+                                                  MeshLevelSet *solidSDF) {
+
+    std::ofstream file(_surfaceMeshStreamingFilepath.c_str(), 
+                       std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        _logfile.log(std::ostringstream().flush() << 
+                     "WARNING: Unable to open surface mesh streaming file: " << 
+                     _surfaceMeshStreamingFilepath << std::endl);
+        return false;
+    }
+
+    ParticleMesher mesher;
+    TriangleMesh previewmesh;
+    size_t numVertices = 0;
+    size_t numTriangles = 0;
+    size_t numBytes = 0;
+    size_t numUndecimatedTriangles = 0;
+    size_t numDecimatedTriangles = 0;
+    double decimationTime = 0.0;
+
+    ParticleMesherParameters params;
+    if (_initializeOutputSurfaceMesherParameters(particles, isOutsideMeshingVolume, solidSDF, params)) {
+        mesher.initializeComputeChunks(params);
+
+        vmath::vec3 scale(_domainScale, _domainScale, _domainScale);
+        TriangleMesh chunkmesh;
+        std::vector<bool> isSeamVertex;
+        std::vector<char> chunkData;
+        while (mesher.meshNextComputeChunk(chunkmesh)) {
+            // Polyhedra that cross a chunk seam are counted per chunk
+            chunkmesh.removeMinimumTriangleCountPolyhedra(_minimumSurfacePolyhedronTriangleCount);
+            _removeMeshNearDomain(chunkmesh);
+            if (chunkmesh.vertices.empty()) {
+                continue;
+            }
+
+            // Seam vertices are shared with the neighbouring chunks and are
+            // held in place so that the streamed chunks stay watertight
+            mesher.getComputeChunkSeamVertices(chunkmesh, isSeamVertex);
+            _smoothSurfaceMesh(chunkmesh, isSeamVertex);
+
+            // Seam vertices lie on an open boundary of the chunk and are 
+            // kept in place by the decimator
+            _decimateSurfaceMesh(chunkmesh, &numUndecimatedTriangles, 
+                                 &numDecimatedTriangles, &decimationTime);
+            _invertContactNormals(chunkmesh);
+
+            chunkmesh.scale(scale);
+            chunkmesh.translate(_domainOffset);
+
+            chunkmesh.getMeshFileDataBOBJ(chunkData);
+            file.write(chunkData.data(), chunkData.size());
+            if (!file.good()) {
+                break;
+            }
+
+            numVertices += chunkmesh.vertices.size();
+            numTriangles += chunkmesh.triangles.size();
+            numBytes += chunkData.size();
+        }
+
+        if (_isPreviewSurfaceMeshEnabled) {
+            previewmesh = mesher.getPreviewMesh();
+            _removeMeshNearDomain(previewmesh);
+        }
+
+        _logSurfaceMesherCacheReuse();
+    }
+
+    file.close();
+    if (file.fail()) {
+        _logfile.log(std::ostringstream().flush() << 
+                     "WARNING: Unable to write surface mesh streaming file: " << 
+                     _surfaceMeshStreamingFilepath << std::endl);
+        std::remove(_surfaceMeshStreamingFilepath.c_str());
+        return false;
+    }
+
+    _logSurfaceDecimation(numUndecimatedTriangles, numDecimatedTriangles, decimationTime);
+
+    _outputData.surfaceData.clear();
+    _outputData.surfaceData.shrink_to_fit();
+    _outputData.frameData.surface.enabled = 1;
+    _outputData.frameData.surface.vertices = numVertices;
+    _outputData.frameData.surface.triangles = numTriangles;
+    _outputData.frameData.surface.bytes = numBytes;
+
+    _outputPreviewSurfaceMesh(previewmesh);
+
+    return true;
+}
+
+void FluidSimulation::_logSurfaceMesherCacheReuse() {
+    if (!_isSurfaceMeshTemporalCacheEnabled) {
+        return;
+    }
+
+    ParticleMesherCache *c = &_surfaceMesherCache;
+    double computePct = 0.0;
+    if (c->numComputeBlocks > 0) {
+        computePct = 100.0 * (double)c->numReusedComputeBlocks / (double)c->numComputeBlocks;
+    }
+    double polygonizerPct = 0.0;
+    if (c->numPolygonizerBlocks > 0) {
+        polygonizerPct = 100.0 * (double)c->numReusedPolygonizerBlocks / (double)c->numPolygonizerBlocks;
+    }
+
+    _logfile.log(std::ostringstream().flush() << 
+                 _logfile.getTime() << " Surface mesh cache reuse: " << 
+                 "compute blocks " << c->numReusedComputeBlocks << " / " << c->numComputeBlocks << 
+                 " (" << std::fixed << std::setprecision(1) << computePct << "%), " <<
+                 "polygonizer blocks " << c->numReusedPolygonizerBlocks << " / " << c->numPolygonizerBlocks << 
+                 " (" << polygonizerPct << "%)" << std::endl);
+}
+
+void FluidSimulation::_outputPreviewSurfaceMesh(TriangleMesh &previewmesh) {
+    if (!_isPreviewSurfaceMeshEnabled) {
+        return;
+    }
+
+    vmath::vec3 scale(_domainScale, _domainScale, _domainScale);
+    _smoothSurfaceMesh(previewmesh);
+    previewmesh.scale(scale);
+    previewmesh.translate(_domainOffset);
+
+    _getTriangleMeshFileData(previewmesh, _outputData.surfacePreviewData);
+    _outputData.frameData.preview.enabled = 1;
+    _outputData.frameData.preview.vertices = previewmesh.vertices.size();
+    _outputData.frameData.preview.triangles = previewmesh.triangles.size();
+    _outputData.frameData.preview.bytes = _outputData.surfacePreviewData.size();
+}
+
 void FluidSimulation::_updateMeshingVolumeSDF() {
     if (!_isMeshingVolumeSet || _currentFrameTimeStepNumber != 0) {
         return;
@@ -9515,39 +10353,16 @@ void FluidSimulation::_updateMeshingVolumeSDF() {
     _isMeshingVolumeLevelSetUpToDate = true;
 }
 
-void FluidSimulation::_applyMeshingVolumeToSDF(MeshLevelSet *sdf) {
-    if (!_isMeshingVolumeSet) {
+void FluidSimulation::_filterParticlesOutsideMeshingVolume(std::vector<vmath::vec3> *particles,
+                                                         std::vector<bool> *isOutsideMeshingVolume) {
+    if (isOutsideMeshingVolume->empty()) {
         return;
     }
 
-    int isdf, jsdf, ksdf;
-    sdf->getGridDimensions(&isdf, &jsdf, &ksdf);
-    if (isdf == 0 && jsdf == 0 && ksdf == 0) {
-        // SDF has not been initialized and does not need meshing volume applied
-        return;
-    }
-
-    for (int k = 0; k < _ksize + 1; k++) {
-        for (int j = 0; j < _jsize + 1; j++) {
-            for (int i = 0; i < _isize + 1; i++) {
-                float d1 = sdf->get(i, j, k);
-                float d2 = _meshingVolumeSDF(i, j, k);
-                if (d2 < d1) {
-                    sdf->set(i, j, k, d2);
-                }
-            }
-        }
-    }
-}
-
-void FluidSimulation::_filterParticlesOutsideMeshingVolume(std::vector<vmath::vec3> *particles) {
-    if (!_isMeshingVolumeSet) {
-        return;
-    }
-
-    std::vector<bool> isSolid;
-    _meshingVolumeSDF.trilinearInterpolateSolidPoints(*particles, isSolid);
-    _removeItemsFromVector(*particles, isSolid);
+    // The mask is cleared so that the particles are only filtered once if 
+    // they are meshed again after a failed streaming attempt
+    _removeItemsFromVector(*particles, *isOutsideMeshingVolume);
+    isOutsideMeshingVolume->clear();
 }
 
 void FluidSimulation::_generateSurfaceMotionBlurData(TriangleMesh &surface, MACVelocityField *vfield) {
@@ -9572,199 +10387,226 @@ void FluidSimulation::_generateSurfaceMotionBlurData(TriangleMesh &surface, MACV
 
 }
 
-void FluidSimulation::_generateSurfaceVelocityAttributeData(TriangleMesh &surface, MACVelocityField *vfield) {
-    if (!_isSurfaceVelocityAttributeEnabled && !_isSurfaceSpeedAttributeEnabled) {
-        return;
-    }
-
-    TriangleMesh velocityData;
-    if (_isSurfaceVelocityAttributeEnabled) {
-        velocityData.vertices.reserve(surface.vertices.size());
-    }
-
-    std::vector<float> speedData;
-    if (_isSurfaceSpeedAttributeEnabled) {
-        speedData.reserve(surface.vertices.size());
-    }
-
-    for (size_t i = 0; i < surface.vertices.size(); i++) {
-        vmath::vec3 p = surface.vertices[i];
-        vmath::vec3 v = vfield->evaluateVelocityAtPositionLinear(p);
+void FluidSimulation::_initializeSurfaceScalarAttributeData(size_t numVertices, 
+                                                            std::vector<char> &data, 
+                                                            FluidSimulationMeshStats &stats) {
+    data = std::vector<char>(numVertices * sizeof(float));
+    stats.enabled = 1;
+    stats.vertices = numVertices;
+    stats.triangles = 0;
+    stats.bytes = data.size();
+}
 
-        if (_isSurfaceVelocityAttributeEnabled) {
-            velocityData.vertices.push_back(v);
-        }
+void FluidSimulation::_outputSurfaceVectorAttributeData(TriangleMesh &attributeData, 
+                                                        std::vector<char> &data, 
+                                                        FluidSimulationMeshStats &stats) {
+    _getTriangleMeshFileData(attributeData, data);
+    stats.enabled = 1;
+    stats.vertices = attributeData.vertices.size();
+    stats.triangles = attributeData.triangles.size();
+    stats.bytes = data.size();
+}
 
-        if (_isSurfaceSpeedAttributeEnabled) {
-            speedData.push_back(v.length());
-        }
-    }
+/*
+    All grid sampled surface attributes are generated in a single threaded
+    pass over the surface vertices. Per-vertex scalar attributes are written
+    directly into the output data buffers and vector attributes are encoded
+    once the pass is complete.
+*/
+void FluidSimulation::_generateSurfaceAttributeData(TriangleMesh &surface, MACVelocityField *vfield) {
+    size_t n = surface.vertices.size();
+    SurfaceAttributeBuffers buffers;
 
     if (_isSurfaceVelocityAttributeEnabled) {
-        _getTriangleMeshFileData(velocityData, _outputData.surfaceVelocityAttributeData);
-        _outputData.frameData.surfacevelocity.enabled = 1;
-        _outputData.frameData.surfacevelocity.vertices = velocityData.vertices.size();
-        _outputData.frameData.surfacevelocity.triangles = velocityData.triangles.size();
-        _outputData.frameData.surfacevelocity.bytes = _outputData.surfaceVelocityAttributeData.size();
+        buffers.velocity.vertices = std::vector<vmath::vec3>(n);
     }
-
     if (_isSurfaceSpeedAttributeEnabled) {
-        size_t datasize = speedData.size() * sizeof(float);
-        _outputData.surfaceSpeedAttributeData = std::vector<char>(datasize);
-        std::memcpy(_outputData.surfaceSpeedAttributeData.data(), (char *)speedData.data(), datasize);
-
-        _outputData.frameData.surfacespeed.enabled = 1;
-        _outputData.frameData.surfacespeed.vertices = speedData.size();
-        _outputData.frameData.surfacespeed.triangles = 0;
-        _outputData.frameData.surfacespeed.bytes = _outputData.surfaceSpeedAttributeData.size();
+        _initializeSurfaceScalarAttributeData(n, _outputData.surfaceSpeedAttributeData, 
+                                              _outputData.frameData.surfacespeed);
+        buffers.speed = _outputData.surfaceSpeedAttributeData.data();
     }
-}
-
-void FluidSimulation::_generateSurfaceVorticityAttributeData(TriangleMesh &surface) {
-    if (!_isSurfaceVorticityAttributeEnabled) {
-        return;
+    if (_isSurfaceVorticityAttributeEnabled) {
+        buffers.vorticity.vertices = std::vector<vmath::vec3>(n);
     }
-
-    TriangleMesh vorticityData;
-    vorticityData.vertices.reserve(surface.vertices.size());
-
-    for (size_t i = 0; i < surface.vertices.size(); i++) {
-        vmath::vec3 p = surface.vertices[i];
-        vmath::vec3 curl = Interpolation::trilinearInterpolate(p, _dx, _vorticityAttributeGrid);
-        vorticityData.vertices.push_back(curl);
-    }
-
-    _getTriangleMeshFileData(vorticityData, _outputData.surfaceVorticityAttributeData);
-    _outputData.frameData.surfacevorticity.enabled = 1;
-    _outputData.frameData.surfacevorticity.vertices = vorticityData.vertices.size();
-    _outputData.frameData.surfacevorticity.triangles = vorticityData.triangles.size();
-    _outputData.frameData.surfacevorticity.bytes = _outputData.surfaceVorticityAttributeData.size();
-}
-
-void FluidSimulation::_generateSurfaceAgeAttributeData(TriangleMesh &surface) {
-    if (!_isSurfaceAgeAttributeEnabled) {
+    if (_isSurfaceSourceViscosityAttributeEnabled) {
+        _initializeSurfaceScalarAttributeData(n, _outputData.surfaceViscosityAttributeData, 
+                                              _outputData.frameData.surfaceviscosity);
+        buffers.viscosity = _outputData.surfaceViscosityAttributeData.data();
+    }
+    if (_isSurfaceDensityAttributeEnabled) {
+        _initializeSurfaceScalarAttributeData(n, _outputData.surfaceDensityAttributeData, 
+                                              _outputData.frameData.surfacedensity);
+        buffers.density = _outputData.surfaceDensityAttributeData.data();
+    }
+    if (_isSurfaceAgeAttributeEnabled) {
+        _initializeSurfaceScalarAttributeData(n, _outputData.surfaceAgeAttributeData, 
+                                              _outputData.frameData.surfaceage);
+        buffers.age = _outputData.surfaceAgeAttributeData.data();
+    }
+    if (_isSurfaceLifetimeAttributeEnabled) {
+        _initializeSurfaceScalarAttributeData(n, _outputData.surfaceLifetimeAttributeData, 
+                                              _outputData.frameData.surfacelifetime);
+        buffers.lifetime = _outputData.surfaceLifetimeAttributeData.data();
+    }
+    if (_isSurfaceWhitewaterProximityAttributeEnabled) {
+        buffers.whitewaterProximity.vertices = std::vector<vmath::vec3>(n);
+    }
+    if (_isSurfaceSourceColorAttributeEnabled) {
+        buffers.color.vertices = std::vector<vmath::vec3>(n);
+    }
+    if (_isSurfaceSourceUVWAttributeEnabled) {
+        buffers.uvw.vertices = std::vector<vmath::vec3>(n);
+    }
+
+    bool isAttributeEnabled = _isSurfaceVelocityAttributeEnabled || 
+                              _isSurfaceSpeedAttributeEnabled ||
+                              _isSurfaceVorticityAttributeEnabled ||
+                              _isSurfaceSourceViscosityAttributeEnabled ||
+                              _isSurfaceDensityAttributeEnabled ||
+                              _isSurfaceAgeAttributeEnabled ||
+                              _isSurfaceLifetimeAttributeEnabled ||
+                              _isSurfaceWhitewaterProximityAttributeEnabled ||
+                              _isSurfaceSourceColorAttributeEnabled ||
+                              _isSurfaceSourceUVWAttributeEnabled;
+    if (!isAttributeEnabled) {
         return;
     }
 
-    std::vector<float> ageData;
-    ageData.reserve(surface.vertices.size());
-    for (size_t i = 0; i < surface.vertices.size(); i++) {
-        vmath::vec3 p = surface.vertices[i];
-        float age = Interpolation::trilinearInterpolate(p, _dx, _ageAttributeGrid);
-        ageData.push_back(age);
+    int numCPU = ThreadUtils::getMaxThreadCount();
+    int numthreads = (int)fmax(fmin(numCPU, (int)n), 1);
+    std::vector<std::thread> threads(numthreads);
+    std::vector<int> intervals = ThreadUtils::splitRangeIntoIntervals(0, (int)n, numthreads);
+    for (int i = 0; i < numthreads; i++) {
+        threads[i] = std::thread(&FluidSimulation::_generateSurfaceAttributeDataThread, this,
+                                 intervals[i], intervals[i + 1], &surface, vfield, &buffers);
     }
 
-    size_t datasize = ageData.size() * sizeof(float);
-    _outputData.surfaceAgeAttributeData = std::vector<char>(datasize);
-    std::memcpy(_outputData.surfaceAgeAttributeData.data(), (char *)ageData.data(), datasize);
+    for (int i = 0; i < numthreads; i++) {
+        threads[i].join();
+    }
 
-    _outputData.frameData.surfaceage.enabled = 1;
-    _outputData.frameData.surfaceage.vertices = ageData.size();
-    _outputData.frameData.surfaceage.triangles = 0;
-    _outputData.frameData.surfaceage.bytes = _outputData.surfaceAgeAttributeData.size();
-}
+    if (_isSurfaceVelocityAttributeEnabled) {
+        _outputSurfaceVectorAttributeData(buffers.velocity, 
+                                          _outputData.surfaceVelocityAttributeData, 
+                                          _outputData.frameData.surfacevelocity);
+    }
+    if (_isSurfaceVorticityAttributeEnabled) {
+        _outputSurfaceVectorAttributeData(buffers.vorticity, 
+                                          _outputData.surfaceVorticityAttributeData, 
+                                          _outputData.frameData.surfacevorticity);
+    }
+    if (_isSurfaceWhitewaterProximityAttributeEnabled) {
+        _outputSurfaceVectorAttributeData(buffers.whitewaterProximity, 
+                                          _outputData.surfaceWhitewaterProximityAttributeData, 
+                                          _outputData.frameData.surfacewhitewaterproximity);
+    }
+    if (_isSurfaceSourceColorAttributeEnabled) {
+        _outputSurfaceVectorAttributeData(buffers.color, 
+                                          _outputData.surfaceColorAttributeData, 
+                                          _outputData.frameData.surfacecolor);
+    }
+    if (_isSurfaceSourceUVWAttributeEnabled) {
+        _outputSurfaceVectorAttributeData(buffers.uvw, 
+                                          _outputData.surfaceUVWAttributeData, 
+                                          _outputData.frameData.surfaceuvw);
+    }
+}
+
+void FluidSimulation::_generateSurfaceAttributeDataThread(int startidx, int endidx, 
+                                                          TriangleMesh *surface, 
+                                                          MACVelocityField *vfield,
+                                                          SurfaceAttributeBuffers *buffers) {
+    bool isVelocityEnabled = _isSurfaceVelocityAttributeEnabled || _isSurfaceSpeedAttributeEnabled;
+    bool isStencilEnabled = _isSurfaceVorticityAttributeEnabled || 
+                            _isSurfaceSourceViscosityAttributeEnabled ||
+                            _isSurfaceDensityAttributeEnabled ||
+                            _isSurfaceAgeAttributeEnabled ||
+                            _isSurfaceLifetimeAttributeEnabled ||
+                            _isSurfaceWhitewaterProximityAttributeEnabled ||
+                            _isSurfaceSourceColorAttributeEnabled;
+    vmath::vec3 uvwOffset(0.5 * _dx, 0.5 * _dx, 0.5 * _dx);
+
+    Interpolation::TrilinearStencil stencil;
+    for (int i = startidx; i < endidx; i++) {
+        vmath::vec3 p = surface->vertices[i];
 
-void FluidSimulation::_generateSurfaceLifetimeAttributeData(TriangleMesh &surface) {
-    if (!_isSurfaceLifetimeAttributeEnabled) {
-        return;
-    }
+        if (isVelocityEnabled) {
+            vmath::vec3 v = vfield->evaluateVelocityAtPositionLinear(p);
+            if (_isSurfaceVelocityAttributeEnabled) {
+                buffers->velocity.vertices[i] = v;
+            }
+            if (_isSurfaceSpeedAttributeEnabled) {
+                _setSurfaceScalarAttributeValue(buffers->speed, i, v.length());
+            }
+        }
 
-    std::vector<float> lifetimeData;
-    lifetimeData.reserve(surface.vertices.size());
-    for (size_t i = 0; i < surface.vertices.size(); i++) {
-        vmath::vec3 p = surface.vertices[i];
-        float lifetime = Interpolation::trilinearInterpolate(p, _dx, _lifetimeAttributeGrid);
-        lifetimeData.push_back(lifetime);
-    }
+        if (isStencilEnabled) {
+            stencil = Interpolation::getTrilinearStencil(p, _dx);
+        }
 
-    size_t datasize = lifetimeData.size() * sizeof(float);
-    _outputData.surfaceLifetimeAttributeData = std::vector<char>(datasize);
-    std::memcpy(_outputData.surfaceLifetimeAttributeData.data(), (char *)lifetimeData.data(), datasize);
+        if (_isSurfaceVorticityAttributeEnabled) {
+            buffers->vorticity.vertices[i] = Interpolation::trilinearInterpolate(stencil, _vorticityAttributeGrid);
+        }
 
-    _outputData.frameData.surfacelifetime.enabled = 1;
-    _outputData.frameData.surfacelifetime.vertices = lifetimeData.size();
-    _outputData.frameData.surfacelifetime.triangles = 0;
-    _outputData.frameData.surfacelifetime.bytes = _outputData.surfaceLifetimeAttributeData.size();
-}
+        if (_isSurfaceSourceViscosityAttributeEnabled) {
+            float viscosity = Interpolation::trilinearInterpolate(stencil, _viscosityAttributeGrid);
+            _setSurfaceScalarAttributeValue(buffers->viscosity, i, viscosity);
+        }
 
-void FluidSimulation::_generateSurfaceWhitewaterProximityAttributeData(TriangleMesh &surface) {
-    if (!_isSurfaceWhitewaterProximityAttributeEnabled) {
-        return;
-    }
+        if (_isSurfaceDensityAttributeEnabled) {
+            float density = Interpolation::trilinearInterpolate(stencil, _densityAttributeGrid);
+            _setSurfaceScalarAttributeValue(buffers->density, i, density);
+        }
 
-    TriangleMesh whitewaterProximityData;
-    whitewaterProximityData.vertices.reserve(surface.vertices.size());
-    for (size_t i = 0; i < surface.vertices.size(); i++) {
-        vmath::vec3 p = surface.vertices[i];
-        vmath::vec3 proximity = Interpolation::trilinearInterpolate(p, _dx, _whitewaterProximityAttributeGrid);        
-        whitewaterProximityData.vertices.push_back(proximity);
-    }
+        if (_isSurfaceAgeAttributeEnabled) {
+            float age = Interpolation::trilinearInterpolate(stencil, _ageAttributeGrid);
+            _setSurfaceScalarAttributeValue(buffers->age, i, age);
+        }
 
-    _getTriangleMeshFileData(whitewaterProximityData, _outputData.surfaceWhitewaterProximityAttributeData);
-    _outputData.frameData.surfacewhitewaterproximity.enabled = 1;
-    _outputData.frameData.surfacewhitewaterproximity.vertices = whitewaterProximityData.vertices.size();
-    _outputData.frameData.surfacewhitewaterproximity.triangles = whitewaterProximityData.triangles.size();
-    _outputData.frameData.surfacewhitewaterproximity.bytes = _outputData.surfaceWhitewaterProximityAttributeData.size();
-}
+        if (_isSurfaceLifetimeAttributeEnabled) {
+            float lifetime = Interpolation::trilinearInterpolate(stencil, _lifetimeAttributeGrid);
+            _setSurfaceScalarAttributeValue(buffers->lifetime, i, lifetime);
+        }
 
-void FluidSimulation::_generateSurfaceColorAttributeData(TriangleMesh &surface) {
-    if (!_isSurfaceSourceColorAttributeEnabled) {
-        return;
-    }
+        if (_isSurfaceWhitewaterProximityAttributeEnabled) {
+            buffers->whitewaterProximity.vertices[i] = Interpolation::trilinearInterpolate(stencil, _whitewaterProximityAttributeGrid);
+        }
 
-    TriangleMesh colorData;
-    colorData.vertices.reserve(surface.vertices.size());
-    for (size_t i = 0; i < surface.vertices.size(); i++) {
-        vmath::vec3 p = surface.vertices[i];
-        float r = Interpolation::trilinearInterpolate(p, _dx, _colorAttributeGridR);
-        float g = Interpolation::trilinearInterpolate(p, _dx, _colorAttributeGridG);
-        float b = Interpolation::trilinearInterpolate(p, _dx, _colorAttributeGridB);
-        vmath::vec3 color(r, g, b);
-
-        color = _RGBToHSV(color);
-        color.y = std::min(color.y * _mixboxSaturationFactor, 1.0f);
-        color = _HSVToRGB(color);
-        color.x = _clamp(color.x, 0.0f, 1.0f);
-        color.y = _clamp(color.y, 0.0f, 1.0f);
-        color.z = _clamp(color.z, 0.0f, 1.0f);
-        
-        colorData.vertices.push_back(color);
-    }
+        if (_isSurfaceSourceColorAttributeEnabled) {
+            float r = Interpolation::trilinearInterpolate(stencil, _colorAttributeGridR);
+            float g = Interpolation::trilinearInterpolate(stencil, _colorAttributeGridG);
+            float b = Interpolation::trilinearInterpolate(stencil, _colorAttributeGridB);
+            vmath::vec3 color(r, g, b);
 
-    _getTriangleMeshFileData(colorData, _outputData.surfaceColorAttributeData);
-    _outputData.frameData.surfacecolor.enabled = 1;
-    _outputData.frameData.surfacecolor.vertices = colorData.vertices.size();
-    _outputData.frameData.surfacecolor.triangles = colorData.triangles.size();
-    _outputData.frameData.surfacecolor.bytes = _outputData.surfaceColorAttributeData.size();
-}
+            color = _RGBToHSV(color);
+            color.y = std::min(color.y * _mixboxSaturationFactor, 1.0f);
+            color = _HSVToRGB(color);
+            color.x = _clamp(color.x, 0.0f, 1.0f);
+            color.y = _clamp(color.y, 0.0f, 1.0f);
+            color.z = _clamp(color.z, 0.0f, 1.0f);
+            
+            buffers->color.vertices[i] = color;
+        }
 
-void FluidSimulation::_generateSurfaceUVWAttributeData(TriangleMesh &surface) {
-    if (!_isSurfaceSourceUVWAttributeEnabled) {
-        return;
-    }
+        if (_isSurfaceSourceUVWAttributeEnabled) {
+            // UVW values are stored at cell centers
+            Interpolation::TrilinearStencil uvwStencil = Interpolation::getTrilinearStencil(p - uvwOffset, _dx);
+            float u = Interpolation::trilinearInterpolate(uvwStencil, _uvwAttributeGridU);
+            float v = Interpolation::trilinearInterpolate(uvwStencil, _uvwAttributeGridV);
+            float w = Interpolation::trilinearInterpolate(uvwStencil, _uvwAttributeGridW);
+            vmath::vec3 uvw(u, v, w);
 
-    vmath::vec3 offset(0.5 * _dx, 0.5 * _dx, 0.5 * _dx);
-    TriangleMesh uvwData;
-    uvwData.vertices.reserve(surface.vertices.size());
-    for (size_t i = 0; i < surface.vertices.size(); i++) {
-        vmath::vec3 p = surface.vertices[i] - offset;
-        float u = Interpolation::trilinearInterpolate(p, _dx, _uvwAttributeGridU);
-        float v = Interpolation::trilinearInterpolate(p, _dx, _uvwAttributeGridV);
-        float w = Interpolation::trilinearInterpolate(p, _dx, _uvwAttributeGridW);
-        vmath::vec3 uvw(u, v, w);
-
-        uvw.x = _clamp(uvw.x, 0.0f, 1.0f);
-        uvw.y = _clamp(uvw.y, 0.0f, 1.0f);
-        uvw.z = _clamp(uvw.z, 0.0f, 1.0f);
-        
-        uvwData.vertices.push_back(uvw);
+            uvw.x = _clamp(uvw.x, 0.0f, 1.0f);
+            uvw.y = _clamp(uvw.y, 0.0f, 1.0f);
+            uvw.z = _clamp(uvw.z, 0.0f, 1.0f);
+            
+            buffers->uvw.vertices[i] = uvw;
+        }
     }
+}
 
-    _getTriangleMeshFileData(uvwData, _outputData.surfaceUVWAttributeData);
-    _outputData.frameData.surfaceuvw.enabled = 1;
-    _outputData.frameData.surfaceuvw.vertices = uvwData.vertices.size();
-    _outputData.frameData.surfaceuvw.triangles = uvwData.triangles.size();
-    _outputData.frameData.surfaceuvw.bytes = _outputData.surfaceUVWAttributeData.size();
+void FluidSimulation::_setSurfaceScalarAttributeValue(char *data, int index, float value) {
+    std::memcpy(data + index * sizeof(float), &value, sizeof(float));
 }
 
 void FluidSimulation::_generateSurfaceSourceIDAttributeData(TriangleMesh &surface, 
@@ -9891,53 +10733,8 @@ void FluidSimulation::_generateSurfaceSourceIDAttributeData(TriangleMesh &surfac
     _outputData.frameData.surfacesourceid.bytes = _outputData.surfaceSourceIDAttributeData.size();
 }
 
-void FluidSimulation::_generateSurfaceViscosityAttributeData(TriangleMesh &surface) {
-    if (!_isSurfaceSourceViscosityAttributeEnabled) {
-        return;
-    }
-
-    std::vector<float> viscosityData;
-    viscosityData.reserve(surface.vertices.size());
-    for (size_t i = 0; i < surface.vertices.size(); i++) {
-        vmath::vec3 p = surface.vertices[i];
-        float viscosity = Interpolation::trilinearInterpolate(p, _dx, _viscosityAttributeGrid);
-        viscosityData.push_back(viscosity);
-    }
-
-    size_t datasize = viscosityData.size() * sizeof(float);
-    _outputData.surfaceViscosityAttributeData = std::vector<char>(datasize);
-    std::memcpy(_outputData.surfaceViscosityAttributeData.data(), (char *)viscosityData.data(), datasize);
-
-    _outputData.frameData.surfaceviscosity.enabled = 1;
-    _outputData.frameData.surfaceviscosity.vertices = viscosityData.size();
-    _outputData.frameData.surfaceviscosity.triangles = 0;
-    _outputData.frameData.surfaceviscosity.bytes = _outputData.surfaceViscosityAttributeData.size();
-}
-
-void FluidSimulation::_generateSurfaceDensityAttributeData(TriangleMesh &surface) {
-    if (!_isSurfaceDensityAttributeEnabled) {
-        return;
-    }
-
-    std::vector<float> densityData;
-    densityData.reserve(surface.vertices.size());
-    for (size_t i = 0; i < surface.vertices.size(); i++) {
-        vmath::vec3 p = surface.vertices[i];
-        float density = Interpolation::trilinearInterpolate(p, _dx, _densityAttributeGrid);
-        densityData.push_back(density);
-    }
-
-    size_t datasize = densityData.size() * sizeof(float);
-    _outputData.surfaceDensityAttributeData = std::vector<char>(datasize);
-    std::memcpy(_outputData.surfaceDensityAttributeData.data(), (char *)densityData.data(), datasize);
-
-    _outputData.frameData.surfacedensity.enabled = 1;
-    _outputData.frameData.surfacedensity.vertices = densityData.size();
-    _outputData.frameData.surfacedensity.triangles = 0;
-    _outputData.frameData.surfacedensity.bytes = _outputData.surfaceDensityAttributeData.size();
-}
-
 void FluidSimulation::_outputSurfaceMeshThread(std::vector<vmath::vec3> *particles,
+                                               std::vector<bool> *isOutsideMeshingVolume,
                                                MeshLevelSet *solidSDF, 
                                                MACVelocityField *vfield,
                                                std::vector<int> *sourceID) {
@@ -9950,37 +10747,71 @@ void FluidSimulation::_outputSurfaceMeshThread(std::vector<vmath::vec3> *particl
     StopWatch t;
     t.start();
 
+    if (_isSurfaceMeshStreamingEnabled && _meshOutputFormat != TriangleMeshFormat::bobj) {
+        _logfile.log(std::ostringstream().flush() << 
+                     "WARNING: Surface mesh streaming requires the BOBJ output format. " << 
+                     "The surface will not be streamed." << std::endl);
+    }
+
+    if (_isSurfaceMeshStreamingEnabled && _meshOutputFormat == TriangleMeshFormat::bobj) {
+        if (_outputStreamingSurfaceMesh(particles, isOutsideMeshingVolume, solidSDF)) {
+            delete particles;
+            delete isOutsideMeshingVolume;
+            delete solidSDF;
+            delete vfield;
+            delete sourceID;
+
+            t.stop();
+            _timingData.outputMeshSimulationData += t.getTime();
+
+            _logfile.logString(_logfile.getTime() + " COMPLETE    Generate Surface Mesh");
+            return;
+        }
+
+        _logfile.log(std::ostringstream().flush() << 
+                     "WARNING: Surface mesh streaming failed. " << 
+                     "The surface will be output to memory." << std::endl);
+    }
+
     std::vector<vmath::vec3> particlesCopy;
     if (_isSurfaceSourceIDAttributeEnabled) {
         particlesCopy = *particles;
     }
 
     TriangleMesh surfacemesh, previewmesh;
-    _generateOutputSurface(surfacemesh, previewmesh, particles, solidSDF);
+    _generateOutputSurface(surfacemesh, previewmesh, particles, isOutsideMeshingVolume, solidSDF);
     delete particles;
+    delete isOutsideMeshingVolume;
     delete solidSDF;
 
+    // The surface is smoothed before it is decimated so that the error 
+    // bound is measured against the output geometry. Without decimation 
+    // the attributes are sampled on the unsmoothed surface as before.
+    bool isSmoothed = false;
+    if (_isSurfaceDecimationEnabled) {
+        _smoothSurfaceMesh(surfacemesh);
+        isSmoothed = true;
+
+        size_t numTriangles = 0;
+        size_t numDecimatedTriangles = 0;
+        double decimationTime = 0.0;
+        _decimateSurfaceMesh(surfacemesh, &numTriangles, &numDecimatedTriangles, &decimationTime);
+        _logSurfaceDecimation(numTriangles, numDecimatedTriangles, decimationTime);
+    }
+
     _generateSurfaceMotionBlurData(surfacemesh, vfield);
-    _generateSurfaceVelocityAttributeData(surfacemesh, vfield);
+    _generateSurfaceAttributeData(surfacemesh, vfield);
     delete vfield;
 
-    _generateSurfaceVorticityAttributeData(surfacemesh);
-
     _generateSurfaceSourceIDAttributeData(surfacemesh, particlesCopy, sourceID);
     delete sourceID;
 
     particlesCopy.clear();
     particlesCopy.shrink_to_fit();
 
-    _generateSurfaceViscosityAttributeData(surfacemesh);
-    _generateSurfaceDensityAttributeData(surfacemesh);
-    _generateSurfaceAgeAttributeData(surfacemesh);
-    _generateSurfaceLifetimeAttributeData(surfacemesh);
-    _generateSurfaceWhitewaterProximityAttributeData(surfacemesh);
-    _generateSurfaceColorAttributeData(surfacemesh);
-    _generateSurfaceUVWAttributeData(surfacemesh);
-
-    _smoothSurfaceMesh(surfacemesh);
+    if (!isSmoothed) {
+        _smoothSurfaceMesh(surfacemesh);
+    }
     _invertContactNormals(surfacemesh);
 
     vmath::vec3 scale(_domainScale, _domainScale, _domainScale);
@@ -9993,17 +10824,7 @@ void FluidSimulation::_outputSurfaceMeshThread(std::vector<vmath::vec3> *particl
     _outputData.frameData.surface.triangles = surfacemesh.triangles.size();
     _outputData.frameData.surface.bytes = _outputData.surfaceData.size();
 
-    if (_isPreviewSurfaceMeshEnabled) {
-        _smoothSurfaceMesh(previewmesh);
-        previewmesh.scale(scale);
-        previewmesh.translate(_domainOffset);
-
-        _getTriangleMeshFileData(previewmesh, _outputData.surfacePreviewData);
-        _outputData.frameData.preview.enabled = 1;
-        _outputData.frameData.preview.vertices = previewmesh.vertices.size();
-        _outputData.frameData.preview.triangles = previewmesh.triangles.size();
-        _outputData.frameData.preview.bytes = _outputData.surfacePreviewData.size();
-    }
+    _outputPreviewSurfaceMesh(previewmesh);
 
     t.stop();
     _timingData.outputMeshSimulationData += t.getTime();
@@ -10026,10 +10847,20 @@ void FluidSimulation::_launchOutputSurfaceMeshThread() {
         particles->push_back(positions->at(i));
     }
 
-    // solidSDF will be deleted within the thread after use
+    // The meshing volume is sampled here rather than in the thread, which
+    // could race with an update of the meshing volume SDF during asynchronous
+    // meshing. The mask will be deleted within the thread after use.
+    std::vector<bool> *isOutsideMeshingVolume = new std::vector<bool>();
+    if (_isMeshingVolumeSet) {
+        _meshingVolumeSDF.trilinearInterpolateSolidPoints(*particles, *isOutsideMeshingVolume);
+    }
+
+    // solidSDF will be deleted within the thread after use. The obstacle 
+    // offset, meshing volume and domain boundary are applied while the 
+    // field is written so that the thread does not need to modify it.
     MeshLevelSet *tempSolidSDF = new MeshLevelSet();
     if (_isFluidInSimulation()) {
-        tempSolidSDF->constructMinimalSignedDistanceField(_solidSDF);
+        _initializeOutputSurfaceSolidSDF(tempSolidSDF);
     }
 
     // Velocity Field will be deleted within the thread after use
@@ -10055,7 +10886,8 @@ void FluidSimulation::_launchOutputSurfaceMeshThread() {
     }
 
     _mesherThread = std::thread(&FluidSimulation::_outputSurfaceMeshThread, this,
-                                particles, tempSolidSDF, vfield, sourceID);
+                                particles, isOutsideMeshingVolume, tempSolidSDF, 
+                                vfield, sourceID);
 
     if (!_isAsynchronousMeshingEnabled && _mesherThread.joinable()) {
         _mesherThread.join();
@@ -10072,6 +10904,7 @@ void FluidSimulation::_outputDiffuseMaterial() {
     if (!_isDiffuseMaterialOutputEnabled) { return; }
 
     if (_isDiffuseMaterialFilesSeparated) {
+        _diffuseMaterial.beginChunkedFileOutput();
         _diffuseMaterial.getFoamParticleFileDataWWP(_outputData.diffuseFoamData);
         _diffuseMaterial.getBubbleParticleFileDataWWP(_outputData.diffuseBubbleData);
         _diffuseMaterial.getSprayParticleFileDataWWP(_outputData.diffuseSprayData);
@@ -10212,6 +11045,7 @@ void FluidSimulation::_outputDiffuseMaterial() {
             _outputData.frameData.dustlifetime.bytes = _outputData.whitewaterDustLifetimeAttributeData.size();
         }
 
+        _diffuseMaterial.endChunkedFileOutput();
     } else {
         _diffuseMaterial.getDiffuseParticleFileDataWWP(_outputData.diffuseData);
     }
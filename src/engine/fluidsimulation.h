@@ -36,6 +36,7 @@ SOFTWARE.
 
 #include "vmath.h"
 #include "array3d.h"
+#include "blockarray3d.h"
 #include "meshobject.h"
 #include "fragmentedvector.h"
 #include "logfile.h"
@@ -50,6 +51,7 @@ SOFTWARE.
 #include "markerparticle.h"
 #include "viscositysolver.h"
 #include "spatialpointgrid.h"
+#include "particlemesher.h"
 
 class AABB;
 class MeshFluidSource;
@@ -429,6 +431,25 @@ public:
     int getSurfaceSmoothingIterations();
     void setSurfaceSmoothingIterations(int n);
 
+    /*
+        Enable/disable adaptive surface output. The reconstructed surface 
+        is simplified with quadric edge collapses before attributes are 
+        generated. Flat and calm regions are merged into larger triangles 
+        while curved regions, thin sheets and open boundaries are kept. The 
+        triangle reduction and decimation time are written to the log.
+
+        Error Bound: maximum distance, in number of grid cells, that the 
+                     decimated surface may deviate from the reconstructed 
+                     surface.
+
+        Disabled by default. Error bound is 0.05 by default.
+    */
+    void enableSurfaceDecimation();
+    void disableSurfaceDecimation();
+    bool isSurfaceDecimationEnabled();
+    double getSurfaceDecimationErrorBound();
+    void setSurfaceDecimationErrorBound(double e);
+
     /*
         If set, only fluid inside of this object will be meshed
     */
@@ -492,6 +513,61 @@ public:
     void disableAsynchronousMeshing();
     bool isAsynchronousMeshingEnabled();
 
+    /*
+        Enable/disable streaming surface mesh output. When enabled, the
+        surface is meshed one compute chunk at a time and every finished
+        chunk is appended as a BOBJ record to the streaming filepath, so 
+        that peak mesher memory scales with a single chunk rather than the 
+        whole surface. Readers concatenate the records. Surface attribute 
+        and motion blur data are not generated for streamed surfaces and 
+        getSurfaceData() will return empty data. Requires the BOBJ mesh 
+        output format.
+
+        Disabled by default.
+    */
+    void enableSurfaceMeshStreaming();
+    void disableSurfaceMeshStreaming();
+    bool isSurfaceMeshStreamingEnabled();
+
+    /*
+        File that streamed surface mesh chunks are written to. The file is
+        overwritten for every output frame, so the path should be set to a 
+        new file before each frame is simulated. If the file cannot be 
+        written, the surface mesh is output to memory as if streaming 
+        were disabled.
+    */
+    void setSurfaceMeshStreamingFilepath(std::string filepath);
+    std::string getSurfaceMeshStreamingFilepath();
+
+    /*
+        Enable/disable temporal coherence in the surface mesher. When enabled,
+        scalar field blocks whose marker particles are unchanged since the 
+        previous output frame and polygonizer blocks whose field values are 
+        unchanged reuse the results of the previous frame instead of being 
+        recomputed. Reuse is keyed on exact hashes so the generated surface is 
+        identical to an uncached surface. Most effective for fluid that is 
+        partially at rest. The cache is held in memory between frames.
+
+        Disabled by default.
+    */
+    void enableSurfaceMeshTemporalCache();
+    void disableSurfaceMeshTemporalCache();
+    bool isSurfaceMeshTemporalCacheEnabled();
+
+    /*
+        Enable/disable anisotropic kernels in the surface mesher. When enabled,
+        each marker particle is splatted as an ellipsoid fitted to the 
+        distribution of its neighbouring particles instead of as a sphere. 
+        Flat regions of the surface are reconstructed smoothly at a lower 
+        subdivision level and thin sheets are better preserved. Adds a
+        neighbour search over the marker particles to each meshing pass.
+
+        Disabled by default.
+    */
+    void enableSurfaceAnisotropicKernels();
+    void disableSurfaceAnisotropicKernels();
+    bool isSurfaceAnisotropicKernelsEnabled();
+
     /*
         Enable/disable the simulation from saving preview triangle 
         meshes to disk.
@@ -536,6 +612,18 @@ public:
     void disableWhitewaterMotionBlur();
     bool isWhitewaterMotionBlurEnabled();
 
+    /*
+        Output whitewater particle and attribute data in the chunked 
+        whitewater format (WWC) instead of the WWP, WWI and WWF formats.
+        Position, vector and float values are quantized to 8 or 16 bits 
+        per component, or stored unquantized with 32 bits.
+    */
+    void enableWhitewaterChunkedOutput();
+    void disableWhitewaterChunkedOutput();
+    bool isWhitewaterChunkedOutputEnabled();
+    int getWhitewaterChunkedOutputBits();
+    void setWhitewaterChunkedOutputBits(int bits);
+
     /*
         Generate velocity vector, speed, and vorticity vector attributes at fluid mesh vertices
     */
@@ -855,6 +943,14 @@ public:
     double getDiffuseEmitterGenerationRate();
     void setDiffuseEmitterGenerationRate(double rate);
 
+    /*
+        Seed for the random values used to generate and emit diffuse 
+        particles. Simulations with the same seed produce the same 
+        diffuse particles independent of the number of threads.
+    */
+    int getDiffuseParticleRandomSeed();
+    void setDiffuseParticleRandomSeed(int seed);
+
     /*
         Min/max emitter energy range
     */
@@ -892,6 +988,23 @@ public:
     AABB getDiffuseEmitterGenerationBounds();
     void setDiffuseEmitterGenerationBounds(AABB bbox);
 
+    /*
+        Distribute the max number of diffuse particles over importance 
+        regions. Each region receives a share of the particle budget that is
+        proportional to its importance, and when the budget is exceeded, 
+        particles in the least important regions are removed first. Positions
+        outside of all regions use the background importance. Regions are 
+        in simulation space, such as a camera frustum bounding box.
+    */
+    void enableDiffuseParticleBudgetScheduler();
+    void disableDiffuseParticleBudgetScheduler();
+    bool isDiffuseParticleBudgetSchedulerEnabled();
+    void addDiffuseParticleImportanceRegion(AABB bbox, double importance);
+    void clearDiffuseParticleImportanceRegions();
+    int getNumDiffuseParticleImportanceRegions();
+    double getDiffuseParticleBackgroundImportance();
+    void setDiffuseParticleBackgroundImportance(double importance);
+
     /*
         The minimum/maximum lifetime of a diffuse particle is spawned for in 
         seconds. Set this value to control how quickly/slowly diffuse
@@ -1285,6 +1398,28 @@ public:
     void disableStaticSolidLevelSetPrecomputation();
     bool isStaticSolidLevelSetPrecomputationEnabled();
 
+    /*
+        Directory for the persistent static obstacle level set cache. 
+        Precomputed static level sets are stored under a hash of the grid 
+        settings and static obstacle geometry and are reloaded instead of 
+        recomputed on resumed or re-baked simulations. An empty string 
+        disables the cache.
+    */
+    void setStaticSolidLevelSetCacheDirectory(std::string directory);
+    std::string getStaticSolidLevelSetCacheDirectory();
+
+    /*
+        Enable/Disable multi-resolution storage of the precomputed static 
+        obstacle level set. The exact band is only computed within tiles 
+        near liquid and is refined as the liquid moves into new tiles. 
+        Elsewhere, distances are sampled from a coarse level set. Only used
+        when static obstacle level set precomputation is enabled. The 
+        persistent level set cache is bypassed in this mode.
+    */
+    void enableStaticSolidLevelSetMultiResolution();
+    void disableStaticSolidLevelSetMultiResolution();
+    bool isStaticSolidLevelSetMultiResolutionEnabled();
+
     /*
         Enable/Disable pre-allocation of temporary MeshLevelSet object
     */
@@ -1658,6 +1793,21 @@ private:
         bool isInitialized = false;
     };
 
+    // Vector attributes are collected into meshes for encoding. Scalar
+    // attributes point directly into their output data buffers.
+    struct SurfaceAttributeBuffers {
+        TriangleMesh velocity;
+        TriangleMesh vorticity;
+        TriangleMesh whitewaterProximity;
+        TriangleMesh color;
+        TriangleMesh uvw;
+        char *speed = nullptr;
+        char *viscosity = nullptr;
+        char *density = nullptr;
+        char *age = nullptr;
+        char *lifetime = nullptr;
+    };
+
     struct MarkerParticleLoadData {
         FragmentedVector<MarkerParticle> particles;
     };
@@ -1850,6 +2000,21 @@ private:
     void _updatePrecomputedSolidLevelSet(double dt, std::vector<MeshObjectStatus> &objectStatus);
     void _addStaticObjectsToSolidSDF(double dt, std::vector<MeshObjectStatus> &objectStatus);
     void _addStaticObjectsToSDF(double dt, MeshLevelSet &sdf);
+    void _updateMultiResolutionStaticSolidLevelSet(double dt);
+    void _computeMultiResolutionStaticSolidLevelSet(double dt);
+    void _refineMultiResolutionStaticSolidLevelSet(double dt);
+    bool _isStaticSolidLevelSetRefinementRequired();
+    void _getRequiredStaticSolidLevelSetTiles(Array3d<bool> &tiles);
+    void _getRequiredStaticSolidLevelSetTilesThread(int startidx, int endidx, 
+                                                    std::vector<vmath::vec3> *positions, 
+                                                    Array3d<bool> *tiles);
+    void _activateStaticSolidLevelSetTiles(AABB bbox, Array3d<bool> &tiles);
+    unsigned long long _getStaticSolidLevelSetCacheKey(double dt);
+    std::string _getStaticSolidLevelSetCacheFilepath(unsigned long long key);
+    std::vector<MeshObject*> _getStaticSolidLevelSetObjectTable();
+    bool _loadStaticSolidLevelSetCache(unsigned long long key);
+    void _writeStaticSolidLevelSetCache(unsigned long long key);
+    unsigned long long _hashData(const void *data, size_t numBytes, unsigned long long hash);
     bool _isSolidStateChanged(std::vector<MeshObjectStatus> &objectStatus);
     bool _isStaticSolidStateChanged(std::vector<MeshObjectStatus> &objectStatus);
     std::vector<MeshObjectStatus> _getSolidObjectStatus();
@@ -1908,8 +2073,8 @@ private:
         Pressure Solve
     */
     void _updateWeightGrid();
-    void _updateWeightGridMT(int dir);
-    void _updateWeightGridThread(int startidx, int endidx, int dir);
+    float _updateWeightGridMT(int dir);
+    void _updateWeightGridThread(int startidx, int endidx, int dir, float *maxError);
     void _pressureSolve(double dt);
 
     /*
@@ -2061,23 +2226,27 @@ private:
     */
     void _outputSimulationData();
     void _generateSurfaceMotionBlurData(TriangleMesh &surface, MACVelocityField *vfield);
-    void _generateSurfaceVelocityAttributeData(TriangleMesh &surface, MACVelocityField *vfield);
-    void _generateSurfaceVorticityAttributeData(TriangleMesh &surface);
-    void _generateSurfaceAgeAttributeData(TriangleMesh &surface);
-    void _generateSurfaceLifetimeAttributeData(TriangleMesh &surface);
-    void _generateSurfaceWhitewaterProximityAttributeData(TriangleMesh &surface);
-    void _generateSurfaceColorAttributeData(TriangleMesh &surface);
-    void _generateSurfaceUVWAttributeData(TriangleMesh &surface);
+    void _initializeSurfaceScalarAttributeData(size_t numVertices, 
+                                               std::vector<char> &data, 
+                                               FluidSimulationMeshStats &stats);
+    void _outputSurfaceVectorAttributeData(TriangleMesh &attributeData, 
+                                           std::vector<char> &data, 
+                                           FluidSimulationMeshStats &stats);
+    void _generateSurfaceAttributeData(TriangleMesh &surface, MACVelocityField *vfield);
+    void _generateSurfaceAttributeDataThread(int startidx, int endidx, 
+                                             TriangleMesh *surface, 
+                                             MACVelocityField *vfield,
+                                             SurfaceAttributeBuffers *buffers);
+    void _setSurfaceScalarAttributeValue(char *data, int index, float value);
     void _generateSurfaceSourceIDAttributeData(TriangleMesh &surface, std::vector<vmath::vec3> &positions, std::vector<int> *sourceID);
-    void _generateSurfaceViscosityAttributeData(TriangleMesh &surface);
-    void _generateSurfaceDensityAttributeData(TriangleMesh &surface);
     void _outputSurfaceMeshThread(std::vector<vmath::vec3> *particles,
+                                  std::vector<bool> *isOutsideMeshingVolume,
                                   MeshLevelSet *solidSDF,
                                   MACVelocityField *vfield,
                                   std::vector<int> *sourceID);
     void _updateMeshingVolumeSDF();
-    void _applyMeshingVolumeToSDF(MeshLevelSet *sdf);
-    void _filterParticlesOutsideMeshingVolume(std::vector<vmath::vec3> *particles);
+    void _filterParticlesOutsideMeshingVolume(std::vector<vmath::vec3> *particles,
+                                              std::vector<bool> *isOutsideMeshingVolume);
     void _launchOutputSurfaceMeshThread();
     void _joinOutputSurfaceMeshThread();
     void _outputDiffuseMaterial();
@@ -2142,12 +2311,28 @@ private:
                                         std::vector<float> &binSpeeds, 
                                         std::vector<char> &outdata);
     void _smoothSurfaceMesh(TriangleMesh &mesh);
+    void _smoothSurfaceMesh(TriangleMesh &mesh, std::vector<bool> &isPinnedVertex);
+    void _decimateSurfaceMesh(TriangleMesh &mesh, size_t *numTriangles, 
+                              size_t *numDecimatedTriangles, double *decimationTime);
+    void _logSurfaceDecimation(size_t numTriangles, size_t numDecimatedTriangles, 
+                               double decimationTime);
     void _invertContactNormals(TriangleMesh &mesh);
     void _removeMeshNearDomain(TriangleMesh &mesh);
-    void _computeDomainBoundarySDF(MeshLevelSet *sdf);
+    void _initializeOutputSurfaceSolidSDF(MeshLevelSet *sdf);
+    void _initializeOutputSurfaceSolidSDFThread(int startk, int endk, MeshLevelSet *sdf);
+    bool _initializeOutputSurfaceMesherParameters(std::vector<vmath::vec3> *particles,
+                                                  std::vector<bool> *isOutsideMeshingVolume,
+                                                  MeshLevelSet *solidSDF,
+                                                  ParticleMesherParameters &params);
     void _generateOutputSurface(TriangleMesh &surface, TriangleMesh &preview,
                                   std::vector<vmath::vec3> *particles,
+                                  std::vector<bool> *isOutsideMeshingVolume,
                                   MeshLevelSet *soldSDF);
+    bool _outputStreamingSurfaceMesh(std::vector<vmath::vec3> *particles,
+                                     std::vector<bool> *isOutsideMeshingVolume,
+                                     MeshLevelSet *solidSDF);
+    void _logSurfaceMesherCacheReuse();
+    void _outputPreviewSurfaceMesh(TriangleMesh &previewmesh);
     void _outputSimulationLogFile();
 
 
@@ -2276,6 +2461,7 @@ private:
     // Compute levelset signed distance field
     MeshLevelSet _solidSDF;
     MeshLevelSet _staticSolidSDF;
+    MeshLevelSet _staticSolidCoarseSDF;
     MeshLevelSet _tempSolidSDF;
     MeshObject _domainMeshObject;
     double _boundaryFrictionXNeg = 0.0;
@@ -2288,6 +2474,15 @@ private:
     bool _isTempSolidLevelSetEnabled = true;
     bool _isSolidLevelSetUpToDate = false;
     bool _isPrecomputedSolidLevelSetUpToDate = false;
+    std::string _staticSolidLevelSetCacheDirectory;
+    bool _isStaticSolidLevelSetMultiResolutionEnabled = false;
+    bool _isStaticSolidLevelSetRefinementPending = false;
+    bool _isStaticSolidLevelSetTileBinningValid = false;
+    double _staticSolidLevelSetTileBinningTravel = 0.0;
+    Array3d<bool> _staticSolidLevelSetTiles;
+    Array3d<bool> _staticSolidLevelSetRefinementTiles;
+    int _staticSolidLevelSetTileWidth = 8;
+    int _staticSolidLevelSetCoarseFactor = 4;
     int _solidLevelSetExactBand = 3;
     bool _isSmoothSurfaceTensionKernelEnabled = false;
     double _liquidSDFParticleScale = 1.0;
@@ -2375,6 +2570,8 @@ private:
     bool _isDiffuseMaterialFilesSeparated = false;
     int _outputFluidSurfaceSubdivisionLevel = 1;
     int _numSurfaceReconstructionPolygonizerSlices = 1;
+    bool _isSurfaceDecimationEnabled = false;
+    double _surfaceDecimationErrorBound = 0.05;
     double _surfaceReconstructionSmoothingValue = 0.5;
     int _surfaceReconstructionSmoothingIterations = 2;
     int _minimumSurfacePolyhedronTriangleCount = 0;
@@ -2394,6 +2591,13 @@ private:
     bool _isAsynchronousMeshingEnabled = true;
     std::thread _mesherThread;
 
+    bool _isSurfaceMeshStreamingEnabled = false;
+    std::string _surfaceMeshStreamingFilepath;
+
+    bool _isSurfaceMeshTemporalCacheEnabled = false;
+    ParticleMesherCache _surfaceMesherCache;
+    bool _isSurfaceAnisotropicKernelsEnabled = false;
+
     // Advect velocity field
     VelocityAdvector _velocityAdvector;
     int _maxParticlesPerVelocityAdvection = 5e6;
@@ -2402,7 +2606,7 @@ private:
 
     // Calculate fluid curvature
     Array3d<float> _fluidSurfaceLevelSet;
-    Array3d<float> _fluidCurvatureGrid;
+    BlockArray3d<float> _fluidCurvatureGrid;
     std::thread _fluidCurvatureThread;
     bool _isCalculateFluidCurvatureGridThreadRunning = false;
 
@@ -2429,6 +2633,7 @@ private:
     // Pressure solve
     WeightGrid _weightGrid;
     bool _isWeightGridUpToDate = false;
+    float _weightGridStorageError = 0.0f;
     bool _isSurfaceTensionEnabled = false;
     double _surfaceTensionConstant = 0.0;
     double _density = 20.0;
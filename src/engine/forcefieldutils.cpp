@@ -41,7 +41,7 @@ float _sleepTimeFactor = 0.25;
 
 void generateSurfaceVectorField(MeshLevelSet &sdf, TriangleMesh &mesh, Array3d<vmath::vec3> &vectorField,
                                 bool generateFrontFacing, bool generateBackFacing, bool generateEdgeFacing) {
-    Array3d<float> *phiptr = sdf.getPhiArray3d();
+    Array3d<StorageFloat> *phiptr = sdf.getPhiArray3d();
     int isize = phiptr->width;
     int jsize = phiptr->height;
     int ksize = phiptr->depth;
@@ -57,7 +57,7 @@ void generateSurfaceVectorField(MeshLevelSet &sdf, TriangleMesh &mesh, Array3d<v
     data.isClosestPointSet = Array3d<bool>(isize, jsize, ksize, false);
     data.dx = dx;
 
-    float *phirawsrc = phiptr->getRawArray();
+    StorageFloat *phirawsrc = phiptr->getRawArray();
     float *phirawdst = data.phi.getRawArray();
     float maxdist = _bandwidth * dx;
     for (size_t i = 0; i < phiptr->getNumElements(); i++) {
@@ -37,7 +37,11 @@ InfluenceGrid::InfluenceGrid() {
 InfluenceGrid::InfluenceGrid(int isize, int jsize, int ksize, double dx, float baselevel) :
                                 _isize(isize), _jsize(jsize), _ksize(ksize), _dx(dx),
                                 _baselevel(baselevel),
-                                _influence(isize, jsize, ksize, baselevel) {
+                                _backgroundValue(baselevel) {
+    _tileSize = _tileWidth * _tileWidth * _tileWidth;
+    _tileSlots = Array3d<int>((_isize + _tileWidth - 1) / _tileWidth,
+                              (_jsize + _tileWidth - 1) / _tileWidth,
+                              (_ksize + _tileWidth - 1) / _tileWidth, -1);
 }
 
 InfluenceGrid::~InfluenceGrid() {
@@ -63,8 +67,26 @@ void InfluenceGrid::setDecayRate(float rate) {
     _decayrate = rate;
 }
 
-Array3d<float>* InfluenceGrid::getInfluenceGrid() {
-    return &_influence;
+float InfluenceGrid::getInfluence(int i, int j, int k) {
+    if (!Grid3d::isGridIndexInRange(i, j, k, _isize, _jsize, _ksize)) {
+        return _backgroundValue;
+    }
+
+    int slot = _tileSlots(i / _tileWidth, j / _tileWidth, k / _tileWidth);
+    if (slot == -1) {
+        return _backgroundValue;
+    }
+
+    int localidx = (i % _tileWidth) + _tileWidth * ((j % _tileWidth) + _tileWidth * (k % _tileWidth));
+    return _tileData[(size_t)slot * _tileSize + localidx];
+}
+
+float InfluenceGrid::getInfluence(GridIndex g) {
+    return getInfluence(g.i, g.j, g.k);
+}
+
+void InfluenceGrid::invalidateInfluenceSources() {
+    _isInfluenceSourceGroupsValid = false;
 }
 
 void InfluenceGrid::update(MeshLevelSet *solidSDF, double dt) {
@@ -76,56 +98,56 @@ void InfluenceGrid::update(MeshLevelSet *solidSDF, double dt) {
     if (isSpreadEnabled) {
         _updateSpread(dt);
     }
-    _updateInfluenceSources(solidSDF);
+
+    if (!_isInfluenceSourceGroupsValid) {
+        _updateInfluenceSourceGroups(solidSDF);
+    }
+    _updateInfluenceSources();
+    _retireTiles();
 }
 
-void InfluenceGrid::_updateDecay(double dt) {
-    for (int k = 0; k < _influence.depth; k++) {
-        for (int j = 0; j < _influence.height; j++) {
-            for (int i = 0; i < _influence.width; i++) {
-                float value = _influence(i, j, k);
-                if (value < _baselevel) {
-                    value = std::min(value + _decayrate * (float)dt, _baselevel);
-                } else if (value > _baselevel) {
-                    value = std::max(value - _decayrate * (float)dt, _baselevel);
-                }
-                _influence.set(i, j, k, value);
-            }
-        }
-    }   
+float InfluenceGrid::_getDecayedValue(float value, double dt) {
+    if (value < _baselevel) {
+        value = std::min(value + _decayrate * (float)dt, _baselevel);
+    } else if (value > _baselevel) {
+        value = std::max(value - _decayrate * (float)dt, _baselevel);
+    }
+    return value;
 }
 
-void InfluenceGrid::_updateSpread(double dt) {
-    bool isInfluenceUniform = true;
-    float constvalue = _influence(0, 0, 0);
-    float eps = 1e-5;
-    for (int k = 0; k < _influence.depth; k++) {
-        for (int j = 0; j < _influence.height; j++) {
-            for (int i = 0; i < _influence.width; i++) {
-                if (std::abs(_influence(i, j, k) - constvalue) > eps) {
-                    isInfluenceUniform = false;
-                    goto endLoop;
-                }
-            }
-        }
+int InfluenceGrid::_activateTile(GridIndex t) {
+    int slot = _tileSlots(t);
+    if (slot != -1) {
+        return slot;
     }
-    endLoop:
 
-    if (isInfluenceUniform) {
-        return;
+    slot = (int)_activeTiles.size();
+    _activeTiles.push_back(t);
+    _tileData.insert(_tileData.end(), _tileSize, _backgroundValue);
+    _tileSlots.set(t, slot);
+
+    return slot;
+}
+
+void InfluenceGrid::_updateDecay(double dt) {
+    _backgroundValue = _getDecayedValue(_backgroundValue, dt);
+    for (size_t i = 0; i < _tileData.size(); i++) {
+        _tileData[i] = _getDecayedValue(_tileData[i], dt);
     }
+}
 
-    if (_tempinfluence.width != _influence.width || 
-            _tempinfluence.height != _influence.height || 
-            _tempinfluence.depth != _influence.depth) {
-        _tempinfluence = Array3d<float>(_influence.width, _influence.height, _influence.depth);
+void InfluenceGrid::_updateSpread(double dt) {
+    if (_isInfluenceUniform()) {
+        return;
     }
 
-    size_t gridsize = _isize * _jsize * _ksize;
+    _activateSpreadTiles();
+    _tempTileData.resize(_tileData.size());
+
     size_t numCPU = ThreadUtils::getMaxThreadCount();
-    int numthreads = (int)fmin(numCPU, gridsize);
+    int numthreads = (int)fmin(numCPU, _activeTiles.size());
     std::vector<std::thread> threads(numthreads);
-    std::vector<int> intervals = ThreadUtils::splitRangeIntoIntervals(0, gridsize, numthreads);
+    std::vector<int> intervals = ThreadUtils::splitRangeIntoIntervals(0, _activeTiles.size(), numthreads);
     for (int i = 0; i < numthreads; i++) {
         threads[i] = std::thread(&InfluenceGrid::_updateSpreadThread, this,
                                  intervals[i], intervals[i + 1], dt);
@@ -135,48 +157,196 @@ void InfluenceGrid::_updateSpread(double dt) {
         threads[i].join();
     }
 
-    for (int k = 0; k < _influence.depth; k++) {
-        for (int j = 0; j < _influence.height; j++) {
-            for (int i = 0; i < _influence.width; i++) {
-                _influence.set(i, j, k, _tempinfluence(i, j, k));
+    _tileData.swap(_tempTileData);
+}
+
+bool InfluenceGrid::_isInfluenceUniform() {
+    float constvalue = getInfluence(0, 0, 0);
+    float eps = 1e-5;
+    if ((int)_activeTiles.size() < _tileSlots.width * _tileSlots.height * _tileSlots.depth &&
+            std::abs(_backgroundValue - constvalue) > eps) {
+        return false;
+    }
+
+    for (size_t tidx = 0; tidx < _activeTiles.size(); tidx++) {
+        GridIndex offset = _activeTiles[tidx];
+        offset.i *= _tileWidth; 
+        offset.j *= _tileWidth; 
+        offset.k *= _tileWidth;
+        float *data = _tileData.data() + tidx * _tileSize;
+
+        int cellidx = 0;
+        for (int k = 0; k < _tileWidth; k++) {
+            for (int j = 0; j < _tileWidth; j++) {
+                for (int i = 0; i < _tileWidth; i++) {
+                    if (Grid3d::isGridIndexInRange(offset.i + i, offset.j + j, offset.k + k, _isize, _jsize, _ksize) && 
+                            std::abs(data[cellidx] - constvalue) > eps) {
+                        return false;
+                    }
+                    cellidx++;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+void InfluenceGrid::_activateSpreadTiles() {
+    // Spread reaches the face neighbour tiles of the active tiles
+    GridIndex nbs[6];
+    size_t numTiles = _activeTiles.size();
+    for (size_t tidx = 0; tidx < numTiles; tidx++) {
+        Grid3d::getNeighbourGridIndices6(_activeTiles[tidx], nbs);
+        for (int nidx = 0; nidx < 6; nidx++) {
+            if (_tileSlots.isIndexInRange(nbs[nidx])) {
+                _activateTile(nbs[nidx]);
             }
         }
-    }   
+    }
 }
 
 void InfluenceGrid::_updateSpreadThread(int startidx, int endidx, double dt) {
     GridIndex nbs[6];
     float rate = _spreadFactor * _decayrate * dt;
-    for (int idx = startidx; idx < endidx; idx++) {
-        GridIndex g = Grid3d::getUnflattenedIndex(idx, _isize, _jsize);
-        Grid3d::getNeighbourGridIndices6(g, nbs);
-        float currentvalue = _influence(g);
-        float sum = 0.0f;
-        int n = 0;
-        for (int nidx = 0; nidx < 6; nidx++) {
-            if (_influence.isIndexInRange(nbs[nidx])) {
-                sum += rate * (_influence(nbs[nidx]) - currentvalue);
-                n++;
+    for (int tidx = startidx; tidx < endidx; tidx++) {
+        GridIndex offset = _activeTiles[tidx];
+        offset.i *= _tileWidth; 
+        offset.j *= _tileWidth; 
+        offset.k *= _tileWidth;
+        float *data = _tileData.data() + (size_t)tidx * _tileSize;
+        float *tempdata = _tempTileData.data() + (size_t)tidx * _tileSize;
+
+        int cellidx = 0;
+        for (int k = 0; k < _tileWidth; k++) {
+            for (int j = 0; j < _tileWidth; j++) {
+                for (int i = 0; i < _tileWidth; i++) {
+                    GridIndex g(offset.i + i, offset.j + j, offset.k + k);
+                    float currentvalue = data[cellidx];
+                    if (!Grid3d::isGridIndexInRange(g, _isize, _jsize, _ksize)) {
+                        tempdata[cellidx] = currentvalue;
+                        cellidx++;
+                        continue;
+                    }
+
+                    Grid3d::getNeighbourGridIndices6(g, nbs);
+                    float sum = 0.0f;
+                    int n = 0;
+                    for (int nidx = 0; nidx < 6; nidx++) {
+                        if (Grid3d::isGridIndexInRange(nbs[nidx], _isize, _jsize, _ksize)) {
+                            sum += rate * (getInfluence(nbs[nidx]) - currentvalue);
+                            n++;
+                        }
+                    }
+                    tempdata[cellidx] = currentvalue + (sum / (float)n);
+                    cellidx++;
+                }
             }
         }
-        _tempinfluence.set(g, currentvalue + (sum / (float)n));
     }
 }
 
-void InfluenceGrid::_updateInfluenceSources(MeshLevelSet *solidSDF) {
+void InfluenceGrid::_updateInfluenceSourceGroups(MeshLevelSet *solidSDF) {
+    std::vector<MeshObject*> meshObjects = solidSDF->getMeshObjects();
+    _sourceGroups.clear();
+    _sourceGroups.resize(meshObjects.size());
+    for (size_t i = 0; i < meshObjects.size(); i++) {
+        _sourceGroups[i].meshObject = meshObjects[i];
+    }
+
     float width = _narrowBandWidth * _dx;
-    for (int k = 0; k < _ksize; k++) {
-        for (int j = 0; j < _jsize; j++) {
-            for (int i = 0; i < _isize; i++) {
-                if (std::abs(solidSDF->get(i, j, k)) > width) {
-                    continue;
+    for (int tk = 0; tk < _tileSlots.depth; tk++) {
+        for (int tj = 0; tj < _tileSlots.height; tj++) {
+            for (int ti = 0; ti < _tileSlots.width; ti++) {
+                GridIndex t(ti, tj, tk);
+                int cellidx = 0;
+                for (int k = tk * _tileWidth; k < (tk + 1) * _tileWidth; k++) {
+                    for (int j = tj * _tileWidth; j < (tj + 1) * _tileWidth; j++) {
+                        for (int i = ti * _tileWidth; i < (ti + 1) * _tileWidth; i++) {
+                            if (!Grid3d::isGridIndexInRange(i, j, k, _isize, _jsize, _ksize) || 
+                                    std::abs(solidSDF->get(i, j, k)) > width) {
+                                cellidx++;
+                                continue;
+                            }
+
+                            int objidx = solidSDF->getClosestMeshObjectIndex(i, j, k);
+                            if (objidx < 0 || objidx >= (int)_sourceGroups.size()) {
+                                cellidx++;
+                                continue;
+                            }
+
+                            InfluenceSourceGroup *group = &(_sourceGroups[objidx]);
+                            if (group->tiles.empty() || group->tiles.back() != t) {
+                                group->tiles.push_back(t);
+                                group->tileCellStarts.push_back((int)group->cells.size());
+                            }
+                            group->cells.push_back((short)cellidx);
+                            cellidx++;
+                        }
+                    }
                 }
+            }
+        }
+    }
+
+    for (size_t i = 0; i < _sourceGroups.size(); i++) {
+        _sourceGroups[i].tileCellStarts.push_back((int)_sourceGroups[i].cells.size());
+    }
 
-                MeshObject *m = solidSDF->getClosestMeshObject(i, j, k);
-                if (m != nullptr) {
-                    _influence.set(i, j, k, m->getWhitewaterInfluence());
+    _isInfluenceSourceGroupsValid = true;
+}
+
+void InfluenceGrid::_updateInfluenceSources() {
+    for (size_t gidx = 0; gidx < _sourceGroups.size(); gidx++) {
+        InfluenceSourceGroup *group = &(_sourceGroups[gidx]);
+        if (group->meshObject == nullptr) {
+            continue;
+        }
+
+        float value = group->meshObject->getWhitewaterInfluence();
+        for (size_t tidx = 0; tidx < group->tiles.size(); tidx++) {
+            int slot = _tileSlots(group->tiles[tidx]);
+            if (slot == -1) {
+                if (value == _backgroundValue) {
+                    continue;
                 }
+                slot = _activateTile(group->tiles[tidx]);
+            }
+
+            float *data = _tileData.data() + (size_t)slot * _tileSize;
+            for (int cidx = group->tileCellStarts[tidx]; cidx < group->tileCellStarts[tidx + 1]; cidx++) {
+                data[group->cells[cidx]] = value;
             }
         }
-    }   
-}
\ No newline at end of file
+    }
+}
+
+void InfluenceGrid::_retireTiles() {
+    size_t numActive = 0;
+    for (size_t tidx = 0; tidx < _activeTiles.size(); tidx++) {
+        float *data = _tileData.data() + tidx * _tileSize;
+        bool isBackground = true;
+        for (int i = 0; i < _tileSize; i++) {
+            if (data[i] != _backgroundValue) {
+                isBackground = false;
+                break;
+            }
+        }
+
+        GridIndex t = _activeTiles[tidx];
+        if (isBackground) {
+            _tileSlots.set(t, -1);
+            continue;
+        }
+
+        if (numActive != tidx) {
+            std::copy(data, data + _tileSize, _tileData.data() + numActive * _tileSize);
+            _activeTiles[numActive] = t;
+        }
+        _tileSlots.set(t, (int)numActive);
+        numActive++;
+    }
+
+    _activeTiles.resize(numActive);
+    _tileData.resize(numActive * _tileSize);
+}
@@ -24,10 +24,26 @@ SOFTWARE.
 
 #pragma once
 
+#if __MINGW32__ && !_WIN64
+    #include "mingw32_threads/mingw.thread.h"
+#else
+    #include <thread>
+#endif
+
+#include <vector>
+
 #include "array3d.h"
 
 class MeshLevelSet;
+class MeshObject;
 
+/*
+    Influence values are stored sparsely in cubic tiles. Cells outside of the
+    active tiles share a uniform background value that decays towards the 
+    base level in the same way as the cells of an active tile. Tiles are 
+    activated by influence sources or by spread and are retired once all of 
+    their values have returned to the background value.
+*/
 class InfluenceGrid
 {
 public:
@@ -40,16 +56,36 @@ public:
     void setBaseLevel(float level);
     float getDecayRate();
     void setDecayRate(float rate);
-    Array3d<float>* getInfluenceGrid();
+    float getInfluence(int i, int j, int k);
+    float getInfluence(GridIndex g);
+
+    // Must be called when the solid level set has changed so that the
+    // influence source cells are found again on the next update
+    void invalidateInfluenceSources();
 
     void update(MeshLevelSet *solidSDF, double dt);
 
 private:
 
+    // Cells within the narrow band of the solid level set, grouped by their
+    // closest mesh object and sorted into tiles
+    struct InfluenceSourceGroup {
+        MeshObject *meshObject = nullptr;
+        std::vector<GridIndex> tiles;
+        std::vector<int> tileCellStarts;
+        std::vector<short> cells;
+    };
+
+    float _getDecayedValue(float value, double dt);
+    int _activateTile(GridIndex t);
     void _updateDecay(double dt);
     void _updateSpread(double dt);
+    bool _isInfluenceUniform();
+    void _activateSpreadTiles();
     void _updateSpreadThread(int startidx, int endidx, double dt);
-    void _updateInfluenceSources(MeshLevelSet *solidSDF);
+    void _updateInfluenceSourceGroups(MeshLevelSet *solidSDF);
+    void _updateInfluenceSources();
+    void _retireTiles();
 
     int _isize = 0;
     int _jsize = 0;
@@ -61,6 +97,14 @@ private:
     bool isSpreadEnabled = false;
     float _narrowBandWidth = 3.0;   // In # of cells
 
-    Array3d<float> _influence;
-    Array3d<float> _tempinfluence;
+    int _tileWidth = 8;
+    int _tileSize = 512;
+    float _backgroundValue = 1.0f;
+    Array3d<int> _tileSlots;                // index into _activeTiles or -1
+    std::vector<GridIndex> _activeTiles;
+    std::vector<float> _tileData;
+    std::vector<float> _tempTileData;
+
+    std::vector<InfluenceSourceGroup> _sourceGroups;
+    bool _isInfluenceSourceGroupsValid = false;
 };
@@ -70,15 +70,47 @@ double Interpolation::trilinearInterpolate(double p[8], double x, double y, doub
 }
 
 double Interpolation::trilinearInterpolate(vmath::vec3 p, double dx, Array3d<float> &grid) {
+    return _trilinearInterpolateScalarGrid(p, dx, grid);
+}
+
+double Interpolation::trilinearInterpolate(vmath::vec3 p, double dx, Array3d<float16> &grid) {
+    return _trilinearInterpolateScalarGrid(p, dx, grid);
+}
 
-    GridIndex g = Grid3d::positionToGridIndex(p, dx);
-    vmath::vec3 gpos = Grid3d::GridIndexToPosition(g, dx);
+double Interpolation::trilinearInterpolate(vmath::vec3 p, double dx, BlockArray3d<float> &grid) {
+    return _trilinearInterpolateScalarGrid(p, dx, grid);
+}
+
+Interpolation::TrilinearStencil Interpolation::getTrilinearStencil(vmath::vec3 p, double dx) {
+    TrilinearStencil s;
+    s.g = Grid3d::positionToGridIndex(p, dx);
+    vmath::vec3 gpos = Grid3d::GridIndexToPosition(s.g, dx);
 
     double inv_dx = 1.0 / dx;
-    double ix = (p.x - gpos.x)*inv_dx;
-    double iy = (p.y - gpos.y)*inv_dx;
-    double iz = (p.z - gpos.z)*inv_dx;
+    s.ix = (p.x - gpos.x)*inv_dx;
+    s.iy = (p.y - gpos.y)*inv_dx;
+    s.iz = (p.z - gpos.z)*inv_dx;
+
+    return s;
+}
+
+double Interpolation::trilinearInterpolate(TrilinearStencil &s, Array3d<float> &grid) {
+    return _trilinearInterpolateScalarGrid(s, grid);
+}
+
+double Interpolation::trilinearInterpolate(TrilinearStencil &s, BlockArray3d<float> &grid) {
+    return _trilinearInterpolateScalarGrid(s, grid);
+}
+
+template<class GridType>
+double Interpolation::_trilinearInterpolateScalarGrid(vmath::vec3 p, double dx, GridType &grid) {
+    TrilinearStencil s = getTrilinearStencil(p, dx);
+    return _trilinearInterpolateScalarGrid(s, grid);
+}
 
+template<class GridType>
+double Interpolation::_trilinearInterpolateScalarGrid(TrilinearStencil &s, GridType &grid) {
+    GridIndex g = s.g;
     double points[8] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
     int isize = grid.width;
     int jsize = grid.height;
@@ -108,18 +140,19 @@ double Interpolation::trilinearInterpolate(vmath::vec3 p, double dx, Array3d<flo
         points[7] = grid(g.i+1, g.j+1, g.k+1); 
     }
 
-    return trilinearInterpolate(points, ix, iy, iz);
+    return trilinearInterpolate(points, s.ix, s.iy, s.iz);
 }
 
 vmath::vec3 Interpolation::trilinearInterpolate(vmath::vec3 p, double dx, Array3d<vmath::vec3> &grid) {
+    TrilinearStencil s = getTrilinearStencil(p, dx);
+    return trilinearInterpolate(s, grid);
+}
 
-    GridIndex g = Grid3d::positionToGridIndex(p, dx);
-    vmath::vec3 gpos = Grid3d::GridIndexToPosition(g, dx);
-
-    double inv_dx = 1.0 / dx;
-    double ix = (p.x - gpos.x)*inv_dx;
-    double iy = (p.y - gpos.y)*inv_dx;
-    double iz = (p.z - gpos.z)*inv_dx;
+vmath::vec3 Interpolation::trilinearInterpolate(TrilinearStencil &s, Array3d<vmath::vec3> &grid) {
+    GridIndex g = s.g;
+    double ix = s.ix;
+    double iy = s.iy;
+    double iz = s.iz;
 
     double pointsX[8] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
     double pointsY[8] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
@@ -196,14 +229,33 @@ double Interpolation::bilinearInterpolate(
 
 void Interpolation::trilinearInterpolateGradient(
             vmath::vec3 p, double dx, Array3d<float> &grid, vmath::vec3 *grad) {
+    _trilinearInterpolateScalarGridGradient(p, dx, grid, grad);
+}
+
+void Interpolation::trilinearInterpolateGradient(
+            vmath::vec3 p, double dx, Array3d<float16> &grid, vmath::vec3 *grad) {
+    _trilinearInterpolateScalarGridGradient(p, dx, grid, grad);
+}
+
+void Interpolation::trilinearInterpolateGradient(
+            TrilinearStencil &s, Array3d<float> &grid, vmath::vec3 *grad) {
+    _trilinearInterpolateScalarGridGradient(s, grid, grad);
+}
 
-    GridIndex g = Grid3d::positionToGridIndex(p, dx);
-    vmath::vec3 gpos = Grid3d::GridIndexToPosition(g, dx);
+template<class T>
+void Interpolation::_trilinearInterpolateScalarGridGradient(
+            vmath::vec3 p, double dx, Array3d<T> &grid, vmath::vec3 *grad) {
+    TrilinearStencil s = getTrilinearStencil(p, dx);
+    _trilinearInterpolateScalarGridGradient(s, grid, grad);
+}
 
-    double inv_dx = 1.0 / dx;
-    double ix = (p.x - gpos.x)*inv_dx;
-    double iy = (p.y - gpos.y)*inv_dx;
-    double iz = (p.z - gpos.z)*inv_dx;
+template<class T>
+void Interpolation::_trilinearInterpolateScalarGridGradient(
+            TrilinearStencil &s, Array3d<T> &grid, vmath::vec3 *grad) {
+    GridIndex g = s.g;
+    double ix = s.ix;
+    double iy = s.iy;
+    double iz = s.iz;
    
     int isize = grid.width;
     int jsize = grid.height;
@@ -26,19 +26,50 @@ SOFTWARE.
 
 #include "vmath.h"
 #include "array3d.h"
+#include "blockarray3d.h"
 
 namespace Interpolation {
 
+    // Cell and local coordinates of a trilinear interpolation at a position.
+    // A stencil can be reused to sample several grids that share a layout.
+    struct TrilinearStencil {
+        GridIndex g;
+        double ix = 0.0;
+        double iy = 0.0;
+        double iz = 0.0;
+    };
+
     extern double cubicInterpolate(double p[4], double x);
     extern double bicubicInterpolate(double p[4][4], double x, double y);
     extern double tricubicInterpolate(double p[4][4][4], double x, double y, double z);
 
     extern double trilinearInterpolate(double p[8], double x, double y, double z);
     extern double trilinearInterpolate(vmath::vec3 p, double dx, Array3d<float> &grid);
+    extern double trilinearInterpolate(vmath::vec3 p, double dx, Array3d<float16> &grid);
+    extern double trilinearInterpolate(vmath::vec3 p, double dx, BlockArray3d<float> &grid);
 
     extern double bilinearInterpolate(double v00, double v10, double v01, double v11, 
                                       double ix, double iy);
     extern vmath::vec3 trilinearInterpolate(vmath::vec3 p, double dx, Array3d<vmath::vec3> &grid);
+    extern TrilinearStencil getTrilinearStencil(vmath::vec3 p, double dx);
+    extern double trilinearInterpolate(TrilinearStencil &s, Array3d<float> &grid);
+    extern double trilinearInterpolate(TrilinearStencil &s, BlockArray3d<float> &grid);
+    extern vmath::vec3 trilinearInterpolate(TrilinearStencil &s, Array3d<vmath::vec3> &grid);
     extern void trilinearInterpolateGradient(
             vmath::vec3 p, double dx, Array3d<float> &grid, vmath::vec3 *grad);
+    extern void trilinearInterpolateGradient(
+            vmath::vec3 p, double dx, Array3d<float16> &grid, vmath::vec3 *grad);
+    extern void trilinearInterpolateGradient(
+            TrilinearStencil &s, Array3d<float> &grid, vmath::vec3 *grad);
+
+    template<class GridType>
+    double _trilinearInterpolateScalarGrid(vmath::vec3 p, double dx, GridType &grid);
+    template<class GridType>
+    double _trilinearInterpolateScalarGrid(TrilinearStencil &s, GridType &grid);
+    template<class T>
+    void _trilinearInterpolateScalarGridGradient(
+            vmath::vec3 p, double dx, Array3d<T> &grid, vmath::vec3 *grad);
+    template<class T>
+    void _trilinearInterpolateScalarGridGradient(
+            TrilinearStencil &s, Array3d<T> &grid, vmath::vec3 *grad);
 }
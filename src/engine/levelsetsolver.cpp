@@ -26,6 +26,7 @@ SOFTWARE.
 
 #include <limits>
 #include <cmath>
+#include <algorithm>
 
 #include "threadutils.h"
 #include "grid3d.h"
@@ -41,116 +42,196 @@ void LevelSetSolver::reinitializeEno(Array3d<float> &inputSDF,
                                      Array3d<float> &outputSDF) {
 
     _maxCFL = 0.25;
+    _reinitialize(inputSDF, dx, maxDistance, solverCells, SolverMethod::eno, outputSDF);
+}
 
-    float dtau = _getPseudoTimeStep(inputSDF, dx);
-    int numIterations = _getNumberOfIterations(maxDistance, dtau);
-
-    int isize = inputSDF.width;
-    int jsize = inputSDF.height;
-    int ksize = inputSDF.depth;
-    outputSDF = inputSDF;
-
-    Array3d<float> tempSDF(isize, jsize, ksize);
-    Array3d<float> *tempPtr = &tempSDF;
-    Array3d<float> *outputPtr = &outputSDF;
-
-    for (int n = 0; n < numIterations; n++) {
-        int numCPU = ThreadUtils::getMaxThreadCount();
-        int numthreads = (int)fmin(numCPU, solverCells.size());
-        std::vector<std::thread> threads(numthreads);
-        std::vector<int> intervals = ThreadUtils::splitRangeIntoIntervals(0, solverCells.size(), numthreads);
-        for (int i = 0; i < numthreads; i++) {
-            threads[i] = std::thread(&LevelSetSolver::_stepSolverThreadEno, this,
-                                     intervals[i], intervals[i + 1], tempPtr, outputPtr, dx, dtau, &solverCells);
-        }
-
-        for (int i = 0; i < numthreads; i++) {
-            threads[i].join();
-        }
+void LevelSetSolver::reinitializeUpwind(Array3d<float> &inputSDF, 
+                                        float dx, 
+                                        float maxDistance, 
+                                        std::vector<GridIndex> &solverCells, 
+                                        Array3d<float> &outputSDF) {
 
-        std::swap(tempPtr, outputPtr);
-    }
+    _maxCFL = 0.5;
+    _reinitialize(inputSDF, dx, maxDistance, solverCells, SolverMethod::upwind, outputSDF);
+}
 
-    float *rawarraysrc = outputPtr->getRawArray();
-    float *rawarraydst = outputSDF.getRawArray();
-    int n = outputSDF.getNumElements();
-    for (int i = 0; i < n; i++) {
-        rawarraydst[i] = rawarraysrc[i];
-    }
+void LevelSetSolver::reinitializeEno(Array3d<float16> &inputSDF, 
+                                     float dx, 
+                                     float maxDistance, 
+                                     std::vector<GridIndex> &solverCells, 
+                                     Array3d<float> &outputSDF) {
+    Array3d<float> floatSDF;
+    _convertGrid(inputSDF, floatSDF);
+    reinitializeEno(floatSDF, dx, maxDistance, solverCells, outputSDF);
 }
 
-void LevelSetSolver::reinitializeUpwind(Array3d<float> &inputSDF, 
+void LevelSetSolver::reinitializeUpwind(Array3d<float16> &inputSDF, 
                                         float dx, 
                                         float maxDistance, 
                                         std::vector<GridIndex> &solverCells, 
                                         Array3d<float> &outputSDF) {
+    Array3d<float> floatSDF;
+    _convertGrid(inputSDF, floatSDF);
+    reinitializeUpwind(floatSDF, dx, maxDistance, solverCells, outputSDF);
+}
 
-    _maxCFL = 0.5;
+void LevelSetSolver::_convertGrid(Array3d<float16> &input, Array3d<float> &output) {
+    output = Array3d<float>(input.width, input.height, input.depth);
+    float16 *src = input.getRawArray();
+    float *dst = output.getRawArray();
+    size_t n = input.getNumElements();
+    for (size_t i = 0; i < n; i++) {
+        dst[i] = src[i];
+    }
+}
 
-    float dtau = _getPseudoTimeStep(inputSDF, dx);
-    int numIterations = _getNumberOfIterations(maxDistance, dtau);
+void LevelSetSolver::_reinitialize(Array3d<float> &inputSDF, 
+                                   float dx, 
+                                   float maxDistance, 
+                                   std::vector<GridIndex> &solverCells, 
+                                   SolverMethod method,
+                                   Array3d<float> &outputSDF) {
 
     int isize = inputSDF.width;
     int jsize = inputSDF.height;
     int ksize = inputSDF.depth;
     outputSDF = inputSDF;
 
-    Array3d<float> tempSDF(isize, jsize, ksize);
+    std::vector<SolverRow> rows;
+    _initializeSolverRows(solverCells, isize, jsize, ksize, rows);
+    if (rows.empty()) {
+        return;
+    }
+
+    float dtau = _getPseudoTimeStep(inputSDF, rows, dx);
+    int numIterations = _getNumberOfIterations(maxDistance, dtau);
+
+    // Both buffers must hold the input values outside of the band since
+    // stencils near the band boundary read cells that are never solved
+    Array3d<float> tempSDF = inputSDF;
     Array3d<float> *tempPtr = &tempSDF;
     Array3d<float> *outputPtr = &outputSDF;
 
+    int numCPU = ThreadUtils::getMaxThreadCount();
+    int numthreads = (int)fmin(numCPU, rows.size());
+    std::vector<int> intervals = _splitRowsIntoIntervals(rows, numthreads);
+    std::vector<float> threadMaxDiffs(numthreads, 0.0f);
+
     float lastMaxDiff = -1.0f;
     for (int n = 0; n < numIterations; n++) {
-        int numCPU = ThreadUtils::getMaxThreadCount();
-        int numthreads = (int)fmin(numCPU, solverCells.size());
         std::vector<std::thread> threads(numthreads);
-        std::vector<int> intervals = ThreadUtils::splitRangeIntoIntervals(0, solverCells.size(), numthreads);
         for (int i = 0; i < numthreads; i++) {
-            threads[i] = std::thread(&LevelSetSolver::_stepSolverThreadUpwind, this,
-                                     intervals[i], intervals[i + 1], tempPtr, outputPtr, dx, dtau, &solverCells);
+            threads[i] = std::thread(&LevelSetSolver::_stepSolverThread, this,
+                                     intervals[i], intervals[i + 1], tempPtr, outputPtr, 
+                                     dx, dtau, method, &rows, &(threadMaxDiffs[i]));
         }
 
         for (int i = 0; i < numthreads; i++) {
             threads[i].join();
         }
 
-        float maxDiff = 0;
-        for (size_t cidx = 0; cidx < solverCells.size(); cidx++) {
-            GridIndex g = solverCells[cidx];
-            float diff = std::abs(tempPtr->get(g) - outputPtr->get(g));
-            maxDiff = std::max(diff, maxDiff);
+        float maxDiff = 0.0f;
+        for (size_t i = 0; i < threadMaxDiffs.size(); i++) {
+            maxDiff = std::max(threadMaxDiffs[i], maxDiff);
         }
 
         std::swap(tempPtr, outputPtr);
 
-        if (std::abs(maxDiff - lastMaxDiff) < _upwindErrorThreshold * dx) {
+        if (maxDiff < _convergenceThreshold * dtau) {
+            break;
+        }
+
+        if (method == SolverMethod::upwind && 
+                std::abs(maxDiff - lastMaxDiff) < _upwindErrorThreshold * dx) {
             break;
         }
         lastMaxDiff = maxDiff;
     }
 
-    float *rawarraysrc = outputPtr->getRawArray();
-    float *rawarraydst = outputSDF.getRawArray();
-    int n = outputSDF.getNumElements();
-    for (int i = 0; i < n; i++) {
-        rawarraydst[i] = rawarraysrc[i];
+    if (outputPtr != &outputSDF) {
+        for (size_t ridx = 0; ridx < rows.size(); ridx++) {
+            SolverRow r = rows[ridx];
+            float *src = outputPtr->getPointer(r.i, r.j, r.k);
+            float *dst = outputSDF.getPointer(r.i, r.j, r.k);
+            std::copy(src, src + r.length, dst);
+        }
+    }
+}
+
+void LevelSetSolver::_initializeSolverRows(std::vector<GridIndex> &solverCells, 
+                                           int isize, int jsize, int ksize,
+                                           std::vector<SolverRow> &rows) {
+    std::vector<size_t> flatIndices;
+    flatIndices.reserve(solverCells.size());
+    for (size_t i = 0; i < solverCells.size(); i++) {
+        GridIndex g = solverCells[i];
+        if (g.i < 0 || g.j < 0 || g.k < 0 || g.i >= isize || g.j >= jsize || g.k >= ksize) {
+            continue;
+        }
+        flatIndices.push_back((size_t)g.i + (size_t)isize * ((size_t)g.j + (size_t)jsize * (size_t)g.k));
+    }
+
+    std::sort(flatIndices.begin(), flatIndices.end());
+    flatIndices.erase(std::unique(flatIndices.begin(), flatIndices.end()), flatIndices.end());
+
+    size_t idx = 0;
+    while (idx < flatIndices.size()) {
+        size_t first = flatIndices[idx];
+        size_t rowid = first / isize;
+        size_t last = first;
+        idx++;
+        while (idx < flatIndices.size() && flatIndices[idx] == last + 1 && 
+                flatIndices[idx] / isize == rowid) {
+            last = flatIndices[idx];
+            idx++;
+        }
+
+        SolverRow r;
+        r.i = (int)(first % isize);
+        r.j = (int)(rowid % jsize);
+        r.k = (int)(rowid / jsize);
+        r.length = (int)(last - first + 1);
+        rows.push_back(r);
     }
 }
 
-float LevelSetSolver::_getPseudoTimeStep(Array3d<float> &sdf, float dx) {
-    int isize = sdf.width;
-    int jsize = sdf.height;
-    int ksize = sdf.depth;
+std::vector<int> LevelSetSolver::_splitRowsIntoIntervals(std::vector<SolverRow> &rows, 
+                                                         int numIntervals) {
+    size_t numCells = 0;
+    for (size_t i = 0; i < rows.size(); i++) {
+        numCells += rows[i].length;
+    }
+
+    std::vector<int> intervals;
+    intervals.reserve(numIntervals + 1);
+    intervals.push_back(0);
+
+    size_t cellCount = 0;
+    int ridx = 0;
+    for (int n = 1; n < numIntervals; n++) {
+        size_t target = (numCells * n) / numIntervals;
+        while ((size_t)ridx < rows.size() && cellCount < target) {
+            cellCount += rows[ridx].length;
+            ridx++;
+        }
+        intervals.push_back(ridx);
+    }
+    intervals.push_back((int)rows.size());
 
+    return intervals;
+}
+
+float LevelSetSolver::_getPseudoTimeStep(Array3d<float> &sdf, 
+                                         std::vector<SolverRow> &rows, 
+                                         float dx) {
     float maxS = -std::numeric_limits<float>::max();
     float dtau = _maxCFL * dx;
 
-    for (int k = 0; k < ksize; k++) {
-        for (int j = 0; j < jsize; j++) {
-            for (int i = 0; i < isize; i++) {
-                float s = _sign(sdf, dx, i, j, k);
-                maxS = std::max(s, maxS);
-            }
+    for (size_t ridx = 0; ridx < rows.size(); ridx++) {
+        SolverRow r = rows[ridx];
+        for (int i = r.i; i < r.i + r.length; i++) {
+            float s = _sign(sdf, dx, i, r.j, r.k);
+            maxS = std::max(s, maxS);
         }
     }
 
@@ -170,38 +251,111 @@ int LevelSetSolver::_getNumberOfIterations(float maxDistance, float dtau) {
     return static_cast<int>(std::ceil(maxDistance / dtau));
 }
 
-void LevelSetSolver::_stepSolverThreadEno(int startidx, int endidx, 
+void LevelSetSolver::_stepSolverThread(int startidx, int endidx, 
                                        Array3d<float> *tempPtr,
                                        Array3d<float> *outputPtr, 
                                        float dx,
                                        float dtau,
-                                       std::vector<GridIndex> *solverCells) {
+                                       SolverMethod method,
+                                       std::vector<SolverRow> *rows,
+                                       float *maxDiff) {
+
+    int isize = outputPtr->width;
+    int jsize = outputPtr->height;
+    int ksize = outputPtr->depth;
+    int jstride = isize;
+    int kstride = isize * jsize;
+    int pad = method == SolverMethod::eno ? 3 : 1;
+
+    float localMaxDiff = 0.0f;
+    for (int ridx = startidx; ridx < endidx; ridx++) {
+        SolverRow r = rows->at(ridx);
+        int rowStart = r.i;
+        int rowEnd = r.i + r.length;
+
+        // Cells whose full stencil lies inside of the grid are processed 
+        // as a contiguous run by the vectorized kernels. Remaining cells
+        // use the clamped per-cell path.
+        int interiorStart = rowEnd;
+        int interiorEnd = rowEnd;
+        bool isInteriorRow = r.j >= pad && r.j < jsize - pad && 
+                             r.k >= pad && r.k < ksize - pad;
+        if (isInteriorRow) {
+            interiorStart = std::min(std::max(rowStart, pad), rowEnd);
+            interiorEnd = std::max(std::min(rowEnd, isize - pad), interiorStart);
+        }
+
+        for (int i = rowStart; i < interiorStart; i++) {
+            float val = _stepSolverCell(outputPtr, i, r.j, r.k, dx, dtau, method);
+            localMaxDiff = std::max(std::abs(val - outputPtr->get(i, r.j, r.k)), localMaxDiff);
+            tempPtr->set(i, r.j, r.k, val);
+        }
 
+        if (interiorEnd > interiorStart) {
+            float *phi = outputPtr->getPointer(interiorStart, r.j, r.k);
+            float *result = tempPtr->getPointer(interiorStart, r.j, r.k);
+            int n = interiorEnd - interiorStart;
+            float diff = 0.0f;
+            if (method == SolverMethod::eno) {
+                diff = _stepSolverRowEno(phi, result, n, jstride, kstride, dx, dtau);
+            } else {
+                diff = _stepSolverRowUpwind(phi, result, n, jstride, kstride, dx, dtau);
+            }
+            localMaxDiff = std::max(diff, localMaxDiff);
+        }
+
+        for (int i = interiorEnd; i < rowEnd; i++) {
+            float val = _stepSolverCell(outputPtr, i, r.j, r.k, dx, dtau, method);
+            localMaxDiff = std::max(std::abs(val - outputPtr->get(i, r.j, r.k)), localMaxDiff);
+            tempPtr->set(i, r.j, r.k, val);
+        }
+    }
+
+    *maxDiff = localMaxDiff;
+}
+
+float LevelSetSolver::_stepSolverCell(Array3d<float> *outputPtr, 
+                                      int i, int j, int k, 
+                                      float dx, 
+                                      float dtau, 
+                                      SolverMethod method) {
     std::array<float, 2> derx, dery, derz;
-    for (int idx = startidx; idx < endidx; idx++) {
-        GridIndex g = solverCells->at(idx);
-
-        float s = _sign(*outputPtr, dx, g.i, g.j, g.k);
-        _getDerivativesEno(outputPtr, g.i, g.j, g.k, dx, &derx, &dery, &derz);
-
-        float val = outputPtr->get(g)
-            - dtau * std::max(s, 0.0f)
-                * (std::sqrt(_square(std::max(derx[0], 0.0f))
-                           + _square(std::min(derx[1], 0.0f))
-                           + _square(std::max(dery[0], 0.0f))
-                           + _square(std::min(dery[1], 0.0f))
-                           + _square(std::max(derz[0], 0.0f))
-                           + _square(std::min(derz[1], 0.0f))) - 1.0f)
-            - dtau * std::min(s, 0.0f)
-                * (std::sqrt(_square(std::min(derx[0], 0.0f))
-                           + _square(std::max(derx[1], 0.0f))
-                           + _square(std::min(dery[0], 0.0f))
-                           + _square(std::max(dery[1], 0.0f))
-                           + _square(std::min(derz[0], 0.0f))
-                           + _square(std::max(derz[1], 0.0f))) - 1.0f);
-
-        tempPtr->set(g, val);
+    if (method == SolverMethod::eno) {
+        _getDerivativesEno(outputPtr, i, j, k, dx, &derx, &dery, &derz);
+    } else {
+        _getDerivativesUpwind(outputPtr, i, j, k, dx, &derx, &dery, &derz);
+    }
+
+    float s = _sign(*outputPtr, dx, i, j, k);
+    return _godunovUpdate(outputPtr->get(i, j, k), s, dtau, 
+                          derx[0], derx[1], dery[0], dery[1], derz[0], derz[1]);
+}
+
+float LevelSetSolver::_stepSolverRowEno(float *phi, float *result, int n, 
+                                        int jstride, int kstride, 
+                                        float dx, float dtau) {
+    float invdx = 1.0f / dx;
+    float dx2 = dx * dx;
+    int j1 = jstride, j2 = 2 * jstride, j3 = 3 * jstride;
+    int k1 = kstride, k2 = 2 * kstride, k3 = 3 * kstride;
+
+    float maxDiff = 0.0f;
+    #pragma omp simd reduction(max:maxDiff)
+    for (int idx = 0; idx < n; idx++) {
+        const float *p = phi + idx;
+        float dxm, dxp, dym, dyp, dzm, dzp;
+        _eno3Inline(p[-3], p[-2], p[-1], p[0], p[1], p[2], p[3], invdx, dx, &dxm, &dxp);
+        _eno3Inline(p[-j3], p[-j2], p[-j1], p[0], p[j1], p[j2], p[j3], invdx, dx, &dym, &dyp);
+        _eno3Inline(p[-k3], p[-k2], p[-k1], p[0], p[k1], p[k2], p[k3], invdx, dx, &dzm, &dzp);
+
+        float d = p[0];
+        float s = d / std::sqrt(d * d + dx2);
+        float val = _godunovUpdate(d, s, dtau, dxm, dxp, dym, dyp, dzm, dzp);
+        result[idx] = val;
+        maxDiff = std::max(std::abs(val - d), maxDiff);
     }
+
+    return maxDiff;
 }
 
 void LevelSetSolver::_getDerivativesEno(Array3d<float> *grid,
@@ -314,38 +468,31 @@ std::array<float, 2> LevelSetSolver::_eno3(float *D0, float dx) {
     return dfx;
 }
 
-void LevelSetSolver::_stepSolverThreadUpwind(int startidx, int endidx, 
-                                       Array3d<float> *tempPtr,
-                                       Array3d<float> *outputPtr, 
-                                       float dx,
-                                       float dtau,
-                                       std::vector<GridIndex> *solverCells) {
-
-    std::array<float, 2> derx, dery, derz;
-    for (int idx = startidx; idx < endidx; idx++) {
-        GridIndex g = solverCells->at(idx);
-
-        float s = _sign(*outputPtr, dx, g.i, g.j, g.k);
-        _getDerivativesUpwind(outputPtr, g.i, g.j, g.k, dx, &derx, &dery, &derz);
-
-        float val = outputPtr->get(g)
-            - dtau * std::max(s, 0.0f)
-                * (std::sqrt(_square(std::max(derx[0], 0.0f))
-                           + _square(std::min(derx[1], 0.0f))
-                           + _square(std::max(dery[0], 0.0f))
-                           + _square(std::min(dery[1], 0.0f))
-                           + _square(std::max(derz[0], 0.0f))
-                           + _square(std::min(derz[1], 0.0f))) - 1.0f)
-            - dtau * std::min(s, 0.0f)
-                * (std::sqrt(_square(std::min(derx[0], 0.0f))
-                           + _square(std::max(derx[1], 0.0f))
-                           + _square(std::min(dery[0], 0.0f))
-                           + _square(std::max(dery[1], 0.0f))
-                           + _square(std::min(derz[0], 0.0f))
-                           + _square(std::max(derz[1], 0.0f))) - 1.0f);
-
-        tempPtr->set(g, val);
+float LevelSetSolver::_stepSolverRowUpwind(float *phi, float *result, int n, 
+                                           int jstride, int kstride, 
+                                           float dx, float dtau) {
+    float invdx = 1.0f / dx;
+    float dx2 = dx * dx;
+
+    float maxDiff = 0.0f;
+    #pragma omp simd reduction(max:maxDiff)
+    for (int idx = 0; idx < n; idx++) {
+        const float *p = phi + idx;
+        float d = p[0];
+        float dxm = invdx * (d - p[-1]);
+        float dxp = invdx * (p[1] - d);
+        float dym = invdx * (d - p[-jstride]);
+        float dyp = invdx * (p[jstride] - d);
+        float dzm = invdx * (d - p[-kstride]);
+        float dzp = invdx * (p[kstride] - d);
+
+        float s = d / std::sqrt(d * d + dx2);
+        float val = _godunovUpdate(d, s, dtau, dxm, dxp, dym, dyp, dzm, dzp);
+        result[idx] = val;
+        maxDiff = std::max(std::abs(val - d), maxDiff);
     }
+
+    return maxDiff;
 }
 
 void LevelSetSolver::_getDerivativesUpwind(Array3d<float> *grid,
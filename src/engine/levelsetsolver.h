@@ -51,6 +51,9 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #pragma once
 
 #include <array>
+#include <vector>
+#include <cmath>
+#include <algorithm>
 
 #include "array3d.h"
 
@@ -72,21 +75,75 @@ public:
                       std::vector<GridIndex> &solverCells, 
                       Array3d<float> &outputSDF);
 
+    void reinitializeEno(Array3d<float16> &inputSDF, 
+                      float dx,
+                      float maxDistance,
+                      std::vector<GridIndex> &solverCells, 
+                      Array3d<float> &outputSDF);
+
+    void reinitializeUpwind(Array3d<float16> &inputSDF, 
+                      float dx,
+                      float maxDistance,
+                      std::vector<GridIndex> &solverCells, 
+                      Array3d<float> &outputSDF);
+
 private:
 
+    enum class SolverMethod : char { 
+        eno    = 0x00, 
+        upwind = 0x01
+    };
+
+    struct SolverRow {
+        int i = 0;
+        int j = 0;
+        int k = 0;
+        int length = 0;
+    };
+
     float _maxCFL = 0.25;
     float _upwindErrorThreshold = 0.01;
 
-    float _getPseudoTimeStep(Array3d<float> &sdf, float dx);
+    // Solver stops early once the largest per-iteration change within the
+    // band drops below this fraction of the pseudo time step, which bounds
+    // the remaining |grad(phi)| - 1 residual.
+    float _convergenceThreshold = 0.005;
+
+    void _reinitialize(Array3d<float> &inputSDF, 
+                       float dx,
+                       float maxDistance,
+                       std::vector<GridIndex> &solverCells,
+                       SolverMethod method,
+                       Array3d<float> &outputSDF);
+    void _convertGrid(Array3d<float16> &input, Array3d<float> &output);
+    void _initializeSolverRows(std::vector<GridIndex> &solverCells, 
+                               int isize, int jsize, int ksize,
+                               std::vector<SolverRow> &rows);
+    std::vector<int> _splitRowsIntoIntervals(std::vector<SolverRow> &rows, int numIntervals);
+    float _getPseudoTimeStep(Array3d<float> &sdf, std::vector<SolverRow> &rows, float dx);
     float _sign(Array3d<float> &sdf, float dx, int i, int j, int k);
     int _getNumberOfIterations(float maxDistance, float dtau);
 
-    void _stepSolverThreadEno(int startidx, int endidx, 
+    void _stepSolverThread(int startidx, int endidx, 
                            Array3d<float> *tempPtr,
                            Array3d<float> *outputPtr, 
                            float dx,
                            float dtau,
-                           std::vector<GridIndex> *solverCells);
+                           SolverMethod method,
+                           std::vector<SolverRow> *rows,
+                           float *maxDiff);
+    float _stepSolverCell(Array3d<float> *outputPtr, 
+                          int i, int j, int k, 
+                          float dx, 
+                          float dtau, 
+                          SolverMethod method);
+    float _stepSolverRowEno(float *phi, float *result, int n, 
+                            int jstride, int kstride, 
+                            float dx, float dtau);
+    float _stepSolverRowUpwind(float *phi, float *result, int n, 
+                               int jstride, int kstride, 
+                               float dx, float dtau);
+
     void _getDerivativesEno(Array3d<float> *grid,
                         int i, int j, int k, float dx, 
                         std::array<float, 2> *derx,
@@ -94,12 +151,6 @@ private:
                         std::array<float, 2> *derz);
     std::array<float, 2> _eno3(float *D0, float dx);
 
-    void _stepSolverThreadUpwind(int startidx, int endidx, 
-                             Array3d<float> *tempPtr,
-                             Array3d<float> *outputPtr, 
-                             float dx,
-                             float dtau,
-                             std::vector<GridIndex> *solverCells);
     void _getDerivativesUpwind(Array3d<float> *grid,
                                int i, int j, int k, float dx, 
                                std::array<float, 2> *derx,
@@ -109,4 +160,68 @@ private:
 
 
     inline float _square(float s) { return s * s; }
+
+    inline float _absMin(float a, float b) { 
+        return std::fabs(a) < std::fabs(b) ? a : b; 
+    }
+
+    /*
+        Branch-free form of _eno3 so that the row kernels can be vectorized 
+        by the compiler. Produces the same one-sided derivatives as _eno3.
+    */
+    inline void _eno3Inline(float p0, float p1, float p2, float p3, 
+                            float p4, float p5, float p6, 
+                            float invdx, float dx, 
+                            float *dminus, float *dplus) {
+        float hinvdx = 0.5f * invdx;
+        float tinvdx = invdx / 3.0f;
+
+        float d10 = invdx * (p1 - p0);
+        float d11 = invdx * (p2 - p1);
+        float d12 = invdx * (p3 - p2);
+        float d13 = invdx * (p4 - p3);
+        float d14 = invdx * (p5 - p4);
+        float d15 = invdx * (p6 - p5);
+
+        float d20 = hinvdx * (d11 - d10);
+        float d21 = hinvdx * (d12 - d11);
+        float d22 = hinvdx * (d13 - d12);
+        float d23 = hinvdx * (d14 - d13);
+        float d24 = hinvdx * (d15 - d14);
+
+        float d30 = tinvdx * (d21 - d20);
+        float d31 = tinvdx * (d22 - d21);
+        float d32 = tinvdx * (d23 - d22);
+        float d33 = tinvdx * (d24 - d23);
+
+        bool isLeft0 = std::fabs(d21) < std::fabs(d22);
+        float c0 = isLeft0 ? d21 : d22;
+        float cstar0 = isLeft0 ? 2.0f * _absMin(d30, d31) : -_absMin(d31, d32);
+        *dminus = d12 + c0 * dx + cstar0 * dx * dx;
+
+        bool isLeft1 = std::fabs(d22) < std::fabs(d23);
+        float c1 = isLeft1 ? d22 : d23;
+        float cstar1 = isLeft1 ? -_absMin(d31, d32) : 2.0f * _absMin(d32, d33);
+        *dplus = d13 - c1 * dx + cstar1 * dx * dx;
+    }
+
+    inline float _godunovUpdate(float phi, float s, float dtau,
+                                float dxm, float dxp, 
+                                float dym, float dyp, 
+                                float dzm, float dzp) {
+        float gradPos = std::sqrt(_square(std::max(dxm, 0.0f))
+                                + _square(std::min(dxp, 0.0f))
+                                + _square(std::max(dym, 0.0f))
+                                + _square(std::min(dyp, 0.0f))
+                                + _square(std::max(dzm, 0.0f))
+                                + _square(std::min(dzp, 0.0f)));
+        float gradNeg = std::sqrt(_square(std::min(dxm, 0.0f))
+                                + _square(std::max(dxp, 0.0f))
+                                + _square(std::min(dym, 0.0f))
+                                + _square(std::max(dyp, 0.0f))
+                                + _square(std::min(dzm, 0.0f))
+                                + _square(std::max(dzp, 0.0f)));
+        return phi - dtau * std::max(s, 0.0f) * (gradPos - 1.0f)
+                   - dtau * std::min(s, 0.0f) * (gradNeg - 1.0f);
+    }
 };
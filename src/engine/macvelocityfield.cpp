@@ -534,18 +534,7 @@ double MACVelocityField::_interpolateLinearU(double x, double y, double z) {
     double iy = (y - gy)*inv_dx;
     double iz = (z - gz)*inv_dx;
 
-    double oor = (double)_outOfRangeVector.x;
-    double points[8] = {oor, oor, oor, oor, oor, oor, oor, oor};
-    if (_u.isIndexInRange(i,   j,   k))   { points[0] = _u(i,   j,   k); }
-    if (_u.isIndexInRange(i+1, j,   k))   { points[1] = _u(i+1, j,   k); }
-    if (_u.isIndexInRange(i,   j+1, k))   { points[2] = _u(i,   j+1, k); }
-    if (_u.isIndexInRange(i,   j,   k+1)) { points[3] = _u(i,   j,   k+1); }
-    if (_u.isIndexInRange(i+1, j,   k+1)) { points[4] = _u(i+1, j,   k+1); }
-    if (_u.isIndexInRange(i,   j+1, k+1)) { points[5] = _u(i,   j+1, k+1); }
-    if (_u.isIndexInRange(i+1, j+1, k))   { points[6] = _u(i+1, j+1, k); }
-    if (_u.isIndexInRange(i+1, j+1, k+1)) { points[7] = _u(i+1, j+1, k+1); }
-
-    return Interpolation::trilinearInterpolate(points, ix, iy, iz);
+    return _interpolateLinear(_u, i, j, k, ix, iy, iz, _outOfRangeVector.x);
 }
 
 double MACVelocityField::_interpolateLinearV(double x, double y, double z) {
@@ -566,18 +555,7 @@ double MACVelocityField::_interpolateLinearV(double x, double y, double z) {
     double iy = (y - gy)*inv_dx;
     double iz = (z - gz)*inv_dx;
 
-    double oor = (double)_outOfRangeVector.y;
-    double points[8] = {oor, oor, oor, oor, oor, oor, oor, oor};
-    if (_v.isIndexInRange(i,   j,   k))   { points[0] = _v(i,   j,   k); }
-    if (_v.isIndexInRange(i+1, j,   k))   { points[1] = _v(i+1, j,   k); }
-    if (_v.isIndexInRange(i,   j+1, k))   { points[2] = _v(i,   j+1, k); }
-    if (_v.isIndexInRange(i,   j,   k+1)) { points[3] = _v(i,   j,   k+1); }
-    if (_v.isIndexInRange(i+1, j,   k+1)) { points[4] = _v(i+1, j,   k+1); }
-    if (_v.isIndexInRange(i,   j+1, k+1)) { points[5] = _v(i,   j+1, k+1); }
-    if (_v.isIndexInRange(i+1, j+1, k))   { points[6] = _v(i+1, j+1, k); }
-    if (_v.isIndexInRange(i+1, j+1, k+1)) { points[7] = _v(i+1, j+1, k+1); }
-
-    return Interpolation::trilinearInterpolate(points, ix, iy, iz);
+    return _interpolateLinear(_v, i, j, k, ix, iy, iz, _outOfRangeVector.y);
 }
 
 double MACVelocityField::_interpolateLinearW(double x, double y, double z) {
@@ -598,16 +576,20 @@ double MACVelocityField::_interpolateLinearW(double x, double y, double z) {
     double iy = (y - gy)*inv_dx;
     double iz = (z - gz)*inv_dx;
 
-    double oor = (double)_outOfRangeVector.z;
+    return _interpolateLinear(_w, i, j, k, ix, iy, iz, _outOfRangeVector.z);
+}
+
+double MACVelocityField::_interpolateLinear(Array3d<float> &grid, int i, int j, int k, 
+                                            double ix, double iy, double iz, double oor) {
     double points[8] = {oor, oor, oor, oor, oor, oor, oor, oor};
-    if (_w.isIndexInRange(i,   j,   k))   { points[0] = _w(i,   j,   k); }
-    if (_w.isIndexInRange(i+1, j,   k))   { points[1] = _w(i+1, j,   k); }
-    if (_w.isIndexInRange(i,   j+1, k))   { points[2] = _w(i,   j+1, k); }
-    if (_w.isIndexInRange(i,   j,   k+1)) { points[3] = _w(i,   j,   k+1); }
-    if (_w.isIndexInRange(i+1, j,   k+1)) { points[4] = _w(i+1, j,   k+1); }
-    if (_w.isIndexInRange(i,   j+1, k+1)) { points[5] = _w(i,   j+1, k+1); }
-    if (_w.isIndexInRange(i+1, j+1, k))   { points[6] = _w(i+1, j+1, k); }
-    if (_w.isIndexInRange(i+1, j+1, k+1)) { points[7] = _w(i+1, j+1, k+1); }
+    if (grid.isIndexInRange(i,   j,   k))   { points[0] = grid(i,   j,   k); }
+    if (grid.isIndexInRange(i+1, j,   k))   { points[1] = grid(i+1, j,   k); }
+    if (grid.isIndexInRange(i,   j+1, k))   { points[2] = grid(i,   j+1, k); }
+    if (grid.isIndexInRange(i,   j,   k+1)) { points[3] = grid(i,   j,   k+1); }
+    if (grid.isIndexInRange(i+1, j,   k+1)) { points[4] = grid(i+1, j,   k+1); }
+    if (grid.isIndexInRange(i,   j+1, k+1)) { points[5] = grid(i,   j+1, k+1); }
+    if (grid.isIndexInRange(i+1, j+1, k))   { points[6] = grid(i+1, j+1, k); }
+    if (grid.isIndexInRange(i+1, j+1, k+1)) { points[7] = grid(i+1, j+1, k+1); }
 
     return Interpolation::trilinearInterpolate(points, ix, iy, iz);
 }
@@ -633,13 +615,53 @@ vmath::vec3 MACVelocityField::evaluateVelocityAtPositionLinear(vmath::vec3 pos)
 }
 
 vmath::vec3 MACVelocityField::evaluateVelocityAtPositionLinear(double x, double y, double z) {
-    if (!Grid3d::isPositionInGrid(x, y, z, _dx, _isize, _jsize, _ksize)) {
+    LinearStencil s = getLinearStencil(x, y, z);
+    return evaluateVelocityAtPositionLinear(s);
+}
+
+MACVelocityField::LinearStencil MACVelocityField::getLinearStencil(vmath::vec3 pos) {
+    return getLinearStencil(pos.x, pos.y, pos.z);
+}
+
+MACVelocityField::LinearStencil MACVelocityField::getLinearStencil(double x, double y, double z) {
+    LinearStencil s;
+    s.isInGrid = Grid3d::isPositionInGrid(x, y, z, _dx, _isize, _jsize, _ksize);
+    if (!s.isInGrid) {
+        return s;
+    }
+
+    double inv_dx = 1 / _dx;
+    double gx, gy, gz;
+    Grid3d::positionToGridIndex(x, y, z, _dx, &(s.node.i), &(s.node.j), &(s.node.k));
+    Grid3d::GridIndexToPosition(s.node, _dx, &gx, &gy, &gz);
+    s.nx = (x - gx)*inv_dx;
+    s.ny = (y - gy)*inv_dx;
+    s.nz = (z - gz)*inv_dx;
+
+    double hdx = 0.5*_dx;
+    x -= hdx;
+    y -= hdx;
+    z -= hdx;
+    Grid3d::positionToGridIndex(x, y, z, _dx, &(s.center.i), &(s.center.j), &(s.center.k));
+    Grid3d::GridIndexToPosition(s.center, _dx, &gx, &gy, &gz);
+    s.cx = (x - gx)*inv_dx;
+    s.cy = (y - gy)*inv_dx;
+    s.cz = (z - gz)*inv_dx;
+
+    return s;
+}
+
+vmath::vec3 MACVelocityField::evaluateVelocityAtPositionLinear(LinearStencil &s) {
+    if (!s.isInGrid) {
         return vmath::vec3();
     }
 
-    double xvel = _interpolateLinearU(x, y, z);
-    double yvel = _interpolateLinearV(x, y, z);
-    double zvel = _interpolateLinearW(x, y, z);
+    double xvel = _interpolateLinear(_u, s.node.i, s.center.j, s.center.k, 
+                                     s.nx, s.cy, s.cz, _outOfRangeVector.x);
+    double yvel = _interpolateLinear(_v, s.center.i, s.node.j, s.center.k, 
+                                     s.cx, s.ny, s.cz, _outOfRangeVector.y);
+    double zvel = _interpolateLinear(_w, s.center.i, s.center.j, s.node.k, 
+                                     s.cx, s.cy, s.nz, _outOfRangeVector.z);
 
     return vmath::vec3(xvel, yvel, zvel);
 }
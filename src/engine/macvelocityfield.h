@@ -134,6 +134,25 @@ public:
     float evaluateVelocityAtPositionLinearW(double x, double y, double z);
     vmath::vec3 evaluateVelocityAtPositionLinear(vmath::vec3 pos);
 
+    // Grid indices and local coordinates of a linear velocity evaluation.
+    // The velocity components share the node and cell center coordinates 
+    // of each axis.
+    struct LinearStencil {
+        bool isInGrid = false;
+        GridIndex node;
+        GridIndex center;
+        double nx = 0.0;
+        double ny = 0.0;
+        double nz = 0.0;
+        double cx = 0.0;
+        double cy = 0.0;
+        double cz = 0.0;
+    };
+
+    LinearStencil getLinearStencil(double x, double y, double z);
+    LinearStencil getLinearStencil(vmath::vec3 pos);
+    vmath::vec3 evaluateVelocityAtPositionLinear(LinearStencil &s);
+
     vmath::vec3 velocityIndexToPositionU(int i, int j, int k);
     vmath::vec3 velocityIndexToPositionV(int i, int j, int k);
     vmath::vec3 velocityIndexToPositionW(int i, int j, int k);
@@ -157,6 +176,8 @@ private:
     double _interpolateLinearU(double x, double y, double z);
     double _interpolateLinearV(double x, double y, double z);
     double _interpolateLinearW(double x, double y, double z);
+    double _interpolateLinear(Array3d<float> &grid, int i, int j, int k, 
+                              double ix, double iy, double iz, double oor);
 
 
     int _isize = 10;
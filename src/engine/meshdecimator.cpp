@@ -0,0 +1,528 @@
+/*
+MIT License
+
+Copyright (C) 2026 Ryan L. Guy & Dennis Fassbaender
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "meshdecimator.h"
+
+#include <algorithm>
+#include <iterator>
+
+#include "threadutils.h"
+
+
+MeshDecimator::MeshDecimator() {
+}
+
+MeshDecimator::~MeshDecimator() {
+}
+
+void MeshDecimator::decimate(MeshDecimatorParameters params, TriangleMesh &mesh) {
+    _maxError = params.maxError;
+    _minNormalDot = params.minNormalDot;
+
+    if (mesh.triangles.empty() || _maxError <= 0.0) {
+        return;
+    }
+
+    _initializeVertexQuadrics(mesh);
+
+    // Chunk boundaries are shifted between passes so that regions locked
+    // along a boundary in one pass can be decimated in the next
+    for (int i = 0; i < _numPasses; i++) {
+        double slabOffset = (double)i / (double)_numPasses;
+        _decimatePass(mesh, slabOffset);
+    }
+
+    _vertexQuadrics.clear();
+    _vertexQuadrics.shrink_to_fit();
+
+    mesh.removeExtraneousVertices();
+}
+
+void MeshDecimator::_initializeVertexQuadrics(TriangleMesh &mesh) {
+    _vertexQuadrics = std::vector<Quadric>(mesh.vertices.size());
+    for (size_t i = 0; i < mesh.triangles.size(); i++) {
+        Triangle t = mesh.triangles[i];
+        vmath::vec3 p0 = mesh.vertices[t.tri[0]];
+        vmath::vec3 p1 = mesh.vertices[t.tri[1]];
+        vmath::vec3 p2 = mesh.vertices[t.tri[2]];
+        vmath::vec3 n = vmath::cross(p1 - p0, p2 - p0);
+        float len = vmath::length(n);
+        if (len > 0.0f) {
+            n /= len;
+            Quadric q(n.x, n.y, n.z, -vmath::dot(n, p0));
+            _vertexQuadrics[t.tri[0]].add(q);
+            _vertexQuadrics[t.tri[1]].add(q);
+            _vertexQuadrics[t.tri[2]].add(q);
+        }
+    }
+}
+
+void MeshDecimator::_decimatePass(TriangleMesh &mesh, double slabOffset) {
+    std::vector<DecimatorChunk> chunks;
+    _splitMeshIntoChunks(mesh, slabOffset, chunks);
+
+    int numCPU = ThreadUtils::getMaxThreadCount();
+    int numthreads = (int)fmin(numCPU, chunks.size());
+    std::vector<std::thread> threads(numthreads);
+    std::vector<int> intervals = ThreadUtils::splitRangeIntoIntervals(0, chunks.size(), numthreads);
+    for (int i = 0; i < numthreads; i++) {
+        threads[i] = std::thread(&MeshDecimator::_decimateChunksThread, this,
+                                 intervals[i], intervals[i + 1], &chunks);
+    }
+
+    for (int i = 0; i < numthreads; i++) {
+        threads[i].join();
+    }
+
+    _mergeChunks(chunks, mesh);
+}
+
+void MeshDecimator::_splitMeshIntoChunks(TriangleMesh &mesh, double slabOffset, 
+                                         std::vector<DecimatorChunk> &chunks) {
+
+    vmath::vec3 vmin = mesh.vertices[0];
+    vmath::vec3 vmax = mesh.vertices[0];
+    for (size_t i = 0; i < mesh.vertices.size(); i++) {
+        vmath::vec3 v = mesh.vertices[i];
+        vmin = vmath::vec3(fmin(vmin.x, v.x), fmin(vmin.y, v.y), fmin(vmin.z, v.z));
+        vmax = vmath::vec3(fmax(vmax.x, v.x), fmax(vmax.y, v.y), fmax(vmax.z, v.z));
+    }
+
+    int axis = 0;
+    vmath::vec3 extents = vmax - vmin;
+    if (extents.y > extents[axis]) {
+        axis = 1;
+    }
+    if (extents.z > extents[axis]) {
+        axis = 2;
+    }
+
+    // Triangles are sorted into slabs along the longest axis by centroid
+    int numslabs = std::max(ThreadUtils::getMaxThreadCount() * _chunksPerThread, 1);
+    double slabwidth = extents[axis] / (double)numslabs;
+    if (slabwidth <= 0.0) {
+        numslabs = 1;
+        slabwidth = 1.0;
+    }
+    numslabs++;
+
+    std::vector<int> triangleSlabs(mesh.triangles.size());
+    std::vector<int> slabCounts(numslabs, 0);
+    for (size_t i = 0; i < mesh.triangles.size(); i++) {
+        vmath::vec3 c = mesh.getTriangleCenter(i);
+        int slab = (int)floor((c[axis] - vmin[axis]) / slabwidth + slabOffset);
+        slab = std::max(std::min(slab, numslabs - 1), 0);
+        triangleSlabs[i] = slab;
+        slabCounts[slab]++;
+    }
+
+    // Vertices used by triangles of more than one slab are locked
+    std::vector<int> vertexSlabs(mesh.vertices.size(), -1);
+    std::vector<bool> isSharedVertex(mesh.vertices.size(), false);
+    for (size_t i = 0; i < mesh.triangles.size(); i++) {
+        Triangle t = mesh.triangles[i];
+        for (int j = 0; j < 3; j++) {
+            int v = t.tri[j];
+            if (vertexSlabs[v] == -1) {
+                vertexSlabs[v] = triangleSlabs[i];
+            } else if (vertexSlabs[v] != triangleSlabs[i]) {
+                isSharedVertex[v] = true;
+            }
+        }
+    }
+
+    std::vector<std::vector<int> > slabTriangles(numslabs);
+    for (int i = 0; i < numslabs; i++) {
+        slabTriangles[i].reserve(slabCounts[i]);
+    }
+    for (size_t i = 0; i < mesh.triangles.size(); i++) {
+        slabTriangles[triangleSlabs[i]].push_back(i);
+    }
+
+    std::vector<int> localVertexIndices(mesh.vertices.size(), -1);
+    for (int sidx = 0; sidx < numslabs; sidx++) {
+        if (slabTriangles[sidx].empty()) {
+            continue;
+        }
+
+        DecimatorChunk chunk;
+        chunk.mesh.triangles.reserve(slabTriangles[sidx].size());
+        for (size_t i = 0; i < slabTriangles[sidx].size(); i++) {
+            Triangle t = mesh.triangles[slabTriangles[sidx][i]];
+            for (int j = 0; j < 3; j++) {
+                int v = t.tri[j];
+                if (localVertexIndices[v] == -1) {
+                    localVertexIndices[v] = (int)chunk.globalVertexIndices.size();
+                    chunk.globalVertexIndices.push_back(v);
+                    chunk.mesh.vertices.push_back(mesh.vertices[v]);
+                    chunk.isLockedVertex.push_back(isSharedVertex[v]);
+                    chunk.quadrics.push_back(_vertexQuadrics[v]);
+                }
+                t.tri[j] = localVertexIndices[v];
+            }
+            chunk.mesh.triangles.push_back(t);
+        }
+
+        for (size_t i = 0; i < chunk.globalVertexIndices.size(); i++) {
+            localVertexIndices[chunk.globalVertexIndices[i]] = -1;
+        }
+
+        chunks.push_back(chunk);
+    }
+}
+
+void MeshDecimator::_mergeChunks(std::vector<DecimatorChunk> &chunks, TriangleMesh &mesh) {
+    size_t numTriangles = 0;
+    for (size_t i = 0; i < chunks.size(); i++) {
+        numTriangles += chunks[i].mesh.triangles.size();
+    }
+
+    std::vector<Triangle> triangles;
+    triangles.reserve(numTriangles);
+    for (size_t cidx = 0; cidx < chunks.size(); cidx++) {
+        DecimatorChunk *c = &(chunks[cidx]);
+        for (size_t i = 0; i < c->mesh.vertices.size(); i++) {
+            mesh.vertices[c->globalVertexIndices[i]] = c->mesh.vertices[i];
+            _vertexQuadrics[c->globalVertexIndices[i]] = c->quadrics[i];
+        }
+
+        for (size_t i = 0; i < c->mesh.triangles.size(); i++) {
+            Triangle t = c->mesh.triangles[i];
+            t.tri[0] = c->globalVertexIndices[t.tri[0]];
+            t.tri[1] = c->globalVertexIndices[t.tri[1]];
+            t.tri[2] = c->globalVertexIndices[t.tri[2]];
+            triangles.push_back(t);
+        }
+    }
+
+    mesh.triangles = triangles;
+}
+
+void MeshDecimator::_decimateChunksThread(int startidx, int endidx, 
+                                          std::vector<DecimatorChunk> *chunks) {
+    for (int i = startidx; i < endidx; i++) {
+        _decimateChunk(chunks->at(i));
+    }
+}
+
+void MeshDecimator::_decimateChunk(DecimatorChunk &chunk) {
+    ChunkDecimationData data;
+    _initializeChunkDecimationData(chunk, data);
+
+    for (int iter = 0; iter < _maxChunkIterations; iter++) {
+        // A vertex takes part in at most one collapse per iteration so that
+        // the cheapest collapses in a region are not starved by chained ones
+        std::fill(data.isVertexDirty.begin(), data.isVertexDirty.end(), false);
+
+        int numCollapsed = 0;
+        for (size_t tidx = 0; tidx < chunk.mesh.triangles.size(); tidx++) {
+            if (data.isTriangleDeleted[tidx]) {
+                continue;
+            }
+
+            Triangle t = chunk.mesh.triangles[tidx];
+            if (data.isVertexDirty[t.tri[0]] || 
+                    data.isVertexDirty[t.tri[1]] || 
+                    data.isVertexDirty[t.tri[2]]) {
+                continue;
+            }
+
+            for (int j = 0; j < 3; j++) {
+                int v0 = t.tri[j];
+                int v1 = t.tri[(j + 1) % 3];
+                if (data.isVertexFixed[v0] || data.isVertexFixed[v1]) {
+                    continue;
+                }
+
+                if (_collapseEdge(v0, v1, chunk, data)) {
+                    numCollapsed++;
+                    break;
+                }
+            }
+        }
+
+        if (numCollapsed == 0) {
+            break;
+        }
+    }
+
+    std::vector<Triangle> triangles;
+    for (size_t i = 0; i < chunk.mesh.triangles.size(); i++) {
+        if (!data.isTriangleDeleted[i]) {
+            triangles.push_back(chunk.mesh.triangles[i]);
+        }
+    }
+    chunk.mesh.triangles = triangles;
+}
+
+void MeshDecimator::_initializeChunkDecimationData(DecimatorChunk &chunk, 
+                                                   ChunkDecimationData &data) {
+    size_t nv = chunk.mesh.vertices.size();
+    size_t nt = chunk.mesh.triangles.size();
+    data.vertexTriangles = std::vector<std::vector<int> >(nv);
+    data.isTriangleDeleted = std::vector<bool>(nt, false);
+    data.isVertexFixed = chunk.isLockedVertex;
+    data.isVertexDirty = std::vector<bool>(nv, false);
+
+    for (size_t i = 0; i < nt; i++) {
+        Triangle t = chunk.mesh.triangles[i];
+        data.vertexTriangles[t.tri[0]].push_back(i);
+        data.vertexTriangles[t.tri[1]].push_back(i);
+        data.vertexTriangles[t.tri[2]].push_back(i);
+    }
+
+    // Vertices on open boundaries or non-manifold edges are never moved.
+    // Every other edge around a vertex is shared by exactly two triangles.
+    std::vector<int> edgeVertices;
+    for (size_t v = 0; v < nv; v++) {
+        edgeVertices.clear();
+        for (size_t i = 0; i < data.vertexTriangles[v].size(); i++) {
+            Triangle t = chunk.mesh.triangles[data.vertexTriangles[v][i]];
+            for (int j = 0; j < 3; j++) {
+                if (t.tri[j] != (int)v) {
+                    edgeVertices.push_back(t.tri[j]);
+                }
+            }
+        }
+        std::sort(edgeVertices.begin(), edgeVertices.end());
+
+        size_t i = 0;
+        while (i < edgeVertices.size()) {
+            size_t j = i;
+            while (j < edgeVertices.size() && edgeVertices[j] == edgeVertices[i]) {
+                j++;
+            }
+            if (j - i != 2) {
+                data.isVertexFixed[v] = true;
+                break;
+            }
+            i = j;
+        }
+    }
+}
+
+bool MeshDecimator::_collapseEdge(int v0, int v1, 
+                                  DecimatorChunk &chunk, 
+                                  ChunkDecimationData &data) {
+    Quadric q = chunk.quadrics[v0];
+    q.add(chunk.quadrics[v1]);
+
+    vmath::vec3 p0 = chunk.mesh.vertices[v0];
+    vmath::vec3 p1 = chunk.mesh.vertices[v1];
+    vmath::vec3 pmid = 0.5f * (p0 + p1);
+    double err0 = q.evaluate(p0);
+    double err1 = q.evaluate(p1);
+    double errmid = q.evaluate(pmid);
+
+    vmath::vec3 p = pmid;
+    double err = errmid;
+    if (err0 < err) {
+        p = p0;
+        err = err0;
+    }
+    if (err1 < err) {
+        p = p1;
+        err = err1;
+    }
+
+    if (err > _maxError * _maxError) {
+        return false;
+    }
+
+    if (!_isCollapseManifold(v0, v1, chunk, data)) {
+        return false;
+    }
+
+    if (_isThinSheetEdge(v0, v1, chunk, data)) {
+        return false;
+    }
+
+    if (_isCollapseFlippingTriangles(v0, v1, p, chunk, data) || 
+            _isCollapseFlippingTriangles(v1, v0, p, chunk, data)) {
+        return false;
+    }
+
+    chunk.mesh.vertices[v0] = p;
+    chunk.quadrics[v0] = q;
+
+    std::vector<int> *vt0 = &(data.vertexTriangles[v0]);
+    std::vector<int> *vt1 = &(data.vertexTriangles[v1]);
+    for (size_t i = 0; i < vt1->size(); i++) {
+        int tidx = vt1->at(i);
+        if (data.isTriangleDeleted[tidx]) {
+            continue;
+        }
+
+        Triangle *t = &(chunk.mesh.triangles[tidx]);
+        if (t->tri[0] == v0 || t->tri[1] == v0 || t->tri[2] == v0) {
+            data.isTriangleDeleted[tidx] = true;
+            continue;
+        }
+
+        for (int j = 0; j < 3; j++) {
+            if (t->tri[j] == v1) {
+                t->tri[j] = v0;
+            }
+        }
+        vt0->push_back(tidx);
+    }
+    vt1->clear();
+
+    size_t count = 0;
+    for (size_t i = 0; i < vt0->size(); i++) {
+        int tidx = vt0->at(i);
+        if (!data.isTriangleDeleted[tidx]) {
+            (*vt0)[count] = tidx;
+            count++;
+        }
+    }
+    vt0->resize(count);
+
+    data.isVertexDirty[v0] = true;
+    data.isVertexDirty[v1] = true;
+
+    return true;
+}
+
+bool MeshDecimator::_isCollapseFlippingTriangles(int v, int vother, vmath::vec3 p, 
+                                                 DecimatorChunk &chunk, 
+                                                 ChunkDecimationData &data) {
+    std::vector<int> *vt = &(data.vertexTriangles[v]);
+    for (size_t i = 0; i < vt->size(); i++) {
+        int tidx = vt->at(i);
+        if (data.isTriangleDeleted[tidx]) {
+            continue;
+        }
+
+        Triangle t = chunk.mesh.triangles[tidx];
+        if (t.tri[0] == vother || t.tri[1] == vother || t.tri[2] == vother) {
+            continue;
+        }
+
+        vmath::vec3 p0 = chunk.mesh.vertices[t.tri[0]];
+        vmath::vec3 p1 = chunk.mesh.vertices[t.tri[1]];
+        vmath::vec3 p2 = chunk.mesh.vertices[t.tri[2]];
+        vmath::vec3 n = vmath::cross(p1 - p0, p2 - p0);
+
+        if (t.tri[0] == v) {
+            p0 = p;
+        } else if (t.tri[1] == v) {
+            p1 = p;
+        } else {
+            p2 = p;
+        }
+        vmath::vec3 newn = vmath::cross(p1 - p0, p2 - p0);
+
+        float len = vmath::length(n);
+        float newlen = vmath::length(newn);
+        if (len <= 0.0f || newlen <= 0.0f) {
+            return true;
+        }
+
+        if (vmath::dot(n, newn) < _minNormalDot * len * newlen) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool MeshDecimator::_isCollapseManifold(int v0, int v1, 
+                                        DecimatorChunk &chunk, 
+                                        ChunkDecimationData &data) {
+    // Link condition: the vertices on either side of the edge must share
+    // exactly the two vertices opposite the edge
+    std::vector<int> n0, n1;
+    _getVertexNeighbours(v0, chunk, data, n0);
+    _getVertexNeighbours(v1, chunk, data, n1);
+
+    std::vector<int> shared;
+    std::set_intersection(n0.begin(), n0.end(), n1.begin(), n1.end(), 
+                          std::back_inserter(shared));
+
+    return shared.size() == 2;
+}
+
+bool MeshDecimator::_isThinSheetEdge(int v0, int v1, 
+                                     DecimatorChunk &chunk, 
+                                     ChunkDecimationData &data) {
+    // An edge that wraps around the rim of a thin sheet joins vertices on 
+    // opposite sides of the sheet. Their normals point in different 
+    // directions, while the quadric error of the collapse can still be 
+    // small because both sides are close together.
+    vmath::vec3 n0 = _getVertexNormal(v0, chunk, data);
+    vmath::vec3 n1 = _getVertexNormal(v1, chunk, data);
+    float len0 = vmath::length(n0);
+    float len1 = vmath::length(n1);
+    if (len0 <= 0.0f || len1 <= 0.0f) {
+        return true;
+    }
+
+    return vmath::dot(n0, n1) < _minNormalDot * len0 * len1;
+}
+
+vmath::vec3 MeshDecimator::_getVertexNormal(int v, 
+                                            DecimatorChunk &chunk, 
+                                            ChunkDecimationData &data) {
+    // Area weighted sum of the adjacent face normals
+    vmath::vec3 n;
+    std::vector<int> *vt = &(data.vertexTriangles[v]);
+    for (size_t i = 0; i < vt->size(); i++) {
+        int tidx = vt->at(i);
+        if (data.isTriangleDeleted[tidx]) {
+            continue;
+        }
+
+        Triangle t = chunk.mesh.triangles[tidx];
+        vmath::vec3 p0 = chunk.mesh.vertices[t.tri[0]];
+        vmath::vec3 p1 = chunk.mesh.vertices[t.tri[1]];
+        vmath::vec3 p2 = chunk.mesh.vertices[t.tri[2]];
+        n += vmath::cross(p1 - p0, p2 - p0);
+    }
+
+    return n;
+}
+
+void MeshDecimator::_getVertexNeighbours(int v, 
+                                         DecimatorChunk &chunk, 
+                                         ChunkDecimationData &data, 
+                                         std::vector<int> &neighbours) {
+    std::vector<int> *vt = &(data.vertexTriangles[v]);
+    for (size_t i = 0; i < vt->size(); i++) {
+        int tidx = vt->at(i);
+        if (data.isTriangleDeleted[tidx]) {
+            continue;
+        }
+
+        Triangle t = chunk.mesh.triangles[tidx];
+        for (int j = 0; j < 3; j++) {
+            if (t.tri[j] != v) {
+                neighbours.push_back(t.tri[j]);
+            }
+        }
+    }
+
+    std::sort(neighbours.begin(), neighbours.end());
+    neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+}
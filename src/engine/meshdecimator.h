@@ -0,0 +1,130 @@
+/*
+MIT License
+
+Copyright (C) 2026 Ryan L. Guy & Dennis Fassbaender
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#if __MINGW32__ && !_WIN64
+    #include "mingw32_threads/mingw.thread.h"
+#else
+    #include <thread>
+#endif
+
+#include <vector>
+
+#include "vmath.h"
+#include "trianglemesh.h"
+
+struct MeshDecimatorParameters {
+    // Maximum quadric error of an edge collapse, measured as a distance
+    double maxError = 0.0;
+
+    // Collapses that rotate an adjacent face normal further than this 
+    // (as the dot product between the old and new normal) are rejected.
+    // Edges whose end vertex normals differ by more than this are treated
+    // as the rim of a thin sheet and are never collapsed.
+    double minNormalDot = 0.5;
+};
+
+class MeshDecimator {
+
+public:
+    MeshDecimator();
+    ~MeshDecimator();
+
+    void decimate(MeshDecimatorParameters params, TriangleMesh &mesh);
+
+private:
+
+    struct Quadric {
+        double q[10] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+
+        Quadric() {}
+        Quadric(double a, double b, double c, double d) {
+            q[0] = a * a; q[1] = a * b; q[2] = a * c; q[3] = a * d;
+            q[4] = b * b; q[5] = b * c; q[6] = b * d;
+            q[7] = c * c; q[8] = c * d;
+            q[9] = d * d;
+        }
+
+        void add(const Quadric &other) {
+            for (int i = 0; i < 10; i++) {
+                q[i] += other.q[i];
+            }
+        }
+
+        double evaluate(vmath::vec3 p) {
+            double x = p.x;
+            double y = p.y;
+            double z = p.z;
+            return q[0]*x*x + 2*q[1]*x*y + 2*q[2]*x*z + 2*q[3]*x + 
+                   q[4]*y*y + 2*q[5]*y*z + 2*q[6]*y + 
+                   q[7]*z*z + 2*q[8]*z + 
+                   q[9];
+        }
+    };
+
+    struct DecimatorChunk {
+        TriangleMesh mesh;
+        std::vector<int> globalVertexIndices;
+        std::vector<bool> isLockedVertex;
+        std::vector<Quadric> quadrics;
+    };
+
+    struct ChunkDecimationData {
+        std::vector<std::vector<int> > vertexTriangles;
+        std::vector<bool> isTriangleDeleted;
+        std::vector<bool> isVertexFixed;
+        std::vector<bool> isVertexDirty;
+    };
+
+    void _initializeVertexQuadrics(TriangleMesh &mesh);
+    void _decimatePass(TriangleMesh &mesh, double slabOffset);
+    void _splitMeshIntoChunks(TriangleMesh &mesh, double slabOffset, 
+                              std::vector<DecimatorChunk> &chunks);
+    void _mergeChunks(std::vector<DecimatorChunk> &chunks, TriangleMesh &mesh);
+    void _decimateChunksThread(int startidx, int endidx, 
+                               std::vector<DecimatorChunk> *chunks);
+    void _decimateChunk(DecimatorChunk &chunk);
+    void _initializeChunkDecimationData(DecimatorChunk &chunk, ChunkDecimationData &data);
+    bool _collapseEdge(int v0, int v1, DecimatorChunk &chunk, ChunkDecimationData &data);
+    bool _isCollapseFlippingTriangles(int v, int vother, vmath::vec3 p, 
+                                      DecimatorChunk &chunk, ChunkDecimationData &data);
+    bool _isCollapseManifold(int v0, int v1, DecimatorChunk &chunk, ChunkDecimationData &data);
+    bool _isThinSheetEdge(int v0, int v1, DecimatorChunk &chunk, ChunkDecimationData &data);
+    vmath::vec3 _getVertexNormal(int v, DecimatorChunk &chunk, ChunkDecimationData &data);
+    void _getVertexNeighbours(int v, DecimatorChunk &chunk, ChunkDecimationData &data, 
+                              std::vector<int> &neighbours);
+
+    double _maxError = 0.0;
+    double _minNormalDot = 0.5;
+
+    // Quadrics are carried across passes so that the error of a vertex is
+    // always measured against the planes of the input mesh
+    std::vector<Quadric> _vertexQuadrics;
+
+    int _numPasses = 2;
+    int _chunksPerThread = 2;
+    int _maxChunkIterations = 32;
+
+};
@@ -29,6 +29,8 @@ SOFTWARE.
 #include "meshutils.h"
 #include "collision.h"
 
+#include <cstdio>
+
 MeshLevelSet::MeshLevelSet() {
 }
 
@@ -60,7 +62,7 @@ void MeshLevelSet::constructMinimalLevelSet(int isize, int jsize, int ksize, dou
     _jsize = jsize;
     _ksize = ksize;
     _dx = dx;
-    _phi = Array3d<float>(_isize + 1, _jsize + 1, _ksize + 1, getDistanceUpperBound());
+    _phi = Array3d<StorageFloat>(_isize + 1, _jsize + 1, _ksize + 1, getDistanceUpperBound());
     _isMinimalLevelSet = true;
     _isVelocityDataEnabled = false;
 }
@@ -68,7 +70,7 @@ void MeshLevelSet::constructMinimalLevelSet(int isize, int jsize, int ksize, dou
 void MeshLevelSet::constructMinimalSignedDistanceField(MeshLevelSet &levelset) {
     levelset.getGridDimensions(&_isize, &_jsize, &_ksize);
     _dx = levelset.getCellSize();
-    _phi = Array3d<float>(_isize + 1, _jsize + 1, _ksize + 1);
+    _phi = Array3d<StorageFloat>(_isize + 1, _jsize + 1, _ksize + 1);
     _isMinimalLevelSet = true;
     _isVelocityDataEnabled = false;
 
@@ -531,7 +533,7 @@ VelocityDataGrid* MeshLevelSet::getVelocityDataGrid() {
     return &_velocityData;
 }
 
-Array3d<float>* MeshLevelSet::getPhiArray3d() {
+Array3d<StorageFloat>* MeshLevelSet::getPhiArray3d() {
     return &_phi;
 }
 
@@ -637,6 +639,47 @@ void MeshLevelSet::calculateUnion(MeshLevelSet &levelset) {
     }
 }
 
+void MeshLevelSet::fillOutsideExactBandMask(MeshLevelSet &coarseLevelSet) {
+    if (_exactBandMask == NULL) {
+        return;
+    }
+
+    size_t gridsize = (_isize + 1) * (_jsize + 1) * (_ksize + 1);
+    size_t numCPU = ThreadUtils::getMaxThreadCount();
+    int numthreads = (int)fmin(numCPU, gridsize);
+    std::vector<std::thread> threads(numthreads);
+    std::vector<int> intervals = ThreadUtils::splitRangeIntoIntervals(0, gridsize, numthreads);
+    for (int i = 0; i < numthreads; i++) {
+        threads[i] = std::thread(&MeshLevelSet::_fillOutsideExactBandMaskThread, this,
+                                 intervals[i], intervals[i + 1], &coarseLevelSet);
+    }
+
+    for (int i = 0; i < numthreads; i++) {
+        threads[i].join();
+    }
+}
+
+void MeshLevelSet::mergeExactBandMaskTiles(MeshLevelSet &levelset) {
+    int isizeOther, jsizeOther, ksizeOther;
+    levelset.getGridDimensions(&isizeOther, &jsizeOther, &ksizeOther);
+    FLUIDSIM_ASSERT(isizeOther == _isize && jsizeOther == _jsize && ksizeOther == _ksize);
+    FLUIDSIM_ASSERT(levelset.getExactBandMask() != NULL);
+
+    size_t gridsize = (_isize + 1) * (_jsize + 1) * (_ksize + 1);
+    size_t numCPU = ThreadUtils::getMaxThreadCount();
+    int numthreads = (int)fmin(numCPU, gridsize);
+    std::vector<std::thread> threads(numthreads);
+    std::vector<int> intervals = ThreadUtils::splitRangeIntoIntervals(0, gridsize, numthreads);
+    for (int i = 0; i < numthreads; i++) {
+        threads[i] = std::thread(&MeshLevelSet::_mergeExactBandMaskTilesThread, this,
+                                 intervals[i], intervals[i + 1], &levelset);
+    }
+
+    for (int i = 0; i < numthreads; i++) {
+        threads[i].join();
+    }
+}
+
 void MeshLevelSet::normalizeVelocityGrid() {
     FLUIDSIM_ASSERT(_isVelocityDataEnabled);
 
@@ -717,6 +760,213 @@ void MeshLevelSet::reset() {
     _meshObjects.clear();
 }
 
+/*
+    Binary cache format, native byte order:
+
+        char[8]             magic/version
+        int                 size of a phi element, sizeof(StorageFloat)
+        uint64              content key
+        int[3], double      isize, jsize, ksize, dx
+        int[3]              grid offset
+        int                 velocity data flag
+        int, vec3[n]        mesh vertices
+        int, Triangle[n]    mesh triangles
+        vec3[n]             vertex velocities
+        int, int[n]         mesh objects as indices into objectTable
+        StorageFloat[]      phi
+        int[]               closest triangles
+        int[]               closest mesh objects
+        float[]             velocity field U, V, W and weights U, V, W 
+                            (if velocity flag is set)
+
+    Files are written to a temporary path and renamed so that an interrupted
+    write never leaves a partial cache file behind.
+*/
+bool MeshLevelSet::writeToFile(std::string filename, 
+                               unsigned long long key, 
+                               std::vector<MeshObject*> &objectTable) {
+    std::vector<int> objectIndices(_meshObjects.size(), -1);
+    for (size_t i = 0; i < _meshObjects.size(); i++) {
+        for (size_t j = 0; j < objectTable.size(); j++) {
+            if (_meshObjects[i] == objectTable[j]) {
+                objectIndices[i] = (int)j;
+                break;
+            }
+        }
+
+        if (objectIndices[i] == -1) {
+            return false;
+        }
+    }
+
+    std::string tempFilename = filename + ".tmp";
+    std::ofstream file(tempFilename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    int isVelocityData = _isVelocityDataEnabled && !_isMinimalLevelSet ? 1 : 0;
+    int numVertices = (int)_mesh.vertices.size();
+    int numTriangles = (int)_mesh.triangles.size();
+    int numObjects = (int)objectIndices.size();
+
+    int storageFloatSize = (int)sizeof(StorageFloat);
+    file.write(_fileCacheMagic, 8);
+    file.write((char *)&storageFloatSize, sizeof(int));
+    file.write((char *)&key, sizeof(unsigned long long));
+    file.write((char *)&_isize, sizeof(int));
+    file.write((char *)&_jsize, sizeof(int));
+    file.write((char *)&_ksize, sizeof(int));
+    file.write((char *)&_dx, sizeof(double));
+    file.write((char *)&(_gridOffset.i), sizeof(int));
+    file.write((char *)&(_gridOffset.j), sizeof(int));
+    file.write((char *)&(_gridOffset.k), sizeof(int));
+    file.write((char *)&isVelocityData, sizeof(int));
+    file.write((char *)&numVertices, sizeof(int));
+    file.write((char *)_mesh.vertices.data(), numVertices * sizeof(vmath::vec3));
+    file.write((char *)&numTriangles, sizeof(int));
+    file.write((char *)_mesh.triangles.data(), numTriangles * sizeof(Triangle));
+    file.write((char *)_vertexVelocities.data(), numVertices * sizeof(vmath::vec3));
+    file.write((char *)&numObjects, sizeof(int));
+    file.write((char *)objectIndices.data(), numObjects * sizeof(int));
+
+    bool success = file.good() && 
+                   _writeArray3dToFile(&file, _phi) &&
+                   _writeArray3dToFile(&file, _closestTriangles) &&
+                   _writeArray3dToFile(&file, _closestMeshObjects);
+    if (success && isVelocityData) {
+        success = _writeArray3dToFile(&file, *(_velocityData.field.getArray3dU())) &&
+                  _writeArray3dToFile(&file, *(_velocityData.field.getArray3dV())) &&
+                  _writeArray3dToFile(&file, *(_velocityData.field.getArray3dW())) &&
+                  _writeArray3dToFile(&file, _velocityData.weightU) &&
+                  _writeArray3dToFile(&file, _velocityData.weightV) &&
+                  _writeArray3dToFile(&file, _velocityData.weightW);
+    }
+    file.close();
+
+    if (!success) {
+        std::remove(tempFilename.c_str());
+        return false;
+    }
+
+    std::remove(filename.c_str());
+    if (std::rename(tempFilename.c_str(), filename.c_str()) != 0) {
+        std::remove(tempFilename.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+bool MeshLevelSet::loadFromFile(std::string filename, 
+                                unsigned long long key, 
+                                std::vector<MeshObject*> &objectTable) {
+    std::ifstream file(filename.c_str(), std::ios::in | std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    char magic[8];
+    int storageFloatSize = 0;
+    unsigned long long fileKey = 0;
+    int isize, jsize, ksize;
+    double dx;
+    GridIndex gridOffset;
+    int isVelocityData;
+    file.read(magic, 8);
+    file.read((char *)&storageFloatSize, sizeof(int));
+    file.read((char *)&fileKey, sizeof(unsigned long long));
+    file.read((char *)&isize, sizeof(int));
+    file.read((char *)&jsize, sizeof(int));
+    file.read((char *)&ksize, sizeof(int));
+    file.read((char *)&dx, sizeof(double));
+    file.read((char *)&(gridOffset.i), sizeof(int));
+    file.read((char *)&(gridOffset.j), sizeof(int));
+    file.read((char *)&(gridOffset.k), sizeof(int));
+    file.read((char *)&isVelocityData, sizeof(int));
+    if (!file.good() || std::string(magic, 8) != std::string(_fileCacheMagic, 8) || fileKey != key) {
+        return false;
+    }
+
+    // Caches written by a build with a different phi storage type 
+    // (WITH_HALF_PRECISION_GRIDS) cannot be read
+    if (storageFloatSize != (int)sizeof(StorageFloat)) {
+        return false;
+    }
+
+    if (isize != _isize || jsize != _jsize || ksize != _ksize || dx != _dx) {
+        return false;
+    }
+
+    bool isVelocityDataExpected = _isVelocityDataEnabled && !_isMinimalLevelSet;
+    if ((isVelocityData != 0) != isVelocityDataExpected) {
+        return false;
+    }
+
+    int numVertices;
+    file.read((char *)&numVertices, sizeof(int));
+    if (!file.good() || numVertices < 0) {
+        return false;
+    }
+    std::vector<vmath::vec3> vertices(numVertices);
+    file.read((char *)vertices.data(), numVertices * sizeof(vmath::vec3));
+
+    int numTriangles;
+    file.read((char *)&numTriangles, sizeof(int));
+    if (!file.good() || numTriangles < 0) {
+        return false;
+    }
+    std::vector<Triangle> triangles(numTriangles);
+    file.read((char *)triangles.data(), numTriangles * sizeof(Triangle));
+
+    std::vector<vmath::vec3> vertexVelocities(numVertices);
+    file.read((char *)vertexVelocities.data(), numVertices * sizeof(vmath::vec3));
+
+    int numObjects;
+    file.read((char *)&numObjects, sizeof(int));
+    if (!file.good() || numObjects < 0) {
+        return false;
+    }
+    std::vector<int> objectIndices(numObjects);
+    file.read((char *)objectIndices.data(), numObjects * sizeof(int));
+    if (!file.good()) {
+        return false;
+    }
+
+    std::vector<MeshObject*> meshObjects(numObjects);
+    for (int i = 0; i < numObjects; i++) {
+        if (objectIndices[i] < 0 || objectIndices[i] >= (int)objectTable.size()) {
+            return false;
+        }
+        meshObjects[i] = objectTable[objectIndices[i]];
+    }
+
+    bool success = _readArray3dFromFile(&file, _phi) &&
+                   _readArray3dFromFile(&file, _closestTriangles) &&
+                   _readArray3dFromFile(&file, _closestMeshObjects);
+    if (success && isVelocityData) {
+        success = _readArray3dFromFile(&file, *(_velocityData.field.getArray3dU())) &&
+                  _readArray3dFromFile(&file, *(_velocityData.field.getArray3dV())) &&
+                  _readArray3dFromFile(&file, *(_velocityData.field.getArray3dW())) &&
+                  _readArray3dFromFile(&file, _velocityData.weightU) &&
+                  _readArray3dFromFile(&file, _velocityData.weightV) &&
+                  _readArray3dFromFile(&file, _velocityData.weightW);
+    }
+
+    if (!success) {
+        reset();
+        return false;
+    }
+
+    _mesh.vertices = vertices;
+    _mesh.triangles = triangles;
+    _vertexVelocities = vertexVelocities;
+    _meshObjects = meshObjects;
+    setGridOffset(gridOffset);
+
+    return true;
+}
+
 void MeshLevelSet::setGridOffset(GridIndex g) {
     _gridOffset = g;
     _positionOffset = Grid3d::GridIndexToPosition(g, _dx);
@@ -730,6 +980,25 @@ vmath::vec3 MeshLevelSet::getPositionOffset() {
     return _positionOffset;
 }
 
+void MeshLevelSet::setExactBandMask(Array3d<bool> *mask, int tileWidth) {
+    FLUIDSIM_ASSERT(tileWidth > 0);
+    _exactBandMask = mask;
+    _exactBandMaskTileWidth = tileWidth;
+}
+
+void MeshLevelSet::clearExactBandMask() {
+    _exactBandMask = NULL;
+    _exactBandMaskTileWidth = 1;
+}
+
+Array3d<bool>* MeshLevelSet::getExactBandMask() {
+    return _exactBandMask;
+}
+
+int MeshLevelSet::getExactBandMaskTileWidth() {
+    return _exactBandMaskTileWidth;
+}
+
 void MeshLevelSet::enableVelocityData() {
     _isVelocityDataEnabled = true;
 }
@@ -905,6 +1174,10 @@ void MeshLevelSet::_initializeTriangleData(int bandwidth, std::vector<TriangleDa
         gmax.j = std::min(gmax.j, _jsize);
         gmax.k = std::min(gmax.k, _ksize);
 
+        if (!_isExactBandRegionActive(gmin, gmax)) {
+            continue;
+        }
+
         TriangleData d;
         d.id = tidx;
         d.gmin = gmin;
@@ -1145,6 +1418,12 @@ void MeshLevelSet::_computeExactBandProducerThread(BoundedBuffer<ComputeBlock> *
                 for (int k = gmin.k; k <= gmax.k; k++) {
                     for (int j = gmin.j; j <= gmax.j; j++) {
                         for (int i = gmin.i; i <= gmax.i; i++) {
+                            if (!_isExactBandNodeActive(i + blockGridIndexOffset.i, 
+                                                        j + blockGridIndexOffset.j, 
+                                                        k + blockGridIndexOffset.k)) {
+                                continue;
+                            }
+
                             vmath::vec3 gpos = Grid3d::GridIndexToPosition(i, j, k, _dx);
                             float dist = _pointToTriangleDistance(gpos, p, q, r);
                             int flatidx = Grid3d::getFlatIndex(i, j, k, _blockwidth, _blockwidth);
@@ -1204,9 +1483,17 @@ void MeshLevelSet::_computeExactBandDistanceFieldSingleThreaded(int bandwidth) {
         int j1 = _clamp(int(fmax(fjp, fmax(fjq, fjr))) + bandwidth + 1, 0, jsize - 1);
         int k1 = _clamp(int(fmax(fkp, fmax(fkq, fkr))) + bandwidth + 1, 0, ksize - 1);
 
+        if (!_isExactBandRegionActive(GridIndex(i0, j0, k0), GridIndex(i1, j1, k1))) {
+            continue;
+        }
+
         for(int k = k0; k <= k1; k++) {
             for(int j = j0; j <= j1; j++) { 
                 for(int i = i0; i <= i1; i++){
+                    if (!_isExactBandNodeActive(i, j, k)) {
+                        continue;
+                    }
+
                     vmath::vec3 gpos = Grid3d::GridIndexToPosition(i, j, k, _dx);
                     float d = _pointToTriangleDistance(gpos, p, q, r);
                     if (d < _phi(i, j, k)) {
@@ -1301,15 +1588,12 @@ void MeshLevelSet::_computeDistanceFieldSigns() {
     int ksize = _phi.depth;
     Array3d<bool> nodes(isize, jsize, ksize, false);
 
-    TriangleMesh tempMesh = _mesh;
-    tempMesh.translate(-_positionOffset);
-
     bool computeSingleThreaded = !_isMultiThreadingEnabled;
-    MeshUtils::getGridNodesInsideTriangleMesh(tempMesh, _dx, nodes, computeSingleThreaded);
+    MeshUtils::getGridNodesInsideTriangleMesh(_mesh, -_positionOffset, _dx, nodes, computeSingleThreaded);
 
     int size = _phi.getNumElements();
     bool *nodesArray = nodes.getRawArray();
-    float *phiArray = _phi.getRawArray();
+    StorageFloat *phiArray = _phi.getRawArray();
     for (int i = 0; i < size; i++) {
         if (nodesArray[i]) {
             phiArray[i] = -phiArray[i];
@@ -1756,6 +2040,101 @@ void MeshLevelSet::_normalizeVelocityGridThread(int startidx, int endidx,
     }
 }
 
+bool MeshLevelSet::_isExactBandNodeActive(int i, int j, int k) {
+    if (_exactBandMask == NULL) {
+        return true;
+    }
+
+    int ti = (i + _gridOffset.i) / _exactBandMaskTileWidth;
+    int tj = (j + _gridOffset.j) / _exactBandMaskTileWidth;
+    int tk = (k + _gridOffset.k) / _exactBandMaskTileWidth;
+    if (!_exactBandMask->isIndexInRange(ti, tj, tk)) {
+        return false;
+    }
+
+    return _exactBandMask->get(ti, tj, tk);
+}
+
+bool MeshLevelSet::_isExactBandRegionActive(GridIndex gmin, GridIndex gmax) {
+    if (_exactBandMask == NULL) {
+        return true;
+    }
+
+    int tw = _exactBandMaskTileWidth;
+    GridIndex tmin((gmin.i + _gridOffset.i) / tw, 
+                   (gmin.j + _gridOffset.j) / tw, 
+                   (gmin.k + _gridOffset.k) / tw);
+    GridIndex tmax((gmax.i + _gridOffset.i) / tw, 
+                   (gmax.j + _gridOffset.j) / tw, 
+                   (gmax.k + _gridOffset.k) / tw);
+    tmin.i = std::max(tmin.i, 0);
+    tmin.j = std::max(tmin.j, 0);
+    tmin.k = std::max(tmin.k, 0);
+    tmax.i = std::min(tmax.i, _exactBandMask->width - 1);
+    tmax.j = std::min(tmax.j, _exactBandMask->height - 1);
+    tmax.k = std::min(tmax.k, _exactBandMask->depth - 1);
+
+    for (int k = tmin.k; k <= tmax.k; k++) {
+        for (int j = tmin.j; j <= tmax.j; j++) {
+            for (int i = tmin.i; i <= tmax.i; i++) {
+                if (_exactBandMask->get(i, j, k)) {
+                    return true;
+                }
+            }
+        }
+    }
+
+    return false;
+}
+
+void MeshLevelSet::_fillOutsideExactBandMaskThread(int startidx, int endidx, 
+                                                   MeshLevelSet *coarseLevelSet) {
+    vmath::vec3 offset = _positionOffset - coarseLevelSet->getPositionOffset();
+    for (int idx = startidx; idx < endidx; idx++) {
+        GridIndex g = Grid3d::getUnflattenedIndex(idx, _isize + 1, _jsize + 1);
+        if (_isExactBandNodeActive(g.i, g.j, g.k)) {
+            continue;
+        }
+
+        vmath::vec3 p = Grid3d::GridIndexToPosition(g, _dx) + offset;
+        _phi.set(g, coarseLevelSet->trilinearInterpolate(p));
+    }
+}
+
+void MeshLevelSet::_mergeExactBandMaskTilesThread(int startidx, int endidx, 
+                                                  MeshLevelSet *levelset) {
+    VelocityDataGrid *otherData = levelset->getVelocityDataGrid();
+    for (int idx = startidx; idx < endidx; idx++) {
+        GridIndex g = Grid3d::getUnflattenedIndex(idx, _isize + 1, _jsize + 1);
+        if (!levelset->_isExactBandNodeActive(g.i, g.j, g.k)) {
+            continue;
+        }
+
+        _phi.set(g, levelset->get(g));
+        _closestTriangles.set(g, levelset->getClosestTriangleIndex(g));
+        _closestMeshObjects.set(g, levelset->getClosestMeshObjectIndex(g));
+
+        if (!_isVelocityDataEnabled) {
+            continue;
+        }
+
+        if (Grid3d::isGridIndexInRange(g, _isize + 1, _jsize, _ksize)) {
+            _velocityData.field.setU(g, otherData->field.U(g));
+            _velocityData.weightU.set(g, otherData->weightU(g));
+        }
+
+        if (Grid3d::isGridIndexInRange(g, _isize, _jsize + 1, _ksize)) {
+            _velocityData.field.setV(g, otherData->field.V(g));
+            _velocityData.weightV.set(g, otherData->weightV(g));
+        }
+
+        if (Grid3d::isGridIndexInRange(g, _isize, _jsize, _ksize + 1)) {
+            _velocityData.field.setW(g, otherData->field.W(g));
+            _velocityData.weightW.set(g, otherData->weightW(g));
+        }
+    }
+}
+
 void MeshLevelSet::_calculateUnionThread(int startidx, int endidx, 
                                          int triIndexOffset, 
                                          int meshObjectIndexOffset,
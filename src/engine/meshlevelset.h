@@ -65,6 +65,8 @@ USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "blockarray3d.h"
 #include "boundedbuffer.h"
 
+#include <fstream>
+
 struct VelocityDataGrid {
     MACVelocityField field;
     Array3d<float> weightU;
@@ -150,7 +152,7 @@ public:
     std::vector<MeshObject*> getMeshObjects();
     std::vector<vmath::vec3> getVertexVelocities();
     VelocityDataGrid* getVelocityDataGrid();
-    Array3d<float>* getPhiArray3d();
+    Array3d<StorageFloat>* getPhiArray3d();
 
     void calculateSignedDistanceField(TriangleMesh &m, int bandwidth = 1);
     void calculateSignedDistanceField(TriangleMesh &m, 
@@ -161,6 +163,8 @@ public:
                                           std::vector<vmath::vec3> &vertexVelocities, 
                                           int bandwidth = 1);
     void calculateUnion(MeshLevelSet &levelset);
+    void fillOutsideExactBandMask(MeshLevelSet &coarseLevelSet);
+    void mergeExactBandMaskTiles(MeshLevelSet &levelset);
     void normalizeVelocityGrid();
     void negate();
     void reset();
@@ -169,6 +173,18 @@ public:
     GridIndex getGridOffset();
     vmath::vec3 getPositionOffset();
 
+    /*
+        Restricts exact band distance calculations to the tiles of a coarse
+        boolean grid. Each tile covers tileWidth x tileWidth x tileWidth
+        nodes in domain grid coordinates. Nodes outside of active tiles are
+        left at the distance upper bound. The mask is not owned by the
+        level set and must outlive any distance field calculation.
+    */
+    void setExactBandMask(Array3d<bool> *mask, int tileWidth);
+    void clearExactBandMask();
+    Array3d<bool>* getExactBandMask();
+    int getExactBandMaskTileWidth();
+
     void enableVelocityData();
     void disableVelocityData();
     bool isVelocityDataEnabled();
@@ -180,6 +196,13 @@ public:
     bool isSignCaclulationEnabled();
     float getDistanceUpperBound();
 
+    bool writeToFile(std::string filename, 
+                     unsigned long long key, 
+                     std::vector<MeshObject*> &objectTable);
+    bool loadFromFile(std::string filename, 
+                      unsigned long long key, 
+                      std::vector<MeshObject*> &objectTable);
+
 
     template<class T>
     void trilinearInterpolateSolidPoints(FragmentedVector<T> &points, 
@@ -252,6 +275,18 @@ private:
         int numTriangles = 0;
     };
 
+    template<class T>
+    bool _writeArray3dToFile(std::ofstream *file, Array3d<T> &grid) {
+        file->write((char *)grid.getRawArray(), grid.getNumElements() * sizeof(T));
+        return file->good();
+    }
+
+    template<class T>
+    bool _readArray3dFromFile(std::ifstream *file, Array3d<T> &grid) {
+        file->read((char *)grid.getRawArray(), grid.getNumElements() * sizeof(T));
+        return file->good();
+    }
+
     void _computeExactBandDistanceField(int bandwidth);
 
     void _computeExactBandDistanceFieldMultiThreaded(int bandwidth);
@@ -303,6 +338,8 @@ private:
                                         vmath::vec3 x1, vmath::vec3 x2, 
                                         vmath::vec3 v1, vmath::vec3 v2, float *distance);
     int _orientation(double x1, double y1, double x2, double y2, double *twiceSignedArea);
+    bool _isExactBandNodeActive(int i, int j, int k);
+    bool _isExactBandRegionActive(GridIndex gmin, GridIndex gmax);
 
     void _trilinearInterpolateSolidGridPointsThread(int startidx, int endidx, vmath::vec3 offset, double dx, 
                                                     Array3d<bool> *grid);
@@ -315,6 +352,10 @@ private:
     void _calculateUnionThread(int startidx, int endidx, 
                                int triIndexOffset, int meshObjectIndexOffset, 
                                MeshLevelSet *levelset);
+    void _fillOutsideExactBandMaskThread(int startidx, int endidx, 
+                                         MeshLevelSet *coarseLevelSet);
+    void _mergeExactBandMaskTilesThread(int startidx, int endidx, 
+                                        MeshLevelSet *levelset);
 
     void _trilinearInterpolatePointsThread(int startidx, int endidx,
                                            std::vector<vmath::vec3> *points, 
@@ -350,7 +391,7 @@ private:
 
     TriangleMesh _mesh;
     std::vector<vmath::vec3> _vertexVelocities;
-    Array3d<float> _phi;
+    Array3d<StorageFloat> _phi;
     Array3d<int> _closestTriangles;
     VelocityDataGrid _velocityData;
 
@@ -366,6 +407,11 @@ private:
     bool _isSignCalculationEnabled = true;
     bool _isMinimalLevelSet = false;
 
+    Array3d<bool> *_exactBandMask = NULL;
+    int _exactBandMaskTileWidth = 1;
+
     int _blockwidth = 10;
     int _numComputeBlocksPerJob = 10;
+
+    const char *_fileCacheMagic = "FFSDF002";
 };
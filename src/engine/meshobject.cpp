@@ -694,6 +694,8 @@ MeshLevelSet MeshObject::_getMeshIslandLevelSet(TriangleMesh &m,
 
     MeshLevelSet islandLevelSet(gwidth, gheight, gdepth, dx, this);
     islandLevelSet.setGridOffset(gmin);
+    islandLevelSet.setExactBandMask(domainLevelSet.getExactBandMask(), 
+                                    domainLevelSet.getExactBandMaskTileWidth());
     islandLevelSet.fastCalculateSignedDistanceField(m, velocities, exactBand);
 
     *success = true;
@@ -830,6 +832,8 @@ void MeshObject::_islandMeshLevelSetProducerThread(BoundedBuffer<MeshIslandWorkI
 
             MeshLevelSet *islandLevelSet = new MeshLevelSet(gwidth, gheight, gdepth, dx, this);
             islandLevelSet->setGridOffset(gmin);
+            islandLevelSet->setExactBandMask(domainLevelSet->getExactBandMask(), 
+                                             domainLevelSet->getExactBandMaskTileWidth());
             islandLevelSet->disableMultiThreading();
             islandLevelSet->fastCalculateSignedDistanceField(w.mesh, w.vertexVelocities, exactBand);
 
@@ -881,6 +885,8 @@ void MeshObject::_obstacleMeshLevelSetProducerThread(BoundedBuffer<MeshObject*>
             MeshLevelSet *islandLevelSet = new MeshLevelSet(gwidth, gheight, gdepth, dx, obstacle);
 
             islandLevelSet->setGridOffset(gmin);
+            islandLevelSet->setExactBandMask(domainLevelSet->getExactBandMask(), 
+                                             domainLevelSet->getExactBandMaskTileWidth());
             islandLevelSet->disableMultiThreading();
             islandLevelSet->fastCalculateSignedDistanceField(mesh, vertexVelocities, exactBand);
 
@@ -25,6 +25,7 @@ SOFTWARE.
 #include "meshutils.h"
 
 #include <limits>
+#include <algorithm>
 
 #include "grid3d.h"
 #include "collision.h"
@@ -379,83 +380,296 @@ void getGridNodesInsideTriangleMesh(TriangleMesh mesh, double dx,
     }
 }
 
-void getGridNodesInsideTriangleMesh(TriangleMesh mesh, double dx, 
+void getGridNodesInsideTriangleMesh(TriangleMesh &mesh, double dx, 
+                                    Array3d<bool> &nodes, bool computeSingleThreaded) {
+    getGridNodesInsideTriangleMesh(mesh, vmath::vec3(0.0f, 0.0f, 0.0f), dx, nodes, computeSingleThreaded);
+}
+
+/*
+    Classifies grid nodes as inside/outside of a mesh translated by offset 
+    without copying or translating the mesh. Triangles are binned into grid
+    columns in a flat CSR buffer and each column is resolved independently 
+    by casting a ray along the z-axis and counting intersection parity.
+
+    Islands that lie completely within the grid are resolved together. Each
+    island that crosses the grid boundary is resolved on its own and combined 
+    by union, as in the original split inside/outside mesh method.
+*/
+void getGridNodesInsideTriangleMesh(TriangleMesh &mesh, vmath::vec3 offset, double dx, 
                                     Array3d<bool> &nodes, bool computeSingleThreaded) {
     nodes.fill(false);
+    if (mesh.triangles.empty()) {
+        return;
+    }
+
+    ColumnTriangleData data;
+    data.isize = nodes.width;
+    data.jsize = nodes.height;
+    data.ksize = nodes.depth;
+    data.dx = dx;
+    data.offset = offset;
+
+    AABB gridAABB(0.0, 0.0, 0.0, (data.isize - 1) * dx, (data.jsize - 1) * dx, (data.ksize - 1) * dx);
+    data.numGroups = _getTriangleParityGroups(mesh, offset, gridAABB, data.triangleGroups);
+    _getColumnTriangleData(mesh, data);
+
+    /* Jitter the ray origins to reduce the chance of a ray striking an edge
+       shared by two triangles and reporting two collisions. See
+       _getCollisionGridZ.
+    */
+    double jit = 0.001 * dx;
+    data.jitter = vmath::vec3(_randomDouble(jit, -jit), 
+                              _randomDouble(jit, -jit), 
+                              _randomDouble(jit, -jit));
+
+    // Columns vary greatly in cost, so threads fetch small batches of columns
+    // from a shared counter rather than working on fixed intervals
+    int numColumns = data.isize * data.jsize;
+    size_t numCPU = ThreadUtils::getMaxThreadCount();
+    if (computeSingleThreaded) {
+        numCPU = 1;
+    }
+    int numthreads = (int)std::min((int)numCPU, std::max(numColumns / _columnBatchSize, 1));
+    std::atomic<int> nextColumn(0);
+    std::vector<std::thread> threads(numthreads);
+    for (int i = 0; i < numthreads; i++) {
+        threads[i] = std::thread(&_getGridNodesInsideTriangleMeshThread,
+                                 &nextColumn, &mesh, &data, &nodes);
+    }
+
+    for (int i = 0; i < numthreads; i++) {
+        threads[i].join();
+    }
+}
 
-    int isize = nodes.width - 1;
-    int jsize = nodes.height - 1;
-    int ksize = nodes.depth - 1;
-    AABB gridAABB(0.0, 0.0, 0.0, isize * dx, jsize * dx, ksize * dx);
+int _getTriangleParityGroups(TriangleMesh &mesh, vmath::vec3 offset, AABB bbox, 
+                             std::vector<int> &triangleGroups) {
+    triangleGroups.assign(mesh.triangles.size(), 0);
 
     bool isMeshContainedInGrid = true;
     for (size_t i = 0; i < mesh.vertices.size(); i++) {
-        if (!gridAABB.isPointInside(mesh.vertices[i])) {
+        if (!bbox.isPointInside(mesh.vertices[i] + offset)) {
             isMeshContainedInGrid = false;
             break;
         }
     }
 
-    std::vector<GridIndex> nodeVector;
     if (isMeshContainedInGrid) {
-        getGridNodesInsideTriangleMesh(mesh, dx, nodeVector, computeSingleThreaded);
+        return 1;
+    }
 
-        GridIndex g;
-        for (size_t i = 0; i < nodeVector.size(); i++) {
-            if (nodes.isIndexInRange(nodeVector[i])) {
-                nodes.set(nodeVector[i], true);
+    // Label mesh islands by union-find over triangle vertices
+    std::vector<int> parent(mesh.vertices.size());
+    for (size_t i = 0; i < parent.size(); i++) {
+        parent[i] = (int)i;
+    }
+
+    for (size_t i = 0; i < mesh.triangles.size(); i++) {
+        Triangle t = mesh.triangles[i];
+        int r0 = _findIslandRoot(parent, t.tri[0]);
+        int r1 = _findIslandRoot(parent, t.tri[1]);
+        int r2 = _findIslandRoot(parent, t.tri[2]);
+        parent[r1] = r0;
+        parent[r2] = r0;
+    }
+
+    int numIslands = 0;
+    std::vector<int> vertexToIsland(mesh.vertices.size(), -1);
+    std::vector<int> rootToIsland(mesh.vertices.size(), -1);
+    for (size_t i = 0; i < mesh.vertices.size(); i++) {
+        int root = _findIslandRoot(parent, (int)i);
+        if (rootToIsland[root] == -1) {
+            rootToIsland[root] = numIslands;
+            numIslands++;
+        }
+        vertexToIsland[i] = rootToIsland[root];
+    }
+
+    double inf = std::numeric_limits<double>::infinity();
+    std::vector<vmath::vec3> islandMin(numIslands, vmath::vec3(inf, inf, inf));
+    std::vector<vmath::vec3> islandMax(numIslands, vmath::vec3(-inf, -inf, -inf));
+    for (size_t i = 0; i < mesh.vertices.size(); i++) {
+        vmath::vec3 v = mesh.vertices[i] + offset;
+        int island = vertexToIsland[i];
+        islandMin[island] = vmath::vec3(fmin(islandMin[island].x, v.x), 
+                                        fmin(islandMin[island].y, v.y), 
+                                        fmin(islandMin[island].z, v.z));
+        islandMax[island] = vmath::vec3(fmax(islandMax[island].x, v.x), 
+                                        fmax(islandMax[island].y, v.y), 
+                                        fmax(islandMax[island].z, v.z));
+    }
+
+    // Group 0 holds all islands contained in the grid, each island crossing 
+    // the grid boundary gets its own group and non-intersecting islands are 
+    // discarded (-1)
+    int numGroups = 1;
+    std::vector<int> islandToGroup(numIslands, -1);
+    for (int i = 0; i < numIslands; i++) {
+        if (bbox.isPointInside(islandMin[i]) && bbox.isPointInside(islandMax[i])) {
+            islandToGroup[i] = 0;
+        } else {
+            AABB inter = bbox.getIntersection(AABB(islandMin[i], islandMax[i]));
+            if (inter.width > 0.0 || inter.height > 0.0 || inter.depth > 0.0) {
+                islandToGroup[i] = numGroups;
+                numGroups++;
             }
         }
+    }
 
-        return;
+    for (size_t i = 0; i < mesh.triangles.size(); i++) {
+        triangleGroups[i] = islandToGroup[vertexToIsland[mesh.triangles[i].tri[0]]];
     }
 
-    TriangleMesh insideMesh;
-    std::vector<TriangleMesh> outsideMeshes;
-    _splitInsideOutsideMesh(mesh, gridAABB, insideMesh, outsideMeshes);
+    return numGroups;
+}
 
-    getGridNodesInsideTriangleMesh(insideMesh, dx, nodeVector, computeSingleThreaded);
+int _findIslandRoot(std::vector<int> &parent, int idx) {
+    while (parent[idx] != idx) {
+        parent[idx] = parent[parent[idx]];
+        idx = parent[idx];
+    }
+    return idx;
+}
 
-    GridIndex g;
-    for (size_t i = 0; i < nodeVector.size(); i++) {
-        if (nodes.isIndexInRange(nodeVector[i])) {
-            nodes.set(nodeVector[i], true);
+void _getColumnTriangleBounds(TriangleMesh &mesh, int tidx, ColumnTriangleData &data,
+                              int *imin, int *jmin, int *imax, int *jmax) {
+    Triangle t = mesh.triangles[tidx];
+    vmath::vec3 v1 = mesh.vertices[t.tri[0]] + data.offset;
+    vmath::vec3 v2 = mesh.vertices[t.tri[1]] + data.offset;
+    vmath::vec3 v3 = mesh.vertices[t.tri[2]] + data.offset;
+    double invdx = 1.0 / data.dx;
+    double minx = fmin(fmin(v1.x, v2.x), v3.x) * invdx;
+    double miny = fmin(fmin(v1.y, v2.y), v3.y) * invdx;
+    double maxx = fmax(fmax(v1.x, v2.x), v3.x) * invdx;
+    double maxy = fmax(fmax(v1.y, v2.y), v3.y) * invdx;
+
+    // Columns are only candidates if their ray, including jitter, can pass
+    // through the triangle bounds
+    double eps = 0.01;
+    *imin = std::max((int)ceil(minx - eps), 0);
+    *jmin = std::max((int)ceil(miny - eps), 0);
+    *imax = std::min((int)floor(maxx + eps), data.isize - 1);
+    *jmax = std::min((int)floor(maxy + eps), data.jsize - 1);
+}
+
+void _getColumnTriangleData(TriangleMesh &mesh, ColumnTriangleData &data) {
+    int numColumns = data.isize * data.jsize;
+    data.columnStart.assign(numColumns + 1, 0);
+
+    // Column bounds are stored as (imin, jmin, imax, jmax) per triangle. Empty
+    // bounds (imin > imax) are left for discarded triangles and triangles 
+    // that do not cover any column
+    std::vector<int> bounds(4 * mesh.triangles.size());
+    for (size_t tidx = 0; tidx < mesh.triangles.size(); tidx++) {
+        int *b = &(bounds[4 * tidx]);
+        if (data.triangleGroups[tidx] == -1) {
+            b[0] = 0; b[1] = 0; b[2] = -1; b[3] = -1;
+            continue;
+        }
+
+        _getColumnTriangleBounds(mesh, tidx, data, &b[0], &b[1], &b[2], &b[3]);
+        for (int j = b[1]; j <= b[3]; j++) {
+            for (int i = b[0]; i <= b[2]; i++) {
+                data.columnStart[i + j * data.isize + 1]++;
+            }
         }
     }
 
-    for (size_t i = 0; i < outsideMeshes.size(); i++) {
-        nodeVector.clear();
-        getGridNodesInsideTriangleMesh(outsideMeshes[i], dx, nodeVector, computeSingleThreaded);
+    for (int i = 0; i < numColumns; i++) {
+        data.columnStart[i + 1] += data.columnStart[i];
+    }
 
-        GridIndex g;
-        for (size_t i = 0; i < nodeVector.size(); i++) {
-            if (nodes.isIndexInRange(nodeVector[i])) {
-                nodes.set(nodeVector[i], true);
+    std::vector<int> columnCount(numColumns, 0);
+    data.columnTriangles.resize(data.columnStart[numColumns]);
+    for (size_t tidx = 0; tidx < mesh.triangles.size(); tidx++) {
+        int *b = &(bounds[4 * tidx]);
+        for (int j = b[1]; j <= b[3]; j++) {
+            for (int i = b[0]; i <= b[2]; i++) {
+                int cidx = i + j * data.isize;
+                data.columnTriangles[data.columnStart[cidx] + columnCount[cidx]] = tidx;
+                columnCount[cidx]++;
             }
         }
     }
 }
 
-void _splitInsideOutsideMesh(TriangleMesh &mesh, AABB bbox, 
-                             TriangleMesh &insideMesh, 
-                             std::vector<TriangleMesh> &outsideMeshes) {
+void _getGridNodesInsideTriangleMeshThread(std::atomic<int> *nextColumn,
+                                           TriangleMesh *mesh, 
+                                           ColumnTriangleData *data,
+                                           Array3d<bool> *nodes) {
 
-    std::vector<TriangleMesh> meshIslands;
-    std::vector<int> vertexToGroupID;
-    std::vector<int> vertexTranslationTable;
-    _splitIntoMeshIslands(mesh, meshIslands, vertexToGroupID, vertexTranslationTable);
+    int numColumns = data->isize * data->jsize;
+    std::vector<std::pair<float, int> > collisions;
+    std::vector<int> groupCount(data->numGroups, 0);
+    std::vector<bool> groupParity(data->numGroups, false);
 
-    for (size_t i = 0; i < meshIslands.size(); i++) {
-        AABB meshAABB(meshIslands[i].vertices);
-        vmath::vec3 minp = meshAABB.getMinPoint();
-        vmath::vec3 maxp = meshAABB.getMaxPoint();
+    vmath::vec3 dir(0.0, 0.0, 1.0);
+    vmath::vec3 coll;
+    for (;;) {
+        int startidx = nextColumn->fetch_add(_columnBatchSize);
+        if (startidx >= numColumns) {
+            break;
+        }
+        int endidx = std::min(startidx + _columnBatchSize, numColumns);
 
-        if (bbox.isPointInside(minp) && bbox.isPointInside(maxp)) {
-            insideMesh.append(meshIslands[i]);
-        } else {
-            AABB inter = bbox.getIntersection(meshAABB);
-            if (inter.width > 0.0 || inter.height > 0.0 || inter.depth > 0.0) {
-                outsideMeshes.push_back(meshIslands[i]);
+        for (int cidx = startidx; cidx < endidx; cidx++) {
+            int start = data->columnStart[cidx];
+            int end = data->columnStart[cidx + 1];
+            if (start == end) {
+                continue;
+            }
+
+            // Cast the ray in mesh space and convert collisions to grid space
+            int i = cidx % data->isize;
+            int j = cidx / data->isize;
+            vmath::vec3 origin = vmath::vec3(i * data->dx, j * data->dx, -data->dx) + 
+                                 data->jitter - data->offset;
+
+            collisions.clear();
+            for (int idx = start; idx < end; idx++) {
+                int tidx = data->columnTriangles[idx];
+                Triangle t = mesh->triangles[tidx];
+                vmath::vec3 v1 = mesh->vertices[t.tri[0]];
+                vmath::vec3 v2 = mesh->vertices[t.tri[1]];
+                vmath::vec3 v3 = mesh->vertices[t.tri[2]];
+                if (Collision::lineIntersectsTriangle(origin, dir, v1, v2, v3, &coll)) {
+                    int group = data->triangleGroups[tidx];
+                    collisions.push_back(std::pair<float, int>(coll.z + data->offset.z, group));
+                    groupCount[group]++;
+                }
+            }
+
+            if (collisions.empty()) {
+                continue;
+            }
+
+            std::sort(collisions.begin(), collisions.end());
+
+            // A group with an odd number of collisions cannot be resolved
+            // for this column and is ignored
+            int numOddGroups = 0;
+            size_t cpos = 0;
+            int kmin = std::max((int)floor(collisions.front().first / data->dx), 0);
+            int kmax = std::min((int)ceil(collisions.back().first / data->dx), data->ksize - 1);
+            for (int k = kmin; k <= kmax; k++) {
+                float z = (float)(k * data->dx);
+                while (cpos < collisions.size() && collisions[cpos].first < z) {
+                    int group = collisions[cpos].second;
+                    if (groupCount[group] % 2 == 0) {
+                        groupParity[group] = !groupParity[group];
+                        numOddGroups += groupParity[group] ? 1 : -1;
+                    }
+                    cpos++;
+                }
+
+                if (numOddGroups > 0) {
+                    nodes->set(i, j, k, true);
+                }
+            }
+
+            for (size_t cidx = 0; cidx < collisions.size(); cidx++) {
+                groupCount[collisions[cidx].second] = 0;
+                groupParity[collisions[cidx].second] = false;
             }
         }
     }
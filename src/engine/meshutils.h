@@ -24,11 +24,13 @@ SOFTWARE.
 
 #pragma once
 
+#include <atomic>
+
 #include "array3d.h"
 #include "vmath.h"
+#include "aabb.h"
 
 class TriangleMesh;
-class AABB;
 
 namespace MeshUtils {
     typedef struct TriangleMesh_t {
@@ -85,16 +87,45 @@ namespace MeshUtils {
         GridIndex g, double dx, Array3d<std::vector<double> > &zsubcollisions);
 
 
-    void getGridNodesInsideTriangleMesh(TriangleMesh mesh, double dx, 
+    struct ColumnTriangleData {
+        int isize = 0;
+        int jsize = 0;
+        int ksize = 0;
+        double dx = 0.0;
+        vmath::vec3 offset;
+        vmath::vec3 jitter;
+        int numGroups = 1;
+        std::vector<int> triangleGroups;
+        std::vector<int> columnStart;
+        std::vector<int> columnTriangles;
+    };
+
+    const int _columnBatchSize = 64;
+
+    void getGridNodesInsideTriangleMesh(TriangleMesh &mesh, double dx, 
+                                        Array3d<bool> &nodes, bool computeSingleThreaded = false);
+
+    void getGridNodesInsideTriangleMesh(TriangleMesh &mesh, vmath::vec3 offset, double dx, 
                                         Array3d<bool> &nodes, bool computeSingleThreaded = false);
 
+    int _getTriangleParityGroups(TriangleMesh &mesh, vmath::vec3 offset, AABB bbox, 
+                                 std::vector<int> &triangleGroups);
+
+    int _findIslandRoot(std::vector<int> &parent, int idx);
+
+    void _getColumnTriangleBounds(TriangleMesh &mesh, int tidx, ColumnTriangleData &data,
+                                  int *imin, int *jmin, int *imax, int *jmax);
+
+    void _getColumnTriangleData(TriangleMesh &mesh, ColumnTriangleData &data);
+
+    void _getGridNodesInsideTriangleMeshThread(std::atomic<int> *nextColumn,
+                                               TriangleMesh *mesh, 
+                                               ColumnTriangleData *data,
+                                               Array3d<bool> *nodes);
+
     void getGridNodesInsideTriangleMesh(TriangleMesh mesh, double dx, 
                                         std::vector<GridIndex> &nodes, bool computeSingleThreaded = false);
 
-    void _splitInsideOutsideMesh(TriangleMesh &mesh, AABB bbox, 
-                                 TriangleMesh &insideMesh, 
-                                 std::vector<TriangleMesh> &outsideMeshes);
-
     void _splitIntoMeshIslands(TriangleMesh &mesh, 
                                std::vector<TriangleMesh> &islands,
                                std::vector<int> &vertexToGroupID,
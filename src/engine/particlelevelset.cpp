@@ -32,7 +32,6 @@ SOFTWARE.
 #include "markerparticle.h"
 #include "grid3d.h"
 #include "meshlevelset.h"
-#include "scalarfield.h"
 #include "levelsetsolver.h"
 
 
@@ -41,7 +40,7 @@ ParticleLevelSet::ParticleLevelSet() {
 
 ParticleLevelSet::ParticleLevelSet(int i, int j, int k, double dx) : 
                     _isize(i), _jsize(j), _ksize(k), _dx(dx) {
-    _phi = Array3d<float>(i, j, k, _getMaxDistance());
+    _phi = Array3d<StorageFloat>(i, j, k, _getMaxDistance());
 }
 
 ParticleLevelSet::~ParticleLevelSet() {
@@ -193,107 +192,122 @@ void ParticleLevelSet::postProcessSignedDistanceField(MeshLevelSet &solidPhi) {
     }
 }
 
+/*
+    Curvature is only needed near the liquid surface, so the computation is
+    restricted to the blocks of the grid that intersect the surface band.
+    The resulting curvature grid is sparse: only blocks within reach of the
+    band (including extrapolation layers) are allocated and all other
+    lookups return zero.
+*/
 void ParticleLevelSet::calculateCurvatureGrid(Array3d<float> &surfacePhi, 
-                                              Array3d<float> &kgrid) {
+                                              BlockArray3d<float> &kgrid) {
 
     FLUIDSIM_ASSERT(surfacePhi.width == _isize && 
                     surfacePhi.height == _jsize && 
                     surfacePhi.depth == _ksize);
-    FLUIDSIM_ASSERT(kgrid.width == _isize && 
-                    kgrid.height == _jsize && 
-                    kgrid.depth == _ksize);
 
-    float maxSurfaceCellDist = 2.0f * _dx;
-    Array3d<bool> validNodes(_isize, _jsize, _ksize, false);
-    for (int k = 0; k < _ksize; k++) {
-        for (int j = 0; j < _jsize; j++) {
-            for (int i = 0; i < _isize; i++) {
-                if (std::abs(_phi(i, j, k)) < maxSurfaceCellDist) {
-                    validNodes.set(i, j, k, true);
+    int blockWidth = 2 * _curvatureGridExactBand;
+    std::vector<GridIndex> solverBlocks;
+    _getCurvatureSolverBlocks(blockWidth, solverBlocks);
+
+    std::vector<GridIndex> solverGridCells;
+    solverGridCells.reserve(solverBlocks.size() * blockWidth * blockWidth * blockWidth);
+    for (size_t bidx = 0; bidx < solverBlocks.size(); bidx++) {
+        GridIndex b = solverBlocks[bidx];
+        int imax = std::min((b.i + 1) * blockWidth, _isize);
+        int jmax = std::min((b.j + 1) * blockWidth, _jsize);
+        int kmax = std::min((b.k + 1) * blockWidth, _ksize);
+        for (int k = b.k * blockWidth; k < kmax; k++) {
+            for (int j = b.j * blockWidth; j < jmax; j++) {
+                for (int i = b.i * blockWidth; i < imax; i++) {
+                    solverGridCells.push_back(GridIndex(i, j, k));
                 }
             }
         }
     }
 
-    int blockWidth = 2 * _curvatureGridExactBand;
+    float width = _curvatureGridExactBand * _dx;
+    LevelSetSolver solver;
+    solver.reinitializeUpwind(_phi, _dx, width, solverGridCells, surfacePhi);
+
     int bisize = (_isize + blockWidth - 1) / blockWidth;
     int bjsize = (_jsize + blockWidth - 1) / blockWidth;
     int bksize = (_ksize + blockWidth - 1) / blockWidth;
-    Array3d<bool> validBlocks(bisize, bjsize, bksize, false);
+    Array3d<bool> isSolverBlock(bisize, bjsize, bksize, false);
+    isSolverBlock.set(solverBlocks, true);
 
+    float outOfRangeDist = _outOfRangeDistance * _dx;
+    float *rawSurfacePhi = surfacePhi.getRawArray();
     for (int k = 0; k < _ksize; k++) {
         for (int j = 0; j < _jsize; j++) {
-            for (int i = 0; i < _isize; i++) {
-                if (validNodes(i, j, k)) {
-                    validBlocks.set(i / blockWidth, j / blockWidth, k / blockWidth, true);
+            int rowOffset = _isize * (j + _jsize * k);
+            for (int bi = 0; bi < bisize; bi++) {
+                if (isSolverBlock(bi, j / blockWidth, k / blockWidth)) {
+                    continue;
                 }
-            }
-        }
-    }
-    GridUtils::featherGrid6(&validBlocks, ThreadUtils::getMaxThreadCount());
 
-    int numValid = 0;
-    for (int k = 0; k < _ksize; k++) {
-        for (int j = 0; j < _jsize; j++) {
-            for (int i = 0; i < _isize; i++) {
-                int bi = i / blockWidth;
-                int bj = j / blockWidth;
-                int bk = k / blockWidth;
-                if (validBlocks(bi, bj, bk)) {
-                    validNodes.set(i, j, k, true);
-                    numValid++;
+                int imax = std::min((bi + 1) * blockWidth, _isize);
+                for (int i = bi * blockWidth; i < imax; i++) {
+                    rawSurfacePhi[rowOffset + i] = outOfRangeDist;
                 }
             }
         }
     }
 
-    std::vector<GridIndex> solverGridCells(numValid);
-    for (int k = 0; k < _ksize; k++) {
-        for (int j = 0; j < _jsize; j++) {
-            for (int i = 0; i < _isize; i++) {
-                if (validNodes(i, j, k)) {
-                    solverGridCells.push_back(GridIndex(i, j, k));
-                }
-            }
-        }
-    }
+    std::vector<GridIndex> validCells;
+    _getValidCurvatureCells(surfacePhi, solverBlocks, blockWidth, validCells);
 
-    float width = _curvatureGridExactBand * _dx;
-    LevelSetSolver solver;
-    solver.reinitializeUpwind(_phi, _dx, width, solverGridCells, surfacePhi);
+    Array3d<bool> isCurvatureBlock = isSolverBlock;
+    GridUtils::featherGrid26(&isCurvatureBlock, ThreadUtils::getMaxThreadCount());
 
-    float outOfRangeDist = _outOfRangeDistance * _dx;
-    for (int k = 0; k < _ksize; k++) {
-        for (int j = 0; j < _jsize; j++) {
-            for (int i = 0; i < _isize; i++) {
-                if (!validNodes(i, j, k)) {
-                    surfacePhi.set(i, j, k, outOfRangeDist);
+    BlockArray3dParameters params;
+    params.isize = _isize;
+    params.jsize = _jsize;
+    params.ksize = _ksize;
+    params.blockwidth = blockWidth;
+    for (int k = 0; k < bksize; k++) {
+        for (int j = 0; j < bjsize; j++) {
+            for (int i = 0; i < bisize; i++) {
+                if (isCurvatureBlock(i, j, k)) {
+                    params.activeblocks.push_back(GridIndex(i, j, k));
                 }
             }
         }
     }
 
-    validNodes.fill(false);
-    _getValidCurvatureNodes(surfacePhi, validNodes);
-
+    kgrid = BlockArray3d<float>(params);
+    kgrid.setBackgroundValue(0.0f);
     kgrid.fill(0.0f);
-    for (int k = 0; k < _ksize; k++) {
-        for (int j = 0; j < _jsize; j++) {
-            for (int i = 0; i < _isize; i++) {
-                if (validNodes(i, j, k)) {
-                    kgrid.set(i, j, k, _getCurvature(i, j, k, surfacePhi));
-                }
-            }
-        }
+
+    size_t numCPU = ThreadUtils::getMaxThreadCount();
+    int numthreads = (int)std::min(numCPU, validCells.size());
+    std::vector<std::thread> threads(numthreads);
+    std::vector<int> intervals = ThreadUtils::splitRangeIntoIntervals(0, validCells.size(), numthreads);
+    for (int i = 0; i < numthreads; i++) {
+        threads[i] = std::thread(&ParticleLevelSet::_calculateCurvatureThread, this,
+                                 intervals[i], intervals[i + 1], &validCells, &surfacePhi, &kgrid);
     }
 
-    GridUtils::extrapolateGrid(&kgrid, &validNodes, _curvatureGridExtrapolationLayers);
+    for (int i = 0; i < numthreads; i++) {
+        threads[i].join();
+    }
+
+    _extrapolateCurvatureGrid(validCells, params, kgrid);
 }
 
-Array3d<float>* ParticleLevelSet::getPhiGrid() {
+Array3d<StorageFloat>* ParticleLevelSet::getPhiGrid() {
     return &_phi;
 }
 
+/*
+    Maximum absolute difference between the exact band distances computed
+    in single precision and the values held in the phi grid storage. Only
+    non-zero when grids are stored in half precision.
+*/
+float ParticleLevelSet::getMaxStorageError() {
+    return _maxStorageError;
+}
+
 void ParticleLevelSet::getGridDimensions(int *i, int *j, int *k) {
     _phi.getGridDimensions(i, j, k);
 }
@@ -309,7 +323,7 @@ bool ParticleLevelSet::isDimensionsValidForCoarseGridGeneration() {
 void ParticleLevelSet::generateCoarseGrid(ParticleLevelSet &coarseGrid) {
     FLUIDSIM_ASSERT(isDimensionsValidForCoarseGridGeneration());
 
-    Array3d<float> *coarsePhi = coarseGrid.getPhiGrid();
+    Array3d<StorageFloat> *coarsePhi = coarseGrid.getPhiGrid();
     FLUIDSIM_ASSERT(_phi.isMatchingDimensionsForCoarseGrid(*coarsePhi));
 
     _phi.generateCoarseGrid(*coarsePhi);
@@ -335,6 +349,7 @@ float ParticleLevelSet::_getMaxDistance() {
 void ParticleLevelSet::_computeSignedDistanceFromParticles(std::vector<vmath::vec3> &particles, 
                                                            double radius) {
     _phi.fill(_getMaxDistance());
+    _maxStorageError = 0.0f;
 
     if (particles.empty()) {
         return;
@@ -395,7 +410,12 @@ void ParticleLevelSet::_computeSignedDistanceFromParticles(std::vector<vmath::ve
                                              localidx.j + gridOffset.j,
                                              localidx.k + gridOffset.k);
                 if (_phi.isIndexInRange(phiidx)) {
-                    _phi.set(phiidx, block.gridBlock.data[vidx]);
+                    float d = block.gridBlock.data[vidx];
+                    _phi.set(phiidx, d);
+                    #if WITH_HALF_PRECISION_GRIDS
+                    float err = fabs((float)_phi(phiidx) - d);
+                    _maxStorageError = fmax(_maxStorageError, err);
+                    #endif
                 }
             }
         }
@@ -665,63 +685,154 @@ void ParticleLevelSet::_computeExactBandProducerThread(BoundedBuffer<ComputeBloc
     }
 }
 
-void ParticleLevelSet::_initializeCurvatureGridScalarField(ScalarField &field) {
-    size_t gridsize = (_isize + 1) * (_jsize + 1) * (_ksize + 1);
-    size_t numCPU = ThreadUtils::getMaxThreadCount();
-    int numthreads = (int)std::min(numCPU, gridsize);
-    std::vector<std::thread> threads(numthreads);
-    std::vector<int> intervals = ThreadUtils::splitRangeIntoIntervals(0, gridsize, numthreads);
-    for (int i = 0; i < numthreads; i++) {
-        threads[i] = std::thread(&ParticleLevelSet::_initializeCurvatureGridScalarFieldThread, this,
-                                 intervals[i], intervals[i + 1], &field);
-    }
+void ParticleLevelSet::_getCurvatureSolverBlocks(int blockWidth, std::vector<GridIndex> &blocks) {
+    int bisize = (_isize + blockWidth - 1) / blockWidth;
+    int bjsize = (_jsize + blockWidth - 1) / blockWidth;
+    int bksize = (_ksize + blockWidth - 1) / blockWidth;
+    Array3d<bool> validBlocks(bisize, bjsize, bksize, false);
 
-    for (int i = 0; i < numthreads; i++) {
-        threads[i].join();
+    float maxSurfaceCellDist = 2.0f * _dx;
+    StorageFloat *rawphi = _phi.getRawArray();
+    for (int k = 0; k < _ksize; k++) {
+        for (int j = 0; j < _jsize; j++) {
+            int rowOffset = _isize * (j + _jsize * k);
+            for (int i = 0; i < _isize; i++) {
+                if (std::abs((float)rawphi[rowOffset + i]) < maxSurfaceCellDist) {
+                    validBlocks.set(i / blockWidth, j / blockWidth, k / blockWidth, true);
+                }
+            }
+        }
     }
-}
+    GridUtils::featherGrid6(&validBlocks, ThreadUtils::getMaxThreadCount());
 
-void ParticleLevelSet::_initializeCurvatureGridScalarFieldThread(int startidx, int endidx, 
-                                                                 ScalarField *field) {
-    for (int idx = startidx; idx < endidx; idx++) {
-        GridIndex g = Grid3d::getUnflattenedIndex(idx, _isize + 1, _jsize + 1);
-        field->setScalarFieldValue(g, -getDistanceAtNode(g));
+    for (int k = 0; k < bksize; k++) {
+        for (int j = 0; j < bjsize; j++) {
+            for (int i = 0; i < bisize; i++) {
+                if (validBlocks(i, j, k)) {
+                    blocks.push_back(GridIndex(i, j, k));
+                }
+            }
+        }
     }
 }
 
-void ParticleLevelSet::_getValidCurvatureNodes(Array3d<float> &surfacePhi, 
-                                               Array3d<bool> &validNodes) {
+void ParticleLevelSet::_getValidCurvatureCells(Array3d<float> &surfacePhi, 
+                                               std::vector<GridIndex> &solverBlocks,
+                                               int blockWidth,
+                                               std::vector<GridIndex> &cells) {
 
+    // Nodes outside of the solver blocks hold the out of range distance
+    // and can never be within the valid distance bound
     float distUpperBound = (_curvatureGridExactBand - 1) * _dx;
-    Array3d<bool> tempValid(_isize, _jsize, _ksize, false);
+    for (size_t bidx = 0; bidx < solverBlocks.size(); bidx++) {
+        GridIndex b = solverBlocks[bidx];
+        int imin = std::max(b.i * blockWidth, 1);
+        int jmin = std::max(b.j * blockWidth, 1);
+        int kmin = std::max(b.k * blockWidth, 1);
+        int imax = std::min((b.i + 1) * blockWidth, _isize - 1);
+        int jmax = std::min((b.j + 1) * blockWidth, _jsize - 1);
+        int kmax = std::min((b.k + 1) * blockWidth, _ksize - 1);
+        for (int k = kmin; k < kmax; k++) {
+            for (int j = jmin; j < jmax; j++) {
+                for (int i = imin; i < imax; i++) {
+                    bool isValid = std::abs(surfacePhi(i, j, k)) < distUpperBound &&
+                                   std::abs(surfacePhi(i + 1, j, k)) < distUpperBound &&
+                                   std::abs(surfacePhi(i - 1, j, k)) < distUpperBound &&
+                                   std::abs(surfacePhi(i, j + 1, k)) < distUpperBound &&
+                                   std::abs(surfacePhi(i, j - 1, k)) < distUpperBound &&
+                                   std::abs(surfacePhi(i, j, k + 1)) < distUpperBound &&
+                                   std::abs(surfacePhi(i, j, k - 1)) < distUpperBound;
+                    if (isValid) {
+                        cells.push_back(GridIndex(i, j, k));
+                    }
+                }
+            }
+        }
+    }
+}
+
+void ParticleLevelSet::_calculateCurvatureThread(int startidx, int endidx, 
+                                                 std::vector<GridIndex> *cells,
+                                                 Array3d<float> *surfacePhi,
+                                                 BlockArray3d<float> *kgrid) {
+    for (int idx = startidx; idx < endidx; idx++) {
+        GridIndex g = cells->at(idx);
+        kgrid->set(g, _getCurvature(g.i, g.j, g.k, *surfacePhi));
+    }
+}
 
-    float *rawphi = surfacePhi.getRawArray();
-    int size = surfacePhi.getNumElements();
-    for (int i = 0; i < size; i++) {
-        if (std::abs(rawphi[i]) < distUpperBound) {
-            tempValid.set(i, true);
+/*
+    Sparse equivalent of GridUtils::extrapolateGrid. Each layer sets
+    unknown neighbours of the current front to the average of their known
+    neighbours. Border nodes are treated as known, as in the dense version.
+*/
+void ParticleLevelSet::_extrapolateCurvatureGrid(std::vector<GridIndex> &validCells,
+                                                 BlockArray3dParameters &params,
+                                                 BlockArray3d<float> &kgrid) {
+    char UNKNOWN = 0x00;
+    char WAITING = 0x01;
+    char DONE = 0x03;
+    char INACTIVE = 0x04;
+
+    BlockArray3d<char> status(params);
+    status.setBackgroundValue(INACTIVE);
+    status.fill(UNKNOWN);
+    for (size_t bidx = 0; bidx < params.activeblocks.size(); bidx++) {
+        GridIndex b = params.activeblocks[bidx];
+        int imax = std::min((b.i + 1) * params.blockwidth, _isize);
+        int jmax = std::min((b.j + 1) * params.blockwidth, _jsize);
+        int kmax = std::min((b.k + 1) * params.blockwidth, _ksize);
+        for (int k = b.k * params.blockwidth; k < kmax; k++) {
+            for (int j = b.j * params.blockwidth; j < jmax; j++) {
+                for (int i = b.i * params.blockwidth; i < imax; i++) {
+                    if (Grid3d::isGridIndexOnBorder(i, j, k, _isize, _jsize, _ksize)) {
+                        status.set(i, j, k, DONE);
+                    }
+                }
+            }
         }
     }
 
-    validNodes.fill(false);
-    for (int k = 1; k < _ksize - 1; k++) {
-        for (int j = 1; j < _jsize - 1; j++) {
-            for (int i = 1; i < _isize - 1; i++) {
-                if (!tempValid(i, j, k)) {
-                    continue;
+    for (size_t i = 0; i < validCells.size(); i++) {
+        status.set(validCells[i], DONE);
+    }
+
+    GridIndex nbs[6];
+    std::vector<GridIndex> front = validCells;
+    std::vector<GridIndex> layerCells;
+    std::vector<float> layerValues;
+    for (int layer = 0; layer < _curvatureGridExtrapolationLayers; layer++) {
+        layerCells.clear();
+        for (size_t fidx = 0; fidx < front.size(); fidx++) {
+            Grid3d::getNeighbourGridIndices6(front[fidx], nbs);
+            for (int nidx = 0; nidx < 6; nidx++) {
+                if (status(nbs[nidx]) == UNKNOWN) {
+                    status.set(nbs[nidx], WAITING);
+                    layerCells.push_back(nbs[nidx]);
                 }
+            }
+        }
 
-                bool isValid = tempValid(i + 1, j, k) &&
-                               tempValid(i - 1, j, k) &&
-                               tempValid(i, j + 1, k) &&
-                               tempValid(i, j - 1, k) &&
-                               tempValid(i, j, k + 1) &&
-                               tempValid(i, j, k - 1);
-                if (isValid) {
-                    validNodes.set(i, j, k, true);
+        layerValues.assign(layerCells.size(), 0.0f);
+        for (size_t cidx = 0; cidx < layerCells.size(); cidx++) {
+            Grid3d::getNeighbourGridIndices6(layerCells[cidx], nbs);
+            float sum = 0.0f;
+            int count = 0;
+            for (int nidx = 0; nidx < 6; nidx++) {
+                if (status(nbs[nidx]) == DONE) {
+                    sum += kgrid(nbs[nidx]);
+                    count++;
                 }
             }
+            layerValues[cidx] = sum / (float)count;
         }
+
+        for (size_t cidx = 0; cidx < layerCells.size(); cidx++) {
+            kgrid.set(layerCells[cidx], layerValues[cidx]);
+            status.set(layerCells[cidx], DONE);
+        }
+
+        front.swap(layerCells);
     }
 }
 
@@ -38,7 +38,6 @@ SOFTWARE.
 #include "particlesystem.h"
 
 class MeshLevelSet;
-class ScalarField;
 struct MarkerParticle;
 
 class ParticleLevelSet {
@@ -66,9 +65,10 @@ public:
     void calculateSignedDistanceField(ParticleSystem &particles, 
                                       double radius);
     void postProcessSignedDistanceField(MeshLevelSet &solidPhi);
-    void calculateCurvatureGrid(Array3d<float> &surfacePhi, Array3d<float> &kgrid);
+    void calculateCurvatureGrid(Array3d<float> &surfacePhi, BlockArray3d<float> &kgrid);
 
-    Array3d<float>* getPhiGrid();
+    Array3d<StorageFloat>* getPhiGrid();
+    float getMaxStorageError();
     void getGridDimensions(int *i, int *j, int *k);
     void getCoarseGridDimensions(int *i, int *j, int *k);
     bool isDimensionsValidForCoarseGridGeneration();
@@ -128,17 +128,26 @@ private:
     void _computeExactBandProducerThread(BoundedBuffer<ComputeBlock> *computeBlockQueue,
                                          BoundedBuffer<ComputeBlock> *finishedComputeBlockQueue);
 
-    void _initializeCurvatureGridScalarField(ScalarField &field);
-    void _initializeCurvatureGridScalarFieldThread(int startidx, int endidx, 
-                                                   ScalarField *field);
-    void _getValidCurvatureNodes(Array3d<float> &surfacePhi, Array3d<bool> &validNodes);
+    void _getCurvatureSolverBlocks(int blockWidth, std::vector<GridIndex> &blocks);
+    void _getValidCurvatureCells(Array3d<float> &surfacePhi, 
+                                 std::vector<GridIndex> &solverBlocks,
+                                 int blockWidth,
+                                 std::vector<GridIndex> &cells);
+    void _calculateCurvatureThread(int startidx, int endidx, 
+                                   std::vector<GridIndex> *cells,
+                                   Array3d<float> *surfacePhi,
+                                   BlockArray3d<float> *kgrid);
+    void _extrapolateCurvatureGrid(std::vector<GridIndex> &validCells,
+                                   BlockArray3dParameters &params,
+                                   BlockArray3d<float> &kgrid);
     float _getCurvature(int i, int j, int k, Array3d<float> &phi);
     
     int _isize = 0;
     int _jsize = 0;
     int _ksize = 0;
     double _dx = 0.0;
-    Array3d<float> _phi;
+    Array3d<StorageFloat> _phi;
+    float _maxStorageError = 0.0f;
 
     int _curvatureGridExactBand = 3;
     int _curvatureGridExtrapolationLayers = 3;
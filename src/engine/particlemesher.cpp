@@ -24,37 +24,123 @@ SOFTWARE.
 
 #include "particlemesher.h"
 
+#include <cstring>
+#include <limits>
+#include <algorithm>
+
 #include "trianglemesh.h"
 #include "polygonizer3d.h"
 #include "threadutils.h"
 #include "gridutils.h"
+#include "meshlevelset.h"
+#include "spatialpointgrid.h"
+#include "aabb.h"
 
 
 ParticleMesher::ParticleMesher() {
 }
 
 TriangleMesh ParticleMesher::meshParticles(ParticleMesherParameters params) {
-    _initialize(params);
-
-    MesherComputeChunkData data;
-    _generateComputeChunkData(data);
+    initializeComputeChunks(params);
     
     double scale = _localdx / _subdx;
     vmath::vec3 scaleVect(scale, scale, scale);
     vmath::vec3 invscaleVect(1.0/scale, 1.0/scale, 1.0/scale);
 
+    // Chunks are appended and only the vertices on chunk seams are welded
+    // once all chunks have been polygonized
     TriangleMesh mesh;
-    for (size_t i = 0; i < data.computeChunks.size(); i++) {
-        MesherComputeChunk c = data.computeChunks[i];
-        TriangleMesh chunkMesh = _polygonizeComputeChunk(c, data);
+    TriangleMesh chunkMesh;
+    std::vector<bool> isSeamVertex;
+    std::vector<bool> isChunkSeamVertex;
+    while (meshNextComputeChunk(chunkMesh)) {
+        getComputeChunkSeamVertices(chunkMesh, isChunkSeamVertex);
+        isSeamVertex.insert(isSeamVertex.end(), isChunkSeamVertex.begin(), isChunkSeamVertex.end());
+
         chunkMesh.scale(scaleVect);
-        mesh.join(chunkMesh);
+        mesh.append(chunkMesh);
     }
+
+    double weldTolerance = 10e-5;
+    mesh.weldVertices(weldTolerance, isSeamVertex);
     mesh.scale(invscaleVect);
 
     return mesh;
 }
 
+void ParticleMesher::initializeComputeChunks(ParticleMesherParameters params) {
+    _initialize(params);
+
+    _computeChunkData = MesherComputeChunkData();
+    _generateComputeChunkData(_computeChunkData);
+    _currentComputeChunkIndex = -1;
+
+    if (_cache != nullptr) {
+        _initializeCache();
+        if (getNumComputeChunks() == 0) {
+            _commitCache();
+        }
+    }
+}
+
+int ParticleMesher::getNumComputeChunks() {
+    return (int)_computeChunkData.computeChunks.size();
+}
+
+bool ParticleMesher::meshNextComputeChunk(TriangleMesh &mesh) {
+    int nextidx = _currentComputeChunkIndex + 1;
+    if (nextidx >= getNumComputeChunks()) {
+        mesh = TriangleMesh();
+        return false;
+    }
+
+    _currentComputeChunkIndex = nextidx;
+    MesherComputeChunk c = _computeChunkData.computeChunks[nextidx];
+    mesh = _polygonizeComputeChunk(c, _computeChunkData);
+
+    if (_cache != nullptr && nextidx == getNumComputeChunks() - 1) {
+        _commitCache();
+    }
+
+    return true;
+}
+
+void ParticleMesher::getComputeChunkSeamVertices(TriangleMesh &mesh, 
+                                                 std::vector<bool> &isSeamVertex) {
+    isSeamVertex = std::vector<bool>(mesh.vertices.size(), false);
+
+    int cidx = _currentComputeChunkIndex;
+    if (cidx < 0 || cidx >= getNumComputeChunks()) {
+        return;
+    }
+
+    MesherComputeChunk c = _computeChunkData.computeChunks[cidx];
+    int dir = 0;
+    if (c.splitDirection == Direction::V) {
+        dir = 1;
+    } else if (c.splitDirection == Direction::W) {
+        dir = 2;
+    }
+
+    // The last node plane of a chunk is shared with the first node plane
+    // of the next chunk
+    vmath::vec3 maxpos = Grid3d::GridIndexToPosition(c.maxGridIndex.i - 1, 
+                                                     c.maxGridIndex.j - 1, 
+                                                     c.maxGridIndex.k - 1, 
+                                                     _subdx);
+    bool hasMinSeam = cidx > 0;
+    bool hasMaxSeam = cidx < getNumComputeChunks() - 1;
+    float minseam = c.positionOffset[dir];
+    float maxseam = maxpos[dir];
+    float eps = 0.01f * (float)_subdx;
+    for (size_t i = 0; i < mesh.vertices.size(); i++) {
+        float v = mesh.vertices[i][dir];
+        if ((hasMinSeam && fabs(v - minseam) < eps) || (hasMaxSeam && fabs(v - maxseam) < eps)) {
+            isSeamVertex[i] = true;
+        }
+    }
+}
+
 TriangleMesh ParticleMesher::getPreviewMesh() {
     if (!_isPreviewMesherEnabled) {
         return TriangleMesh();
@@ -84,12 +170,19 @@ void ParticleMesher::_initialize(ParticleMesherParameters params) {
 
     _particles = params.particles;
     _solidSDF = params.solidSDF;
+    _cache = params.cache;
 
     _subisize = _isize * _subdivisions + 1;
     _subjsize = _jsize * _subdivisions + 1;
     _subksize = _ksize * _subdivisions + 1;
     _subdx = _dx / (double)_subdivisions;
 
+    _isAnisotropicKernelEnabled = params.isAnisotropicKernelEnabled;
+    if (_isAnisotropicKernelEnabled) {
+        _computeAnisotropicKernels();
+        _particles = &_kernelCenters;
+    }
+
     _initializeSeamData();
 }
 
@@ -111,6 +204,297 @@ void ParticleMesher::_initializeSeamData() {
     _seamData.reset();
 }
 
+void ParticleMesher::_computeAnisotropicKernels() {
+    // Particles keep a spherical kernel unless a neighbourhood is fitted
+    _kernelCenters = *_particles;
+    _kernelTransforms = std::vector<vmath::mat3>(_particles->size());
+    if (_particles->empty()) {
+        return;
+    }
+
+    SpatialPointGrid grid(_isize, _jsize, _ksize, _dx);
+    grid.insert(*_particles);
+
+    Array3d<bool> isCellOccupied(_isize, _jsize, _ksize, false);
+    for (size_t i = 0; i < _particles->size(); i++) {
+        GridIndex g = Grid3d::positionToGridIndex(_particles->at(i), _dx);
+        if (isCellOccupied.isIndexInRange(g)) {
+            isCellOccupied.set(g, true);
+        }
+    }
+
+    // Particles are processed per grid cell so that the neighbour candidates
+    // are only gathered once for all particles in the cell
+    int numCells = _isize * _jsize * _ksize;
+    int numCPU = ThreadUtils::getMaxThreadCount();
+    int numthreads = (int)fmin(numCPU, numCells);
+    std::vector<std::thread> threads(numthreads);
+    std::vector<int> intervals = ThreadUtils::splitRangeIntoIntervals(0, numCells, numthreads);
+    for (int i = 0; i < numthreads; i++) {
+        threads[i] = std::thread(&ParticleMesher::_computeAnisotropicKernelsThread, this,
+                                 intervals[i], intervals[i + 1], &grid, &isCellOccupied);
+    }
+
+    for (int i = 0; i < numthreads; i++) {
+        threads[i].join();
+    }
+}
+
+bool ParticleMesher::_isAnisotropicKernelCellInterior(GridIndex g, int width, 
+                                                      Array3d<bool> *isCellOccupied) {
+    // A cell is interior when every cell that can hold one of its particles'
+    // neighbours is occupied
+    for (int k = g.k - width; k <= g.k + width; k++) {
+        for (int j = g.j - width; j <= g.j + width; j++) {
+            for (int i = g.i - width; i <= g.i + width; i++) {
+                if (!isCellOccupied->isIndexInRange(i, j, k) || !isCellOccupied->get(i, j, k)) {
+                    return false;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+void ParticleMesher::_computeAnisotropicKernelsThread(int startidx, int endidx, 
+                                                      SpatialPointGrid *grid,
+                                                      Array3d<bool> *isCellOccupied) {
+    // Kernels are fitted to the weighted covariance of the particle 
+    // neighbourhood. See "Reconstructing Surfaces of Particle-Based Fluids
+    // Using Anisotropic Kernels" by Yu and Turk.
+    float h = (float)(_anisotropicNeighbourRadiusFactor * _dx);
+    float invhsq = 1.0f / (h * h);
+    double maxStretch = _searchRadiusFactor;
+    double minAxis = std::min(_minAnisotropicAxisWidth * _subdx / _radius, 1.0);
+    double lambda = _anisotropicSmoothingFactor;
+
+    // Particles deep inside the fluid do not affect the surface and keep
+    // their spherical kernels
+    int neighbourCellWidth = (int)ceil(_anisotropicNeighbourRadiusFactor);
+
+    std::vector<GridPointReference> refs;
+    std::vector<int> cellParticles;
+    std::vector<int> neighbours;
+    std::vector<float> cx, cy, cz, weights;
+    for (int cidx = startidx; cidx < endidx; cidx++) {
+        GridIndex g = Grid3d::getUnflattenedIndex(cidx, _isize, _jsize);
+        if (!isCellOccupied->get(g) || 
+                _isAnisotropicKernelCellInterior(g, neighbourCellWidth, isCellOccupied)) {
+            continue;
+        }
+
+        AABB cellbbox(g, _dx);
+        cellbbox.expand(2.0 * h);
+
+        refs.clear();
+        grid->queryPointReferencesInsideAABB(cellbbox, refs);
+
+        cellParticles.clear();
+        cx.resize(refs.size());
+        cy.resize(refs.size());
+        cz.resize(refs.size());
+        weights.resize(refs.size());
+        neighbours.resize(refs.size());
+        for (size_t i = 0; i < refs.size(); i++) {
+            vmath::vec3 q = _particles->at(refs[i].id);
+            cx[i] = q.x;
+            cy[i] = q.y;
+            cz[i] = q.z;
+            if (Grid3d::positionToGridIndex(q, _dx) == g) {
+                cellParticles.push_back(refs[i].id);
+            }
+        }
+
+        int numCandidates = (int)refs.size();
+        for (size_t cpidx = 0; cpidx < cellParticles.size(); cpidx++) {
+            int pidx = cellParticles[cpidx];
+            vmath::vec3 p = _particles->at(pidx);
+
+            // Weights fall off as (1 - d^2/h^2)^3 so that no square root is
+            // needed. The particle is its own neighbour with a weight of 1.
+            for (int i = 0; i < numCandidates; i++) {
+                float vx = cx[i] - p.x;
+                float vy = cy[i] - p.y;
+                float vz = cz[i] - p.z;
+                weights[i] = 1.0f - (vx * vx + vy * vy + vz * vz) * invhsq;
+            }
+
+            // Branch free compaction of the candidates inside the radius
+            int numNeighbours = 0;
+            for (int i = 0; i < numCandidates; i++) {
+                neighbours[numNeighbours] = i;
+                numNeighbours += weights[i] > 0.0f ? 1 : 0;
+            }
+
+            if (numNeighbours - 1 < _minAnisotropicNeighbours) {
+                continue;
+            }
+
+            double weightSum = 0.0;
+            double mean[3] = {0.0, 0.0, 0.0};
+            for (int nidx = 0; nidx < numNeighbours; nidx++) {
+                int i = neighbours[nidx];
+                float t = weights[i];
+                weights[i] = t * t * t;
+                weightSum += weights[i];
+                mean[0] += weights[i] * cx[i];
+                mean[1] += weights[i] * cy[i];
+                mean[2] += weights[i] * cz[i];
+            }
+
+            for (int i = 0; i < 3; i++) {
+                mean[i] /= weightSum;
+            }
+
+            double C[3][3] = {{0.0, 0.0, 0.0}, {0.0, 0.0, 0.0}, {0.0, 0.0, 0.0}};
+            for (int nidx = 0; nidx < numNeighbours; nidx++) {
+                int i = neighbours[nidx];
+                double w = weights[i];
+                double vx = cx[i] - mean[0];
+                double vy = cy[i] - mean[1];
+                double vz = cz[i] - mean[2];
+                C[0][0] += w * vx * vx;
+                C[0][1] += w * vx * vy;
+                C[0][2] += w * vx * vz;
+                C[1][1] += w * vy * vy;
+                C[1][2] += w * vy * vz;
+                C[2][2] += w * vz * vz;
+            }
+
+            C[1][0] = C[0][1];
+            C[2][0] = C[0][2];
+            C[2][1] = C[1][2];
+            for (int r = 0; r < 3; r++) {
+                for (int c = 0; c < 3; c++) {
+                    C[r][c] /= weightSum;
+                }
+            }
+
+            double eigenvalues[3];
+            double eigenvectors[3][3];
+            _computeSymmetricEigenDecomposition(C, eigenvalues, eigenvectors);
+            if (eigenvalues[0] <= 0.0) {
+                continue;
+            }
+
+            // Axis lengths are proportional to the clamped eigenvalues and are 
+            // normalized to preserve the kernel volume. Axes are not stretched
+            // beyond the search radius so that kernels stay within the blocks 
+            // that their particle was sorted into, and are not flattened below
+            // what the mesher grid can resolve so that thin sheets do not 
+            // break up.
+            double axis[3];
+            for (int i = 0; i < 3; i++) {
+                axis[i] = std::max(eigenvalues[i], eigenvalues[0] / _maxAnisotropicAxisRatio);
+            }
+
+            double volumeScale = cbrt(axis[0] * axis[1] * axis[2]);
+            for (int i = 0; i < 3; i++) {
+                axis[i] = std::min(axis[i] / volumeScale, maxStretch);
+                axis[i] = std::max(axis[i], minAxis);
+            }
+
+            vmath::mat3 G(0.0f);
+            for (int r = 0; r < 3; r++) {
+                for (int c = 0; c < 3; c++) {
+                    double gval = 0.0;
+                    for (int i = 0; i < 3; i++) {
+                        gval += eigenvectors[r][i] * eigenvectors[c][i] / axis[i];
+                    }
+                    G.m[3 * c + r] = (float)gval;
+                }
+            }
+
+            _kernelTransforms[pidx] = G;
+            _kernelCenters[pidx] = vmath::vec3((1.0 - lambda) * p.x + lambda * mean[0],
+                                               (1.0 - lambda) * p.y + lambda * mean[1],
+                                               (1.0 - lambda) * p.z + lambda * mean[2]);
+        }
+    }
+}
+
+void ParticleMesher::_computeSymmetricEigenDecomposition(double A[3][3], 
+                                                         double eigenvalues[3], 
+                                                         double eigenvectors[3][3]) {
+    // Cyclic Jacobi rotations. Eigenvectors are stored as columns and are
+    // sorted by decreasing eigenvalue.
+    double a[3][3];
+    for (int r = 0; r < 3; r++) {
+        for (int c = 0; c < 3; c++) {
+            a[r][c] = A[r][c];
+            eigenvectors[r][c] = r == c ? 1.0 : 0.0;
+        }
+    }
+
+    int maxSweeps = 32;
+    double eps = 1e-24;
+    for (int sweep = 0; sweep < maxSweeps; sweep++) {
+        double diag = a[0][0] * a[0][0] + a[1][1] * a[1][1] + a[2][2] * a[2][2];
+        double off = a[0][1] * a[0][1] + a[0][2] * a[0][2] + a[1][2] * a[1][2];
+        if (off <= eps * diag) {
+            break;
+        }
+
+        for (int p = 0; p < 2; p++) {
+            for (int q = p + 1; q < 3; q++) {
+                if (a[p][q] == 0.0) {
+                    continue;
+                }
+
+                double theta = (a[q][q] - a[p][p]) / (2.0 * a[p][q]);
+                double t = 1.0 / (fabs(theta) + sqrt(theta * theta + 1.0));
+                if (theta < 0.0) {
+                    t = -t;
+                }
+                double c = 1.0 / sqrt(t * t + 1.0);
+                double s = t * c;
+
+                for (int k = 0; k < 3; k++) {
+                    double akp = a[k][p];
+                    double akq = a[k][q];
+                    a[k][p] = c * akp - s * akq;
+                    a[k][q] = s * akp + c * akq;
+                }
+
+                for (int k = 0; k < 3; k++) {
+                    double apk = a[p][k];
+                    double aqk = a[q][k];
+                    a[p][k] = c * apk - s * aqk;
+                    a[q][k] = s * apk + c * aqk;
+                }
+
+                for (int k = 0; k < 3; k++) {
+                    double vkp = eigenvectors[k][p];
+                    double vkq = eigenvectors[k][q];
+                    eigenvectors[k][p] = c * vkp - s * vkq;
+                    eigenvectors[k][q] = s * vkp + c * vkq;
+                }
+            }
+        }
+    }
+
+    for (int i = 0; i < 3; i++) {
+        eigenvalues[i] = a[i][i];
+    }
+
+    for (int i = 0; i < 2; i++) {
+        int maxidx = i;
+        for (int j = i + 1; j < 3; j++) {
+            if (eigenvalues[j] > eigenvalues[maxidx]) {
+                maxidx = j;
+            }
+        }
+
+        if (maxidx != i) {
+            std::swap(eigenvalues[i], eigenvalues[maxidx]);
+            for (int k = 0; k < 3; k++) {
+                std::swap(eigenvectors[k][i], eigenvectors[k][maxidx]);
+            }
+        }
+    }
+}
+
 void ParticleMesher::_generateComputeChunkData(MesherComputeChunkData &data) {
     _initializeComputeChunkDataActiveBlocks(data);
     _initializeComputeChunkDataComputeChunks(data);
@@ -291,6 +675,10 @@ TriangleMesh ParticleMesher::_polygonizeComputeChunk(MesherComputeChunk chunk,
     _updateSeamData(fieldData);
 
     Polygonizer3d polygonizer(&(fieldData.fieldValues), _solidSDF);
+    if (_cache != nullptr) {
+        polygonizer.setBlockMeshCache(&(_cache->polygonizerCaches[chunk.id]), 
+                                      _getPolygonizerCacheSignature(chunk));
+    }
 
     TriangleMesh m = polygonizer.polygonizeSurface();
     m.translate(chunk.positionOffset);
@@ -318,10 +706,16 @@ void ParticleMesher::_initializeScalarFieldData(MesherComputeChunk chunk,
     }
 
     fieldData.particles.reserve(count);
+    if (_isAnisotropicKernelEnabled) {
+        fieldData.kernelTransforms.reserve(count);
+    }
     for (size_t i = 0; i < _particles->size(); i++) {
         vmath::vec3 p = _particles->at(i);
         if (bbox.isPointInside(p)) {
             fieldData.particles.push_back(p - chunk.positionOffset);
+            if (_isAnisotropicKernelEnabled) {
+                fieldData.kernelTransforms.push_back(_kernelTransforms[i]);
+            }
         }
     }
 
@@ -363,8 +757,10 @@ void ParticleMesher::_computeScalarField(ScalarFieldData &fieldData) {
     _computeGridCountData(fieldData, gridCountData);
 
     std::vector<vmath::vec3> sortedParticles;
+    std::vector<vmath::mat3> sortedKernelTransforms;
     std::vector<int> blockToParticleIndex;
-    _sortParticlesIntoBlocks(fieldData, gridCountData, sortedParticles, blockToParticleIndex);
+    _sortParticlesIntoBlocks(fieldData, gridCountData, sortedParticles, 
+                             sortedKernelTransforms, blockToParticleIndex);
 
     std::vector<GridBlock<float> > gridBlocks;
     fieldData.scalarField.getActiveGridBlocks(gridBlocks);
@@ -380,7 +776,13 @@ void ParticleMesher::_computeScalarField(ScalarFieldData &fieldData) {
         ComputeBlock computeBlock;
         computeBlock.gridBlock = b;
         computeBlock.particleData = &(sortedParticles[blockToParticleIndex[b.id]]);
+        if (_isAnisotropicKernelEnabled) {
+            computeBlock.kernelTransformData = &(sortedKernelTransforms[blockToParticleIndex[b.id]]);
+        }
         computeBlock.numParticles = gridCountData.totalGridCount[b.id];
+        if (_cache != nullptr) {
+            computeBlock.cacheKey = _getComputeBlockCacheKey(fieldData.computeChunk, b.index);
+        }
         computeBlockQueue.push(computeBlock);
         numComputeBlocks++;
     }
@@ -401,6 +803,10 @@ void ParticleMesher::_computeScalarField(ScalarFieldData &fieldData) {
         finishedComputeBlockQueue.popAll(finishedBlocks);
         for (size_t i = 0; i < finishedBlocks.size(); i++) {
             ComputeBlock block = finishedBlocks[i];
+            if (_cache != nullptr) {
+                _saveCachedComputeBlock(block);
+            }
+
             GridIndex gridOffset(block.gridBlock.index.i * _blockwidth,
                                  block.gridBlock.index.j * _blockwidth,
                                  block.gridBlock.index.k * _blockwidth);
@@ -538,6 +944,7 @@ void ParticleMesher::_computeGridCountDataThread(int startidx, int endidx,
 void ParticleMesher::_sortParticlesIntoBlocks(ScalarFieldData &fieldData, 
                                               ParticleGridCountData &gridCountData,
                                               std::vector<vmath::vec3> &sortedParticles,
+                                              std::vector<vmath::mat3> &sortedKernelTransforms,
                                               std::vector<int> &blockToParticleIndex) {
 
     blockToParticleIndex = std::vector<int>(gridCountData.gridsize, 0);
@@ -550,6 +957,9 @@ void ParticleMesher::_sortParticlesIntoBlocks(ScalarFieldData &fieldData,
     int totalParticleCount = currentIndex;
 
     sortedParticles = std::vector<vmath::vec3>(totalParticleCount);
+    if (_isAnisotropicKernelEnabled) {
+        sortedKernelTransforms = std::vector<vmath::mat3>(totalParticleCount);
+    }
     for (int tidx = 0; tidx < gridCountData.numthreads; tidx++) {
         GridCountData *countData = &(gridCountData.threadGridCountData[tidx]);
 
@@ -565,6 +975,9 @@ void ParticleMesher::_sortParticlesIntoBlocks(ScalarFieldData &fieldData,
                 int blockid = countData->simpleGridIndices[i];
                 int sortedIndex = blockToParticleIndexCurrent[blockid];
                 sortedParticles[sortedIndex] = p;
+                if (_isAnisotropicKernelEnabled) {
+                    sortedKernelTransforms[sortedIndex] = fieldData.kernelTransforms[i + indexOffset];
+                }
                 blockToParticleIndexCurrent[blockid]++;
             } else {
                 int numblocks = -(countData->simpleGridIndices[i]);
@@ -574,6 +987,9 @@ void ParticleMesher::_sortParticlesIntoBlocks(ScalarFieldData &fieldData,
 
                     int sortedIndex = blockToParticleIndexCurrent[blockid];
                     sortedParticles[sortedIndex] = p;
+                    if (_isAnisotropicKernelEnabled) {
+                        sortedKernelTransforms[sortedIndex] = fieldData.kernelTransforms[i + indexOffset];
+                    }
                     blockToParticleIndexCurrent[blockid]++;
                 }
             }
@@ -584,8 +1000,8 @@ void ParticleMesher::_sortParticlesIntoBlocks(ScalarFieldData &fieldData,
 void ParticleMesher::_scalarFieldProducerThread(BoundedBuffer<ComputeBlock> *computeBlockQueue,
                                                 BoundedBuffer<ComputeBlock> *finishedComputeBlockQueue) {
     
-    float r = _radius;
-    float sr = _searchRadiusFactor * r;
+    ComputeBlockWorkspace workspace;
+    _initializeComputeBlockWorkspace(workspace);
 
     while (computeBlockQueue->size() > 0) {
         std::vector<ComputeBlock> computeBlocks;
@@ -596,45 +1012,340 @@ void ParticleMesher::_scalarFieldProducerThread(BoundedBuffer<ComputeBlock> *com
 
         for (size_t bidx = 0; bidx < computeBlocks.size(); bidx++) {
             ComputeBlock block = computeBlocks[bidx];
-            GridIndex blockIndex = block.gridBlock.index;
-            vmath::vec3 blockPositionOffset = Grid3d::GridIndexToPosition(blockIndex, _blockwidth * _subdx);
-
-            for (int pidx = 0; pidx < block.numParticles; pidx++) {
-                vmath::vec3 p = block.particleData[pidx];
-                p -= blockPositionOffset;
-
-                vmath::vec3 pmin(p.x - sr, p.y - sr, p.z - sr);
-                vmath::vec3 pmax(p.x + sr, p.y + sr, p.z + sr);
-                GridIndex gmin = Grid3d::positionToGridIndex(pmin, _subdx);
-                GridIndex gmax = Grid3d::positionToGridIndex(pmax, _subdx);
-                gmax.i++;
-                gmax.j++;
-                gmax.k++;
-
-                for (int k = gmin.k; k <= gmax.k; k++) {
-                    for (int j = gmin.j; j <= gmax.j; j++) {
-                        for (int i = gmin.i; i <= gmax.i; i++) {
-                            if (i < 0 || j < 0 || k < 0 ||
-                                    i >= _blockwidth || j >= _blockwidth || k >= _blockwidth) {
-                                continue;
-                            }
-
-                            vmath::vec3 gpos = Grid3d::GridIndexToPosition(i, j, k, _subdx);
-                            float dist = vmath::length(gpos - p) - r;
-                            int flatidx = Grid3d::getFlatIndex(i, j, k, _blockwidth, _blockwidth);
-                            if (dist < block.gridBlock.data[flatidx]) {
-                                 block.gridBlock.data[flatidx] = dist;
-                            }
-                        }
-                    }
-                }
+            if (_cache != nullptr && _loadCachedComputeBlock(block, workspace)) {
+                finishedComputeBlockQueue->push(block);
+                continue;
             }
 
+            _computeBlockScalarField(block, workspace);
             finishedComputeBlockQueue->push(block);
         }
     }
 }
 
+void ParticleMesher::_initializeComputeBlockWorkspace(ComputeBlockWorkspace &workspace) {
+    workspace.gridPositions = std::vector<float>(_blockwidth);
+    for (int i = 0; i < _blockwidth; i++) {
+        workspace.gridPositions[i] = Grid3d::GridIndexToPosition(i, 0, 0, _subdx).x;
+    }
+
+    int datasize = _blockwidth * _blockwidth * _blockwidth;
+    workspace.distanceSquared = std::vector<float>(datasize);
+}
+
+void ParticleMesher::_computeBlockScalarField(ComputeBlock &block, 
+                                              ComputeBlockWorkspace &workspace) {
+    float r = _radius;
+    float sr = _searchRadiusFactor * r;
+
+    GridIndex blockIndex = block.gridBlock.index;
+    vmath::vec3 blockPositionOffset = Grid3d::GridIndexToPosition(blockIndex, _blockwidth * _subdx);
+
+    // The minimum squared distance is tracked per node and converted to a 
+    // distance once per node. The square root is monotonic so the result is
+    // the same as taking the minimum of the distances to each particle.
+    std::fill(workspace.distanceSquared.begin(), workspace.distanceSquared.end(), 
+              std::numeric_limits<float>::infinity());
+
+    float *gridPositions = workspace.gridPositions.data();
+    for (int pidx = 0; pidx < block.numParticles; pidx++) {
+        vmath::vec3 p = block.particleData[pidx] - blockPositionOffset;
+        vmath::vec3 pmin(p.x - sr, p.y - sr, p.z - sr);
+        vmath::vec3 pmax(p.x + sr, p.y + sr, p.z + sr);
+        GridIndex gmin = Grid3d::positionToGridIndex(pmin, _subdx);
+        GridIndex gmax = Grid3d::positionToGridIndex(pmax, _subdx);
+        gmin.i = (int)fmax(gmin.i, 0);
+        gmin.j = (int)fmax(gmin.j, 0);
+        gmin.k = (int)fmax(gmin.k, 0);
+        gmax.i = (int)fmin(gmax.i + 1, _blockwidth - 1);
+        gmax.j = (int)fmin(gmax.j + 1, _blockwidth - 1);
+        gmax.k = (int)fmin(gmax.k + 1, _blockwidth - 1);
+
+        if (block.kernelTransformData != nullptr) {
+            // Distances are measured in the space of the kernel transform
+            vmath::mat3 G = block.kernelTransformData[pidx];
+            vmath::vec3 gx(G.m[0], G.m[1], G.m[2]);
+            vmath::vec3 gy(G.m[3], G.m[4], G.m[5]);
+            vmath::vec3 gz(G.m[6], G.m[7], G.m[8]);
+            for (int k = gmin.k; k <= gmax.k; k++) {
+                vmath::vec3 gzv = gz * (gridPositions[k] - p.z);
+                for (int j = gmin.j; j <= gmax.j; j++) {
+                    vmath::vec3 gyz = gy * (gridPositions[j] - p.y) + gzv;
+                    int rowidx = Grid3d::getFlatIndex(0, j, k, _blockwidth, _blockwidth);
+                    _updateAnisotropicDistanceSquaredRow(&(workspace.distanceSquared[rowidx]), 
+                                                         gridPositions, gmin.i, gmax.i, 
+                                                         p.x, gx, gyz);
+                }
+            }
+            continue;
+        }
+
+        for (int k = gmin.k; k <= gmax.k; k++) {
+            float vz = gridPositions[k] - p.z;
+            float vzsq = vz * vz;
+            for (int j = gmin.j; j <= gmax.j; j++) {
+                float vy = gridPositions[j] - p.y;
+                float vysq = vy * vy;
+                int rowidx = Grid3d::getFlatIndex(0, j, k, _blockwidth, _blockwidth);
+                _updateDistanceSquaredRow(&(workspace.distanceSquared[rowidx]), gridPositions,
+                                          gmin.i, gmax.i, p.x, vysq, vzsq);
+            }
+        }
+    }
+
+    float *data = block.gridBlock.data;
+    float *distanceSquared = workspace.distanceSquared.data();
+    int datasize = _blockwidth * _blockwidth * _blockwidth;
+    for (int vidx = 0; vidx < datasize; vidx++) {
+        float dist = (float)sqrt(distanceSquared[vidx]) - r;
+        if (dist < data[vidx]) {
+            data[vidx] = dist;
+        }
+    }
+}
+
+void ParticleMesher::_updateDistanceSquaredRow(float *row, float *gridPositions, 
+                                               int imin, int imax, 
+                                               float px, float vysq, float vzsq) {
+    // Branch free so that the compiler can vectorize the row for the target
+    // instruction set
+    for (int i = imin; i <= imax; i++) {
+        float vx = gridPositions[i] - px;
+        float distsq = vx * vx + vysq + vzsq;
+        row[i] = distsq < row[i] ? distsq : row[i];
+    }
+}
+
+void ParticleMesher::_updateAnisotropicDistanceSquaredRow(float *row, float *gridPositions, 
+                                                          int imin, int imax, float px, 
+                                                          vmath::vec3 gx, vmath::vec3 gyz) {
+    for (int i = imin; i <= imax; i++) {
+        float vx = gridPositions[i] - px;
+        float wx = gx.x * vx + gyz.x;
+        float wy = gx.y * vx + gyz.y;
+        float wz = gx.z * vx + gyz.z;
+        float distsq = wx * wx + wy * wy + wz * wz;
+        row[i] = distsq < row[i] ? distsq : row[i];
+    }
+}
+
+void ParticleMesher::_initializeCache() {
+    unsigned long long signature = 14695981039346656037ULL;
+    signature = _hashData(&_subisize, sizeof(int), signature);
+    signature = _hashData(&_subjsize, sizeof(int), signature);
+    signature = _hashData(&_subksize, sizeof(int), signature);
+    signature = _hashData(&_subdx, sizeof(double), signature);
+    signature = _hashData(&_radius, sizeof(double), signature);
+    signature = _hashData(&_blockwidth, sizeof(int), signature);
+    signature = _hashData(&_searchRadiusFactor, sizeof(float), signature);
+    signature = _hashData(&_isAnisotropicKernelEnabled, sizeof(bool), signature);
+    if (signature != _cache->signature) {
+        _cache->clear();
+        _cache->signature = signature;
+    }
+
+    // Triangles near obstacles depend on the solid SDF, so polygonizer blocks
+    // are only reused while the solid SDF is unchanged
+    unsigned long long solidHash = _getSolidSDFHash();
+
+    _cache->solidSDFHash = solidHash;
+    _cache->pass++;
+    _cache->nextComputeBlocks.clear();
+    _cache->polygonizerCaches.resize(getNumComputeChunks());
+    for (size_t i = 0; i < _cache->polygonizerCaches.size(); i++) {
+        _cache->polygonizerCaches[i].numBlocks = 0;
+        _cache->polygonizerCaches[i].numReusedBlocks = 0;
+    }
+
+    _cache->numComputeBlocks = 0;
+    _cache->numReusedComputeBlocks = 0;
+    _cache->numPolygonizerBlocks = 0;
+    _cache->numReusedPolygonizerBlocks = 0;
+}
+
+void ParticleMesher::_commitCache() {
+    // Compute blocks that were not visited in this pass are carried over 
+    // until they are evicted
+    for (auto it = _cache->computeBlocks.begin(); it != _cache->computeBlocks.end(); ++it) {
+        if (_cache->nextComputeBlocks.find(it->first) == _cache->nextComputeBlocks.end()) {
+            _cache->nextComputeBlocks[it->first] = std::move(it->second);
+        }
+    }
+    _cache->computeBlocks.swap(_cache->nextComputeBlocks);
+    _cache->nextComputeBlocks.clear();
+
+    _cache->numComputeBlockBytes = 0;
+    for (auto it = _cache->computeBlocks.begin(); it != _cache->computeBlocks.end(); ++it) {
+        _cache->numComputeBlockBytes += it->second.data.size() * sizeof(float);
+    }
+    _evictCachedComputeBlocks();
+
+    for (size_t i = 0; i < _cache->polygonizerCaches.size(); i++) {
+        _cache->numPolygonizerBlocks += _cache->polygonizerCaches[i].numBlocks;
+        _cache->numReusedPolygonizerBlocks += _cache->polygonizerCaches[i].numReusedBlocks;
+    }
+}
+
+void ParticleMesher::_evictCachedComputeBlocks() {
+    if (_cache->numComputeBlockBytes <= _cache->maxComputeBlockBytes) {
+        return;
+    }
+
+    // Least recently used blocks are evicted first. Ties are broken by key
+    // so that the result does not depend on the hash map iteration order.
+    std::vector<std::pair<unsigned long long, unsigned long long> > blockAges;
+    blockAges.reserve(_cache->computeBlocks.size());
+    for (auto it = _cache->computeBlocks.begin(); it != _cache->computeBlocks.end(); ++it) {
+        blockAges.push_back(std::make_pair(it->second.lastUsedPass, it->first));
+    }
+    std::sort(blockAges.begin(), blockAges.end());
+
+    for (size_t i = 0; i < blockAges.size(); i++) {
+        if (_cache->numComputeBlockBytes <= _cache->maxComputeBlockBytes) {
+            break;
+        }
+
+        auto it = _cache->computeBlocks.find(blockAges[i].second);
+        _cache->numComputeBlockBytes -= it->second.data.size() * sizeof(float);
+        _cache->computeBlocks.erase(it);
+    }
+}
+
+unsigned long long ParticleMesher::_hashData(const void *data, size_t numBytes, 
+                                             unsigned long long hash) {
+    // 64-bit FNV-1a
+    const unsigned char *bytes = (const unsigned char *)data;
+    for (size_t i = 0; i < numBytes; i++) {
+        hash ^= (unsigned long long)bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+unsigned long long ParticleMesher::_getSolidSDFHash() {
+    int si, sj, sk;
+    _solidSDF->getGridDimensions(&si, &sj, &sk);
+    unsigned long long hash = 14695981039346656037ULL;
+    hash = _hashData(&si, sizeof(int), hash);
+    hash = _hashData(&sj, sizeof(int), hash);
+    hash = _hashData(&sk, sizeof(int), hash);
+    if (si <= 0 || sj <= 0 || sk <= 0) {
+        return hash;
+    }
+
+    // Each k slice is hashed independently and the slice hashes are combined 
+    // in order, so that the result does not depend on the number of threads
+    int numSlices = sk + 1;
+    std::vector<unsigned long long> sliceHashes(numSlices);
+
+    int numCPU = ThreadUtils::getMaxThreadCount();
+    int numthreads = (int)fmin(numCPU, numSlices);
+    std::vector<std::thread> threads(numthreads);
+    std::vector<int> intervals = ThreadUtils::splitRangeIntoIntervals(0, numSlices, numthreads);
+    for (int i = 0; i < numthreads; i++) {
+        threads[i] = std::thread(&ParticleMesher::_hashSolidSDFSlicesThread, this,
+                                 intervals[i], intervals[i + 1], &sliceHashes);
+    }
+
+    for (int i = 0; i < numthreads; i++) {
+        threads[i].join();
+    }
+
+    return _hashData(sliceHashes.data(), numSlices * sizeof(unsigned long long), hash);
+}
+
+void ParticleMesher::_hashSolidSDFSlicesThread(int startidx, int endidx, 
+                                               std::vector<unsigned long long> *sliceHashes) {
+    int si, sj, sk;
+    _solidSDF->getGridDimensions(&si, &sj, &sk);
+    for (int k = startidx; k < endidx; k++) {
+        unsigned long long hash = 14695981039346656037ULL;
+        for (int j = 0; j < sj + 1; j++) {
+            for (int i = 0; i < si + 1; i++) {
+                float value = (*_solidSDF)(i, j, k);
+                unsigned int bits;
+                std::memcpy(&bits, &value, sizeof(float));
+                hash ^= (unsigned long long)bits;
+                hash *= 1099511628211ULL;
+            }
+        }
+        sliceHashes->at(k) = hash;
+    }
+}
+
+unsigned long long ParticleMesher::_getComputeBlockCacheKey(MesherComputeChunk &chunk, 
+                                                            GridIndex blockIndex) {
+    unsigned long long key = 14695981039346656037ULL;
+    key = _hashData(&(chunk.minGridIndex), sizeof(GridIndex), key);
+    key = _hashData(&(chunk.isize), sizeof(int), key);
+    key = _hashData(&(chunk.jsize), sizeof(int), key);
+    key = _hashData(&(chunk.ksize), sizeof(int), key);
+    key = _hashData(&blockIndex, sizeof(GridIndex), key);
+    return key;
+}
+
+unsigned long long ParticleMesher::_getComputeBlockParticleHash(ComputeBlock &block, 
+                                                                ComputeBlockWorkspace &workspace) {
+    // Particle hashes are sorted before they are combined so that the block 
+    // hash does not depend on the order of the particles. Unlike a sum of the
+    // particle hashes, the sorted sequence only matches for equal particle sets.
+    std::vector<unsigned long long> *particleHashes = &(workspace.particleHashes);
+    particleHashes->resize(block.numParticles);
+    for (int i = 0; i < block.numParticles; i++) {
+        unsigned long long h = _hashData(&(block.particleData[i]), sizeof(vmath::vec3), 14695981039346656037ULL);
+        if (block.kernelTransformData != nullptr) {
+            h = _hashData(&(block.kernelTransformData[i]), sizeof(vmath::mat3), h);
+        }
+        (*particleHashes)[i] = h;
+    }
+    std::sort(particleHashes->begin(), particleHashes->end());
+
+    unsigned long long hash = block.cacheKey;
+    hash = _hashData(&(block.numParticles), sizeof(int), hash);
+    hash = _hashData(particleHashes->data(), particleHashes->size() * sizeof(unsigned long long), hash);
+    return hash;
+}
+
+unsigned long long ParticleMesher::_getPolygonizerCacheSignature(MesherComputeChunk &chunk) {
+    unsigned long long signature = _cache->signature;
+    signature = _hashData(&(_cache->solidSDFHash), sizeof(unsigned long long), signature);
+    signature = _hashData(&(chunk.minGridIndex), sizeof(GridIndex), signature);
+    signature = _hashData(&(chunk.isize), sizeof(int), signature);
+    signature = _hashData(&(chunk.jsize), sizeof(int), signature);
+    signature = _hashData(&(chunk.ksize), sizeof(int), signature);
+    return signature;
+}
+
+bool ParticleMesher::_loadCachedComputeBlock(ComputeBlock &block, 
+                                             ComputeBlockWorkspace &workspace) {
+    // The cache is only read while compute blocks are being processed
+    block.cacheHash = _getComputeBlockParticleHash(block, workspace);
+    auto it = _cache->computeBlocks.find(block.cacheKey);
+    if (it == _cache->computeBlocks.end() || it->second.hash != block.cacheHash) {
+        return false;
+    }
+
+    int datasize = _blockwidth * _blockwidth * _blockwidth;
+    std::memcpy(block.gridBlock.data, it->second.data.data(), datasize * sizeof(float));
+    block.isReused = true;
+
+    return true;
+}
+
+void ParticleMesher::_saveCachedComputeBlock(ComputeBlock &block) {
+    int datasize = _blockwidth * _blockwidth * _blockwidth;
+    ParticleMesherCacheBlock cacheBlock;
+    cacheBlock.hash = block.cacheHash;
+    cacheBlock.lastUsedPass = _cache->pass;
+    cacheBlock.data.assign(block.gridBlock.data, block.gridBlock.data + datasize);
+    _cache->nextComputeBlocks[block.cacheKey] = cacheBlock;
+
+    _cache->numComputeBlocks++;
+    if (block.isReused) {
+        _cache->numReusedComputeBlocks++;
+    }
+}
+
 void ParticleMesher::_setScalarFieldSolidBorders(ScalarField &field) {
     double eps = 1e-3;
     double thresh = field.getSurfaceThreshold() - eps;
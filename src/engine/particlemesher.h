@@ -25,15 +25,65 @@ SOFTWARE.
 #pragma once
 
 #include <vector>
+#include <unordered_map>
 
 #include "vmath.h"
 #include "array3d.h"
 #include "blockarray3d.h"
 #include "scalarfield.h"
 #include "boundedbuffer.h"
+#include "polygonizer3d.h"
 
 class TriangleMesh;
 class MeshLevelSet;
+class SpatialPointGrid;
+
+struct ParticleMesherCacheBlock {
+    unsigned long long hash = 0;
+    unsigned long long lastUsedPass = 0;
+    std::vector<float> data;
+};
+
+/*
+    Temporal coherence cache that persists between meshing passes. Compute
+    blocks whose particle set hashes to a cached value reuse their scalar 
+    field values, and polygonizer blocks whose node values hash to the value 
+    of the previous pass reuse their triangles. Compute blocks are evicted 
+    in least recently used order once their data exceeds maxComputeBlockBytes. 
+    Polygonizer blocks are only kept for the previous pass. A cache must not
+    be shared by meshers that run at the same time.
+*/
+struct ParticleMesherCache {
+    unsigned long long signature = 0;
+    unsigned long long solidSDFHash = 0;
+    unsigned long long pass = 0;
+    std::unordered_map<unsigned long long, ParticleMesherCacheBlock> computeBlocks;
+    std::unordered_map<unsigned long long, ParticleMesherCacheBlock> nextComputeBlocks;
+    std::vector<Polygonizer3d::BlockMeshCache> polygonizerCaches;
+
+    size_t numComputeBlockBytes = 0;
+    size_t maxComputeBlockBytes = 512ULL * 1024ULL * 1024ULL;
+
+    // Statistics of the most recent meshing pass
+    int numComputeBlocks = 0;
+    int numReusedComputeBlocks = 0;
+    int numPolygonizerBlocks = 0;
+    int numReusedPolygonizerBlocks = 0;
+
+    void clear() {
+        signature = 0;
+        solidSDFHash = 0;
+        pass = 0;
+        numComputeBlockBytes = 0;
+        computeBlocks.clear();
+        nextComputeBlocks.clear();
+        polygonizerCaches.clear();
+        numComputeBlocks = 0;
+        numReusedComputeBlocks = 0;
+        numPolygonizerBlocks = 0;
+        numReusedPolygonizerBlocks = 0;
+    }
+};
 
 struct ParticleMesherParameters {
     int isize = 0;
@@ -47,9 +97,16 @@ struct ParticleMesherParameters {
 
     bool isPreviewMesherEnabled = false;
     double previewdx = 0.0;
+
+    // Splat ellipsoids fitted to the neighbourhood of each particle instead
+    // of spheres
+    bool isAnisotropicKernelEnabled = false;
     
     std::vector<vmath::vec3> *particles;
     MeshLevelSet *solidSDF;
+
+    // Optional, may be nullptr
+    ParticleMesherCache *cache = nullptr;
 };
 
 class ParticleMesher {
@@ -59,6 +116,14 @@ public:
     TriangleMesh meshParticles(ParticleMesherParameters params);
     TriangleMesh getPreviewMesh();
 
+    // Chunked meshing: compute chunks are polygonized one at a time and in
+    // order so that only a single chunk is held in memory. Chunk meshes are
+    // not welded together and share duplicate vertices on their seams.
+    void initializeComputeChunks(ParticleMesherParameters params);
+    int getNumComputeChunks();
+    bool meshNextComputeChunk(TriangleMesh &mesh);
+    void getComputeChunkSeamVertices(TriangleMesh &mesh, std::vector<bool> &isSeamVertex);
+
 private:
     enum class Direction { U, V, W };
 
@@ -101,12 +166,25 @@ private:
         BlockArray3d<float> scalarField;
         ScalarField fieldValues;
         std::vector<vmath::vec3> particles;
+        std::vector<vmath::mat3> kernelTransforms;
     };
 
     struct ComputeBlock {
         GridBlock<float> gridBlock;
         vmath::vec3 *particleData;
+        vmath::mat3 *kernelTransformData = nullptr;
         int numParticles = 0;
+        unsigned long long cacheKey = 0;
+        unsigned long long cacheHash = 0;
+        bool isReused = false;
+    };
+
+    // Per thread scratch space for computing the scalar field of a compute
+    // block
+    struct ComputeBlockWorkspace {
+        std::vector<float> gridPositions;
+        std::vector<float> distanceSquared;
+        std::vector<unsigned long long> particleHashes;
     };
 
     struct ScalarFieldSeam {
@@ -129,6 +207,13 @@ private:
     void _initializePreviewMesher(double dx);
     void _initializeSeamData();
 
+    void _computeAnisotropicKernels();
+    void _computeAnisotropicKernelsThread(int startidx, int endidx, SpatialPointGrid *grid,
+                                          Array3d<bool> *isCellOccupied);
+    bool _isAnisotropicKernelCellInterior(GridIndex g, int width, Array3d<bool> *isCellOccupied);
+    void _computeSymmetricEigenDecomposition(double A[3][3], double eigenvalues[3], 
+                                             double eigenvectors[3][3]);
+
     void _generateComputeChunkData(MesherComputeChunkData &data);
     void _initializeComputeChunkDataActiveBlocks(MesherComputeChunkData &data);
     void _initializeComputeChunkDataComputeChunks(MesherComputeChunkData &data);
@@ -148,9 +233,32 @@ private:
     void _sortParticlesIntoBlocks(ScalarFieldData &fieldData, 
                                   ParticleGridCountData &gridCountData,
                                   std::vector<vmath::vec3> &sortedParticles,
+                                  std::vector<vmath::mat3> &sortedKernelTransforms,
                                   std::vector<int> &blockToParticleIndex);
     void _scalarFieldProducerThread(BoundedBuffer<ComputeBlock> *computeBlockQueue,
                                     BoundedBuffer<ComputeBlock> *finishedComputeBlockQueue);
+    void _initializeComputeBlockWorkspace(ComputeBlockWorkspace &workspace);
+    void _computeBlockScalarField(ComputeBlock &block, ComputeBlockWorkspace &workspace);
+    void _updateDistanceSquaredRow(float *row, float *gridPositions, 
+                                   int imin, int imax, 
+                                   float px, float vysq, float vzsq);
+    void _updateAnisotropicDistanceSquaredRow(float *row, float *gridPositions, 
+                                              int imin, int imax, float px, 
+                                              vmath::vec3 gx, vmath::vec3 gyz);
+
+    void _initializeCache();
+    void _commitCache();
+    void _evictCachedComputeBlocks();
+    unsigned long long _hashData(const void *data, size_t numBytes, unsigned long long hash);
+    unsigned long long _getSolidSDFHash();
+    void _hashSolidSDFSlicesThread(int startidx, int endidx, 
+                                   std::vector<unsigned long long> *sliceHashes);
+    unsigned long long _getComputeBlockCacheKey(MesherComputeChunk &chunk, GridIndex blockIndex);
+    unsigned long long _getComputeBlockParticleHash(ComputeBlock &block, 
+                                                    ComputeBlockWorkspace &workspace);
+    unsigned long long _getPolygonizerCacheSignature(MesherComputeChunk &chunk);
+    bool _loadCachedComputeBlock(ComputeBlock &block, ComputeBlockWorkspace &workspace);
+    void _saveCachedComputeBlock(ComputeBlock &block);
 
     void _setScalarFieldSolidBorders(ScalarField &field);
     void _addComputeChunkScalarFieldToPreviewField(ScalarFieldData &fieldData);
@@ -185,11 +293,33 @@ private:
     std::vector<vmath::vec3> *_particles;
     MeshLevelSet *_solidSDF;
 
+    // Anisotropic kernel centers replace the particles when enabled
+    bool _isAnisotropicKernelEnabled = false;
+    std::vector<vmath::vec3> _kernelCenters;
+    std::vector<vmath::mat3> _kernelTransforms;
+    ParticleMesherCache *_cache = nullptr;
+
     // Internal Parameters
     int _blockwidth = 10;
     int _numComputeBlocksPerJob = 10;
     double _localdx = 0.1;
     float _searchRadiusFactor = 1.5f;
+
+    // Anisotropic kernel parameters. Neighbourhoods are gathered within
+    // _anisotropicNeighbourRadiusFactor cells. Particles with fewer than 
+    // _minAnisotropicNeighbours neighbours keep a spherical kernel. Kernel
+    // axes are limited to a ratio of _maxAnisotropicAxisRatio, may not be
+    // stretched beyond the block search radius and may not be thinner than 
+    // _minAnisotropicAxisWidth mesher cells. Kernel centers are moved 
+    // towards the neighbourhood mean by _anisotropicSmoothingFactor.
+    double _anisotropicNeighbourRadiusFactor = 1.5;
+    int _minAnisotropicNeighbours = 25;
+    double _maxAnisotropicAxisRatio = 4.0;
+    double _minAnisotropicAxisWidth = 0.7;
+    double _anisotropicSmoothingFactor = 0.9;
     ScalarFieldSeam _seamData;
 
+    MesherComputeChunkData _computeChunkData;
+    int _currentComputeChunkIndex = -1;
+
 };
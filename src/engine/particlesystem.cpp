@@ -24,6 +24,8 @@ SOFTWARE.
 
 #include "particlesystem.h"
 
+#include <cmath>
+
 
 ParticleSystem::ParticleSystem() {
 }
@@ -86,15 +88,16 @@ void ParticleSystem::reserve(size_t n) {
 }
 
 void ParticleSystem::removeParticles(std::vector<bool> &toRemove) {
-    _removeParticlesFromVectorList(_charAttributes, toRemove);
-    _removeParticlesFromVectorList(_ucharAttributes, toRemove);
-    _removeParticlesFromVectorList(_boolAttributes, toRemove);
-    _removeParticlesFromVectorList(_intAttributes, toRemove);
-    _removeParticlesFromVectorList(_idAttributes, toRemove);
-    _removeParticlesFromVectorList(_uint16Attributes, toRemove);
-    _removeParticlesFromVectorList(_uLongLongAttributes, toRemove);
-    _removeParticlesFromVectorList(_floatAttributes, toRemove);
-    _removeParticlesFromVectorList(_vector3Attributes, toRemove);
+    RemovalLayout layout = _getRemovalLayout(toRemove);
+    _removeParticlesFromVectorList(_charAttributes, toRemove, layout);
+    _removeParticlesFromVectorList(_ucharAttributes, toRemove, layout);
+    _removeParticlesFromVectorList(_boolAttributes, toRemove, layout);
+    _removeParticlesFromVectorList(_intAttributes, toRemove, layout);
+    _removeParticlesFromVectorList(_idAttributes, toRemove, layout);
+    _removeParticlesFromVectorList(_uint16Attributes, toRemove, layout);
+    _removeParticlesFromVectorList(_uLongLongAttributes, toRemove, layout);
+    _removeParticlesFromVectorList(_floatAttributes, toRemove, layout);
+    _removeParticlesFromVectorList(_vector3Attributes, toRemove, layout);
     update();
 }
 
@@ -601,6 +604,54 @@ std::vector<vmath::vec3> *ParticleSystem::getAttributeValuesVector3(std::string
 }
 
 
+ParticleSystem::RemovalLayout ParticleSystem::_getRemovalLayout(std::vector<bool> &toRemove) {
+    // Each thread compacts one interval of the mask. Destination offsets are
+    // an exclusive prefix sum over the number of kept particles in each 
+    // interval, so every attribute is compacted with the same layout.
+    RemovalLayout layout;
+    size_t n = toRemove.size();
+    int numthreads = 1;
+    if (n >= _minParallelRemovalSize) {
+        numthreads = (int)fmin(ThreadUtils::getMaxThreadCount(), n);
+    }
+
+    layout.intervals = ThreadUtils::splitRangeIntoIntervals(0, n, numthreads);
+    if (numthreads == 1) {
+        return layout;
+    }
+
+    std::vector<size_t> counts(numthreads, 0);
+    std::vector<std::thread> threads(numthreads);
+    for (int i = 0; i < numthreads; i++) {
+        threads[i] = std::thread(&ParticleSystem::_countKeptParticlesThread, this,
+                                 layout.intervals[i], layout.intervals[i + 1], 
+                                 &toRemove, &(counts[i]));
+    }
+
+    for (int i = 0; i < numthreads; i++) {
+        threads[i].join();
+    }
+
+    layout.offsets = std::vector<size_t>(numthreads + 1, 0);
+    for (int i = 0; i < numthreads; i++) {
+        layout.offsets[i + 1] = layout.offsets[i] + counts[i];
+    }
+
+    return layout;
+}
+
+void ParticleSystem::_countKeptParticlesThread(int startidx, int endidx, 
+                                               std::vector<bool> *toRemove, 
+                                               size_t *count) {
+    size_t keptcount = 0;
+    for (int i = startidx; i < endidx; i++) {
+        if (!(*toRemove)[i]) {
+            keptcount++;
+        }
+    }
+    *count = keptcount;
+}
+
 ParticleSystemAttribute ParticleSystem::_getAttributeByName(std::string name) {
     for (size_t i = 0; i < _attributes.size(); i++) {
         if (_attributes[i].name == name) {
@@ -24,6 +24,12 @@ SOFTWARE.
 
 #pragma once
 
+#if __MINGW32__ && !_WIN64
+    #include "mingw32_threads/mingw.thread.h"
+#else
+    #include <thread>
+#endif
+
 #include <vector>
 #include <string>
 #include <sstream>
@@ -32,6 +38,7 @@ SOFTWARE.
 
 #include "vmath.h"
 #include "fluidsimassert.h"
+#include "threadutils.h"
 
 
 enum class AttributeDataType : char { 
@@ -272,10 +279,58 @@ private:
         }
     }
 
+    // Thread intervals of a removal mask and the offset of the first kept
+    // particle of each interval in the compacted attribute vectors
+    struct RemovalLayout {
+        std::vector<int> intervals;
+        std::vector<size_t> offsets;
+
+        bool isParallel() { return intervals.size() > 2; }
+        size_t getNumKept() { return offsets.back(); }
+    };
+
+    RemovalLayout _getRemovalLayout(std::vector<bool> &toRemove);
+    void _countKeptParticlesThread(int startidx, int endidx, 
+                                   std::vector<bool> *toRemove, 
+                                   size_t *count);
+
     template<class T>
-    inline void _removeParticlesFromVector(T &vector, std::vector<bool> &toRemove) {
+    inline void _removeParticlesFromVector(std::vector<T> &vector, 
+                                           std::vector<bool> &toRemove, 
+                                           RemovalLayout &layout) {
         FLUIDSIM_ASSERT(vector.size() == toRemove.size());
 
+        if (!layout.isParallel()) {
+            _removeParticlesFromVectorSerial(vector, toRemove);
+            return;
+        }
+
+        std::vector<T> compacted(layout.getNumKept());
+        int numthreads = (int)layout.intervals.size() - 1;
+        std::vector<std::thread> threads(numthreads);
+        for (int i = 0; i < numthreads; i++) {
+            threads[i] = std::thread(&ParticleSystem::_compactVectorThread<T>, this,
+                                     layout.intervals[i], layout.intervals[i + 1], layout.offsets[i],
+                                     &vector, &toRemove, &compacted);
+        }
+
+        for (int i = 0; i < numthreads; i++) {
+            threads[i].join();
+        }
+
+        vector.swap(compacted);
+    }
+
+    // Bool vectors are bit packed and cannot be written by multiple threads
+    inline void _removeParticlesFromVector(std::vector<bool> &vector, 
+                                           std::vector<bool> &toRemove, 
+                                           RemovalLayout &) {
+        FLUIDSIM_ASSERT(vector.size() == toRemove.size());
+        _removeParticlesFromVectorSerial(vector, toRemove);
+    }
+
+    template<class T>
+    inline void _removeParticlesFromVectorSerial(T &vector, std::vector<bool> &toRemove) {
         int currentidx = 0;
         for (size_t i = 0; i < vector.size(); i++) {
             if (!toRemove[i]) {
@@ -287,9 +342,24 @@ private:
     }
 
     template<class T>
-    inline void _removeParticlesFromVectorList(T &vectorList, std::vector<bool> &toRemove) {
+    void _compactVectorThread(int startidx, int endidx, size_t offset,
+                              std::vector<T> *vector, 
+                              std::vector<bool> *toRemove, 
+                              std::vector<T> *compacted) {
+        for (int i = startidx; i < endidx; i++) {
+            if (!(*toRemove)[i]) {
+                (*compacted)[offset] = (*vector)[i];
+                offset++;
+            }
+        }
+    }
+
+    template<class T>
+    inline void _removeParticlesFromVectorList(T &vectorList, 
+                                               std::vector<bool> &toRemove, 
+                                               RemovalLayout &layout) {
         for (size_t i = 0; i < vectorList.size(); i++) {
-            _removeParticlesFromVector(vectorList[i], toRemove);
+            _removeParticlesFromVector(vectorList[i], toRemove, layout);
         }
     }
 
@@ -301,6 +371,7 @@ private:
     }
 
     size_t _size = 0;
+    size_t _minParallelRemovalSize = 65536;
 
     std::vector<ParticleSystemAttribute> _attributes;
 
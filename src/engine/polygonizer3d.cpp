@@ -23,6 +23,9 @@ SOFTWARE.
 */
 
 #include "polygonizer3d.h"
+
+#include <cstring>
+
 #include "scalarfield.h"
 #include "grid3d.h"
 #include "meshlevelset.h"
@@ -363,90 +366,6 @@ vmath::vec3 Polygonizer3d::_getVertexPosition(GridIndex g) {
     return (float)_dx*vmath::vec3((float)g.i, (float)g.j, (float)g.k);
 }
 
-void Polygonizer3d::_findSurfaceCells(Array3d<bool> &isSurfaceCell) {
-
-    bool isEmpty = true;
-    for (int k = 0; k < _ksize + 1; k++) {
-        for (int j = 0; j < _jsize + 1; j++) {
-            for (int i = 0; i < _isize + 1; i++) {
-                if (_scalarField->getScalarFieldValue(i, j, k) > _surfaceThreshold) {
-                    isEmpty = false;
-                    goto endLoop;
-                }
-            }
-        }
-    }
-    endLoop:
-
-    if (isEmpty) {
-        return;
-    }
-
-    std::vector<GridIndex> workQueue({GridIndex(0, 0, 0),
-                                      GridIndex(1, 0, 0),
-                                      GridIndex(0, 1, 0),
-                                      GridIndex(1, 1, 0),
-                                      GridIndex(0, 0, 1),
-                                      GridIndex(1, 0, 1),
-                                      GridIndex(0, 1, 1),
-                                      GridIndex(1, 1, 1)});
-
-    int numCPU = ThreadUtils::getMaxThreadCount();
-    int numthreads = (int)fmin(numCPU, workQueue.size());
-    std::vector<std::thread> threads(numthreads);
-    FLUIDSIM_ASSERT(numthreads > 0);
-
-    Array3d<bool> hasInsideNode(_isize, _jsize, _ksize, false);
-    Array3d<bool> hasOutsideNode(_isize, _jsize, _ksize, false);
-
-    while (!workQueue.empty()) {
-
-        numthreads = (int)fmin(numCPU, workQueue.size());
-        for (int tidx = 0; tidx < numthreads; tidx++) {
-            GridIndex gridOffset = workQueue.back();
-            workQueue.pop_back();
-
-            threads[tidx] = std::thread(&Polygonizer3d::_getCellNodeStatusThread, this,
-                                        gridOffset, &hasInsideNode, &hasOutsideNode);
-        }
-
-        for (int tidx = 0; tidx < numthreads; tidx++) {
-            threads[tidx].join();
-        }
-    }
-
-    for (int k = 0; k < _ksize; k++) {
-        for (int j = 0; j < _jsize; j++) {
-            for (int i = 0; i < _isize; i++) {
-                if (hasInsideNode(i, j, k) && hasOutsideNode(i, j, k)) {
-                    isSurfaceCell.set(i, j, k, true);
-                }
-            }
-        }
-    }
-
-}
-
-void Polygonizer3d::_getCellNodeStatusThread(GridIndex gridOffset, 
-                                             Array3d<bool> *hasInsideNode, 
-                                             Array3d<bool> *hasOutsideNode) {
-
-    for (int k = 0; k < _ksize; k++) {
-        for (int j = 0; j < _jsize; j++) {
-            for (int i = 0; i < _isize; i++) {
-                double v = _scalarField->getScalarFieldValue(i + gridOffset.i,
-                                                             j + gridOffset.j,
-                                                             k + gridOffset.k);
-                if (v > _surfaceThreshold) {
-                    hasInsideNode->set(i, j, k, true);
-                } else {
-                    hasOutsideNode->set(i, j, k, true);
-                }
-            }
-        }
-    }
-}
-
 int Polygonizer3d::_calculateCubeIndex(GridIndex g) {
     GridIndex vs[8];
     Grid3d::getGridIndexVertices(g, vs);
@@ -504,9 +423,11 @@ vmath::vec3 Polygonizer3d::_vertexInterp(vmath::vec3 p1, vmath::vec3 p2,
 void Polygonizer3d::_calculateVertexList(GridIndex g,
                                          int cubeIndex, 
                                          EdgeGrid &edges,
+                                         GridIndex edgeOffset,
                                          std::vector<vmath::vec3> &meshVertices,
                                          int vertexList[12]) {
     GridIndex vertices[8];
+    GridIndex edgeIndices[8];
     double values[8];
     vmath::vec3 positions[8];
     vmath::vec3 v;
@@ -515,103 +436,106 @@ void Polygonizer3d::_calculateVertexList(GridIndex g,
     for (int i = 0; i < 8; i++) {
         values[i] = _scalarField->getScalarFieldValue(vertices[i]);
         positions[i] = _getVertexPosition(vertices[i]);
+        edgeIndices[i] = GridIndex(vertices[i].i - edgeOffset.i, 
+                                   vertices[i].j - edgeOffset.j, 
+                                   vertices[i].k - edgeOffset.k);
     }
 
     if (_edgeTable[cubeIndex] & 1) {
-        if (edges.U(vertices[0]) == -1) {
+        if (edges.U(edgeIndices[0]) == -1) {
             v = _vertexInterp(positions[0], positions[1], values[0], values[1]);
             meshVertices.push_back(v);
-            edges.U.set(vertices[0], (int)meshVertices.size() - 1);
+            edges.U.set(edgeIndices[0], (int)meshVertices.size() - 1);
         }
-        vertexList[0] = edges.U(vertices[0]);
+        vertexList[0] = edges.U(edgeIndices[0]);
     }
     if (_edgeTable[cubeIndex] & 2) {
-        if (edges.W(vertices[1]) == -1) {
+        if (edges.W(edgeIndices[1]) == -1) {
             v = _vertexInterp(positions[1], positions[2], values[1], values[2]);
             meshVertices.push_back(v);
-            edges.W.set(vertices[1], (int)meshVertices.size() - 1);
+            edges.W.set(edgeIndices[1], (int)meshVertices.size() - 1);
         }
-        vertexList[1] = edges.W(vertices[1]);
+        vertexList[1] = edges.W(edgeIndices[1]);
     }
     if (_edgeTable[cubeIndex] & 4) {
-        if (edges.U(vertices[3]) == -1) {
+        if (edges.U(edgeIndices[3]) == -1) {
             v = _vertexInterp(positions[2], positions[3], values[2], values[3]);
             meshVertices.push_back(v);
-            edges.U.set(vertices[3], (int)meshVertices.size() - 1);
+            edges.U.set(edgeIndices[3], (int)meshVertices.size() - 1);
         }
-        vertexList[2] = edges.U(vertices[3]);
+        vertexList[2] = edges.U(edgeIndices[3]);
     }
     if (_edgeTable[cubeIndex] & 8) {
-        if (edges.W(vertices[0]) == -1) {
+        if (edges.W(edgeIndices[0]) == -1) {
             v = _vertexInterp(positions[3], positions[0], values[3], values[0]);
             meshVertices.push_back(v);
-            edges.W.set(vertices[0], (int)meshVertices.size() - 1);
+            edges.W.set(edgeIndices[0], (int)meshVertices.size() - 1);
         }
-        vertexList[3] = edges.W(vertices[0]);
+        vertexList[3] = edges.W(edgeIndices[0]);
     }
     if (_edgeTable[cubeIndex] & 16) {
-        if (edges.U(vertices[4]) == -1) {
+        if (edges.U(edgeIndices[4]) == -1) {
             v = _vertexInterp(positions[4], positions[5], values[4], values[5]);
             meshVertices.push_back(v);
-            edges.U.set(vertices[4], (int)meshVertices.size() - 1);
+            edges.U.set(edgeIndices[4], (int)meshVertices.size() - 1);
         }
-        vertexList[4] = edges.U(vertices[4]);
+        vertexList[4] = edges.U(edgeIndices[4]);
     }
     if (_edgeTable[cubeIndex] & 32) {
-        if (edges.W(vertices[5]) == -1) {
+        if (edges.W(edgeIndices[5]) == -1) {
             v = _vertexInterp(positions[5], positions[6], values[5], values[6]);
             meshVertices.push_back(v);
-            edges.W.set(vertices[5], (int)meshVertices.size() - 1);
+            edges.W.set(edgeIndices[5], (int)meshVertices.size() - 1);
         }
-        vertexList[5] = edges.W(vertices[5]);
+        vertexList[5] = edges.W(edgeIndices[5]);
     }
     if (_edgeTable[cubeIndex] & 64) {
-        if (edges.U(vertices[7]) == -1) {
+        if (edges.U(edgeIndices[7]) == -1) {
             v = _vertexInterp(positions[6], positions[7], values[6], values[7]);
             meshVertices.push_back(v);
-            edges.U.set(vertices[7], (int)meshVertices.size() - 1);
+            edges.U.set(edgeIndices[7], (int)meshVertices.size() - 1);
         }
-        vertexList[6] = edges.U(vertices[7]);
+        vertexList[6] = edges.U(edgeIndices[7]);
     }
     if (_edgeTable[cubeIndex] & 128) {
-        if (edges.W(vertices[4]) == -1) {
+        if (edges.W(edgeIndices[4]) == -1) {
             v = _vertexInterp(positions[7], positions[4], values[7], values[4]);
             meshVertices.push_back(v);
-            edges.W.set(vertices[4], (int)meshVertices.size() - 1);
+            edges.W.set(edgeIndices[4], (int)meshVertices.size() - 1);
         }
-        vertexList[7] = edges.W(vertices[4]);
+        vertexList[7] = edges.W(edgeIndices[4]);
     }
     if (_edgeTable[cubeIndex] & 256) {
-        if (edges.V(vertices[0]) == -1) {
+        if (edges.V(edgeIndices[0]) == -1) {
             v = _vertexInterp(positions[0], positions[4], values[0], values[4]);
             meshVertices.push_back(v);
-            edges.V.set(vertices[0], (int)meshVertices.size() - 1);
+            edges.V.set(edgeIndices[0], (int)meshVertices.size() - 1);
         }
-        vertexList[8] = edges.V(vertices[0]);
+        vertexList[8] = edges.V(edgeIndices[0]);
     }
     if (_edgeTable[cubeIndex] & 512) {
-        if (edges.V(vertices[1]) == -1) {
+        if (edges.V(edgeIndices[1]) == -1) {
             v = _vertexInterp(positions[1], positions[5], values[1], values[5]);
             meshVertices.push_back(v);
-            edges.V.set(vertices[1], (int)meshVertices.size() - 1);
+            edges.V.set(edgeIndices[1], (int)meshVertices.size() - 1);
         }
-        vertexList[9] = edges.V(vertices[1]);
+        vertexList[9] = edges.V(edgeIndices[1]);
     }
     if (_edgeTable[cubeIndex] & 1024) {
-        if (edges.V(vertices[2]) == -1) {
+        if (edges.V(edgeIndices[2]) == -1) {
             v = _vertexInterp(positions[2], positions[6], values[2], values[6]);
             meshVertices.push_back(v);
-            edges.V.set(vertices[2], (int)meshVertices.size() - 1);
+            edges.V.set(edgeIndices[2], (int)meshVertices.size() - 1);
         }
-        vertexList[10] = edges.V(vertices[2]);
+        vertexList[10] = edges.V(edgeIndices[2]);
     }
     if (_edgeTable[cubeIndex] & 2048) {
-        if (edges.V(vertices[3]) == -1) {
+        if (edges.V(edgeIndices[3]) == -1) {
             v = _vertexInterp(positions[3], positions[7], values[3], values[7]);
             meshVertices.push_back(v);
-            edges.V.set(vertices[3], (int)meshVertices.size() - 1);
+            edges.V.set(edgeIndices[3], (int)meshVertices.size() - 1);
         }
-        vertexList[11] = edges.V(vertices[3]);
+        vertexList[11] = edges.V(edgeIndices[3]);
     }
 }
 
@@ -619,6 +543,7 @@ void Polygonizer3d::_calculateVertexList(GridIndex g,
 // http://paulbourke.net/geometry/polygonise/
 void Polygonizer3d::_polygonizeCell(GridIndex g,
                                     EdgeGrid &edges, 
+                                    GridIndex edgeOffset,
                                     TriangleMesh &mesh) {
 
     int cubeIndex = _calculateCubeIndex(g);
@@ -629,7 +554,7 @@ void Polygonizer3d::_polygonizeCell(GridIndex g,
     }
 
     int vertexList[12];
-    _calculateVertexList(g, cubeIndex, edges, mesh.vertices, vertexList);
+    _calculateVertexList(g, cubeIndex, edges, edgeOffset, mesh.vertices, vertexList);
 
     for (int i = 0; _triTable[cubeIndex][i] != -1; i += 3) {
         Triangle t = Triangle(vertexList[_triTable[cubeIndex][i]],
@@ -640,20 +565,6 @@ void Polygonizer3d::_polygonizeCell(GridIndex g,
     }
 }
 
-void Polygonizer3d::_calculateSurfaceTriangles(Array3d<bool> &isSurfaceCell,
-                                               TriangleMesh &mesh) {
-    EdgeGrid edges(_isize, _jsize, _ksize);
-    for (int k = 0; k < _ksize; k++) {
-        for (int j = 0; j < _jsize; j++) {
-            for (int i = 0; i < _isize; i++) {
-                if (isSurfaceCell(i, j, k)) {
-                    _polygonizeCell(GridIndex(i, j, k), edges, mesh);
-                }
-            }
-        }
-    }
-}
-
 void Polygonizer3d::setSurfaceCellMask(Array3d<bool> *mask) {
     FLUIDSIM_ASSERT(mask->width == _isize && 
            mask->height == _jsize && 
@@ -663,14 +574,350 @@ void Polygonizer3d::setSurfaceCellMask(Array3d<bool> *mask) {
     _isSurfaceCellMaskSet = true;
 }
 
+void Polygonizer3d::setBlockMeshCache(BlockMeshCache *cache, unsigned long long signature) {
+    if (cache->signature != signature) {
+        cache->blocks.clear();
+        cache->signature = signature;
+    }
+
+    _blockMeshCache = cache;
+    _isBlockMeshCacheSet = true;
+}
+
+void Polygonizer3d::_getBlockGridDimensions(int *bi, int *bj, int *bk) {
+    *bi = (int)ceil((double)_isize / (double)_blockWidth);
+    *bj = (int)ceil((double)_jsize / (double)_blockWidth);
+    *bk = (int)ceil((double)_ksize / (double)_blockWidth);
+}
+
+GridIndex Polygonizer3d::_getBlockOffset(GridIndex blockIndex) {
+    return GridIndex(blockIndex.i * _blockWidth, 
+                     blockIndex.j * _blockWidth, 
+                     blockIndex.k * _blockWidth);
+}
+
+bool Polygonizer3d::_isSurfaceBlock(GridIndex blockIndex) {
+    GridIndex offset = _getBlockOffset(blockIndex);
+    int imax = (int)fmin(offset.i + _blockWidth, _isize);
+    int jmax = (int)fmin(offset.j + _blockWidth, _jsize);
+    int kmax = (int)fmin(offset.k + _blockWidth, _ksize);
+
+    bool hasInsideNode = false;
+    bool hasOutsideNode = false;
+    for (int k = offset.k; k <= kmax; k++) {
+        for (int j = offset.j; j <= jmax; j++) {
+            for (int i = offset.i; i <= imax; i++) {
+                if (_scalarField->getScalarFieldValue(i, j, k) > _surfaceThreshold) {
+                    hasInsideNode = true;
+                } else {
+                    hasOutsideNode = true;
+                }
+
+                if (hasInsideNode && hasOutsideNode) {
+                    return true;
+                }
+            }
+        }
+    }
+
+    return false;
+}
+
+void Polygonizer3d::_findSurfaceBlocks(std::vector<GridIndex> &surfaceBlocks) {
+    int bi, bj, bk;
+    _getBlockGridDimensions(&bi, &bj, &bk);
+    int numBlocks = bi * bj * bk;
+    if (numBlocks == 0) {
+        return;
+    }
+
+    std::vector<int> isSurfaceBlock(numBlocks, 0);
+
+    int numCPU = ThreadUtils::getMaxThreadCount();
+    int numthreads = (int)fmin(numCPU, numBlocks);
+    std::vector<std::thread> threads(numthreads);
+    std::vector<int> intervals = ThreadUtils::splitRangeIntoIntervals(0, numBlocks, numthreads);
+    for (int i = 0; i < numthreads; i++) {
+        threads[i] = std::thread(&Polygonizer3d::_findSurfaceBlocksThread, this,
+                                 intervals[i], intervals[i + 1], &isSurfaceBlock);
+    }
+
+    for (int i = 0; i < numthreads; i++) {
+        threads[i].join();
+    }
+
+    for (int i = 0; i < numBlocks; i++) {
+        if (isSurfaceBlock[i]) {
+            surfaceBlocks.push_back(Grid3d::getUnflattenedIndex(i, bi, bj));
+        }
+    }
+}
+
+void Polygonizer3d::_findSurfaceBlocksThread(int startidx, int endidx, 
+                                             std::vector<int> *isSurfaceBlock) {
+    int bi, bj, bk;
+    _getBlockGridDimensions(&bi, &bj, &bk);
+    for (int idx = startidx; idx < endidx; idx++) {
+        GridIndex b = Grid3d::getUnflattenedIndex(idx, bi, bj);
+        (*isSurfaceBlock)[idx] = _isSurfaceBlock(b) ? 1 : 0;
+    }
+}
+
+void Polygonizer3d::_polygonizeBlock(GridIndex blockIndex, 
+                                     EdgeGrid &edges, 
+                                     BlockMesh &blockMesh) {
+    edges.U.fill(-1);
+    edges.V.fill(-1);
+    edges.W.fill(-1);
+
+    GridIndex offset = _getBlockOffset(blockIndex);
+    int imax = (int)fmin(offset.i + _blockWidth, _isize);
+    int jmax = (int)fmin(offset.j + _blockWidth, _jsize);
+    int kmax = (int)fmin(offset.k + _blockWidth, _ksize);
+    for (int k = offset.k; k < kmax; k++) {
+        for (int j = offset.j; j < jmax; j++) {
+            for (int i = offset.i; i < imax; i++) {
+                _polygonizeCell(GridIndex(i, j, k), edges, offset, blockMesh.mesh);
+            }
+        }
+    }
+
+    // Vertices on the faces of the block are shared with neighbouring blocks
+    // and are recorded by global edge so that they can be welded when merging
+    int w = _blockWidth;
+    int vidx;
+    for (int k = 0; k < edges.U.depth; k++) {
+        for (int j = 0; j < edges.U.height; j++) {
+            for (int i = 0; i < edges.U.width; i++) {
+                vidx = edges.U(i, j, k);
+                if (vidx != -1 && (j == 0 || j == w || k == 0 || k == w)) {
+                    GridIndex g(i + offset.i, j + offset.j, k + offset.k);
+                    blockMesh.seamVertices.push_back(vidx);
+                    blockMesh.seamEdges.push_back(_getEdgeKey(g, 0));
+                }
+            }
+        }
+    }
+
+    for (int k = 0; k < edges.V.depth; k++) {
+        for (int j = 0; j < edges.V.height; j++) {
+            for (int i = 0; i < edges.V.width; i++) {
+                vidx = edges.V(i, j, k);
+                if (vidx != -1 && (i == 0 || i == w || k == 0 || k == w)) {
+                    GridIndex g(i + offset.i, j + offset.j, k + offset.k);
+                    blockMesh.seamVertices.push_back(vidx);
+                    blockMesh.seamEdges.push_back(_getEdgeKey(g, 1));
+                }
+            }
+        }
+    }
+
+    for (int k = 0; k < edges.W.depth; k++) {
+        for (int j = 0; j < edges.W.height; j++) {
+            for (int i = 0; i < edges.W.width; i++) {
+                vidx = edges.W(i, j, k);
+                if (vidx != -1 && (i == 0 || i == w || j == 0 || j == w)) {
+                    GridIndex g(i + offset.i, j + offset.j, k + offset.k);
+                    blockMesh.seamVertices.push_back(vidx);
+                    blockMesh.seamEdges.push_back(_getEdgeKey(g, 2));
+                }
+            }
+        }
+    }
+}
+
+void Polygonizer3d::_polygonizeBlocksThread(std::atomic<int> *nextBlock,
+                                            std::vector<GridIndex> *surfaceBlocks,
+                                            std::vector<BlockMesh> *blockMeshes,
+                                            std::vector<unsigned long long> *blockHashes) {
+    int bi, bj, bk;
+    _getBlockGridDimensions(&bi, &bj, &bk);
+
+    EdgeGrid edges(_blockWidth, _blockWidth, _blockWidth);
+    int numBlocks = (int)surfaceBlocks->size();
+    for (;;) {
+        int startidx = nextBlock->fetch_add(_blockBatchSize);
+        if (startidx >= numBlocks) {
+            break;
+        }
+
+        int endidx = (int)fmin(startidx + _blockBatchSize, numBlocks);
+        for (int idx = startidx; idx < endidx; idx++) {
+            GridIndex b = surfaceBlocks->at(idx);
+            if (_isBlockMeshCacheSet) {
+                // The cache is only read while blocks are polygonized
+                unsigned long long hash = _getBlockHash(b);
+                (*blockHashes)[idx] = hash;
+
+                int flatidx = Grid3d::getFlatIndex(b, bi, bj);
+                auto it = _blockMeshCache->blocks.find(flatidx);
+                if (it != _blockMeshCache->blocks.end() && it->second.hash == hash) {
+                    (*blockMeshes)[idx] = it->second.blockMesh;
+                    continue;
+                }
+            }
+
+            _polygonizeBlock(b, edges, blockMeshes->at(idx));
+        }
+    }
+}
+
+unsigned long long Polygonizer3d::_getBlockHash(GridIndex blockIndex) {
+    GridIndex offset = _getBlockOffset(blockIndex);
+    int imax = (int)fmin(offset.i + _blockWidth, _isize);
+    int jmax = (int)fmin(offset.j + _blockWidth, _jsize);
+    int kmax = (int)fmin(offset.k + _blockWidth, _ksize);
+
+    // 64-bit FNV-1a over the 32-bit node values
+    unsigned long long hash = 14695981039346656037ULL;
+    for (int k = offset.k; k <= kmax; k++) {
+        for (int j = offset.j; j <= jmax; j++) {
+            for (int i = offset.i; i <= imax; i++) {
+                float value = (float)_scalarField->getScalarFieldValue(i, j, k);
+                unsigned int bits;
+                std::memcpy(&bits, &value, sizeof(float));
+                hash ^= (unsigned long long)bits;
+                hash *= 1099511628211ULL;
+            }
+        }
+    }
+
+    return hash;
+}
+
+void Polygonizer3d::_updateBlockMeshCache(std::vector<GridIndex> &surfaceBlocks,
+                                          std::vector<BlockMesh> &blockMeshes,
+                                          std::vector<unsigned long long> &blockHashes) {
+    int bi, bj, bk;
+    _getBlockGridDimensions(&bi, &bj, &bk);
+
+    std::unordered_map<int, CachedBlockMesh> blocks;
+    blocks.reserve(surfaceBlocks.size());
+    int numReusedBlocks = 0;
+    for (size_t idx = 0; idx < surfaceBlocks.size(); idx++) {
+        int flatidx = Grid3d::getFlatIndex(surfaceBlocks[idx], bi, bj);
+        auto it = _blockMeshCache->blocks.find(flatidx);
+        if (it != _blockMeshCache->blocks.end() && it->second.hash == blockHashes[idx]) {
+            numReusedBlocks++;
+        }
+
+        CachedBlockMesh cached;
+        cached.hash = blockHashes[idx];
+        cached.blockMesh = blockMeshes[idx];
+        blocks.insert(std::make_pair(flatidx, cached));
+    }
+
+    _blockMeshCache->blocks.swap(blocks);
+    _blockMeshCache->numBlocks += (int)surfaceBlocks.size();
+    _blockMeshCache->numReusedBlocks += numReusedBlocks;
+}
+
+unsigned long long Polygonizer3d::_getEdgeKey(GridIndex g, int direction) {
+    unsigned long long ni = (unsigned long long)_isize + 1;
+    unsigned long long nj = (unsigned long long)_jsize + 1;
+    unsigned long long flatidx = (unsigned long long)g.i + ni * 
+                                 ((unsigned long long)g.j + nj * (unsigned long long)g.k);
+    return 3 * flatidx + (unsigned long long)direction;
+}
+
+/*
+    Block meshes are appended in block order. The merged mesh has the same 
+    surface as a serial cell walk over the whole grid, but vertices and 
+    triangles are ordered by block rather than by cell, so vertex and 
+    triangle indices differ from the serial order.
+*/
+void Polygonizer3d::_mergeBlockMeshes(std::vector<BlockMesh> &blockMeshes, 
+                                      TriangleMesh &mesh) {
+    size_t vertexCount = 0;
+    size_t triangleCount = 0;
+    size_t seamCount = 0;
+    for (size_t i = 0; i < blockMeshes.size(); i++) {
+        vertexCount += blockMeshes[i].mesh.vertices.size();
+        triangleCount += blockMeshes[i].mesh.triangles.size();
+        seamCount += blockMeshes[i].seamVertices.size();
+    }
+
+    mesh.vertices.reserve(vertexCount);
+    mesh.triangles.reserve(triangleCount);
+
+    std::unordered_map<unsigned long long, int> seamVertexTable;
+    seamVertexTable.reserve(seamCount);
+
+    std::vector<int> indexTable;
+    for (size_t bidx = 0; bidx < blockMeshes.size(); bidx++) {
+        BlockMesh *b = &(blockMeshes[bidx]);
+
+        indexTable.assign(b->mesh.vertices.size(), -1);
+        for (size_t i = 0; i < b->seamVertices.size(); i++) {
+            auto it = seamVertexTable.find(b->seamEdges[i]);
+            if (it != seamVertexTable.end()) {
+                indexTable[b->seamVertices[i]] = it->second;
+            }
+        }
+
+        for (size_t i = 0; i < b->mesh.vertices.size(); i++) {
+            if (indexTable[i] == -1) {
+                indexTable[i] = (int)mesh.vertices.size();
+                mesh.vertices.push_back(b->mesh.vertices[i]);
+            }
+        }
+
+        for (size_t i = 0; i < b->seamVertices.size(); i++) {
+            seamVertexTable.insert(std::make_pair(b->seamEdges[i], 
+                                                  indexTable[b->seamVertices[i]]));
+        }
+
+        for (size_t i = 0; i < b->mesh.triangles.size(); i++) {
+            Triangle t = b->mesh.triangles[i];
+            mesh.triangles.push_back(Triangle(indexTable[t.tri[0]], 
+                                              indexTable[t.tri[1]], 
+                                              indexTable[t.tri[2]]));
+        }
+
+        b->mesh = TriangleMesh();
+        b->seamVertices = std::vector<int>();
+        b->seamEdges = std::vector<unsigned long long>();
+    }
+}
+
 TriangleMesh Polygonizer3d::polygonizeSurface() {
     FLUIDSIM_ASSERT(_isScalarFieldSet);
 
-    Array3d<bool> isSurfaceCell(_isize, _jsize, _ksize, false);
-    _findSurfaceCells(isSurfaceCell);
-
     TriangleMesh mesh;
-    _calculateSurfaceTriangles(isSurfaceCell, mesh);
+
+    std::vector<GridIndex> surfaceBlocks;
+    _findSurfaceBlocks(surfaceBlocks);
+    if (surfaceBlocks.empty()) {
+        if (_isBlockMeshCacheSet) {
+            _blockMeshCache->blocks.clear();
+        }
+        return mesh;
+    }
+
+    std::vector<BlockMesh> blockMeshes(surfaceBlocks.size());
+    std::vector<unsigned long long> blockHashes;
+    if (_isBlockMeshCacheSet) {
+        blockHashes = std::vector<unsigned long long>(surfaceBlocks.size(), 0);
+    }
+    std::atomic<int> nextBlock(0);
+
+    int numCPU = ThreadUtils::getMaxThreadCount();
+    int numthreads = (int)fmin(numCPU, surfaceBlocks.size());
+    std::vector<std::thread> threads(numthreads);
+    for (int i = 0; i < numthreads; i++) {
+        threads[i] = std::thread(&Polygonizer3d::_polygonizeBlocksThread, this,
+                                 &nextBlock, &surfaceBlocks, &blockMeshes, &blockHashes);
+    }
+
+    for (int i = 0; i < numthreads; i++) {
+        threads[i].join();
+    }
+
+    if (_isBlockMeshCacheSet) {
+        _updateBlockMeshCache(surfaceBlocks, blockMeshes, blockHashes);
+    }
+
+    _mergeBlockMeshes(blockMeshes, mesh);
 
     return mesh;
-}
\ No newline at end of file
+}
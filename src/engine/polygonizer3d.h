@@ -30,12 +30,15 @@ SOFTWARE.
     #include <thread>
 #endif
 
+#include <atomic>
+#include <unordered_map>
+
 #include "threadutils.h"
 #include "array3d.h"
 #include "vmath.h"
+#include "trianglemesh.h"
 
 class ScalarField;
-class TriangleMesh;
 class MeshLevelSet;
 
 class Polygonizer3d
@@ -50,6 +53,30 @@ public:
     void setSurfaceCellMask(Array3d<bool> *mask);
     TriangleMesh polygonizeSurface();
 
+    struct BlockMesh {
+        TriangleMesh mesh;
+        std::vector<int> seamVertices;                // index to vertex in mesh
+        std::vector<unsigned long long> seamEdges;    // global edge key
+    };
+
+    struct CachedBlockMesh {
+        unsigned long long hash = 0;
+        BlockMesh blockMesh;
+    };
+
+    // Block meshes of a previous polygonization. A surface block whose node
+    // values hash to the cached value reuses the cached block mesh. The
+    // signature identifies everything other than the node values that the 
+    // block meshes depend on and cached blocks are discarded when it changes.
+    struct BlockMeshCache {
+        unsigned long long signature = 0;
+        std::unordered_map<int, CachedBlockMesh> blocks;
+        int numBlocks = 0;
+        int numReusedBlocks = 0;
+    };
+
+    void setBlockMeshCache(BlockMeshCache *cache, unsigned long long signature);
+
 private:
     struct EdgeGrid {
         Array3d<int> U;         // store index to vertex
@@ -68,19 +95,32 @@ private:
 
     vmath::vec3 _getVertexPosition(GridIndex v);
     double _getVertexFieldValue(GridIndex v);
-    void _polygonizeCell(GridIndex g, EdgeGrid &edges, TriangleMesh &mesh);
+    void _polygonizeCell(GridIndex g, EdgeGrid &edges, GridIndex edgeOffset, TriangleMesh &mesh);
     int _calculateCubeIndex(GridIndex g);
     void _calculateVertexList(GridIndex g,
                               int cubeIndex, 
                               EdgeGrid &edges, 
+                              GridIndex edgeOffset,
                               std::vector<vmath::vec3> &meshVertices, 
                               int vertList[12]);
     vmath::vec3 _vertexInterp(vmath::vec3 p1, vmath::vec3 p2, double valp1, double valp2);
-    void _calculateSurfaceTriangles(Array3d<bool> &isSurfaceCell, TriangleMesh &mesh);
-    void _findSurfaceCells(Array3d<bool> &isSurfaceCell);
-    void _getCellNodeStatusThread(GridIndex gridOffset, 
-                                  Array3d<bool> *hasInsideNode, 
-                                  Array3d<bool> *hasOutsideNode);
+    void _getBlockGridDimensions(int *bi, int *bj, int *bk);
+    GridIndex _getBlockOffset(GridIndex blockIndex);
+    bool _isSurfaceBlock(GridIndex blockIndex);
+    void _findSurfaceBlocks(std::vector<GridIndex> &surfaceBlocks);
+    void _findSurfaceBlocksThread(int startidx, int endidx, 
+                                  std::vector<int> *isSurfaceBlock);
+    void _polygonizeBlock(GridIndex blockIndex, EdgeGrid &edges, BlockMesh &blockMesh);
+    void _polygonizeBlocksThread(std::atomic<int> *nextBlock,
+                                 std::vector<GridIndex> *surfaceBlocks,
+                                 std::vector<BlockMesh> *blockMeshes,
+                                 std::vector<unsigned long long> *blockHashes);
+    unsigned long long _getBlockHash(GridIndex blockIndex);
+    void _updateBlockMeshCache(std::vector<GridIndex> &surfaceBlocks,
+                               std::vector<BlockMesh> &blockMeshes,
+                               std::vector<unsigned long long> &blockHashes);
+    unsigned long long _getEdgeKey(GridIndex g, int direction);
+    void _mergeBlockMeshes(std::vector<BlockMesh> &blockMeshes, TriangleMesh &mesh);
 
 
     static const int _edgeTable[256];
@@ -93,6 +133,11 @@ private:
 
     double _surfaceThreshold = 0.5;
 
+    // Cells are polygonized in cubic blocks of width _blockWidth. Threads
+    // claim _blockBatchSize surface blocks at a time
+    int _blockWidth = 16;
+    int _blockBatchSize = 4;
+
     ScalarField *_scalarField;
     bool _isScalarFieldSet = false;
 
@@ -102,4 +147,7 @@ private:
     Array3d<bool> *_surfaceCellMask;
     bool _isSurfaceCellMaskSet = false;
 
+    BlockMeshCache *_blockMeshCache;
+    bool _isBlockMeshCacheSet = false;
+
 };
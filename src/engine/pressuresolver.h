@@ -38,6 +38,7 @@ SOFTWARE.
 #include "gridindexkeymap.h"
 #include "gridindexvector.h"
 #include "fluidmaterialgrid.h"
+#include "blockarray3d.h"
 #include "vmath.h"
 #include "fluidsimassert.h"
 
@@ -47,10 +48,10 @@ class ParticleLevelSet;
 class MeshLevelSet;
 
 struct WeightGrid {
-    Array3d<float> center;
-    Array3d<float> U;
-    Array3d<float> V;
-    Array3d<float> W;
+    Array3d<StorageFloat> center;
+    Array3d<StorageFloat> U;
+    Array3d<StorageFloat> V;
+    Array3d<StorageFloat> W;
 
     WeightGrid() {}
     WeightGrid(int i, int j, int k) :
@@ -106,14 +107,14 @@ struct PressureSolverParameters {
     MACVelocityField *velocityFieldFluid;
     MACVelocityField *velocityFieldSolid;
     ValidVelocityComponentGrid *validVelocities;
-    Array3d<float> *liquidSDF;
+    Array3d<StorageFloat> *liquidSDF;
     WeightGrid *weightGrid;
     Array3d<float> *pressureGrid;
     Array3d<float> *densityGrid;
 
     bool isSurfaceTensionEnabled = false;
     double surfaceTensionConstant;
-    Array3d<float> *curvatureGrid;
+    BlockArray3d<float> *curvatureGrid;
 };
 
 /********************************************************************************
@@ -213,14 +214,14 @@ private:
     MACVelocityField *_vFieldFluid;
     MACVelocityField *_vFieldSolid;
     ValidVelocityComponentGrid *_validVelocities;
-    Array3d<float> *_liquidSDF;
+    Array3d<StorageFloat> *_liquidSDF;
     WeightGrid *_weightGrid;
     Array3d<float> *_pressureGrid;
     Array3d<float> *_densityGrid;
 
     bool _isSurfaceTensionEnabled = false;
     double _surfaceTensionConstant;
-    Array3d<float> *_curvatureGrid;
+    BlockArray3d<float> *_curvatureGrid;
 
     GridIndexVector _pressureCells;
     int _matSize = 0;
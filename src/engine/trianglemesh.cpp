@@ -30,6 +30,7 @@ SOFTWARE.
 
 #include "fluidsimassert.h"
 #include "spatialpointgrid.h"
+#include "threadutils.h"
 
 TriangleMesh::TriangleMesh() {
 }
@@ -277,22 +278,64 @@ bool triangleSort(const Triangle &a, const Triangle &b)
     }
 }
 
+/*
+    Triangles are sorted in parallel runs that are merged pairwise, which
+    gives the same order as a single sort since equal triangles are 
+    indistinguishable.
+*/
 void TriangleMesh::removeDuplicateTriangles() {
-    std::vector<Triangle> uniqueTriangles;
+    if (triangles.empty()) {
+        return;
+    }
 
-    std::sort(triangles.begin(), triangles.end(), triangleSort);
+    int nt = (int)triangles.size();
+    int numCPU = ThreadUtils::getMaxThreadCount();
+    int numthreads = (int)fmax(fmin(numCPU, nt), 1);
+    std::vector<std::thread> threads(numthreads);
+    std::vector<int> intervals = ThreadUtils::splitRangeIntoIntervals(0, nt, numthreads);
+    for (int i = 0; i < numthreads; i++) {
+        threads[i] = std::thread(&TriangleMesh::_sortTrianglesThread, this,
+                                 intervals[i], intervals[i + 1]);
+    }
+    for (int i = 0; i < numthreads; i++) {
+        threads[i].join();
+    }
+
+    for (int width = 1; width < numthreads; width *= 2) {
+        std::vector<std::thread> mergeThreads;
+        for (int i = 0; i + width < numthreads; i += 2 * width) {
+            int endidx = intervals[std::min(i + 2 * width, numthreads)];
+            mergeThreads.push_back(std::thread(&TriangleMesh::_mergeSortedTrianglesThread, this,
+                                               intervals[i], intervals[i + width], endidx));
+        }
+        for (size_t i = 0; i < mergeThreads.size(); i++) {
+            mergeThreads[i].join();
+        }
+    }
+
+    size_t count = 0;
     Triangle last;
-    for (unsigned int i = 0; i < triangles.size(); i++) {
+    for (size_t i = 0; i < triangles.size(); i++) {
         Triangle t = triangles[i];
-
         if (!_trianglesEqual(t, last)) {
-            uniqueTriangles.push_back(t);
+            triangles[count] = t;
+            count++;
         }
         last = t;
     }
+    triangles.resize(count);
+    triangles.shrink_to_fit();
+}
 
-    triangles.clear();
-    triangles.insert(triangles.end(), uniqueTriangles.begin(), uniqueTriangles.end());
+void TriangleMesh::_sortTrianglesThread(int startidx, int endidx) {
+    std::sort(triangles.begin() + startidx, triangles.begin() + endidx, triangleSort);
+}
+
+void TriangleMesh::_mergeSortedTrianglesThread(int startidx, int mididx, int endidx) {
+    std::inplace_merge(triangles.begin() + startidx, 
+                       triangles.begin() + mididx, 
+                       triangles.begin() + endidx, 
+                       triangleSort);
 }
 
 void TriangleMesh::getFaceNeighbours(unsigned int tidx, std::vector<int> &n) {
@@ -619,89 +662,213 @@ vmath::vec3 TriangleMesh::getCentroid() {
     return c;
 }
 
-void TriangleMesh::_smoothTriangleMesh(double value) {
-    std::vector<vmath::vec3> newvertices;
-    newvertices.reserve(vertices.size());
+void TriangleMesh::_initializeVertexNeighbourCSR(VertexNeighbourCSR &csr) {
+    int nv = (int)vertices.size();
+    int nt = (int)triangles.size();
+    int numCPU = ThreadUtils::getMaxThreadCount();
 
-    vmath::vec3 v;
-    vmath::vec3 nv;
-    vmath::vec3 avg;
-    Triangle t;
-    for (unsigned int i = 0; i < vertices.size(); i++) {
-        int count = 0;
-        avg = vmath::vec3();
-        for (unsigned int j = 0; j < _vertexTriangles[i].size(); j++) {
-            t = triangles[_vertexTriangles[i][j]];
-            if (t.tri[0] != (int)i) {
-                avg += vertices[t.tri[0]];
-                count++;
-            }
-            if (t.tri[1] != (int)i) {
-                avg += vertices[t.tri[1]];
-                count++;
-            }
-            if (t.tri[2] != (int)i) {
-                avg += vertices[t.tri[2]];
-                count++;
-            }
-        }
+    // Vertex to triangle incidence is counted and inserted with atomic
+    // cursors, then sorted per vertex so that the order does not depend on
+    // thread scheduling
+    std::vector<std::atomic<int> > cursors(nv);
+    for (int i = 0; i < nv; i++) {
+        cursors[i].store(0);
+    }
 
-        avg /= (float)count;
-        v = vertices[i];
-        nv = v + (float)value * (avg - v);
-        newvertices.push_back(nv);
+    int numthreads = (int)fmax(fmin(numCPU, nt), 1);
+    std::vector<std::thread> threads(numthreads);
+    std::vector<int> intervals = ThreadUtils::splitRangeIntoIntervals(0, nt, numthreads);
+    for (int i = 0; i < numthreads; i++) {
+        threads[i] = std::thread(&TriangleMesh::_countVertexTrianglesThread, this,
+                                 intervals[i], intervals[i + 1], &cursors);
+    }
+    for (int i = 0; i < numthreads; i++) {
+        threads[i].join();
+    }
+
+    std::vector<int> triangleOffsets(nv + 1, 0);
+    for (int i = 0; i < nv; i++) {
+        int count = cursors[i].load();
+        triangleOffsets[i + 1] = triangleOffsets[i] + count;
+        cursors[i].store(triangleOffsets[i]);
     }
 
-    vertices = newvertices;
+    std::vector<int> vertexTriangles(triangleOffsets[nv]);
+    for (int i = 0; i < numthreads; i++) {
+        threads[i] = std::thread(&TriangleMesh::_insertVertexTrianglesThread, this,
+                                 intervals[i], intervals[i + 1], &cursors, &vertexTriangles);
+    }
+    for (int i = 0; i < numthreads; i++) {
+        threads[i].join();
+    }
+
+    numthreads = (int)fmax(fmin(numCPU, nv), 1);
+    threads = std::vector<std::thread>(numthreads);
+    intervals = ThreadUtils::splitRangeIntoIntervals(0, nv, numthreads);
+    std::vector<int> neighbourCounts(nv, 0);
+    for (int i = 0; i < numthreads; i++) {
+        threads[i] = std::thread(&TriangleMesh::_countVertexNeighboursThread, this,
+                                 intervals[i], intervals[i + 1], 
+                                 &triangleOffsets, &vertexTriangles, &neighbourCounts);
+    }
+    for (int i = 0; i < numthreads; i++) {
+        threads[i].join();
+    }
+
+    csr.offsets = std::vector<int>(nv + 1, 0);
+    for (int i = 0; i < nv; i++) {
+        csr.offsets[i + 1] = csr.offsets[i] + neighbourCounts[i];
+    }
+    csr.neighbours = std::vector<int>(csr.offsets[nv]);
+
+    for (int i = 0; i < numthreads; i++) {
+        threads[i] = std::thread(&TriangleMesh::_insertVertexNeighboursThread, this,
+                                 intervals[i], intervals[i + 1], 
+                                 &triangleOffsets, &vertexTriangles, &csr);
+    }
+    for (int i = 0; i < numthreads; i++) {
+        threads[i].join();
+    }
 }
 
-void TriangleMesh::smooth(double value, int iterations) {
-    if (iterations == 0) {
-        return;
+void TriangleMesh::_countVertexTrianglesThread(int startidx, int endidx, 
+                                               std::vector<std::atomic<int> > *counts) {
+    for (int i = startidx; i < endidx; i++) {
+        Triangle t = triangles[i];
+        (*counts)[t.tri[0]].fetch_add(1);
+        (*counts)[t.tri[1]].fetch_add(1);
+        (*counts)[t.tri[2]].fetch_add(1);
     }
+}
 
-    _vertexTriangles.clear();
-    _updateVertexTriangles();
-    for (int i = 0; i < iterations; i++) {
-        _smoothTriangleMesh(value);
+void TriangleMesh::_insertVertexTrianglesThread(int startidx, int endidx, 
+                                                std::vector<std::atomic<int> > *cursors,
+                                                std::vector<int> *vertexTriangles) {
+    for (int i = startidx; i < endidx; i++) {
+        Triangle t = triangles[i];
+        for (int j = 0; j < 3; j++) {
+            int idx = (*cursors)[t.tri[j]].fetch_add(1);
+            (*vertexTriangles)[idx] = i;
+        }
     }
-    _vertexTriangles.clear();
 }
 
-std::vector<vmath::vec3> TriangleMesh::_smoothTriangleMeshColors(double value, std::vector<vmath::vec3> &colors) {
-    std::vector<vmath::vec3> newcolors;
-    newcolors.reserve(vertices.size());
+void TriangleMesh::_countVertexNeighboursThread(int startidx, int endidx, 
+                                                std::vector<int> *triangleOffsets,
+                                                std::vector<int> *vertexTriangles,
+                                                std::vector<int> *neighbourCounts) {
+    for (int i = startidx; i < endidx; i++) {
+        int begin = triangleOffsets->at(i);
+        int end = triangleOffsets->at(i + 1);
+        std::sort(vertexTriangles->begin() + begin, vertexTriangles->begin() + end);
 
-    vmath::vec3 c;
-    vmath::vec3 nc;
-    vmath::vec3 avg;
-    Triangle t;
-    for (unsigned int i = 0; i < vertices.size(); i++) {
         int count = 0;
-        avg = vmath::vec3();
-        for (unsigned int j = 0; j < _vertexTriangles[i].size(); j++) {
-            t = triangles[_vertexTriangles[i][j]];
-            if (t.tri[0] != (int)i) {
-                avg += colors[t.tri[0]];
-                count++;
-            }
-            if (t.tri[1] != (int)i) {
-                avg += colors[t.tri[1]];
-                count++;
+        for (int tidx = begin; tidx < end; tidx++) {
+            Triangle t = triangles[vertexTriangles->at(tidx)];
+            for (int j = 0; j < 3; j++) {
+                if (t.tri[j] != i) {
+                    count++;
+                }
             }
-            if (t.tri[2] != (int)i) {
-                avg += colors[t.tri[2]];
-                count++;
+        }
+        (*neighbourCounts)[i] = count;
+    }
+}
+
+void TriangleMesh::_insertVertexNeighboursThread(int startidx, int endidx, 
+                                                 std::vector<int> *triangleOffsets,
+                                                 std::vector<int> *vertexTriangles,
+                                                 VertexNeighbourCSR *csr) {
+    for (int i = startidx; i < endidx; i++) {
+        int nidx = csr->offsets[i];
+        int begin = triangleOffsets->at(i);
+        int end = triangleOffsets->at(i + 1);
+        for (int tidx = begin; tidx < end; tidx++) {
+            Triangle t = triangles[vertexTriangles->at(tidx)];
+            for (int j = 0; j < 3; j++) {
+                if (t.tri[j] != i) {
+                    csr->neighbours[nidx] = t.tri[j];
+                    nidx++;
+                }
             }
         }
+    }
+}
+
+void TriangleMesh::_smoothVertexValues(double value, int iterations, 
+                                       VertexNeighbourCSR &csr, 
+                                       std::vector<vmath::vec3> &values,
+                                       std::vector<bool> *isPinned) {
+    FLUIDSIM_ASSERT(isPinned == nullptr || isPinned->size() == values.size());
+
+    int nv = (int)values.size();
+    int numCPU = ThreadUtils::getMaxThreadCount();
+    int numthreads = (int)fmax(fmin(numCPU, nv), 1);
+    std::vector<std::thread> threads(numthreads);
+    std::vector<int> intervals = ThreadUtils::splitRangeIntoIntervals(0, nv, numthreads);
+
+    // Jacobi iterations, alternating between two buffers
+    std::vector<vmath::vec3> smoothedValues(nv);
+    for (int n = 0; n < iterations; n++) {
+        for (int i = 0; i < numthreads; i++) {
+            threads[i] = std::thread(&TriangleMesh::_smoothVertexValuesThread, this,
+                                     intervals[i], intervals[i + 1], value, 
+                                     &csr, isPinned, &values, &smoothedValues);
+        }
+        for (int i = 0; i < numthreads; i++) {
+            threads[i].join();
+        }
+
+        values.swap(smoothedValues);
+    }
+}
+
+void TriangleMesh::_smoothVertexValuesThread(int startidx, int endidx, double value, 
+                                             VertexNeighbourCSR *csr,
+                                             std::vector<bool> *isPinned,
+                                             std::vector<vmath::vec3> *values, 
+                                             std::vector<vmath::vec3> *smoothedValues) {
+    vmath::vec3 v;
+    vmath::vec3 avg;
+    for (int i = startidx; i < endidx; i++) {
+        if (isPinned != nullptr && (*isPinned)[i]) {
+            (*smoothedValues)[i] = values->at(i);
+            continue;
+        }
+
+        int begin = csr->offsets[i];
+        int end = csr->offsets[i + 1];
+        avg = vmath::vec3();
+        for (int j = begin; j < end; j++) {
+            avg += values->at(csr->neighbours[j]);
+        }
 
-        avg /= (float)count;
-        c = colors[i];
-        nc = c + (float)value * (avg - c);
-        newcolors.push_back(nc);
+        avg /= (float)(end - begin);
+        v = values->at(i);
+        (*smoothedValues)[i] = v + (float)value * (avg - v);
     }
+}
+
+void TriangleMesh::smooth(double value, int iterations) {
+    if (iterations == 0) {
+        return;
+    }
+
+    VertexNeighbourCSR csr;
+    _initializeVertexNeighbourCSR(csr);
+    _smoothVertexValues(value, iterations, csr, vertices);
+}
 
-    return newcolors;
+// Pinned vertices keep their position in every iteration, so their 
+// neighbours are always smoothed towards the pinned positions
+void TriangleMesh::smooth(double value, int iterations, std::vector<bool> &isPinnedVertex) {
+    if (iterations == 0) {
+        return;
+    }
+
+    VertexNeighbourCSR csr;
+    _initializeVertexNeighbourCSR(csr);
+    _smoothVertexValues(value, iterations, csr, vertices, &isPinnedVertex);
 }
 
 std::vector<vmath::vec3> TriangleMesh::smoothColors(double value, int iterations, std::vector<vmath::vec3> colors) {
@@ -709,12 +876,9 @@ std::vector<vmath::vec3> TriangleMesh::smoothColors(double value, int iterations
         return colors;
     }
 
-    _vertexTriangles.clear();
-    _updateVertexTriangles();
-    for (int i = 0; i < iterations; i++) {
-        colors = _smoothTriangleMeshColors(value, colors);
-    }
-    _vertexTriangles.clear();
+    VertexNeighbourCSR csr;
+    _initializeVertexNeighbourCSR(csr);
+    _smoothVertexValues(value, iterations, csr, colors);
 
     return colors;
 }
@@ -811,15 +975,7 @@ std::vector<int> TriangleMesh::removeExtraneousVertices() {
     newVertexList.shrink_to_fit();
     vertices = newVertexList;
 
-    for (unsigned int i = 0; i < triangles.size(); i++) {
-        t = triangles[i];
-        t.tri[0] = indexTranslationTable[t.tri[0]];
-        t.tri[1] = indexTranslationTable[t.tri[1]];
-        t.tri[2] = indexTranslationTable[t.tri[2]];
-        FLUIDSIM_ASSERT(t.tri[0] != -1 && t.tri[1] != -1 && t.tri[2] != -1);
-
-        triangles[i] = t;
-    }
+    _remapTriangleVertices(indexTranslationTable);
 
     return unusedindices;
 }
@@ -978,65 +1134,6 @@ AABB TriangleMesh::_getMeshVertexIntersectionAABB(std::vector<vmath::vec3> verts
     return inter;
 }
 
-bool sortVertexPairByFirstIndex(const std::pair<int, int> &a,
-                                const std::pair<int, int> &b) { 
-    return a.first < b.first;
-}
-
-// Unique list of vertex pair indices sorted in order of first index.
-// For each pair, first < second
-void TriangleMesh::_findDuplicateVertexPairs(int i, int j, int k, double dx, 
-                                             std::vector<std::pair<int, int> > &vertexPairs) {
-    SpatialPointGrid grid(i, j, k, dx);
-    std::vector<GridPointReference> refs = grid.insert(vertices);
-
-    std::vector<bool> isPaired(vertices.size(), false);
-
-    double eps = 10e-6;
-    std::vector<GridPointReference> query;
-    for (unsigned int i = 0; i < vertices.size(); i++) {
-
-        if (isPaired[i]) {
-            continue;
-        }
-
-        query.clear();
-        grid.queryPointReferencesInsideSphere(refs[i], eps, query);
-
-        if (query.size() == 0) {
-            continue;
-        }
-
-        GridPointReference closestRef;
-        if (query.size() == 1) {
-            closestRef = query[0];
-        } else {
-            double mindist = std::numeric_limits<double>::infinity();
-
-            for (unsigned int idx = 0; idx < query.size(); idx++) {
-                vmath::vec3 v = vertices[i] - vertices[query[idx].id];
-                double distsq = vmath::lengthsq(v);
-                if (distsq < mindist) {
-                    mindist = distsq;
-                    closestRef = query[idx];
-                }
-            }
-        }
-
-        int pair1 = i;
-        int pair2 = closestRef.id;
-        if (pair2 < pair1) {
-            pair1 = closestRef.id;
-            pair2 = i;
-        }
-
-        vertexPairs.push_back(std::pair<int, int>(pair1, pair2));
-        isPaired[closestRef.id] = true;
-    }
-
-    std::sort(vertexPairs.begin(), vertexPairs.end(), sortVertexPairByFirstIndex);
-}
-
 // matches vertex pairs between verts1 and verts2
 // AABB bbox bounds verts1 and verts2
 void TriangleMesh::_findDuplicateVertexPairs(std::vector<int> &verts1, 
@@ -1095,27 +1192,26 @@ void TriangleMesh::_findDuplicateVertexPairs(std::vector<int> &verts1,
     }
 }
 
-void TriangleMesh::removeDuplicateVertices(int i, int j, int k, double dx) {
-
-    std::vector<std::pair<int, int> > vertexPairs;
-    _findDuplicateVertexPairs(i, j, k, dx, vertexPairs);
-
-    std::vector<int> indexTable;
-    indexTable.reserve(vertices.size());
-    for (unsigned int i = 0; i < vertices.size(); i++) {
-        indexTable.push_back(i);
+/*
+    Vertices within a small distance of each other are merged. Unlike 
+    weldVertices, a triangle that would collapse onto an edge or a point
+    is kept with its original vertices.
+*/
+void TriangleMesh::removeDuplicateVertices() {
+    if (vertices.empty()) {
+        return;
     }
 
-    for (unsigned int i = 1; i < vertexPairs.size(); i++) {
-        indexTable[vertexPairs[i].second] = vertexPairs[i].first;
-    }
+    double eps = 10e-6;
+    std::vector<bool> isWeldable(vertices.size(), true);
+    std::vector<int> representatives;
+    _getWeldRepresentatives(eps, isWeldable, representatives);
 
-    Triangle t;
-    for (unsigned int i = 0; i < triangles.size(); i++) {
-        t = triangles[i];
-        t.tri[0] = indexTable[t.tri[0]];
-        t.tri[1] = indexTable[t.tri[1]];
-        t.tri[2] = indexTable[t.tri[2]];
+    for (size_t i = 0; i < triangles.size(); i++) {
+        Triangle t = triangles[i];
+        t.tri[0] = representatives[t.tri[0]];
+        t.tri[1] = representatives[t.tri[1]];
+        t.tri[2] = representatives[t.tri[2]];
 
         if (t.tri[0] == t.tri[1] || t.tri[1] == t.tri[2] || t.tri[2] == t.tri[0]) {
             // Don't collapse triangles
@@ -1126,4 +1222,274 @@ void TriangleMesh::removeDuplicateVertices(int i, int j, int k, double dx) {
     }
 
     removeExtraneousVertices();
-}
\ No newline at end of file
+}
+
+void TriangleMesh::weldVertices(double eps) {
+    std::vector<bool> isWeldable(vertices.size(), true);
+    weldVertices(eps, isWeldable);
+}
+
+/*
+    Vertices within distance eps of each other are merged. Each weldable
+    vertex is mapped to the lowest indexed weldable vertex within eps and
+    chains of mappings are collapsed, so that the result does not depend
+    on the number of threads. Surviving vertices keep their position and
+    relative order. Triangles that collapse onto an edge or a point are
+    removed from the mesh.
+*/
+void TriangleMesh::weldVertices(double eps, std::vector<bool> &isWeldable) {
+    FLUIDSIM_ASSERT(isWeldable.size() == vertices.size());
+    if (vertices.empty() || eps <= 0.0) {
+        return;
+    }
+
+    std::vector<int> representatives;
+    _getWeldRepresentatives(eps, isWeldable, representatives);
+
+    int nv = (int)vertices.size();
+    std::vector<int> indexTable(nv, -1);
+    int vidx = 0;
+    for (int i = 0; i < nv; i++) {
+        int r = representatives[i];
+        if (r == i) {
+            indexTable[i] = vidx;
+            vertices[vidx] = vertices[i];
+            vidx++;
+        } else {
+            indexTable[i] = indexTable[r];
+        }
+    }
+
+    if (vidx == nv) {
+        return;
+    }
+
+    vertices.resize(vidx);
+    vertices.shrink_to_fit();
+    _remapTriangleVertices(indexTable);
+
+    size_t tidx = 0;
+    for (size_t i = 0; i < triangles.size(); i++) {
+        Triangle t = triangles[i];
+        if (t.tri[0] == t.tri[1] || t.tri[1] == t.tri[2] || t.tri[2] == t.tri[0]) {
+            continue;
+        }
+        triangles[tidx] = t;
+        tidx++;
+    }
+    triangles.resize(tidx);
+}
+
+void TriangleMesh::_getWeldRepresentatives(double eps, 
+                                           std::vector<bool> &isWeldable, 
+                                           std::vector<int> &representatives) {
+    VertexWeldGrid grid;
+    _initializeVertexWeldGrid(eps, isWeldable, grid);
+
+    int nv = (int)vertices.size();
+    representatives = std::vector<int>(nv);
+
+    int numCPU = ThreadUtils::getMaxThreadCount();
+    int numthreads = (int)fmax(fmin(numCPU, nv), 1);
+    std::vector<std::thread> threads(numthreads);
+    std::vector<int> intervals = ThreadUtils::splitRangeIntoIntervals(0, nv, numthreads);
+    for (int i = 0; i < numthreads; i++) {
+        threads[i] = std::thread(&TriangleMesh::_findWeldRepresentativesThread, this,
+                                 intervals[i], intervals[i + 1], eps,
+                                 &isWeldable, &grid, &representatives);
+    }
+    for (int i = 0; i < numthreads; i++) {
+        threads[i].join();
+    }
+
+    // A representative always has a lower index than its vertex, so chains
+    // are fully collapsed in a single pass
+    for (int i = 0; i < nv; i++) {
+        representatives[i] = representatives[representatives[i]];
+    }
+}
+
+void TriangleMesh::_initializeVertexWeldGrid(double cellsize, 
+                                             std::vector<bool> &isWeldable, 
+                                             VertexWeldGrid &grid) {
+    int nv = (int)vertices.size();
+    unsigned long long numBuckets = 1;
+    while (numBuckets < (unsigned long long)nv) {
+        numBuckets <<= 1;
+    }
+
+    grid.cellsize = cellsize;
+    grid.bucketMask = numBuckets - 1;
+
+    std::vector<std::atomic<int> > cursors(numBuckets);
+    for (size_t i = 0; i < cursors.size(); i++) {
+        cursors[i].store(0);
+    }
+
+    int numCPU = ThreadUtils::getMaxThreadCount();
+    int numthreads = (int)fmax(fmin(numCPU, nv), 1);
+    std::vector<std::thread> threads(numthreads);
+    std::vector<int> intervals = ThreadUtils::splitRangeIntoIntervals(0, nv, numthreads);
+    for (int i = 0; i < numthreads; i++) {
+        threads[i] = std::thread(&TriangleMesh::_countVertexWeldGridBucketsThread, this,
+                                 intervals[i], intervals[i + 1], 
+                                 &isWeldable, &grid, &cursors);
+    }
+    for (int i = 0; i < numthreads; i++) {
+        threads[i].join();
+    }
+
+    grid.offsets = std::vector<int>(numBuckets + 1, 0);
+    for (unsigned long long i = 0; i < numBuckets; i++) {
+        int count = cursors[i].load();
+        grid.offsets[i + 1] = grid.offsets[i] + count;
+        cursors[i].store(grid.offsets[i]);
+    }
+    grid.vertexIndices = std::vector<int>(grid.offsets[numBuckets]);
+
+    for (int i = 0; i < numthreads; i++) {
+        threads[i] = std::thread(&TriangleMesh::_insertVertexWeldGridBucketsThread, this,
+                                 intervals[i], intervals[i + 1], 
+                                 &isWeldable, &grid, &cursors);
+    }
+    for (int i = 0; i < numthreads; i++) {
+        threads[i].join();
+    }
+
+    numthreads = (int)fmax(fmin(numCPU, (int)numBuckets), 1);
+    threads = std::vector<std::thread>(numthreads);
+    intervals = ThreadUtils::splitRangeIntoIntervals(0, (int)numBuckets, numthreads);
+    for (int i = 0; i < numthreads; i++) {
+        threads[i] = std::thread(&TriangleMesh::_sortVertexWeldGridBucketsThread, this,
+                                 intervals[i], intervals[i + 1], &grid);
+    }
+    for (int i = 0; i < numthreads; i++) {
+        threads[i].join();
+    }
+}
+
+void TriangleMesh::_countVertexWeldGridBucketsThread(int startidx, int endidx, 
+                                                     std::vector<bool> *isWeldable,
+                                                     VertexWeldGrid *grid,
+                                                     std::vector<std::atomic<int> > *counts) {
+    long long ci, cj, ck;
+    for (int i = startidx; i < endidx; i++) {
+        if (!isWeldable->at(i)) {
+            continue;
+        }
+
+        _getVertexWeldCell(vertices[i], grid->cellsize, &ci, &cj, &ck);
+        unsigned long long b = _getVertexWeldBucket(ci, cj, ck, grid);
+        (*counts)[b].fetch_add(1);
+    }
+}
+
+void TriangleMesh::_insertVertexWeldGridBucketsThread(int startidx, int endidx, 
+                                                      std::vector<bool> *isWeldable,
+                                                      VertexWeldGrid *grid,
+                                                      std::vector<std::atomic<int> > *cursors) {
+    long long ci, cj, ck;
+    for (int i = startidx; i < endidx; i++) {
+        if (!isWeldable->at(i)) {
+            continue;
+        }
+
+        _getVertexWeldCell(vertices[i], grid->cellsize, &ci, &cj, &ck);
+        unsigned long long b = _getVertexWeldBucket(ci, cj, ck, grid);
+        int idx = (*cursors)[b].fetch_add(1);
+        grid->vertexIndices[idx] = i;
+    }
+}
+
+void TriangleMesh::_sortVertexWeldGridBucketsThread(int startidx, int endidx, 
+                                                    VertexWeldGrid *grid) {
+    for (int i = startidx; i < endidx; i++) {
+        std::sort(grid->vertexIndices.begin() + grid->offsets[i], 
+                  grid->vertexIndices.begin() + grid->offsets[i + 1]);
+    }
+}
+
+void TriangleMesh::_getVertexWeldCell(vmath::vec3 v, double cellsize, 
+                                      long long *ci, long long *cj, long long *ck) {
+    double invcellsize = 1.0 / cellsize;
+    *ci = (long long)floor(v.x * invcellsize);
+    *cj = (long long)floor(v.y * invcellsize);
+    *ck = (long long)floor(v.z * invcellsize);
+}
+
+unsigned long long TriangleMesh::_getVertexWeldBucket(long long ci, long long cj, long long ck, 
+                                                      VertexWeldGrid *grid) {
+    unsigned long long h = (unsigned long long)ci * 73856093ULL ^
+                           (unsigned long long)cj * 19349663ULL ^
+                           (unsigned long long)ck * 83492791ULL;
+    return h & grid->bucketMask;
+}
+
+void TriangleMesh::_findWeldRepresentativesThread(int startidx, int endidx, double eps,
+                                                  std::vector<bool> *isWeldable,
+                                                  VertexWeldGrid *grid,
+                                                  std::vector<int> *representatives) {
+    double epssq = eps * eps;
+    long long ci, cj, ck;
+    for (int i = startidx; i < endidx; i++) {
+        int rep = i;
+        if (!isWeldable->at(i)) {
+            (*representatives)[i] = rep;
+            continue;
+        }
+
+        vmath::vec3 v = vertices[i];
+        _getVertexWeldCell(v, grid->cellsize, &ci, &cj, &ck);
+        for (long long nk = ck - 1; nk <= ck + 1; nk++) {
+            for (long long nj = cj - 1; nj <= cj + 1; nj++) {
+                for (long long ni = ci - 1; ni <= ci + 1; ni++) {
+                    unsigned long long b = _getVertexWeldBucket(ni, nj, nk, grid);
+                    int end = grid->offsets[b + 1];
+                    for (int idx = grid->offsets[b]; idx < end; idx++) {
+                        int vidx = grid->vertexIndices[idx];
+                        if (vidx >= rep) {
+                            break;
+                        }
+
+                        vmath::vec3 d = vertices[vidx] - v;
+                        if (vmath::lengthsq(d) <= epssq) {
+                            rep = vidx;
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+
+        (*representatives)[i] = rep;
+    }
+}
+
+void TriangleMesh::_remapTriangleVertices(std::vector<int> &indexTable) {
+    int nt = (int)triangles.size();
+    int numCPU = ThreadUtils::getMaxThreadCount();
+    int numthreads = (int)fmax(fmin(numCPU, nt), 1);
+    std::vector<std::thread> threads(numthreads);
+    std::vector<int> intervals = ThreadUtils::splitRangeIntoIntervals(0, nt, numthreads);
+    for (int i = 0; i < numthreads; i++) {
+        threads[i] = std::thread(&TriangleMesh::_remapTriangleVerticesThread, this,
+                                 intervals[i], intervals[i + 1], &indexTable);
+    }
+    for (int i = 0; i < numthreads; i++) {
+        threads[i].join();
+    }
+}
+
+void TriangleMesh::_remapTriangleVerticesThread(int startidx, int endidx, 
+                                                std::vector<int> *indexTable) {
+    Triangle t;
+    for (int i = startidx; i < endidx; i++) {
+        t = triangles[i];
+        t.tri[0] = indexTable->at(t.tri[0]);
+        t.tri[1] = indexTable->at(t.tri[1]);
+        t.tri[2] = indexTable->at(t.tri[2]);
+        FLUIDSIM_ASSERT(t.tri[0] != -1 && t.tri[1] != -1 && t.tri[2] != -1);
+
+        triangles[i] = t;
+    }
+}
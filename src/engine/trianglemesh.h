@@ -24,10 +24,17 @@ SOFTWARE.
 
 #pragma once
 
+#if __MINGW32__ && !_WIN64
+    #include "mingw32_threads/mingw.thread.h"
+#else
+    #include <thread>
+#endif
+
 #include <string>
 #include <vector>
 #include <sstream>
 #include <limits>
+#include <atomic>
 
 #include "vmath.h"
 #include "triangle.h"
@@ -60,6 +67,7 @@ public:
     void updateVertexTriangles();
     void clearVertexTriangles();
     void smooth(double value, int iterations);
+    void smooth(double value, int iterations, std::vector<bool> &isPinnedVertex);
     std::vector<vmath::vec3> smoothColors(double value, int iterations, std::vector<vmath::vec3> colors);
     void getFaceNeighbours(unsigned int tidx, std::vector<int> &n);
     void getFaceNeighbours(Triangle t, std::vector<int> &n);
@@ -77,7 +85,9 @@ public:
     void append(TriangleMesh &mesh);
     void join(TriangleMesh &mesh);
     void join(TriangleMesh &mesh, double tolerance);
-    void removeDuplicateVertices(int i, int j, int k, double dx);
+    void removeDuplicateVertices();
+    void weldVertices(double eps);
+    void weldVertices(double eps, std::vector<bool> &isWeldable);
 
     std::vector<vmath::vec3> vertices;
     std::vector<Triangle> triangles;
@@ -91,10 +101,78 @@ private:
     bool _loadPLYVertexData(std::ifstream *file, std::string &header);
     bool _loadPLYTriangleData(std::ifstream *file, std::string &header);
 
+    // Compressed sparse row vertex adjacency. The neighbours of vertex i are
+    // neighbours[offsets[i]] to neighbours[offsets[i + 1] - 1] and are listed
+    // once for every adjacent triangle in triangle order.
+    struct VertexNeighbourCSR {
+        std::vector<int> offsets;
+        std::vector<int> neighbours;
+    };
+
+    // Spatial hash of vertex positions quantized to cells of width cellsize.
+    // The vertices hashed into bucket b are vertexIndices[offsets[b]] to
+    // vertexIndices[offsets[b + 1] - 1] and are sorted by index.
+    struct VertexWeldGrid {
+        double cellsize = 0.0;
+        unsigned long long bucketMask = 0;
+        std::vector<int> offsets;
+        std::vector<int> vertexIndices;
+    };
+
     void _updateVertexTriangles();
     bool _trianglesEqual(Triangle &t1, Triangle &t2);
-    void _smoothTriangleMesh(double value);
-    std::vector<vmath::vec3> _smoothTriangleMeshColors(double value, std::vector<vmath::vec3> &colors);
+    void _sortTrianglesThread(int startidx, int endidx);
+    void _mergeSortedTrianglesThread(int startidx, int mididx, int endidx);
+    void _initializeVertexNeighbourCSR(VertexNeighbourCSR &csr);
+    void _countVertexTrianglesThread(int startidx, int endidx, 
+                                     std::vector<std::atomic<int> > *counts);
+    void _insertVertexTrianglesThread(int startidx, int endidx, 
+                                      std::vector<std::atomic<int> > *cursors,
+                                      std::vector<int> *vertexTriangles);
+    void _countVertexNeighboursThread(int startidx, int endidx, 
+                                      std::vector<int> *triangleOffsets,
+                                      std::vector<int> *vertexTriangles,
+                                      std::vector<int> *neighbourCounts);
+    void _insertVertexNeighboursThread(int startidx, int endidx, 
+                                       std::vector<int> *triangleOffsets,
+                                       std::vector<int> *vertexTriangles,
+                                       VertexNeighbourCSR *csr);
+    void _initializeVertexWeldGrid(double cellsize, 
+                                   std::vector<bool> &isWeldable, 
+                                   VertexWeldGrid &grid);
+    void _countVertexWeldGridBucketsThread(int startidx, int endidx, 
+                                           std::vector<bool> *isWeldable,
+                                           VertexWeldGrid *grid,
+                                           std::vector<std::atomic<int> > *counts);
+    void _insertVertexWeldGridBucketsThread(int startidx, int endidx, 
+                                            std::vector<bool> *isWeldable,
+                                            VertexWeldGrid *grid,
+                                            std::vector<std::atomic<int> > *cursors);
+    void _sortVertexWeldGridBucketsThread(int startidx, int endidx, 
+                                          VertexWeldGrid *grid);
+    void _getVertexWeldCell(vmath::vec3 v, double cellsize, 
+                            long long *ci, long long *cj, long long *ck);
+    unsigned long long _getVertexWeldBucket(long long ci, long long cj, long long ck, 
+                                            VertexWeldGrid *grid);
+    void _getWeldRepresentatives(double eps, 
+                                 std::vector<bool> &isWeldable, 
+                                 std::vector<int> &representatives);
+    void _findWeldRepresentativesThread(int startidx, int endidx, double eps,
+                                        std::vector<bool> *isWeldable,
+                                        VertexWeldGrid *grid,
+                                        std::vector<int> *representatives);
+    void _remapTriangleVertices(std::vector<int> &indexTable);
+    void _remapTriangleVerticesThread(int startidx, int endidx, 
+                                      std::vector<int> *indexTable);
+    void _smoothVertexValues(double value, int iterations, 
+                             VertexNeighbourCSR &csr, 
+                             std::vector<vmath::vec3> &values,
+                             std::vector<bool> *isPinned = nullptr);
+    void _smoothVertexValuesThread(int startidx, int endidx, double value, 
+                                   VertexNeighbourCSR *csr,
+                                   std::vector<bool> *isPinned,
+                                   std::vector<vmath::vec3> *values, 
+                                   std::vector<vmath::vec3> *smoothedValues);
 
     void _getPolyhedra(std::vector<std::vector<int> > &polyList);
     void _getPolyhedronFromTriangle(int triangle, 
@@ -103,8 +181,6 @@ private:
     AABB _getMeshVertexIntersectionAABB(std::vector<vmath::vec3> verts1,
                                         std::vector<vmath::vec3> verts2, 
                                         double tolerance);
-    void _findDuplicateVertexPairs(int i, int j, int k, double dx, 
-                                   std::vector<std::pair<int, int> > &pairs);
     void _findDuplicateVertexPairs(std::vector<int> &verts1, 
                                    std::vector<int> &verts2, 
                                    AABB bbox,
@@ -39,26 +39,78 @@ TurbulenceField::~TurbulenceField() {
 }
 
 float TurbulenceField::operator()(int i, int j, int k) {
-    FLUIDSIM_ASSERT(_field.isIndexInRange(i, j, k));
-    return _field(i, j, k);
+    FLUIDSIM_ASSERT(Grid3d::isGridIndexInRange(i, j, k, _isize, _jsize, _ksize));
+    return _getTurbulence(i, j, k);
 }
 
 float TurbulenceField::operator()(GridIndex g) {
-    FLUIDSIM_ASSERT(_field.isIndexInRange(g));
-    return _field(g);
+    FLUIDSIM_ASSERT(Grid3d::isGridIndexInRange(g, _isize, _jsize, _ksize));
+    return _getTurbulence(g.i, g.j, g.k);
 }
 
-void TurbulenceField::_getVelocityGrid(MACVelocityField *macfield, 
-                                       Array3d<vmath::vec3> &vgrid) {
+int TurbulenceField::getTileWidth() {
+    return _tileWidth;
+}
+
+void TurbulenceField::getTileGridDimensions(int *ti, int *tj, int *tk) {
+    *ti = _tileStatus.width;
+    *tj = _tileStatus.height;
+    *tk = _tileStatus.depth;
+}
+
+float TurbulenceField::getMaxTileTurbulence(GridIndex tile) {
+    FLUIDSIM_ASSERT(_tileStatus.isIndexInRange(tile));
+    FLUIDSIM_ASSERT(_tileStatus(tile) != TileStatus::uncomputed);
 
-    size_t gridsize = vgrid.width * vgrid.height * vgrid.depth;
-    size_t numCPU = ThreadUtils::getMaxThreadCount();
-    int numthreads = (int)std::min(numCPU, gridsize);
+    int tid = Grid3d::getFlatIndex(tile, _tileStatus.width, _tileStatus.height);
+    return _tileMaxTurbulence[tid];
+}
+
+void TurbulenceField::initializeTurbulenceField(MACVelocityField *vfield,
+                                                ParticleLevelSet &liquidSDF) {
+    _vfield = vfield;
+    _liquidSDF = &liquidSDF;
+    _vfield->getGridDimensions(&_isize, &_jsize, &_ksize);
+    _dx = vfield->getGridCellSize();
+    _radius = sqrt(3.0*(2*_dx)*(2*_dx));  // maximum distance from center grid cell
+                                          // to its 124 neighbours
+
+    int ti = (int)std::ceil((double)_isize / (double)_tileWidth);
+    int tj = (int)std::ceil((double)_jsize / (double)_tileWidth);
+    int tk = (int)std::ceil((double)_ksize / (double)_tileWidth);
+    if (_tileStatus.width != ti || _tileStatus.height != tj || _tileStatus.depth != tk) {
+        _tileStatus = Array3d<TileStatus>(ti, tj, tk);
+    }
+    _tileStatus.fill(TileStatus::uncomputed);
+
+    _tileData.clear();
+    _tileData.resize(ti * tj * tk);
+    _tileMaxTurbulence.assign(ti * tj * tk, 0.0f);
+}
+
+void TurbulenceField::calculateTurbulenceTiles(std::vector<GridIndex> &tiles) {
+    std::vector<GridIndex> uncomputedTiles;
+    uncomputedTiles.reserve(tiles.size());
+    for (size_t i = 0; i < tiles.size(); i++) {
+        GridIndex t = tiles[i];
+        if (_tileStatus.isIndexInRange(t) && _tileStatus(t) == TileStatus::uncomputed) {
+            // Marked as empty so that duplicate tiles are only computed once
+            _tileStatus.set(t, TileStatus::empty);
+            uncomputedTiles.push_back(t);
+        }
+    }
+
+    if (uncomputedTiles.empty()) {
+        return;
+    }
+
+    int numCPU = ThreadUtils::getMaxThreadCount();
+    int numthreads = (int)fmin(numCPU, uncomputedTiles.size());
     std::vector<std::thread> threads(numthreads);
-    std::vector<int> intervals = ThreadUtils::splitRangeIntoIntervals(0, gridsize, numthreads);
+    std::vector<int> intervals = ThreadUtils::splitRangeIntoIntervals(0, uncomputedTiles.size(), numthreads);
     for (int i = 0; i < numthreads; i++) {
-        threads[i] = std::thread(&TurbulenceField::_getVelocityGridThread, this,
-                                 intervals[i], intervals[i + 1], macfield, &vgrid);
+        threads[i] = std::thread(&TurbulenceField::_calculateTurbulenceTilesThread, this,
+                                 intervals[i], intervals[i + 1], &uncomputedTiles);
     }
 
     for (int i = 0; i < numthreads; i++) {
@@ -66,112 +118,170 @@ void TurbulenceField::_getVelocityGrid(MACVelocityField *macfield,
     }
 }
 
-void TurbulenceField::_getVelocityGridThread(int startidx, int endidx, 
-                                             MACVelocityField *vfield, 
-                                             Array3d<vmath::vec3> *vgrid) {
-    int isize = vgrid->width;
-    int jsize = vgrid->height;
-    for (int idx = startidx; idx < endidx; idx++) {
-        GridIndex g = Grid3d::getUnflattenedIndex(idx, isize, jsize);
-        vgrid->set(g, vfield->evaluateVelocityAtCellCenter(g.i, g.j, g.k));
+void TurbulenceField::calculateTurbulenceTilesAtPositions(std::vector<vmath::vec3> &positions) {
+    // Tiles containing the trilinear interpolation stencil of each position
+    Array3d<bool> isTileRequired(_tileStatus.width, _tileStatus.height, _tileStatus.depth, false);
+    vmath::vec3 hdx(0.5*_dx, 0.5*_dx, 0.5*_dx);
+    for (size_t idx = 0; idx < positions.size(); idx++) {
+        GridIndex g = Grid3d::positionToGridIndex(positions[idx] - hdx, _dx);
+        int imin = std::min(std::max(g.i, 0), _isize - 1) / _tileWidth;
+        int jmin = std::min(std::max(g.j, 0), _jsize - 1) / _tileWidth;
+        int kmin = std::min(std::max(g.k, 0), _ksize - 1) / _tileWidth;
+        int imax = std::min(std::max(g.i + 1, 0), _isize - 1) / _tileWidth;
+        int jmax = std::min(std::max(g.j + 1, 0), _jsize - 1) / _tileWidth;
+        int kmax = std::min(std::max(g.k + 1, 0), _ksize - 1) / _tileWidth;
+        for (int k = kmin; k <= kmax; k++) {
+            for (int j = jmin; j <= jmax; j++) {
+                for (int i = imin; i <= imax; i++) {
+                    isTileRequired.set(i, j, k, true);
+                }
+            }
+        }
     }
-}
-
-void TurbulenceField::calculateTurbulenceField(MACVelocityField *vfield,
-                                               ParticleLevelSet &liquidSDF) {
 
-    int isize, jsize, ksize;
-    vfield->getGridDimensions(&isize, &jsize, &ksize);
-
-    GridIndexVector fluidcells(isize, jsize, ksize);
-    for (int k = 0; k < ksize; k++) {
-        for (int j = 0; j < jsize; j++) {
-            for (int i = 0; i < isize; i++) {
-                if (liquidSDF(i, j, k) < 0.0f) {
-                    fluidcells.push_back(i, j, k);
+    std::vector<GridIndex> tiles;
+    for (int k = 0; k < isTileRequired.depth; k++) {
+        for (int j = 0; j < isTileRequired.height; j++) {
+            for (int i = 0; i < isTileRequired.width; i++) {
+                if (isTileRequired(i, j, k)) {
+                    tiles.push_back(GridIndex(i, j, k));
                 }
             }
         }
     }
 
-    calculateTurbulenceField(vfield, fluidcells);
+    calculateTurbulenceTiles(tiles);
 }
 
-void TurbulenceField::calculateTurbulenceField(MACVelocityField *vfield,
-                                               GridIndexVector &fluidCells) {
-    vfield->getGridDimensions(&_isize, &_jsize, &_ksize);
-    _dx = vfield->getGridCellSize();
-    _radius = sqrt(3.0*(2*_dx)*(2*_dx));  // maximum distance from center grid cell
-                                          // to its 124 neighbours
+void TurbulenceField::invalidateTurbulenceField() {
+    _tileStatus.fill(TileStatus::uncomputed);
+    for (size_t i = 0; i < _tileData.size(); i++) {
+        _tileData[i].clear();
+        _tileData[i].shrink_to_fit();
+    }
+    _tileMaxTurbulence.assign(_tileMaxTurbulence.size(), 0.0f);
+}
 
-    if (_field.width != _isize || _field.height != _jsize || _field.depth != _ksize) {
-        _field = Array3d<float>(_isize, _jsize, _ksize);
+void TurbulenceField::_calculateTurbulenceTilesThread(int startidx, int endidx,
+                                                      std::vector<GridIndex> *tiles) {
+    std::vector<vmath::vec3> vgrid;
+    for (int idx = startidx; idx < endidx; idx++) {
+        _calculateTurbulenceTile(tiles->at(idx), vgrid);
     }
-    _field.fill(0.0f);
+}
 
-    Array3d<vmath::vec3> vgrid = Array3d<vmath::vec3>(_isize, _jsize, _ksize);
-    _getVelocityGrid(vfield, vgrid);
+void TurbulenceField::_calculateTurbulenceTile(GridIndex tile, std::vector<vmath::vec3> &vgrid) {
+    int imin = tile.i * _tileWidth;
+    int jmin = tile.j * _tileWidth;
+    int kmin = tile.k * _tileWidth;
+    int imax = std::min(imin + _tileWidth, _isize);
+    int jmax = std::min(jmin + _tileWidth, _jsize);
+    int kmax = std::min(kmin + _tileWidth, _ksize);
+    int tid = Grid3d::getFlatIndex(tile, _tileStatus.width, _tileStatus.height);
+
+    bool isFluidTile = false;
+    for (int k = kmin; k < kmax && !isFluidTile; k++) {
+        for (int j = jmin; j < jmax && !isFluidTile; j++) {
+            for (int i = imin; i < imax; i++) {
+                if ((*_liquidSDF)(i, j, k) < 0.0f) {
+                    isFluidTile = true;
+                    break;
+                }
+            }
+        }
+    }
 
-    int numCPU = ThreadUtils::getMaxThreadCount();
-    int numthreads = (int)fmin(numCPU, fluidCells.size());
-    std::vector<std::thread> threads(numthreads);
-    std::vector<int> intervals = ThreadUtils::splitRangeIntoIntervals(0, fluidCells.size(), numthreads);
-    for (int i = 0; i < numthreads; i++) {
-        threads[i] = std::thread(&TurbulenceField::_calculateTurbulenceFieldThread, this,
-                                 intervals[i], intervals[i + 1], &vgrid, &fluidCells);
+    if (!isFluidTile) {
+        _tileMaxTurbulence[tid] = 0.0f;
+        _tileStatus.set(tile, TileStatus::empty);
+        return;
     }
 
-    for (int i = 0; i < numthreads; i++) {
-        threads[i].join();
+    // Cell center velocities of the tile and its two cell wide border
+    int vimin = std::max(imin - 2, 0);
+    int vjmin = std::max(jmin - 2, 0);
+    int vkmin = std::max(kmin - 2, 0);
+    int vimax = std::min(imax + 2, _isize);
+    int vjmax = std::min(jmax + 2, _jsize);
+    int vkmax = std::min(kmax + 2, _ksize);
+    int visize = vimax - vimin;
+    int vjsize = vjmax - vjmin;
+    vgrid.resize(visize * vjsize * (vkmax - vkmin));
+    for (int k = vkmin; k < vkmax; k++) {
+        for (int j = vjmin; j < vjmax; j++) {
+            for (int i = vimin; i < vimax; i++) {
+                int vidx = Grid3d::getFlatIndex(i - vimin, j - vjmin, k - vkmin, visize, vjsize);
+                vgrid[vidx] = _vfield->evaluateVelocityAtCellCenter(i, j, k);
+            }
+        }
     }
-}
 
-void TurbulenceField::_calculateTurbulenceFieldThread(int startidx, int endidx,
-                                                      Array3d<vmath::vec3> *vgrid,
-                                                      GridIndexVector *fluidCells) {
+    std::vector<float> &data = _tileData[tid];
+    data.assign(_tileWidth * _tileWidth * _tileWidth, 0.0f);
+    float maxTurbulence = 0.0f;
+
     double eps = 10e-6;
     double invradius = 1.0 / _radius;
     vmath::vec3 vi, vj, vij, vijnorm, xi, xj, xij, xijnorm;
+    for (int k = kmin; k < kmax; k++) {
+        for (int j = jmin; j < jmax; j++) {
+            for (int i = imin; i < imax; i++) {
+                if ((*_liquidSDF)(i, j, k) >= 0.0f) {
+                    continue;
+                }
 
-    for (int idx = startidx; idx < endidx; idx++) {
-        GridIndex g = fluidCells->at(idx);
-        int i = g.i;
-        int j = g.j;
-        int k = g.k;
-
-        vi = vgrid->get(i, j, k);
-        xi = Grid3d::GridIndexToCellCenter(i, j, k, _dx);
-        double vlen, xlen;
-        double turb = 0.0;
-
-        for (int nk = fmax(k - 2, 0); nk < fmin(k + 2, _ksize - 1); nk++) {
-            for (int nj = fmax(j - 2, 0); nj < fmin(j + 2, _jsize - 1); nj++) {
-                for (int ni = fmax(i - 2, 0); ni < fmin(i + 2, _isize - 1); ni++) {
-                    vj = vgrid->get(ni, nj, nk);
-                    vij = vi - vj;
-                    vlen = vmath::length(vij);
-
-                    if (fabs(vlen) < eps) {
-                        continue;
+                vi = vgrid[Grid3d::getFlatIndex(i - vimin, j - vjmin, k - vkmin, visize, vjsize)];
+                xi = Grid3d::GridIndexToCellCenter(i, j, k, _dx);
+                double vlen, xlen;
+                double turb = 0.0;
+
+                for (int nk = fmax(k - 2, 0); nk < fmin(k + 2, _ksize - 1); nk++) {
+                    for (int nj = fmax(j - 2, 0); nj < fmin(j + 2, _jsize - 1); nj++) {
+                        for (int ni = fmax(i - 2, 0); ni < fmin(i + 2, _isize - 1); ni++) {
+                            vj = vgrid[Grid3d::getFlatIndex(ni - vimin, nj - vjmin, nk - vkmin, visize, vjsize)];
+                            vij = vi - vj;
+                            vlen = vmath::length(vij);
+
+                            if (fabs(vlen) < eps) {
+                                continue;
+                            }
+                            vijnorm = vij / (float)vlen;
+
+                            xj = Grid3d::GridIndexToCellCenter(ni, nj, nk, _dx);
+                            xij = xi - xj;
+                            xlen = vmath::length(xij);
+                            xijnorm = xij / (float)xlen;
+
+                            turb += vlen*(1.0 - vmath::dot(vijnorm, xijnorm))*(1.0 - (xlen*invradius));
+                        }
                     }
-                    vijnorm = vij / (float)vlen;
-
-                    xj = Grid3d::GridIndexToCellCenter(ni, nj, nk, _dx);
-                    xij = xi - xj;
-                    xlen = vmath::length(xij);
-                    xijnorm = xij / (float)xlen;
-
-                    turb += vlen*(1.0 - vmath::dot(vijnorm, xijnorm))*(1.0 - (xlen*invradius));
                 }
+
+                int didx = Grid3d::getFlatIndex(i - imin, j - jmin, k - kmin, _tileWidth, _tileWidth);
+                data[didx] = (float)turb;
+                maxTurbulence = std::max(maxTurbulence, (float)turb);
             }
         }
-
-        _field.set(i, j, k, turb);
     }
+
+    _tileMaxTurbulence[tid] = maxTurbulence;
+    _tileStatus.set(tile, TileStatus::computed);
 }
 
-void TurbulenceField::destroyTurbulenceField() {
-    _field = Array3d<float>();
+float TurbulenceField::_getTurbulence(int i, int j, int k) {
+    GridIndex t(i / _tileWidth, j / _tileWidth, k / _tileWidth);
+    TileStatus status = _tileStatus(t);
+    FLUIDSIM_ASSERT(status != TileStatus::uncomputed);
+    if (status != TileStatus::computed) {
+        return 0.0f;
+    }
+
+    int tid = Grid3d::getFlatIndex(t, _tileStatus.width, _tileStatus.height);
+    int didx = Grid3d::getFlatIndex(i - t.i * _tileWidth, 
+                                    j - t.j * _tileWidth, 
+                                    k - t.k * _tileWidth, 
+                                    _tileWidth, _tileWidth);
+    return _tileData[tid][didx];
 }
 
 double TurbulenceField::evaluateTurbulenceAtPosition(vmath::vec3 p) {
@@ -190,14 +300,14 @@ double TurbulenceField::evaluateTurbulenceAtPosition(vmath::vec3 p) {
     double iz = (p.z - gz)*inv_dx;
 
     double points[8] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
-    if (_field.isIndexInRange(i,   j,   k))   { points[0] = _field(i,   j,   k); }
-    if (_field.isIndexInRange(i+1, j,   k))   { points[1] = _field(i+1, j,   k); }
-    if (_field.isIndexInRange(i,   j+1, k))   { points[2] = _field(i,   j+1, k); }
-    if (_field.isIndexInRange(i,   j,   k+1)) { points[3] = _field(i,   j,   k+1); }
-    if (_field.isIndexInRange(i+1, j,   k+1)) { points[4] = _field(i+1, j,   k+1); }
-    if (_field.isIndexInRange(i,   j+1, k+1)) { points[5] = _field(i,   j+1, k+1); }
-    if (_field.isIndexInRange(i+1, j+1, k))   { points[6] = _field(i+1, j+1, k); }
-    if (_field.isIndexInRange(i+1, j+1, k+1)) { points[7] = _field(i+1, j+1, k+1); }
+    if (Grid3d::isGridIndexInRange(i,   j,   k,   _isize, _jsize, _ksize)) { points[0] = _getTurbulence(i,   j,   k); }
+    if (Grid3d::isGridIndexInRange(i+1, j,   k,   _isize, _jsize, _ksize)) { points[1] = _getTurbulence(i+1, j,   k); }
+    if (Grid3d::isGridIndexInRange(i,   j+1, k,   _isize, _jsize, _ksize)) { points[2] = _getTurbulence(i,   j+1, k); }
+    if (Grid3d::isGridIndexInRange(i,   j,   k+1, _isize, _jsize, _ksize)) { points[3] = _getTurbulence(i,   j,   k+1); }
+    if (Grid3d::isGridIndexInRange(i+1, j,   k+1, _isize, _jsize, _ksize)) { points[4] = _getTurbulence(i+1, j,   k+1); }
+    if (Grid3d::isGridIndexInRange(i,   j+1, k+1, _isize, _jsize, _ksize)) { points[5] = _getTurbulence(i,   j+1, k+1); }
+    if (Grid3d::isGridIndexInRange(i+1, j+1, k,   _isize, _jsize, _ksize)) { points[6] = _getTurbulence(i+1, j+1, k); }
+    if (Grid3d::isGridIndexInRange(i+1, j+1, k+1, _isize, _jsize, _ksize)) { points[7] = _getTurbulence(i+1, j+1, k+1); }
 
     return Interpolation::trilinearInterpolate(points, ix, iy, iz);
-}
\ No newline at end of file
+}
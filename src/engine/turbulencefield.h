@@ -30,44 +30,66 @@ SOFTWARE.
     #include <thread>
 #endif
 
+#include <vector>
+
 #include "vmath.h"
 #include "array3d.h"
 
 class MACVelocityField;
-class GridIndexVector;
 class ParticleLevelSet;
 
+/*
+    Turbulence is stored in cubic tiles of width _tileWidth cells. After 
+    initializeTurbulenceField, tiles must be computed with 
+    calculateTurbulenceTiles or calculateTurbulenceTilesAtPositions before 
+    they are accessed. Accessors only read tile data and are safe to call 
+    from multiple threads. Tiles are valid until the field is initialized 
+    again or invalidated after the velocity field has changed.
+*/
 class TurbulenceField
 {
 public:
     TurbulenceField();
     ~TurbulenceField();
 
-    void calculateTurbulenceField(MACVelocityField *vfield,
-                                  GridIndexVector &fluidCells);
-    void calculateTurbulenceField(MACVelocityField *vfield,
-                                  ParticleLevelSet &liquidSDF);
-
-    void destroyTurbulenceField();
+    void initializeTurbulenceField(MACVelocityField *vfield,
+                                   ParticleLevelSet &liquidSDF);
+    void calculateTurbulenceTiles(std::vector<GridIndex> &tiles);
+    void calculateTurbulenceTilesAtPositions(std::vector<vmath::vec3> &positions);
+    void invalidateTurbulenceField();
     double evaluateTurbulenceAtPosition(vmath::vec3 p);
 
     float operator()(int i, int j, int k);
     float operator()(GridIndex g);
 
+    int getTileWidth();
+    void getTileGridDimensions(int *ti, int *tj, int *tk);
+    float getMaxTileTurbulence(GridIndex tile);
+
 private:
-    
-    void _getVelocityGrid(MACVelocityField *macfield, 
-                          Array3d<vmath::vec3> &vgrid);
-    void _getVelocityGridThread(int startidx, int endidx, 
-                                MACVelocityField *vfield, 
-                                Array3d<vmath::vec3> *vgrid);
-    void _calculateTurbulenceFieldThread(int startidx, int endidx,
-                                         Array3d<vmath::vec3> *vgrid,
-                                         GridIndexVector *fluidCells);
-
-    Array3d<float> _field;
-
-    int _isize, _jsize, _ksize;
-    double _dx;
-    double _radius;
+
+    enum class TileStatus : char { 
+        uncomputed = 0x00, 
+        empty      = 0x01, 
+        computed   = 0x02
+    };
+
+    void _calculateTurbulenceTilesThread(int startidx, int endidx,
+                                         std::vector<GridIndex> *tiles);
+    void _calculateTurbulenceTile(GridIndex tile, std::vector<vmath::vec3> &vgrid);
+    float _getTurbulence(int i, int j, int k);
+
+    MACVelocityField *_vfield = nullptr;
+    ParticleLevelSet *_liquidSDF = nullptr;
+
+    int _isize = 0;
+    int _jsize = 0;
+    int _ksize = 0;
+    double _dx = 0.0;
+    double _radius = 0.0;
+
+    int _tileWidth = 8;
+    Array3d<TileStatus> _tileStatus;
+    std::vector<std::vector<float> > _tileData;
+    std::vector<float> _tileMaxTurbulence;
 };
@@ -0,0 +1,654 @@
+/*
+MIT License
+
+Copyright (C) 2026 Ryan L. Guy & Dennis Fassbaender
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#include "whitewaterchunkedfile.h"
+
+#if __MINGW32__ && !_WIN64
+    #include "mingw32_threads/mingw.thread.h"
+#else
+    #include <thread>
+#endif
+
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+#include "threadutils.h"
+#include "fluidsimassert.h"
+
+namespace WhitewaterChunkedFile {
+
+const unsigned int fileVersion = 1;
+const int defaultComponentBits = 16;
+const int defaultChunkSize = 65536;
+
+const char _magic[4] = {'W', 'W', 'C', (char)0xFF};
+const size_t _headerSize = 32;
+const size_t _chunkInfoSize = 64;
+const size_t _dataAlignment = 8;
+
+void generateChunkLayout(std::vector<vmath::vec3> &positions,
+                         std::vector<unsigned char> &ids,
+                         int idLimit,
+                         int chunkSize,
+                         ChunkLayout &layout) {
+    FLUIDSIM_ASSERT(positions.size() == ids.size());
+    FLUIDSIM_ASSERT(chunkSize > 0);
+
+    layout.idLimit = idLimit;
+    layout.order.clear();
+    layout.chunks.clear();
+    layout.idCounts.assign(idLimit, 0);
+
+    int n = (int)positions.size();
+    if (n == 0) {
+        return;
+    }
+
+    vmath::vec3 pmin = positions[0];
+    vmath::vec3 pmax = positions[0];
+    for (size_t i = 1; i < positions.size(); i++) {
+        vmath::vec3 p = positions[i];
+        pmin = vmath::vec3(std::min(pmin.x, p.x), std::min(pmin.y, p.y), std::min(pmin.z, p.z));
+        pmax = vmath::vec3(std::max(pmax.x, p.x), std::max(pmax.y, p.y), std::max(pmax.z, p.z));
+    }
+
+    vmath::vec3 size = pmax - pmin;
+    vmath::vec3 invsize(size.x > 0.0f ? 1.0f / size.x : 0.0f,
+                        size.y > 0.0f ? 1.0f / size.y : 0.0f,
+                        size.z > 0.0f ? 1.0f / size.z : 0.0f);
+
+    std::vector<unsigned int> codes(n);
+    for (int i = 0; i < n; i++) {
+        codes[i] = _getMortonCode(positions[i], pmin, invsize);
+    }
+
+    std::vector<int> mortonOrder;
+    _sortByMortonCode(codes, mortonOrder);
+    codes.clear();
+    codes.shrink_to_fit();
+
+    int numChunks = (n + chunkSize - 1) / chunkSize;
+    layout.chunks = std::vector<Chunk>(numChunks);
+    for (int i = 0; i < numChunks; i++) {
+        layout.chunks[i].startidx = i * chunkSize;
+        layout.chunks[i].endidx = std::min((i + 1) * chunkSize, n);
+    }
+    layout.order = std::vector<int>(n);
+
+    int numCPU = ThreadUtils::getMaxThreadCount();
+    int numthreads = (int)fmin(numCPU, numChunks);
+    std::vector<std::thread> threads(numthreads);
+    std::vector<int> intervals = ThreadUtils::splitRangeIntoIntervals(0, numChunks, numthreads);
+    for (int i = 0; i < numthreads; i++) {
+        threads[i] = std::thread(&_initializeChunksThread,
+                                 intervals[i], intervals[i + 1],
+                                 &positions, &ids, &mortonOrder, &layout);
+    }
+
+    for (int i = 0; i < numthreads; i++) {
+        threads[i].join();
+    }
+
+    for (size_t cidx = 0; cidx < layout.chunks.size(); cidx++) {
+        std::vector<unsigned int> &counts = layout.chunks[cidx].idCounts;
+        for (int i = 0; i < idLimit; i++) {
+            layout.idCounts[i] += counts[i];
+        }
+    }
+}
+
+void writeVectorData(ChunkLayout &layout, std::vector<vmath::vec3> &values, 
+                     int componentBits, std::vector<char> &data) {
+    FLUIDSIM_ASSERT(values.size() == layout.order.size());
+    const float *fvalues = values.empty() ? nullptr : &(values[0].x);
+    _writeFileData(layout, ValueType::vector, componentBits, fvalues, nullptr, data);
+}
+
+void writeFloatData(ChunkLayout &layout, std::vector<float> &values, 
+                    int componentBits, std::vector<char> &data) {
+    FLUIDSIM_ASSERT(values.size() == layout.order.size());
+    _writeFileData(layout, ValueType::scalar, componentBits, values.data(), nullptr, data);
+}
+
+void writeIntData(ChunkLayout &layout, std::vector<int> &values, 
+                  std::vector<char> &data) {
+    FLUIDSIM_ASSERT(values.size() == layout.order.size());
+    _writeFileData(layout, ValueType::integer, 32, nullptr, values.data(), data);
+}
+
+bool isChunkedFileData(const char *data, size_t size) {
+    return size >= _headerSize && std::memcmp(data, _magic, 4) == 0;
+}
+
+bool readFileHeader(const char *data, size_t size, FileHeader &header) {
+    if (!isChunkedFileData(data, size)) {
+        return false;
+    }
+
+    unsigned int values[7];
+    std::memcpy(values, data + 4, sizeof(values));
+    header.version = values[0];
+    header.valueType = (ValueType)values[1];
+    header.componentBits = values[2];
+    header.numParticles = values[3];
+    header.numChunks = values[4];
+    header.idLimit = values[5];
+
+    if (header.version != fileVersion) {
+        return false;
+    }
+    if (header.valueType != ValueType::vector && 
+            header.valueType != ValueType::scalar && 
+            header.valueType != ValueType::integer) {
+        return false;
+    }
+    if (header.componentBits != 8 && header.componentBits != 16 && header.componentBits != 32) {
+        return false;
+    }
+    if (header.idLimit == 0) {
+        return false;
+    }
+
+    size_t tableEnd = _headerSize + 
+                      (size_t)header.idLimit * sizeof(unsigned int) + 
+                      (size_t)header.numChunks * _chunkInfoSize;
+    return tableEnd <= size;
+}
+
+bool readChunkInfo(const char *data, size_t size, int chunkIndex, ChunkInfo &info) {
+    FileHeader header;
+    if (!readFileHeader(data, size, header)) {
+        return false;
+    }
+    if (chunkIndex < 0 || chunkIndex >= (int)header.numChunks) {
+        return false;
+    }
+
+    size_t offset = _headerSize + 
+                    (size_t)header.idLimit * sizeof(unsigned int) + 
+                    (size_t)chunkIndex * _chunkInfoSize;
+    float bounds[12];
+    std::memcpy(bounds, data + offset, sizeof(bounds));
+    std::memcpy(&(info.dataOffset), data + offset + 48, sizeof(unsigned long long));
+    std::memcpy(&(info.numParticles), data + offset + 56, sizeof(unsigned int));
+    info.positionMin = vmath::vec3(bounds[0], bounds[1], bounds[2]);
+    info.positionMax = vmath::vec3(bounds[3], bounds[4], bounds[5]);
+    info.valueMin = vmath::vec3(bounds[6], bounds[7], bounds[8]);
+    info.valueMax = vmath::vec3(bounds[9], bounds[10], bounds[11]);
+
+    int numComponents = _getNumComponents(header.valueType);
+    size_t chunkSize = _getChunkDataSize(info.numParticles, header.idLimit, 
+                                         numComponents, header.componentBits);
+    return info.dataOffset + chunkSize <= size;
+}
+
+bool readNumParticles(const char *data, size_t size, double pct, 
+                      unsigned int &numParticles) {
+    return _readNumParticles(data, size, pct, nullptr, numParticles);
+}
+
+bool readNumParticles(const char *data, size_t size, double pct, AABB region,
+                      unsigned int &numParticles) {
+    return _readNumParticles(data, size, pct, &region, numParticles);
+}
+
+bool readVectorData(const char *data, size_t size, double pct, 
+                    std::vector<vmath::vec3> &values) {
+    std::vector<float> fvalues;
+    std::vector<int> ivalues;
+    if (!_readData(data, size, pct, nullptr, ValueType::vector, fvalues, ivalues)) {
+        return false;
+    }
+
+    values = std::vector<vmath::vec3>(fvalues.size() / 3);
+    for (size_t i = 0; i < values.size(); i++) {
+        values[i] = vmath::vec3(fvalues[3*i], fvalues[3*i + 1], fvalues[3*i + 2]);
+    }
+    return true;
+}
+
+bool readVectorData(const char *data, size_t size, double pct, AABB region,
+                    std::vector<vmath::vec3> &values) {
+    std::vector<float> fvalues;
+    std::vector<int> ivalues;
+    if (!_readData(data, size, pct, &region, ValueType::vector, fvalues, ivalues)) {
+        return false;
+    }
+
+    values = std::vector<vmath::vec3>(fvalues.size() / 3);
+    for (size_t i = 0; i < values.size(); i++) {
+        values[i] = vmath::vec3(fvalues[3*i], fvalues[3*i + 1], fvalues[3*i + 2]);
+    }
+    return true;
+}
+
+bool readFloatData(const char *data, size_t size, double pct, 
+                   std::vector<float> &values) {
+    std::vector<int> ivalues;
+    return _readData(data, size, pct, nullptr, ValueType::scalar, values, ivalues);
+}
+
+bool readFloatData(const char *data, size_t size, double pct, AABB region,
+                   std::vector<float> &values) {
+    std::vector<int> ivalues;
+    return _readData(data, size, pct, &region, ValueType::scalar, values, ivalues);
+}
+
+bool readIntData(const char *data, size_t size, double pct, 
+                 std::vector<int> &values) {
+    std::vector<float> fvalues;
+    return _readData(data, size, pct, nullptr, ValueType::integer, fvalues, values);
+}
+
+bool readIntData(const char *data, size_t size, double pct, AABB region,
+                 std::vector<int> &values) {
+    std::vector<float> fvalues;
+    return _readData(data, size, pct, &region, ValueType::integer, fvalues, values);
+}
+
+unsigned int _getMortonCode(vmath::vec3 p, vmath::vec3 pmin, vmath::vec3 invsize) {
+    vmath::vec3 r = p - pmin;
+    unsigned int maxv = 1023;
+    unsigned int i = (unsigned int)std::min(std::max(r.x * invsize.x * maxv, 0.0f), (float)maxv);
+    unsigned int j = (unsigned int)std::min(std::max(r.y * invsize.y * maxv, 0.0f), (float)maxv);
+    unsigned int k = (unsigned int)std::min(std::max(r.z * invsize.z * maxv, 0.0f), (float)maxv);
+    return (_expandBits(k) << 2) | (_expandBits(j) << 1) | _expandBits(i);
+}
+
+unsigned int _expandBits(unsigned int v) {
+    // Inserts two zero bits between each of the lower 10 bits of v
+    v = (v * 0x00010001u) & 0xFF0000FFu;
+    v = (v * 0x00000101u) & 0x0F00F00Fu;
+    v = (v * 0x00000011u) & 0xC30C30C3u;
+    v = (v * 0x00000005u) & 0x49249249u;
+    return v;
+}
+
+void _sortByMortonCode(std::vector<unsigned int> &codes, std::vector<int> &order) {
+    // Two pass LSD radix sort of the 30-bit codes. The sort is stable so 
+    // that particles with equal codes keep their input order.
+    int n = (int)codes.size();
+    int radixBits = 15;
+    int numBuckets = 1 << radixBits;
+    unsigned int mask = numBuckets - 1;
+
+    std::vector<int> current(n);
+    for (int i = 0; i < n; i++) {
+        current[i] = i;
+    }
+    std::vector<int> next(n);
+    std::vector<int> bucketOffsets(numBuckets);
+
+    for (int pass = 0; pass < 2; pass++) {
+        int shift = pass * radixBits;
+        std::fill(bucketOffsets.begin(), bucketOffsets.end(), 0);
+        for (int i = 0; i < n; i++) {
+            bucketOffsets[(codes[i] >> shift) & mask]++;
+        }
+
+        int offset = 0;
+        for (int b = 0; b < numBuckets; b++) {
+            int count = bucketOffsets[b];
+            bucketOffsets[b] = offset;
+            offset += count;
+        }
+
+        for (int i = 0; i < n; i++) {
+            int idx = current[i];
+            next[bucketOffsets[(codes[idx] >> shift) & mask]++] = idx;
+        }
+        current.swap(next);
+    }
+
+    order.swap(current);
+}
+
+void _initializeChunksThread(int startidx, int endidx,
+                             std::vector<vmath::vec3> *positions,
+                             std::vector<unsigned char> *ids,
+                             std::vector<int> *mortonOrder,
+                             ChunkLayout *layout) {
+    int idLimit = layout->idLimit;
+    std::vector<unsigned int> binOffsets(idLimit);
+    for (int cidx = startidx; cidx < endidx; cidx++) {
+        Chunk &chunk = layout->chunks[cidx];
+        chunk.idCounts.assign(idLimit, 0);
+
+        vmath::vec3 pmin = positions->at(mortonOrder->at(chunk.startidx));
+        vmath::vec3 pmax = pmin;
+        for (int i = chunk.startidx; i < chunk.endidx; i++) {
+            int pidx = mortonOrder->at(i);
+            vmath::vec3 p = positions->at(pidx);
+            pmin = vmath::vec3(std::min(pmin.x, p.x), std::min(pmin.y, p.y), std::min(pmin.z, p.z));
+            pmax = vmath::vec3(std::max(pmax.x, p.x), std::max(pmax.y, p.y), std::max(pmax.z, p.z));
+            chunk.idCounts[ids->at(pidx)]++;
+        }
+        chunk.positionMin = pmin;
+        chunk.positionMax = pmax;
+
+        unsigned int offset = 0;
+        for (int i = 0; i < idLimit; i++) {
+            binOffsets[i] = offset;
+            offset += chunk.idCounts[i];
+            chunk.idCounts[i] = offset;
+        }
+
+        for (int i = chunk.startidx; i < chunk.endidx; i++) {
+            int pidx = mortonOrder->at(i);
+            layout->order[chunk.startidx + binOffsets[ids->at(pidx)]++] = pidx;
+        }
+    }
+}
+
+void _writeFileData(ChunkLayout &layout, ValueType valueType, int componentBits,
+                    const float *values, const int *intValues, std::vector<char> &data) {
+    FLUIDSIM_ASSERT(componentBits == 8 || componentBits == 16 || componentBits == 32);
+
+    int numComponents = _getNumComponents(valueType);
+    size_t idHeaderSize = layout.idLimit * sizeof(unsigned int);
+    size_t tableSize = layout.chunks.size() * _chunkInfoSize;
+    size_t dataSize = _headerSize + idHeaderSize + tableSize;
+    dataSize = (dataSize + _dataAlignment - 1) / _dataAlignment * _dataAlignment;
+
+    std::vector<unsigned long long> chunkOffsets(layout.chunks.size());
+    for (size_t i = 0; i < layout.chunks.size(); i++) {
+        int n = layout.chunks[i].endidx - layout.chunks[i].startidx;
+        chunkOffsets[i] = dataSize;
+        dataSize += _getChunkDataSize(n, layout.idLimit, numComponents, componentBits);
+    }
+
+    data.clear();
+    data.resize(dataSize, 0);
+    data.shrink_to_fit();
+
+    unsigned int header[7] = {
+        fileVersion,
+        (unsigned int)valueType,
+        (unsigned int)componentBits,
+        (unsigned int)layout.order.size(),
+        (unsigned int)layout.chunks.size(),
+        (unsigned int)layout.idLimit,
+        0
+    };
+    std::memcpy(data.data(), _magic, 4);
+    std::memcpy(data.data() + 4, header, sizeof(header));
+    std::memcpy(data.data() + _headerSize, layout.idCounts.data(), idHeaderSize);
+
+    for (size_t i = 0; i < layout.chunks.size(); i++) {
+        size_t offset = _headerSize + idHeaderSize + i * _chunkInfoSize;
+        unsigned int n = layout.chunks[i].endidx - layout.chunks[i].startidx;
+        std::memcpy(data.data() + offset + 48, &(chunkOffsets[i]), sizeof(unsigned long long));
+        std::memcpy(data.data() + offset + 56, &n, sizeof(unsigned int));
+    }
+
+    if (layout.chunks.empty()) {
+        return;
+    }
+
+    int numCPU = ThreadUtils::getMaxThreadCount();
+    int numthreads = (int)fmin(numCPU, layout.chunks.size());
+    std::vector<std::thread> threads(numthreads);
+    std::vector<int> intervals = ThreadUtils::splitRangeIntoIntervals(0, layout.chunks.size(), numthreads);
+    for (int i = 0; i < numthreads; i++) {
+        threads[i] = std::thread(&_writeChunkDataThread,
+                                 intervals[i], intervals[i + 1],
+                                 &layout, valueType, componentBits,
+                                 values, intValues, &data);
+    }
+
+    for (int i = 0; i < numthreads; i++) {
+        threads[i].join();
+    }
+}
+
+void _writeChunkDataThread(int startidx, int endidx,
+                           ChunkLayout *layout, ValueType valueType, int componentBits,
+                           const float *values, const int *intValues,
+                           std::vector<char> *data) {
+    int numComponents = _getNumComponents(valueType);
+    int idLimit = layout->idLimit;
+    size_t idHeaderSize = idLimit * sizeof(unsigned int);
+    size_t tableOffset = _headerSize + idHeaderSize;
+    unsigned int maxq = componentBits == 32 ? 0 : (1u << componentBits) - 1;
+
+    for (int cidx = startidx; cidx < endidx; cidx++) {
+        Chunk &chunk = layout->chunks[cidx];
+        char *info = data->data() + tableOffset + cidx * _chunkInfoSize;
+        unsigned long long dataOffset;
+        std::memcpy(&dataOffset, info + 48, sizeof(unsigned long long));
+        char *chunkData = data->data() + dataOffset;
+
+        std::memcpy(chunkData, chunk.idCounts.data(), idHeaderSize);
+        char *valueData = chunkData + idHeaderSize;
+
+        float bounds[12] = {
+            chunk.positionMin.x, chunk.positionMin.y, chunk.positionMin.z,
+            chunk.positionMax.x, chunk.positionMax.y, chunk.positionMax.z,
+            0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f
+        };
+
+        if (valueType == ValueType::integer) {
+            for (int i = chunk.startidx; i < chunk.endidx; i++) {
+                int v = intValues[layout->order[i]];
+                std::memcpy(valueData + (size_t)(i - chunk.startidx) * sizeof(int), &v, sizeof(int));
+            }
+            std::memcpy(info, bounds, sizeof(bounds));
+            continue;
+        }
+
+        float vmin[3] = {0.0f, 0.0f, 0.0f};
+        float vmax[3] = {0.0f, 0.0f, 0.0f};
+        for (int c = 0; c < numComponents; c++) {
+            vmin[c] = values[(size_t)layout->order[chunk.startidx] * numComponents + c];
+            vmax[c] = vmin[c];
+        }
+        for (int i = chunk.startidx; i < chunk.endidx; i++) {
+            const float *v = values + (size_t)layout->order[i] * numComponents;
+            for (int c = 0; c < numComponents; c++) {
+                vmin[c] = std::min(vmin[c], v[c]);
+                vmax[c] = std::max(vmax[c], v[c]);
+            }
+        }
+
+        float scale[3] = {0.0f, 0.0f, 0.0f};
+        for (int c = 0; c < numComponents; c++) {
+            bounds[6 + c] = vmin[c];
+            bounds[9 + c] = vmax[c];
+            if (vmax[c] > vmin[c]) {
+                scale[c] = (float)maxq / (vmax[c] - vmin[c]);
+            }
+        }
+        std::memcpy(info, bounds, sizeof(bounds));
+
+        size_t valueIndex = 0;
+        if (componentBits == 32) {
+            float *out = (float *)valueData;
+            for (int i = chunk.startidx; i < chunk.endidx; i++) {
+                const float *v = values + (size_t)layout->order[i] * numComponents;
+                for (int c = 0; c < numComponents; c++) {
+                    out[valueIndex++] = v[c];
+                }
+            }
+        } else if (componentBits == 16) {
+            unsigned short *out = (unsigned short *)valueData;
+            for (int i = chunk.startidx; i < chunk.endidx; i++) {
+                const float *v = values + (size_t)layout->order[i] * numComponents;
+                for (int c = 0; c < numComponents; c++) {
+                    float q = std::floor((v[c] - vmin[c]) * scale[c] + 0.5f);
+                    out[valueIndex++] = (unsigned short)std::min(std::max(q, 0.0f), (float)maxq);
+                }
+            }
+        } else {
+            unsigned char *out = (unsigned char *)valueData;
+            for (int i = chunk.startidx; i < chunk.endidx; i++) {
+                const float *v = values + (size_t)layout->order[i] * numComponents;
+                for (int c = 0; c < numComponents; c++) {
+                    float q = std::floor((v[c] - vmin[c]) * scale[c] + 0.5f);
+                    out[valueIndex++] = (unsigned char)std::min(std::max(q, 0.0f), (float)maxq);
+                }
+            }
+        }
+    }
+}
+
+int _getNumComponents(ValueType valueType) {
+    return valueType == ValueType::vector ? 3 : 1;
+}
+
+size_t _getChunkDataSize(int numParticles, int idLimit, int numComponents, int componentBits) {
+    size_t size = idLimit * sizeof(unsigned int) + 
+                  (size_t)numParticles * numComponents * (componentBits / 8);
+    return (size + _dataAlignment - 1) / _dataAlignment * _dataAlignment;
+}
+
+bool _readNumParticles(const char *data, size_t size, double pct, AABB *region, 
+                       unsigned int &numParticles) {
+    numParticles = 0;
+
+    FileHeader header;
+    if (!readFileHeader(data, size, header)) {
+        return false;
+    }
+    if (pct <= 0.0) {
+        return true;
+    }
+
+    int idbin = _getIDBin(pct, header.idLimit);
+    for (unsigned int cidx = 0; cidx < header.numChunks; cidx++) {
+        ChunkInfo info;
+        if (!readChunkInfo(data, size, cidx, info)) {
+            numParticles = 0;
+            return false;
+        }
+
+        if (region != nullptr) {
+            AABB bbox(info.positionMin, info.positionMax);
+            if (!region->isIntersecting(bbox)) {
+                continue;
+            }
+        }
+
+        unsigned int n;
+        std::memcpy(&n, data + info.dataOffset + idbin * sizeof(unsigned int), sizeof(unsigned int));
+        numParticles += std::min(n, info.numParticles);
+    }
+
+    return true;
+}
+
+int _getIDBin(double pct, unsigned int idLimit) {
+    return (int)std::ceil(std::min(pct, 1.0) * (idLimit - 1));
+}
+
+bool _readData(const char *data, size_t size, double pct, AABB *region, 
+               ValueType valueType, std::vector<float> &values, 
+               std::vector<int> &intValues) {
+    values.clear();
+    intValues.clear();
+
+    FileHeader header;
+    if (!readFileHeader(data, size, header) || header.valueType != valueType) {
+        return false;
+    }
+    if (pct <= 0.0) {
+        return true;
+    }
+
+    int numComponents = _getNumComponents(valueType);
+    int idbin = _getIDBin(pct, header.idLimit);
+    unsigned int maxq = header.componentBits == 32 ? 0 : (1u << header.componentBits) - 1;
+
+    unsigned int numParticles;
+    std::memcpy(&numParticles, data + _headerSize + idbin * sizeof(unsigned int), sizeof(unsigned int));
+    if (valueType == ValueType::integer) {
+        intValues.reserve(numParticles);
+    } else {
+        values.reserve((size_t)numParticles * numComponents);
+    }
+
+    for (unsigned int cidx = 0; cidx < header.numChunks; cidx++) {
+        ChunkInfo info;
+        if (!readChunkInfo(data, size, cidx, info)) {
+            values.clear();
+            intValues.clear();
+            return false;
+        }
+
+        if (region != nullptr) {
+            AABB bbox(info.positionMin, info.positionMax);
+            if (!region->isIntersecting(bbox)) {
+                continue;
+            }
+        }
+
+        const char *chunkData = data + info.dataOffset;
+        unsigned int n;
+        std::memcpy(&n, chunkData + idbin * sizeof(unsigned int), sizeof(unsigned int));
+        n = std::min(n, info.numParticles);
+        const char *valueData = chunkData + header.idLimit * sizeof(unsigned int);
+
+        if (valueType == ValueType::integer) {
+            size_t offset = intValues.size();
+            intValues.resize(offset + n);
+            std::memcpy(intValues.data() + offset, valueData, n * sizeof(int));
+            continue;
+        }
+
+        float vmin[3] = {info.valueMin.x, info.valueMin.y, info.valueMin.z};
+        float vmax[3] = {info.valueMax.x, info.valueMax.y, info.valueMax.z};
+        float invscale[3] = {0.0f, 0.0f, 0.0f};
+        for (int c = 0; c < numComponents; c++) {
+            if (maxq > 0) {
+                invscale[c] = (vmax[c] - vmin[c]) / (float)maxq;
+            }
+        }
+
+        size_t offset = values.size();
+        size_t numValues = (size_t)n * numComponents;
+        values.resize(offset + numValues);
+        float *out = values.data() + offset;
+        if (header.componentBits == 32) {
+            std::memcpy(out, valueData, numValues * sizeof(float));
+        } else if (header.componentBits == 16) {
+            const unsigned char *q = (const unsigned char *)valueData;
+            for (size_t i = 0; i < numValues; i++) {
+                int c = i % numComponents;
+                unsigned int q16 = (unsigned int)q[2*i] | ((unsigned int)q[2*i + 1] << 8);
+                out[i] = vmin[c] + q16 * invscale[c];
+            }
+        } else {
+            const unsigned char *q = (const unsigned char *)valueData;
+            for (size_t i = 0; i < numValues; i++) {
+                int c = i % numComponents;
+                out[i] = vmin[c] + q[i] * invscale[c];
+            }
+        }
+    }
+
+    return true;
+}
+
+}
@@ -0,0 +1,185 @@
+/*
+MIT License
+
+Copyright (C) 2026 Ryan L. Guy & Dennis Fassbaender
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#pragma once
+
+#include <vector>
+
+#include "vmath.h"
+#include "aabb.h"
+
+/*
+    Chunked whitewater file format (WWC)
+
+    An alternative to the WWP, WWI and WWF whitewater formats. Particles are
+    sorted by the Morton code of their position and split into chunks of
+    consecutive particles. Within a chunk, particles are ordered by their
+    ID bin and then by Morton code. Vector and float values are quantized 
+    to the value range of their chunk. Files of the same particle set that 
+    share a chunk layout list their particles in the same order.
+
+    All values are little endian.
+
+    Header (32 bytes)
+        char[4]     magic 'W', 'W', 'C', 0xFF. Read as an int32, this is 
+                    negative which no WWP, WWI or WWF file begins with
+        uint32      version
+        uint32      value type (0 = vec3, 1 = float, 2 = int32)
+        uint32      bits per component (8, 16 or 32, 32 is unquantized)
+        uint32      number of particles
+        uint32      number of chunks
+        uint32      ID limit
+        uint32      reserved
+
+    ID header (ID limit * 4 bytes)
+        uint32      number of particles in the file with an ID less than or 
+                    equal to i
+
+    Chunk table (number of chunks * 64 bytes)
+        float[3]    minimum of the particle position bounds
+        float[3]    maximum of the particle position bounds
+        float[3]    minimum of the value quantization range
+        float[3]    maximum of the value quantization range
+        uint64      byte offset of the chunk data from the start of the file
+        uint32      number of particles in the chunk
+        uint32      reserved
+
+    Chunk data (aligned to 8 bytes)
+        uint32      ID limit values, the number of particles in the chunk
+                    with an ID less than or equal to i
+        values      number of particles * components, each component is
+                    stored in (bits per component / 8) bytes. A quantized 
+                    component q is decoded as min + q * (max - min) / (2^bits - 1)
+*/
+namespace WhitewaterChunkedFile {
+
+    enum class ValueType : unsigned int { 
+        vector  = 0, 
+        scalar  = 1,
+        integer = 2
+    };
+
+    struct FileHeader {
+        unsigned int version = 0;
+        ValueType valueType = ValueType::vector;
+        unsigned int componentBits = 0;
+        unsigned int numParticles = 0;
+        unsigned int numChunks = 0;
+        unsigned int idLimit = 0;
+    };
+
+    struct ChunkInfo {
+        vmath::vec3 positionMin;
+        vmath::vec3 positionMax;
+        vmath::vec3 valueMin;
+        vmath::vec3 valueMax;
+        unsigned long long dataOffset = 0;
+        unsigned int numParticles = 0;
+    };
+
+    struct Chunk {
+        int startidx = 0;
+        int endidx = 0;
+        vmath::vec3 positionMin;
+        vmath::vec3 positionMax;
+        std::vector<unsigned int> idCounts;
+    };
+
+    // Particle ordering and chunk boundaries that are shared by every file
+    // written for a particle set
+    struct ChunkLayout {
+        int idLimit = 0;
+        std::vector<int> order;
+        std::vector<Chunk> chunks;
+        std::vector<unsigned int> idCounts;
+    };
+
+    extern const unsigned int fileVersion;
+    extern const int defaultComponentBits;
+    extern const int defaultChunkSize;
+
+    void generateChunkLayout(std::vector<vmath::vec3> &positions,
+                             std::vector<unsigned char> &ids,
+                             int idLimit,
+                             int chunkSize,
+                             ChunkLayout &layout);
+
+    void writeVectorData(ChunkLayout &layout, std::vector<vmath::vec3> &values, 
+                         int componentBits, std::vector<char> &data);
+    void writeFloatData(ChunkLayout &layout, std::vector<float> &values, 
+                        int componentBits, std::vector<char> &data);
+    void writeIntData(ChunkLayout &layout, std::vector<int> &values, 
+                      std::vector<char> &data);
+
+    bool isChunkedFileData(const char *data, size_t size);
+    bool readFileHeader(const char *data, size_t size, FileHeader &header);
+    bool readChunkInfo(const char *data, size_t size, int chunkIndex, ChunkInfo &info);
+    bool readNumParticles(const char *data, size_t size, double pct, 
+                          unsigned int &numParticles);
+    bool readNumParticles(const char *data, size_t size, double pct, AABB region,
+                          unsigned int &numParticles);
+
+    // Decodes the particles with an ID bin less than or equal to 
+    // ceil(pct * (ID limit - 1)), the same subset that the WWP import 
+    // percentage selects. The region variant skips chunks with position 
+    // bounds that do not intersect the region.
+    bool readVectorData(const char *data, size_t size, double pct, 
+                        std::vector<vmath::vec3> &values);
+    bool readVectorData(const char *data, size_t size, double pct, AABB region,
+                        std::vector<vmath::vec3> &values);
+    bool readFloatData(const char *data, size_t size, double pct, 
+                       std::vector<float> &values);
+    bool readFloatData(const char *data, size_t size, double pct, AABB region,
+                       std::vector<float> &values);
+    bool readIntData(const char *data, size_t size, double pct, 
+                     std::vector<int> &values);
+    bool readIntData(const char *data, size_t size, double pct, AABB region,
+                     std::vector<int> &values);
+
+    unsigned int _getMortonCode(vmath::vec3 p, vmath::vec3 pmin, vmath::vec3 invsize);
+    unsigned int _expandBits(unsigned int v);
+    void _sortByMortonCode(std::vector<unsigned int> &codes, std::vector<int> &order);
+    void _initializeChunksThread(int startidx, int endidx,
+                                 std::vector<vmath::vec3> *positions,
+                                 std::vector<unsigned char> *ids,
+                                 std::vector<int> *mortonOrder,
+                                 ChunkLayout *layout);
+
+    void _writeFileData(ChunkLayout &layout, ValueType valueType, int componentBits,
+                        const float *values, const int *intValues, std::vector<char> &data);
+    void _writeChunkDataThread(int startidx, int endidx,
+                               ChunkLayout *layout, ValueType valueType, int componentBits,
+                               const float *values, const int *intValues,
+                               std::vector<char> *data);
+    int _getNumComponents(ValueType valueType);
+    size_t _getChunkDataSize(int numParticles, int idLimit, int numComponents, int componentBits);
+
+    bool _readNumParticles(const char *data, size_t size, double pct, AABB *region, 
+                           unsigned int &numParticles);
+    int _getIDBin(double pct, unsigned int idLimit);
+    bool _readData(const char *data, size_t size, double pct, AABB *region, 
+                   ValueType valueType, std::vector<float> &values, 
+                   std::vector<int> &intValues);
+}